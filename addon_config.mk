@@ -26,6 +26,8 @@ common:
 	ADDON_CFLAGS = -DPD -DUSEAPI_DUMMY -DPD_INTERNAL -DHAVE_UNISTD_H -DHAVE_ALLOCA_H -DLIBPD_EXTRA
 	# uncomment this for multiple instance support, ie. for pdMultiExample
 	#ADDON_CFLAGS += -DPDINSTANCE -DPDTHREADS
+	# uncomment this to use the Ooura FFT instead of the vectorized one
+	#ADDON_CFLAGS += -DPD_FFT_FFTSG
 	# this is included directly in pd~.c, don't build twice
 	ADDON_SOURCES_EXCLUDE = libs/libpd/pure-data/extra/pd~/binarymsg.c
 
@@ -18,6 +18,10 @@
 #include "z_print_util.h"
 
 #include <map>  
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
 
 #include "PdTypes.hpp"
 #include "PdReceiver.hpp"
@@ -32,16 +36,235 @@
     #define HAVE_UNISTD_H
 #endif
 
+// libpd calls on this thread would deadlock while it has an array view of the
+// instance open, so they fail with an error and return ret instead
+#define PDBASE_CHECKVIEWS(ret) \
+    if(pd::ArrayView::isOpen(instancePtr())) { \
+        std::cerr << "Pd: cannot call pd while an array view is open " \
+                  << "on the same thread" << std::endl; \
+        return ret; \
+    }
+
 #ifdef PDINSTANCE
-    #define PDBASE_SETINSTANCE libpd_set_instance(instance);
+    #define PDBASE_SETINSTANCE_OR(ret) \
+        PDBASE_CHECKVIEWS(ret) libpd_set_instance(instance);
 #else
-    #define PDBASE_SETINSTANCE
+    #define PDBASE_SETINSTANCE_OR(ret) PDBASE_CHECKVIEWS(ret)
 #endif
 
+// for functions without a return value
+#define PDBASE_SETINSTANCE PDBASE_SETINSTANCE_OR()
+
 typedef struct _atom t_atom;
 
 namespace pd {
 
+/// \section Pd Array View
+
+/// direct, zero-copy access to the live samples of a pd array
+///
+/// a view is set up by PdBase::openArray() and keeps the pd instance locked
+/// while it is valid, so samples can be read and written in place without
+/// the array being resized or freed underneath it:
+///
+///     pd::ArrayView view;
+///     if(pd.openArray("array1", view)) {
+///         for(int i = 0; i < view.size(); ++i) {
+///             view.set(i, view[i] * 0.5f);
+///         }
+///         view.close(); // or let it go out of scope
+///     }
+///
+/// note: audio processing and all other libpd calls on the instance will block
+///       until the view is closed, so keep access short and do not call other
+///       PdBase functions for the instance on the same thread while a view is
+///       open, as the instance lock is not recursive: such calls fail with an
+///       error instead of deadlocking
+class ArrayView {
+
+public:
+
+    ArrayView() : _vec(NULL), _size(0), _instance(NULL) {}
+
+    ~ArrayView() {close();}
+
+    /// release the array and unlock the pd instance
+    void close() {
+        if(_vec == NULL) {
+            return;
+        }
+        #ifdef PDINSTANCE
+            t_pdinstance *current = libpd_this_instance();
+            libpd_set_instance(_instance);
+            libpd_array_release();
+            libpd_set_instance(current);
+        #else
+            libpd_array_release();
+        #endif
+        std::vector<t_pdinstance *> &open = openInstances();
+        open.erase(std::find(open.begin(), open.end(), _instance));
+        _vec = NULL;
+        _size = 0;
+        _instance = NULL;
+    }
+
+    /// is the view open?
+    bool isValid() const {return _vec != NULL;}
+
+    /// get the number of samples
+    int size() const {return _size;}
+
+    /// get a sample value, performs no bounds checking
+    float operator[](int index) const {return _vec[index].w_float;}
+
+    /// set a sample value, performs no bounds checking
+    void set(int index, float value) {_vec[index].w_float = value;}
+
+    /// copy len samples starting at offset into dest
+    /// returns false if offset and len exceed the array size
+    bool read(float *dest, int offset, int len) const {
+        if(offset < 0 || len < 0 || offset + len > _size) {
+            return false;
+        }
+        libpd_words_to_floats(dest, _vec + offset, len);
+        return true;
+    }
+
+    /// copy len samples from src into the array starting at offset
+    /// returns false if offset and len exceed the array size
+    bool write(const float *src, int offset, int len) {
+        if(offset < 0 || len < 0 || offset + len > _size) {
+            return false;
+        }
+        libpd_floats_to_words(_vec + offset, src, len);
+        return true;
+    }
+
+    /// set all samples to a value
+    void fill(float value) {
+        for(int i = 0; i < _size; ++i) {
+            _vec[i].w_float = value;
+        }
+    }
+
+    /// get the raw array words, samples are accessed via words()[i].w_float
+    t_word* words() const {return _vec;}
+
+    /// is a view of the given instance open on the calling thread?
+    static bool isOpen(t_pdinstance *instance) {
+        std::vector<t_pdinstance *> &open = openInstances();
+        return std::find(open.begin(), open.end(), instance) != open.end();
+    }
+
+private:
+
+    /// instances with open views on the calling thread
+    static std::vector<t_pdinstance *>& openInstances() {
+        static thread_local std::vector<t_pdinstance *> instances;
+        return instances;
+    }
+
+    friend class PdBase;
+
+    // views hold the instance lock, so they cannot be copied
+    ArrayView(const ArrayView &from);
+    void operator=(const ArrayView &from);
+
+    t_word *_vec;              ///< array words
+    int _size;                 ///< number of samples
+    t_pdinstance *_instance;   ///< locked pd instance
+};
+
+/// \section Pd Sound File Map
+
+/// random access to an uncompressed soundfile (wave, aiff, caf, or next)
+/// which is mapped into memory instead of being loaded into an array, so
+/// opening is instant and only the parts which are read take up memory
+///
+/// a map is set up by PdBase::openSoundFile() and does not lock the pd
+/// instance, so it can be read from any thread, ie. the audio thread:
+///
+///     pd::SoundFileMap map;
+///     if(pd.openSoundFile("sounds/piano.wav", map)) {
+///         std::vector<float> frames(64 * map.numChannels());
+///         map.read(&frames[0], 0, 64); // interleaved
+///     }
+///
+/// reads never wait for the disk: a background thread pages the file in
+/// ahead of the last read and frames which are not in memory yet read as
+/// zeros, so call prefetch() first outside of the audio thread to make sure
+/// a range is complete, ie. the start of the file right after opening
+///
+/// the same files can be played from a patch with [sfread4~]
+class SoundFileMap {
+
+public:
+
+    SoundFileMap() : _map(NULL), _channels(0), _samplerate(0), _frames(0) {}
+
+    ~SoundFileMap() {close();}
+
+    /// unmap the soundfile
+    void close() {
+        if(_map == NULL) {
+            return;
+        }
+        libpd_soundmap_close(_map);
+        _map = NULL;
+        _channels = 0;
+        _samplerate = 0;
+        _frames = 0;
+    }
+
+    /// is a soundfile open?
+    bool isValid() const {return _map != NULL;}
+
+    /// get the number of channels
+    int numChannels() const {return _channels;}
+
+    /// get the file's sample rate
+    int sampleRate() const {return _samplerate;}
+
+    /// get the number of sample frames
+    size_t numFrames() const {return _frames;}
+
+    /// copy len frames starting at frame offset into dest as interleaved
+    /// samples, dest must hold len * numChannels() floats
+    ///
+    /// frames past the end of the file or not paged in yet are zeroed
+    ///
+    /// returns the number of frames read from the file
+    size_t read(float *dest, size_t offset, size_t len) const {
+        if(_map == NULL) {
+            return 0;
+        }
+        return libpd_soundmap_read(_map, offset, len, dest);
+    }
+
+    /// page in len frames starting at frame offset, waiting for the disk
+    ///
+    /// note: blocks, so do not call this from the audio thread
+    void prefetch(size_t offset, size_t len) {
+        if(_map == NULL) {
+            return;
+        }
+        libpd_soundmap_prefetch(_map, offset, len);
+    }
+
+private:
+
+    friend class PdBase;
+
+    // maps own the mapping, so they cannot be copied
+    SoundFileMap(const SoundFileMap &from);
+    void operator=(const SoundFileMap &from);
+
+    struct _soundmap *_map; ///< mapped soundfile
+    int _channels;          ///< number of channels
+    int _samplerate;        ///< sample rate
+    size_t _frames;         ///< number of sample frames
+};
+
 /// a Pure Data instance
 ///
 /// use this class directly or extend it and any of its virtual functions
@@ -67,6 +290,8 @@ public:
         midiReceiver = NULL;
         bInited = false;
         bQueued = false;
+        symbolsCreated = 0;
+        symbolStatsTime = std::chrono::steady_clock::now();
         libpd_init();
         #ifdef PDINSTANCE
             instance = libpd_new_instance();
@@ -113,7 +338,7 @@ public:
     ///
     virtual bool init(const int numInChannels, const int numOutChannels,
                       const int sampleRate, bool queued=false) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
 
         // attach callbacks
         bQueued = queued;
@@ -242,6 +467,78 @@ public:
         libpd_clear_search_path();
     }
 
+    /// rescan the search path for abstractions and externals
+    ///
+    /// directory listings are cached when objects are first looked up, so
+    /// call this after adding files to a search path folder outside of pd
+    ///
+    virtual void rescanSearchPath() {
+        PDBASE_SETINSTANCE
+        libpd_rescan_search_path();
+    }
+
+    /// clear cached abstractions so new instances read their files again
+    ///
+    /// abstractions are parsed once and then copied for each instance, files
+    /// changed on disk are noticed by their modification time
+    ///
+    /// takes a full path, a file name (ie. "voice.pd") to match that file in
+    /// any folder, or an empty string to clear all
+    ///
+    virtual void clearAbstractionCache(const std::string &path="") {
+        PDBASE_SETINSTANCE
+        libpd_clear_abstraction_cache(path.c_str());
+    }
+
+/// \section Symbols
+
+    /// get symbol table statistics
+    ///
+    /// the creation rate is measured since the previous call or, for the
+    /// first call, since this object was created; a steady rate means the
+    /// symbol table keeps growing, ie. when sending unique symbols
+    ///
+    virtual pd::SymbolStats symbolStats() {
+        PDBASE_SETINSTANCE_OR(pd::SymbolStats())
+        pd::SymbolStats stats;
+        libpd_symbol_stats(&stats.count, &stats.bytes, &stats.created,
+                           &stats.transient);
+        std::chrono::steady_clock::time_point now =
+            std::chrono::steady_clock::now();
+        double secs =
+            std::chrono::duration<double>(now - symbolStatsTime).count();
+        if(secs > 0) {
+            stats.creationRate =
+                (double)(stats.created - symbolsCreated) / secs;
+        }
+        symbolsCreated = stats.created;
+        symbolStatsTime = now;
+        return stats;
+    }
+
+    /// make symbols sent with sendSymbol() and in lists and messages
+    /// transient, so they can be retired with collectSymbols(),
+    /// default: false
+    ///
+    /// note: objects like [symbol] or [list store] may still keep retired
+    ///       symbols, so their memory is only freed once no patch is open,
+    ///       see libpd_set_transient_symbols()
+    ///
+    virtual void setTransientSymbols(bool transient) {
+        PDBASE_SETINSTANCE
+        libpd_set_transient_symbols(transient ? 1 : 0);
+    }
+
+    /// retire transient symbols which are no longer in use, freeing the
+    /// retired ones if no patch is open, returns how many were retired
+    ///
+    /// call this from the processing thread between ticks
+    ///
+    virtual int collectSymbols() {
+        PDBASE_SETINSTANCE_OR(0)
+        return libpd_collect_symbols();
+    }
+
 /// \section Opening Patches
 
     /// open a patch file (aka somefile.pd) at a specified parent dir path
@@ -255,7 +552,7 @@ public:
     ///     }
     virtual pd::Patch openPatch(const std::string &patch,
                                 const std::string &path) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(pd::Patch())
         // [; pd open file folder(
         void *handle = libpd_openfile(patch.c_str(), path.c_str());
         if(handle == NULL) {
@@ -305,6 +602,83 @@ public:
         patch.clear();
     }
 
+    /// suspend a patch, takes a patch object
+    ///
+    /// the patch stays loaded but is cut off: it receives no messages, its
+    /// timers stop and it is left out of audio processing, until resumed
+    /// this is much faster than closing and reopening it, so many scenes
+    /// can be kept ready and switched between
+    ///
+    /// returns true on success
+    virtual bool suspendPatch(pd::Patch &patch) {
+        if(!patch.isValid()) {
+            return false;
+        }
+        PDBASE_SETINSTANCE_OR(false)
+        return libpd_suspendfile(patch.handle()) == 0;
+    }
+
+    /// resume a suspended patch, takes a patch object
+    /// timers continue with the time they had left
+    /// returns true on success
+    virtual bool resumePatch(pd::Patch &patch) {
+        if(!patch.isValid()) {
+            return false;
+        }
+        PDBASE_SETINSTANCE_OR(false)
+        return libpd_resumefile(patch.handle()) == 0;
+    }
+
+    /// is a patch suspended?
+    virtual bool isPatchSuspended(pd::Patch &patch) {
+        if(!patch.isValid()) {
+            return false;
+        }
+        PDBASE_SETINSTANCE_OR(false)
+        return libpd_issuspended(patch.handle()) != 0;
+    }
+
+    /// convert a patch file to the compiled ".pdc" format, which opens
+    /// faster as it needs no parsing, ie. for slow storage:
+    ///
+    ///     pd.compilePatch("main.pd", "/some/dir/path/"); // -> main.pdc
+    ///     pd::Patch p = pd.openPatch("main.pdc", "/some/dir/path/");
+    ///
+    /// openPatch() takes either kind of file and abstractions are also
+    /// found as "name.pdc" if there is no "name.pd"
+    ///
+    /// outPatch is relative to path unless absolute, default: the patch
+    /// name with a ".pdc" extension
+    ///
+    /// returns true on success
+    virtual bool compilePatch(const std::string &patch,
+                              const std::string &path,
+                              const std::string &outPatch = "") {
+        PDBASE_SETINSTANCE_OR(false)
+        return libpd_compilefile(patch.c_str(), path.c_str(),
+                                 outPatch.c_str()) == 0;
+    }
+
+    /// set the number of threads used to read patch files, default: 0 (off)
+    ///
+    /// when on, openPatch() first reads and parses the patch and the
+    /// abstractions it uses in parallel, then creates the objects; this
+    /// pays off for big patches with many abstractions on slow storage
+    ///
+    virtual void setLoadThreads(int threads) {
+        PDBASE_SETINSTANCE
+        libpd_set_load_threads(threads);
+    }
+
+    /// get the time spent in each phase of the last openPatch()
+    virtual pd::LoadTimes loadTimes() {
+        PDBASE_SETINSTANCE_OR(pd::LoadTimes())
+        pd::LoadTimes times;
+        libpd_load_times(&times.prefetch, &times.build, &times.loadbang,
+                         &times.files);
+        return times;
+    }
+
 /// \section Audio Processing
 ///
 /// one of these must be called for audio dsp and message io to occur
@@ -320,42 +694,42 @@ public:
     /// process float buffers for a given number of ticks
     /// returns false on error
     bool processFloat(int ticks, const float *inBuffer, float *outBuffer) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
         return libpd_process_float(ticks, inBuffer, outBuffer) == 0;
     }
 
     /// process short buffers for a given number of ticks
     /// returns false on error
     bool processShort(int ticks, const short *inBuffer, short *outBuffer) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
         return libpd_process_short(ticks, inBuffer, outBuffer) == 0;
     }
 
     /// process double buffers for a given number of ticks
     /// returns false on error
     bool processDouble(int ticks, const double *inBuffer, double *outBuffer) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
         return libpd_process_double(ticks, inBuffer, outBuffer) == 0;
     }
 
     /// process one pd tick, writes raw float data to/from buffers
     /// returns false on error
     bool processRaw(const float *inBuffer, float *outBuffer) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
         return libpd_process_raw(inBuffer, outBuffer) == 0;
     }
 
     /// process one pd tick, writes raw short data to/from buffers
     /// returns false on error
     bool processRawShort(const short *inBuffer, short *outBuffer) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
         return libpd_process_raw_short(inBuffer, outBuffer) == 0;
     }
 
     /// process one pd tick, writes raw double data to/from buffers
     /// returns false on error
     bool processRawDouble(const double *inBuffer, double *outBuffer) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
         return libpd_process_raw_double(inBuffer, outBuffer) == 0;
     }
 
@@ -414,7 +788,7 @@ public:
 
     /// is a pd send source subscribed?
     virtual bool exists(const std::string &source) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
         if(sources.find(source) != sources.end()) {
             return true;
         }
@@ -682,6 +1056,79 @@ public:
         finishMessage(dest, msg);
     }
 
+/// \section Sending Bulk Lists
+///
+/// send a whole list of floats at once without building it element by
+/// element, the list is converted in one pass and delivered with a single
+/// lock:
+///
+///     std::vector<float> values(256);
+///     pd.sendList("test", values);
+///
+/// for repeated sends, intern the destination once:
+///
+///     pd::Interned test = pd.intern("test");
+///     pd.sendList(test, values);
+///
+/// pre-built atom buffers with interned symbols can be resent as is:
+///
+///     t_atom v[2];
+///     libpd_set_interned(v, pd.intern("hello").handle());
+///     libpd_set_float(v + 1, 1.23);
+///     pd.sendList(test, 2, v);
+///
+
+    /// intern a name once for use with the bulk list sends,
+    /// returns an invalid handle on failure
+    virtual pd::Interned intern(const std::string &name) {
+        PDBASE_SETINSTANCE_OR(pd::Interned())
+        void *handle = libpd_intern(name.c_str());
+        return handle ? pd::Interned(name, handle) : pd::Interned();
+    }
+
+    /// send an array of floats as a list
+    virtual void sendList(const std::string &dest,
+                          const float *values, int count) {
+        PDBASE_SETINSTANCE
+        libpd_floatlist(dest.c_str(), count, values);
+    }
+
+    /// send a vector of floats as a list
+    virtual void sendList(const std::string &dest,
+                          const std::vector<float> &values) {
+        PDBASE_SETINSTANCE
+        libpd_floatlist(dest.c_str(), (int)values.size(), values.data());
+    }
+
+    /// send an array of floats as a list to an interned destination
+    virtual void sendList(const pd::Interned &dest,
+                          const float *values, int count) {
+        if(!dest.isValid()) {
+            std::cerr << "Pd: cannot send list, destination not interned"
+                      << std::endl;
+            return;
+        }
+        PDBASE_SETINSTANCE
+        libpd_floatlist_to(dest.handle(), count, values);
+    }
+
+    /// send a vector of floats as a list to an interned destination
+    virtual void sendList(const pd::Interned &dest,
+                          const std::vector<float> &values) {
+        sendList(dest, values.data(), (int)values.size());
+    }
+
+    /// send a pre-built atom buffer as a list to an interned destination
+    virtual void sendList(const pd::Interned &dest, int argc, t_atom *argv) {
+        if(!dest.isValid()) {
+            std::cerr << "Pd: cannot send list, destination not interned"
+                      << std::endl;
+            return;
+        }
+        PDBASE_SETINSTANCE
+        libpd_list_to(dest.handle(), argc, argv);
+    }
+
 /// \section Sending MIDI
 ///
 /// any out of range messages will be silently ignored
@@ -1010,7 +1457,7 @@ public:
     /// get the size of a pd array
     /// returns 0 if array not found
     int arraySize(const std::string &name) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(0)
         int len = libpd_arraysize(name.c_str());
         if(len < 0) {
             std::cerr << "Pd: cannot get size of unknown array \""
@@ -1024,7 +1471,7 @@ public:
     /// sizes <= 0 are clipped to 1
     /// returns true on success, false on failure
     bool resizeArray(const std::string &name, long size) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
         int ret = libpd_resize_array(name.c_str(), size);
         if(ret < 0) {
             std::cerr << "Pd: cannot resize unknown array \"" << name << "\""
@@ -1048,7 +1495,7 @@ public:
     virtual bool readArray(const std::string &name,
                            std::vector<float> &dest,
                            int readLen=-1, int offset=0) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
         int len = libpd_arraysize(name.c_str());
         if(len < 0) {
             std::cerr << "Pd: cannot read unknown array \"" << name << "\""
@@ -1092,7 +1539,7 @@ public:
     virtual bool writeArray(const std::string &name,
                             std::vector<float> &source,
                             int writeLen=-1, int offset=0) {
-        PDBASE_SETINSTANCE
+        PDBASE_SETINSTANCE_OR(false)
         int len = libpd_arraysize(name.c_str());
         if(len < 0) {
             std::cerr << "Pd: cannot write to unknown array \"" << name << "\""
@@ -1130,19 +1577,252 @@ public:
 
     /// clear array and set to a specific value
     virtual void clearArray(const std::string &name, int value=0) {
-        PDBASE_SETINSTANCE
-        int len = libpd_arraysize(name.c_str());
-        if(len < 0) {
+        pd::ArrayView view;
+        if(!openArray(name, view)) {
             std::cerr << "Pd: cannot clear unknown array \""
                       << name << "\"" << std::endl;
             return;
         }
-        std::vector<float> array;
-        array.resize(len, value);
-        if(libpd_write_array(name.c_str(), 0, &array[0], len) < 0) {
-            std::cerr << "Pd: libpd_write_array failed while clearing array \""
-                      << name << "\"" << std::endl;
+        view.fill(value);
+    }
+
+    /// open a view for direct, zero-copy access to a pd array
+    ///
+    /// the pd instance stays locked until the view is closed or destroyed,
+    /// see pd::ArrayView for details
+    ///
+    /// returns true on success, false if the array is unknown or not a plain
+    /// float array
+    ///
+    ///     pd::ArrayView view;
+    ///     if(pd.openArray("array1", view)) {
+    ///         view.read(&samples[0], 0, view.size());
+    ///     }
+    ///
+    bool openArray(const std::string &name, pd::ArrayView &view) {
+        view.close();
+        PDBASE_SETINSTANCE_OR(false)
+        t_word *vec;
+        int size;
+        if(libpd_array_acquire(name.c_str(), &vec, &size) < 0) {
+            return false;
         }
+        view._vec = vec;
+        view._size = size;
+        view._instance = instancePtr();
+        pd::ArrayView::openInstances().push_back(view._instance);
+        return true;
+    }
+
+/// \section Sound Files
+
+    /// map an uncompressed soundfile into memory for random access
+    ///
+    /// relative paths are found using the pd search path,
+    /// see pd::SoundFileMap for details
+    ///
+    /// returns true on success, false if the file could not be opened or is
+    /// not a supported soundfile
+    bool openSoundFile(const std::string &path, pd::SoundFileMap &map) {
+        map.close();
+        PDBASE_SETINSTANCE_OR(false)
+        struct _soundmap *m = libpd_soundmap_open(path.c_str());
+        if(m == NULL) {
+            std::cerr << "Pd: could not open soundfile \""
+                      << path << "\"" << std::endl;
+            return false;
+        }
+        map._map = m;
+        libpd_soundmap_info(m, &map._channels, &map._samplerate, &map._frames);
+        return true;
+    }
+
+    /// read soundfiles into arrays in the background without blocking pd
+    ///
+    /// files[i] is read into channels arrays starting at arrays[i * channels],
+    /// which are resized to fit; relative paths use the pd search path
+    ///
+    /// the arrays are filled while processing: progress is sent to the
+    /// receiver as "progress ndone nfiles" after each file and completion as
+    /// "done nread nfailed", so subscribe to it first to know when the arrays
+    /// are ready
+    ///
+    /// returns true if the batch was started, false on bad arguments
+    bool readSoundFiles(const std::string &receiver,
+                        const std::vector<std::string> &files,
+                        const std::vector<std::string> &arrays,
+                        int channels=1) {
+        if(channels < 1 || files.empty() ||
+           arrays.size() != files.size() * channels) {
+            std::cerr << "Pd: readSoundFiles: need " << channels
+                      << " array name(s) per file" << std::endl;
+            return false;
+        }
+        std::vector<const char *> f(files.size()), a(arrays.size());
+        for(std::size_t i = 0; i < files.size(); ++i)
+            f[i] = files[i].c_str();
+        for(std::size_t i = 0; i < arrays.size(); ++i)
+            a[i] = arrays[i].c_str();
+        PDBASE_SETINSTANCE_OR(false)
+        return libpd_read_soundfiles(receiver.c_str(), channels,
+            (int)files.size(), &f[0], &a[0]) == 0;
+    }
+
+    /// make readsf~ and writesf~ wait for the disk when their buffers run
+    /// dry instead of dropping blocks, for processing faster than realtime
+    /// (writesf~ only drops blocks after a "wait 0" message anyway)
+    ///
+    /// note: this applies to all instances
+    void setSoundFileWait(bool wait) {
+        libpd_set_soundfile_wait((int)wait);
+    }
+
+    /// get the number of blocks readsf~ and writesf~ have dropped because
+    /// their buffers ran dry (or full), optionally resetting the count
+    int soundFileUnderruns(bool reset=false) {
+        return libpd_soundfile_underruns((int)reset);
+    }
+
+/// \section Offline Rendering
+
+    /// render a patch into a soundfile as fast as possible, see pd::RenderJob
+    ///
+    /// the patch is opened, processed with dsp on for the job's duration
+    /// while the inputs are streamed into [adc~] and the timed messages are
+    /// sent, then closed again; the output is written as it is processed,
+    /// so long renders don't need to fit in memory
+    ///
+    /// renders on separate PdBase instances can run in parallel on separate
+    /// threads when libpd is compiled with PDINSTANCE
+    ///
+    /// note: the audio settings are changed to match the job, so call init()
+    ///       again before processing this instance in realtime, and if the
+    ///       patch uses [readsf~] or [writesf~], call setSoundFileWait(true)
+    ///       first so they don't drop blocks
+    ///
+    /// returns true on success, false if a file could not be opened or
+    /// written or the patch could not be opened
+    virtual bool render(const pd::RenderJob &job) {
+        if(job.outChannels < 1 || job.ticksPerBuffer < 1 ||
+           job.duration < 0) {
+            std::cerr << "Pd: render: bad channels, ticks, or duration"
+                      << std::endl;
+            return false;
+        }
+        PDBASE_SETINSTANCE_OR(false)
+
+        // inputs, in [adc~] channel order
+        std::vector<struct _soundstream *> inputs;
+        std::vector<int> inputChannels;
+        int numIn = 0, sampleRate = job.sampleRate;
+        for(std::size_t i = 0; i < job.inputs.size(); ++i) {
+            struct _soundstream *s =
+                libpd_soundstream_open(job.inputs[i].c_str());
+            if(s == NULL) {
+                std::cerr << "Pd: render: could not open input \""
+                          << job.inputs[i] << "\"" << std::endl;
+                closeStreams(inputs);
+                return false;
+            }
+            int channels, rate;
+            libpd_soundstream_info(s, &channels, &rate, NULL);
+            if(sampleRate == 0) {
+                sampleRate = rate;
+            }
+            else if(rate != sampleRate) {
+                std::cerr << "Pd: render: input \"" << job.inputs[i]
+                          << "\" is " << rate << " Hz, not resampled"
+                          << std::endl;
+            }
+            inputs.push_back(s);
+            inputChannels.push_back(channels);
+            numIn += channels;
+        }
+        if(sampleRate == 0) {
+            sampleRate = 44100;
+        }
+
+        struct _soundstream *output = libpd_soundstream_create(
+            job.output.c_str(), job.outChannels, sampleRate,
+            job.bytesPerSample);
+        if(output == NULL) {
+            std::cerr << "Pd: render: could not create output \""
+                      << job.output << "\"" << std::endl;
+            closeStreams(inputs);
+            return false;
+        }
+        libpd_init_audio(numIn, job.outChannels, sampleRate);
+        pd::Patch patch = openPatch(job.patch, job.path);
+        if(!patch.isValid()) {
+            std::cerr << "Pd: render: could not open patch \""
+                      << job.patch << "\"" << std::endl;
+            closeStreams(inputs);
+            libpd_soundstream_close(output);
+            return false;
+        }
+
+        // timed messages in order, keeping the order they were added
+        std::vector<pd::RenderJob::Event> events(job.events);
+        std::stable_sort(events.begin(), events.end(), eventBefore);
+
+        const int block = blockSize();
+        const double ticksPerMs = sampleRate / (1000.0 * block);
+        const long frames = (long)(job.duration * sampleRate / 1000.0 + 0.5);
+        std::vector<float> inBuffer(numIn * block * job.ticksPerBuffer + 1);
+        std::vector<float> outBuffer(job.outChannels * block *
+                                     job.ticksPerBuffer);
+        std::size_t next = 0;
+        long tick = 0, done = 0;
+        bool ok = true;
+        computeAudio(true);
+        while(done < frames) {
+
+            // send the messages due by this tick
+            while(next < events.size() &&
+                  eventTick(events[next], ticksPerMs) <= tick) {
+                sendMessage(events[next].dest, events[next].msg,
+                            events[next].list);
+                ++next;
+            }
+
+            // process up to the next message, the buffer size, or the end
+            long ticks = (frames - done + block - 1) / block;
+            if(ticks > job.ticksPerBuffer) {
+                ticks = job.ticksPerBuffer;
+            }
+            if(next < events.size() &&
+               eventTick(events[next], ticksPerMs) - tick < ticks) {
+                ticks = eventTick(events[next], ticksPerMs) - tick;
+            }
+            for(std::size_t i = 0, ch = 0; i < inputs.size(); ++i) {
+                libpd_soundstream_read(inputs[i], &inBuffer[ch],
+                                       ticks * block, numIn);
+                ch += inputChannels[i];
+            }
+            processFloat((int)ticks, &inBuffer[0], &outBuffer[0]);
+            long nframes = std::min(ticks * block, frames - done);
+            if(libpd_soundstream_write(output, &outBuffer[0], nframes) < 0) {
+                std::cerr << "Pd: render: could not write output \""
+                          << job.output << "\"" << std::endl;
+                ok = false;
+                break;
+            }
+            done += nframes;
+            tick += ticks;
+            if(bQueued) {
+                receiveMessages();
+                receiveMidi();
+            }
+        }
+        computeAudio(false);
+        closePatch(patch);
+        closeStreams(inputs);
+        if(libpd_soundstream_close(output) < 0) {
+            std::cerr << "Pd: render: could not finish output \""
+                      << job.output << "\"" << std::endl;
+            ok = false;
+        }
+        return ok;
     }
 
 /// \section Utils
@@ -1223,6 +1903,27 @@ protected:
     bool bInited; ///< is this pd instance inited?
     bool bQueued; ///< is this instance using the libpd_queued ringbuffer?
 
+    std::size_t symbolsCreated; ///< symbols created at the last symbolStats()
+    std::chrono::steady_clock::time_point symbolStatsTime; ///< and its time
+
+    // render helpers
+    static bool eventBefore(const pd::RenderJob::Event &a,
+                            const pd::RenderJob::Event &b) {
+        return a.time < b.time;
+    }
+
+    // first tick starting at or after the event's time
+    static long eventTick(const pd::RenderJob::Event &e, double ticksPerMs) {
+        return e.time > 0 ? (long)std::ceil(e.time * ticksPerMs - 1e-9) : 0;
+    }
+
+    static void closeStreams(std::vector<struct _soundstream *> &streams) {
+        for(std::size_t i = 0; i < streams.size(); ++i) {
+            libpd_soundstream_close(streams[i]);
+        }
+        streams.clear();
+    }
+
     // libpd static callback functions
     static void _print(const char *s) {
         PdBase *base = (PdBase *)libpd_get_instancedata();
@@ -321,6 +321,38 @@ private:
     std::vector<MsgObject> objects; ///< list objects
 };
 
+/// a name interned once by PdBase::intern() for repeated bulk sends
+///
+/// use it as the destination of PdBase::sendList() to skip the receiver
+/// lookup, or write it into a pre-built atom buffer with libpd_set_interned()
+///
+/// note: only valid for the pd instance it was interned in
+class Interned {
+
+public:
+
+    Interned() : _handle(NULL) {}
+
+    /// the interned name
+    const std::string& name() const {return _name;}
+
+    /// opaque libpd symbol handle, see libpd_set_interned()
+    void* handle() const {return _handle;}
+
+    /// is the handle set?
+    bool isValid() const {return _handle != NULL;}
+
+private:
+
+    Interned(const std::string &name, void *handle) :
+        _handle(handle), _name(name) {}
+
+    void *_handle;     ///< libpd symbol pointer
+    std::string _name; ///< interned name
+
+    friend class PdBase;
+};
+
 /// start a compound message
 struct StartMessage {
     explicit StartMessage() {}
@@ -449,4 +481,128 @@ struct Finish {
     explicit Finish() {}
 };
 
+/// \section Offline Rendering
+
+/// a patch to render offline into a soundfile with PdBase::render()
+///
+/// input soundfiles feed [adc~] in order: the channels of the first file,
+/// then those of the second, and so on; messages are sent at their time in
+/// ms from the start of the render
+///
+///     pd::RenderJob job("synth.pd", "/path/to/patches", "out.wav", 10000);
+///     job.addInput("voice.wav");         // [adc~ 1 2] if stereo
+///     job.addFloat(0, "cutoff", 800);
+///     job.addFloat(2500, "cutoff", 1200);
+///     job.addBang(9000, "fadeout");
+///     if(!pd.render(job)) {
+///         std::cout << "aww ... the render failed" << std::endl;
+///     }
+///
+/// note: like messages sent while processing in realtime, timed messages
+///       take effect at the start of the first dsp block (64 samples) at or
+///       after their time
+class RenderJob {
+
+public:
+
+    /// a message sent at a given time
+    struct Event {
+        double time;      ///< time in ms from the start of the render
+        std::string dest; ///< dest receiver name
+        std::string msg;  ///< message selector, ie. "float" or "list"
+        List list;        ///< message arguments
+    };
+
+    std::string patch;  ///< patch filename
+    std::string path;   ///< parent dir path of the patch
+    std::string output; ///< output soundfile, type by extension (wave default)
+    double duration;    ///< length of the render in ms
+    int outChannels;    ///< number of output channels, default: 2
+    int sampleRate;     ///< sample rate, default 0: that of the first input
+                        ///< or 44100 without inputs
+    int bytesPerSample; ///< output sample size: 2, 3, or 4 (float), default: 2
+    int ticksPerBuffer; ///< ticks processed between file reads & writes,
+                        ///< default: 64 (4096 samples)
+
+    std::vector<std::string> inputs; ///< input soundfiles
+    std::vector<Event> events;       ///< timed messages
+
+    RenderJob(const std::string &patch, const std::string &path,
+              const std::string &output, double duration) :
+        patch(patch), path(path), output(output), duration(duration),
+        outChannels(2), sampleRate(0), bytesPerSample(2),
+        ticksPerBuffer(64) {}
+
+    /// add an input soundfile, relative paths use the pd search path
+    void addInput(const std::string &file) {
+        inputs.push_back(file);
+    }
+
+    /// send a bang at a given time in ms
+    void addBang(double time, const std::string &dest) {
+        addMessage(time, dest, "bang");
+    }
+
+    /// send a float at a given time in ms
+    void addFloat(double time, const std::string &dest, float num) {
+        List list;
+        list.addFloat(num);
+        addMessage(time, dest, "float", list);
+    }
+
+    /// send a symbol at a given time in ms
+    void addSymbol(double time, const std::string &dest,
+                   const std::string &symbol) {
+        List list;
+        list.addSymbol(symbol);
+        addMessage(time, dest, "symbol", list);
+    }
+
+    /// send a list at a given time in ms
+    void addList(double time, const std::string &dest, const List &list) {
+        addMessage(time, dest, "list", list);
+    }
+
+    /// send a typed message at a given time in ms
+    ///
+    /// messages for the same time are sent in the order they were added
+    void addMessage(double time, const std::string &dest,
+                    const std::string &msg, const List &list=List()) {
+        Event e;
+        e.time = time;
+        e.dest = dest;
+        e.msg = msg;
+        e.list = list;
+        events.push_back(e);
+    }
+};
+
+/// \section Patch Loading
+
+/// time spent opening a patch, returned by PdBase::loadTimes()
+struct LoadTimes {
+
+    double prefetch;  ///< ms reading files beforehand, see PdBase::setLoadThreads()
+    double build;     ///< ms creating and connecting objects
+    double loadbang;  ///< ms sending loadbang
+    int files;        ///< number of files prefetched
+
+    LoadTimes() : prefetch(0), build(0), loadbang(0), files(0) {}
+};
+
+/// \section Symbol Table
+
+/// symbol table statistics returned by PdBase::symbolStats()
+struct SymbolStats {
+
+    int count;            ///< number of symbols
+    std::size_t bytes;    ///< memory used by symbols and the table
+    std::size_t created;  ///< symbols created so far
+    int transient;        ///< symbols which may be collected
+    double creationRate;  ///< symbols created per second since last call
+
+    SymbolStats() :
+        count(0), bytes(0), created(0), transient(0), creationRate(0) {}
+};
+
 } // namespace
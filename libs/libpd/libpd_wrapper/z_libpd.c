@@ -22,6 +22,7 @@
 #include "z_hooks.h"
 #include "m_imp.h"
 #include "g_all_guis.h"
+#include "d_soundfile.h"
 
 // pd_init() doesn't call socket_init() which is needed on windows for
 // libpd_start_gui() to work
@@ -126,15 +127,56 @@ void libpd_clear_search_path(void) {
   sys_lock();
   namelist_free(STUFF->st_searchpath);
   STUFF->st_searchpath = NULL;
+  sys_flushdirindex();
   sys_unlock();
 }
 
 void libpd_add_to_search_path(const char *path) {
   sys_lock();
   STUFF->st_searchpath = namelist_append(STUFF->st_searchpath, path, 0);
+  sys_flushdirindex();
   sys_unlock();
 }
 
+void libpd_rescan_search_path(void) {
+  sys_lock();
+  sys_flushdirindex();
+  sys_unlock();
+}
+
+void libpd_clear_abstraction_cache(const char *path) {
+  sys_lock();
+  binbuf_flushtemplates(path && *path ? gensym(path) : NULL);
+  sys_unlock();
+}
+
+void libpd_symbol_stats(int *count, size_t *bytes, size_t *created,
+    int *transient) {
+  int n, t;
+  size_t b, c;
+  sys_lock();
+  symtab_getstats(&n, &b, &c, &t);
+  sys_unlock();
+  if (count) *count = n;
+  if (bytes) *bytes = b;
+  if (created) *created = c;
+  if (transient) *transient = t;
+}
+
+void libpd_set_transient_symbols(int flag) {
+  sys_lock();
+  symtab_settransient(flag);
+  sys_unlock();
+}
+
+int libpd_collect_symbols(void) {
+  int n;
+  sys_lock();
+  n = symtab_collect();
+  sys_unlock();
+  return n;
+}
+
 void *libpd_openfile(const char *name, const char *dir) {
   void *retval;
   sys_lock();
@@ -145,12 +187,83 @@ void *libpd_openfile(const char *name, const char *dir) {
   return retval;
 }
 
+int libpd_compilefile(const char *name, const char *dir,
+    const char *outname) {
+  char outpath[MAXPDSTRING];
+  t_binbuf *b;
+  int ret;
+  if (outname && *outname) {
+    if (sys_isabsolutepath(outname) || !*dir)
+      snprintf(outpath, MAXPDSTRING, "%s", outname);
+    else
+      snprintf(outpath, MAXPDSTRING, "%s/%s", dir, outname);
+  } else {
+    size_t len = strlen(name);
+    const char *ext = (len > 3 && !strcmp(name + len - 3, ".pd")) ?
+      "c" : ".pdc";
+    if (*dir)
+      snprintf(outpath, MAXPDSTRING, "%s/%s%s", dir, name, ext);
+    else
+      snprintf(outpath, MAXPDSTRING, "%s%s", name, ext);
+  }
+  sys_lock();
+  b = binbuf_new();
+  ret = binbuf_read(b, name, dir, 0);
+  if (!ret)
+    ret = binbuf_write_compiled(b, outpath);
+  binbuf_free(b);
+  sys_unlock();
+  return ret ? -1 : 0;
+}
+
+void libpd_set_load_threads(int nthreads) {
+  sys_lock();
+  STUFF->st_loadthreads = (nthreads > 0 ? nthreads : 0);
+  sys_unlock();
+}
+
+void libpd_load_times(double *prefetch, double *build,
+    double *loadbang, int *nfiles) {
+  t_loadtimes lt;
+  sys_lock();
+  lt = STUFF->st_loadtimes;
+  sys_unlock();
+  if (prefetch) *prefetch = lt.lt_prefetch;
+  if (build) *build = lt.lt_build;
+  if (loadbang) *loadbang = lt.lt_loadbang;
+  if (nfiles) *nfiles = lt.lt_nfiles;
+}
+
 void libpd_closefile(void *p) {
   sys_lock();
   pd_free((t_pd *)p);
   sys_unlock();
 }
 
+int libpd_suspendfile(void *p) {
+  int ret;
+  sys_lock();
+  ret = canvas_suspend((t_canvas *)p);
+  sys_unlock();
+  return ret ? 0 : -1;
+}
+
+int libpd_resumefile(void *p) {
+  int ret;
+  sys_lock();
+  ret = canvas_resume((t_canvas *)p);
+  sys_unlock();
+  return ret ? 0 : -1;
+}
+
+int libpd_issuspended(void *p) {
+  int ret;
+  sys_lock();
+  ret = canvas_issuspended((t_canvas *)p);
+  sys_unlock();
+  return ret;
+}
+
 int libpd_getdollarzero(void *p) {
   sys_lock();
   pd_pushsym((t_pd *)p);
@@ -176,9 +289,13 @@ int libpd_init_audio(int inChannels, int outChannels, int sampleRate) {
   as.a_advance = -1;
   as.a_api = API_DUMMY;
   sys_lock();
+  // the audio settings are global, keep concurrent instances from
+  // opening with each other's
+  pd_globallock();
   sys_set_audio_settings(&as);
   sched_set_using_audio(SCHED_AUDIO_CALLBACK);
   sys_reopen_audio();
+  pd_globalunlock();
   sys_unlock();
   return 0;
 }
@@ -274,23 +391,83 @@ int libpd_resize_array(const char *name, long size) {
   return 0;
 }
 
-#define MEMCPY(_x, _y) \
+#define GETRANGE \
   GETARRAY \
-  if (n < 0 || offset < 0 || offset + n > garray_npoints(garray)) return -2; \
-  t_word *vec = ((t_word *) garray_vec(garray)) + offset; \
+  if (n < 0 || offset < 0 || offset + n > garray_npoints(garray)) \
+    {sys_unlock(); return -2;} \
+  t_word *vec = ((t_word *) garray_vec(garray)) + offset;
+
+#define MEMCPY(_x, _y) \
+  GETRANGE \
   int i; \
   for (i = 0; i < n; i++) _x = _y;
 
+// t_word is packed float storage when it is the same size as a float,
+// ie. 32 bit builds without PD_FLOATSIZE=64, so bulk copy in that case
+#if PD_FLOATSIZE == 32
+# define WORDS_ARE_FLOATS (sizeof(t_word) == sizeof(float))
+#else
+# define WORDS_ARE_FLOATS 0
+#endif
+
+// otherwise the float is the first half of an 8 byte word on 64 bit builds,
+// which SSE2 packs and unpacks 4 words at a time
+#if PD_FLOATSIZE == 32 && (defined(__SSE2__) || defined(_M_X64) || \
+  (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+# include <emmintrin.h>
+# define WORDS_SSE2
+#endif
+
+void libpd_words_to_floats(float *dest, const t_word *src, int n) {
+  int i = 0;
+  if (WORDS_ARE_FLOATS) {
+    memcpy(dest, src, n * sizeof(float));
+    return;
+  }
+#ifdef WORDS_SSE2
+  if (sizeof(t_word) == 2 * sizeof(float)) {
+    const float *f = (const float *)src;
+    for (; i + 4 <= n; i += 4, f += 8) {
+      __m128 lo = _mm_loadu_ps(f), hi = _mm_loadu_ps(f + 4);
+      _mm_storeu_ps(dest + i, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+    }
+  }
+#endif
+  for (; i < n; i++) dest[i] = src[i].w_float;
+}
+
+void libpd_floats_to_words(t_word *dest, const float *src, int n) {
+  int i = 0;
+  if (WORDS_ARE_FLOATS) {
+    memcpy(dest, src, n * sizeof(float));
+    return;
+  }
+#ifdef WORDS_SSE2
+  if (sizeof(t_word) == 2 * sizeof(float)) {
+    float *f = (float *)dest;
+    __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= n; i += 4, f += 8) {
+      __m128 v = _mm_loadu_ps(src + i);
+      _mm_storeu_ps(f, _mm_unpacklo_ps(v, zero));
+      _mm_storeu_ps(f + 4, _mm_unpackhi_ps(v, zero));
+    }
+  }
+#endif
+  for (; i < n; i++) dest[i].w_float = src[i];
+}
+
 int libpd_read_array(float *dest, const char *name, int offset, int n) {
   sys_lock();
-  MEMCPY(*dest++, (vec++)->w_float)
+  GETRANGE
+  libpd_words_to_floats(dest, vec, n);
   sys_unlock();
   return 0;
 }
 
 int libpd_write_array(const char *name, int offset, const float *src, int n) {
   sys_lock();
-  MEMCPY((vec++)->w_float, *src++)
+  GETRANGE
+  libpd_floats_to_words(vec, src, n);
   sys_unlock();
   return 0;
 }
@@ -309,6 +486,178 @@ int libpd_write_array_double(const char *name, int offset, const double *src, in
   return 0;
 }
 
+int libpd_array_acquire(const char *name, t_word **vec, int *size) {
+  t_garray *garray;
+  sys_lock();
+  garray = (t_garray *)pd_findbyclass(gensym(name), garray_class);
+  if (!garray) {
+    sys_unlock();
+    return -1;
+  }
+  if (!garray_getfloatwords(garray, size, vec)) {
+    sys_unlock();
+    return -2;
+  }
+  return 0; // stays locked until libpd_array_release()
+}
+
+void libpd_array_release(void) {
+  sys_unlock();
+}
+
+void libpd_set_soundfile_wait(int wait) {
+  soundfile_setstreamwait(wait);
+}
+
+int libpd_soundfile_underruns(int reset) {
+  return soundfile_getunderruns(reset);
+}
+
+int libpd_read_soundfiles(const char *receiver, int nchannels,
+  int nfiles, const char **files, const char **arrays) {
+  int argc = nfiles * (nchannels + 1), i, j, ret;
+  t_atom *argv, *ap;
+  if (nchannels < 1 || nfiles < 1) return -1;
+  argv = (t_atom *)getbytes(argc * sizeof(t_atom));
+  sys_lock();
+  for (i = 0, ap = argv; i < nfiles; i++) {
+    SETSYMBOL(ap, gensym(files[i])); ap++;
+    for (j = 0; j < nchannels; j++, ap++)
+      SETSYMBOL(ap, gensym(arrays[i * nchannels + j]));
+  }
+  ret = soundfiler_readbatch(0, gensym(receiver), nchannels, argc, argv);
+  sys_unlock();
+  freebytes(argv, argc * sizeof(t_atom));
+  return ret ? 0 : -1;
+}
+
+t_soundmap *libpd_soundmap_open(const char *path) {
+  t_soundmap *map;
+  sys_lock();
+  map = soundmap_open(NULL, path);
+  sys_unlock();
+  return map;
+}
+
+void libpd_soundmap_close(t_soundmap *map) {
+  soundmap_close(map);
+}
+
+void libpd_soundmap_info(t_soundmap *map, int *nchannels,
+  int *samplerate, size_t *nframes) {
+  if (nchannels) *nchannels = map->sm_sf.sf_nchannels;
+  if (samplerate) *samplerate = map->sm_sf.sf_samplerate;
+  if (nframes) *nframes = map->sm_nframes;
+}
+
+size_t libpd_soundmap_read(t_soundmap *map, size_t onset,
+  size_t nframes, float *dest) {
+#if PD_FLOATSIZE == 32
+  return soundmap_read(map, onset, nframes, (t_sample *)dest);
+#else
+  // convert through a buffer of samples, a run of frames at a time
+  t_sample buf[1024];
+  int nchannels = map->sm_sf.sf_nchannels;
+  size_t run = 1024 / nchannels, nread = 0, n, got, i;
+  while (nframes) {
+    n = (nframes < run ? nframes : run);
+    got = soundmap_read(map, onset, n, buf);
+    for (i = 0; i < n * nchannels; i++)
+      *dest++ = buf[i];
+    nread += got;
+    if (got < n) { // zero the rest without reading further
+      memset(dest, 0, (nframes - n) * nchannels * sizeof(float));
+      break;
+    }
+    onset += n;
+    nframes -= n;
+  }
+  return nread;
+#endif
+}
+
+void libpd_soundmap_prefetch(t_soundmap *map, size_t onset, size_t nframes) {
+  soundmap_prefetch(map, onset, nframes);
+}
+
+t_soundstream *libpd_soundstream_open(const char *path) {
+  t_soundstream *stream;
+  sys_lock();
+  stream = soundstream_open(NULL, path);
+  sys_unlock();
+  return stream;
+}
+
+t_soundstream *libpd_soundstream_create(const char *path,
+  int nchannels, int samplerate, int bytespersample) {
+  return soundstream_create(NULL, path, nchannels, samplerate,
+    bytespersample);
+}
+
+void libpd_soundstream_info(t_soundstream *stream, int *nchannels,
+  int *samplerate, size_t *nframes) {
+  if (nchannels) *nchannels = stream->ss_sf.sf_nchannels;
+  if (samplerate) *samplerate = stream->ss_sf.sf_samplerate;
+  if (nframes) *nframes = stream->ss_nframes;
+}
+
+#if PD_FLOATSIZE == 32
+
+size_t libpd_soundstream_read(t_soundstream *stream, float *dest,
+  size_t nframes, int stride) {
+  if (stride < 1) return 0;
+  return soundstream_read(stream, dest, nframes, stride);
+}
+
+int libpd_soundstream_write(t_soundstream *stream, const float *src,
+  size_t nframes) {
+  return soundstream_write(stream, src, nframes) < 0 ? -1 : 0;
+}
+
+#else // convert through a t_sample buffer
+
+#define STREAM_CONVSIZE 4096
+
+size_t libpd_soundstream_read(t_soundstream *stream, float *dest,
+  size_t nframes, int stride) {
+  t_sample buf[STREAM_CONVSIZE];
+  int nchannels = stream->ss_sf.sf_nchannels, ch;
+  size_t chunk, nread = 0, n, i;
+  if (stride < 1) return 0;
+  if (nchannels > stride) nchannels = stride;
+  chunk = STREAM_CONVSIZE / nchannels;
+  while (nframes) {
+    n = (nframes < chunk ? nframes : chunk);
+    nread += soundstream_read(stream, buf, n, nchannels);
+    for (i = 0; i < n; i++, dest += stride)
+      for (ch = 0; ch < nchannels; ch++)
+        dest[ch] = buf[i * nchannels + ch];
+    nframes -= n;
+  }
+  return nread;
+}
+
+int libpd_soundstream_write(t_soundstream *stream, const float *src,
+  size_t nframes) {
+  t_sample buf[STREAM_CONVSIZE];
+  int nchannels = stream->ss_sf.sf_nchannels;
+  size_t chunk = STREAM_CONVSIZE / nchannels, n, i;
+  while (nframes) {
+    n = (nframes < chunk ? nframes : chunk);
+    for (i = 0; i < n * nchannels; i++)
+      buf[i] = *src++;
+    if (soundstream_write(stream, buf, n) < 0) return -1;
+    nframes -= n;
+  }
+  return 0;
+}
+
+#endif
+
+int libpd_soundstream_close(t_soundstream *stream) {
+  return soundstream_close(stream);
+}
+
 int libpd_bang(const char *recv) {
   void *obj;
   sys_lock();
@@ -354,7 +703,7 @@ int libpd_symbol(const char *recv, const char *symbol) {
     sys_unlock();
     return -1;
   }
-  pd_symbol(obj, gensym(symbol));
+  pd_symbol(obj, gensym_transient(symbol));
   sys_unlock();
   return 0;
 }
@@ -387,7 +736,7 @@ void libpd_add_double(double x) {
 void libpd_add_symbol(const char *symbol) {
   t_symbol *x;
   sys_lock();
-  x = gensym(symbol);
+  x = gensym_transient(symbol);
   sys_unlock();
   ADD_ARG(SETSYMBOL);
 }
@@ -426,6 +775,64 @@ int libpd_list(const char *recv, int argc, t_atom *argv) {
   return 0;
 }
 
+// lists up to this long are converted on the stack, longer ones on the heap
+#define LIBPD_LISTSTACK 256
+
+// convert floats to atoms outside of the lock, then send them as a list
+// to sym's binding, or recv's if sym is NULL
+static int floatlist_send(const char *recv, t_symbol *sym,
+  int argc, const float *argv) {
+  t_atom buf[LIBPD_LISTSTACK], *v = buf;
+  t_pd *obj;
+  int i;
+  if (argc > LIBPD_LISTSTACK)
+    v = (t_atom *)getbytes(argc * sizeof(t_atom));
+  for (i = 0; i < argc; i++)
+    SETFLOAT(v + i, argv[i]);
+  sys_lock();
+  obj = (sym ? sym->s_thing : get_object(recv));
+  if (obj != NULL)
+    pd_list(obj, &s_list, argc, v);
+  sys_unlock();
+  if (v != buf)
+    freebytes(v, argc * sizeof(t_atom));
+  return (obj != NULL ? 0 : -1);
+}
+
+int libpd_floatlist(const char *recv, int argc, const float *argv) {
+  return floatlist_send(recv, NULL, argc, argv);
+}
+
+void *libpd_intern(const char *name) {
+  t_symbol *x;
+  sys_lock();
+  x = gensym(name);
+  sys_unlock();
+  return x;
+}
+
+void libpd_set_interned(t_atom *a, void *symbol) {
+  SETSYMBOL(a, (t_symbol *)symbol);
+}
+
+int libpd_list_to(void *recv, int argc, t_atom *argv) {
+  t_pd *obj;
+  sys_lock();
+  obj = ((t_symbol *)recv)->s_thing;
+  if (obj == NULL)
+  {
+    sys_unlock();
+    return -1;
+  }
+  pd_list(obj, &s_list, argc, argv);
+  sys_unlock();
+  return 0;
+}
+
+int libpd_floatlist_to(void *recv, int argc, const float *argv) {
+  return floatlist_send(NULL, (t_symbol *)recv, argc, argv);
+}
+
 int libpd_message(const char *recv, const char *msg, int argc, t_atom *argv) {
   t_pd *obj;
   sys_lock();
@@ -36,6 +36,45 @@ EXTERN void libpd_clear_search_path(void);
 /// unlike desktop pd, *no* search paths are set by default (ie. extra)
 EXTERN void libpd_add_to_search_path(const char *path);
 
+/// forget the cached directory listings used to find abstractions and
+/// externals, so files added to the search paths since they were read are
+/// found; the cache is also reset when the search path changes
+EXTERN void libpd_rescan_search_path(void);
+
+/// forget the parsed contents of an abstraction file so that new instances
+/// read it again, ie. for live reloading
+/// path may be a full path, a file name like "voice.pd" which matches that
+/// file in any folder, or NULL to clear all
+/// note: files changed on disk are noticed by their modification time, this
+///       is for when that is not enough
+EXTERN void libpd_clear_abstraction_cache(const char *path);
+
+/// get symbol table statistics for the current instance: number of symbols,
+/// the memory they use in bytes, the number of symbols created so far, and
+/// how many of them are transient (see below)
+/// pass NULL for values that are not needed
+EXTERN void libpd_symbol_stats(int *count, size_t *bytes, size_t *created,
+  int *transient);
+
+/// turn transient symbols on or off for the current instance, default off
+/// pd never frees symbols, so sending many unique symbols (ie. timestamps or
+/// file names) makes the symbol table grow without bound; when on, symbols
+/// sent by libpd_symbol() and libpd_add_symbol() are transient and may be
+/// retired by libpd_collect_symbols() once they are no longer in use
+/// note: a symbol stays in use while anything is bound to it or while a
+///       message box, object box, or [text]/[qlist]/[textfile] contains it;
+///       objects like [symbol] or [list store] may still keep a retired
+///       symbol, so its memory is only freed once no patch is open, and
+///       sending the same name again brings back the same symbol
+EXTERN void libpd_set_transient_symbols(int flag);
+
+/// retire transient symbols that are no longer in use, taking them out of
+/// the symbol table, and free the retired ones if no patch is open
+/// call this periodically from the thread that calls the process functions,
+/// ie. between ticks and never while building a message
+/// returns the number of symbols retired
+EXTERN int libpd_collect_symbols(void);
+
 /* opening patches */
 
 /// open a patch by filename and parent dir path
@@ -45,10 +84,49 @@ EXTERN void *libpd_openfile(const char *name, const char *dir);
 /// close a patch by patch handle pointer
 EXTERN void libpd_closefile(void *p);
 
+/// suspend a patch by patch handle pointer: it stays loaded but receives
+/// no messages, its timers stop and it is left out of DSP until resumed
+/// returns 0 on success or -1 if it is not a toplevel patch or already
+/// suspended
+EXTERN int libpd_suspendfile(void *p);
+
+/// resume a suspended patch by patch handle pointer, timers continue with
+/// the time they had left
+/// returns 0 on success or -1 if the patch is not suspended
+EXTERN int libpd_resumefile(void *p);
+
+/// returns 1 if the patch handle pointer is suspended, otherwise 0
+EXTERN int libpd_issuspended(void *p);
+
 /// get the $0 id of the patch handle pointer
 /// returns $0 value or 0 if the patch is non-existent
 EXTERN int libpd_getdollarzero(void *p);
 
+/// convert a patch file to the compiled ".pdc" format, which opens faster
+/// since it needs no parsing: libpd_openfile() takes either kind of file,
+/// and abstractions are also found as "name.pdc" if there is no "name.pd"
+/// outname is relative to dir unless absolute, NULL or "" for the input
+/// name with a ".pdc" extension
+/// returns 0 on success or -1 if the file could not be read or written
+EXTERN int libpd_compilefile(const char *name, const char *dir,
+  const char *outname);
+
+/// set the number of threads used to read patch files, default 0 (off)
+/// when on, opening a patch first reads and parses it and the abstractions
+/// it uses, found beside the files using them or in the search path, on
+/// this many threads (including the calling one), so that creating the
+/// objects afterward doesn't wait for files; 1 does this on the calling
+/// thread only; it helps most when files are slow to open, and with verbose
+/// printing on it always uses the calling thread only
+EXTERN void libpd_set_load_threads(int nthreads);
+
+/// get the time in ms spent in each phase of the last libpd_openfile():
+/// prefetching files (0 if off), creating and connecting objects, and
+/// sending loadbang, plus the number of files prefetched
+/// pass NULL for values that are not needed
+EXTERN void libpd_load_times(double *prefetch, double *build,
+  double *loadbang, int *nfiles);
+
 /* audio processing */
 
 /// return pd's fixed block size: the number of sample frames per 1 pd tick
@@ -149,6 +227,123 @@ EXTERN int libpd_read_array_double(double *dest, const char *src,
 EXTERN int libpd_write_array_double(const char *dest, int offset,
     const double *src, int n);
 
+/// get direct access to the live samples of a named float array
+/// on success, vec points to the first element and size is set to the array
+/// length, samples are then read and written in place via vec[i].w_float
+/// note: libpd stays locked until libpd_array_release() is called, so keep the
+///       access short and do not call other libpd functions in between
+/// note: vec is invalid after release as the array may be resized or freed
+/// returns 0 on success or a negative error code if the array is non-existent
+/// or not a plain float array, in which case libpd is not locked
+EXTERN int libpd_array_acquire(const char *name, t_word **vec, int *size);
+
+/// release direct access to an array acquired with libpd_array_acquire()
+EXTERN void libpd_array_release(void);
+
+/// copy n samples from array words, ie. from libpd_array_acquire(), into dest
+/// note: converts 4 samples at a time with SSE2 when words are 8 bytes (64 bit)
+EXTERN void libpd_words_to_floats(float *dest, const t_word *src, int n);
+
+/// copy n samples from src into array words, ie. from libpd_array_acquire()
+/// note: converts 4 samples at a time with SSE2 when words are 8 bytes (64 bit)
+EXTERN void libpd_floats_to_words(t_word *dest, const float *src, int n);
+
+/* reading soundfiles */
+
+/// read soundfiles into arrays in the background without blocking pd,
+/// files[i] is read into arrays[i * nchannels] ... arrays[i * nchannels +
+/// nchannels - 1] which are resized to fit, relative paths use the pd search
+/// path, and files are decoded on worker threads which never lock libpd
+/// the arrays are filled and progress is sent to the receiver as
+/// "progress <ndone> <nfiles>" while processing, completion as
+/// "done <nread> <nfailed>"; a batch still running when the instance is
+/// freed is cancelled
+/// returns 0 if the batch was started or -1 on bad arguments
+EXTERN int libpd_read_soundfiles(const char *receiver, int nchannels,
+  int nfiles, const char **files, const char **arrays);
+
+/* streaming soundfiles */
+
+/// make readsf~ and writesf~ wait for the disk when their buffers run dry
+/// instead of dropping blocks, for processing faster than realtime
+/// (writesf~ only drops blocks after a "wait 0" message anyway)
+/// default: 0, note: this applies to all instances
+EXTERN void libpd_set_soundfile_wait(int wait);
+
+/// get the number of blocks readsf~ and writesf~ have dropped because their
+/// buffers ran dry (or full) in all instances, resetting it to 0 if reset is
+/// nonzero
+EXTERN int libpd_soundfile_underruns(int reset);
+
+/* memory-mapped soundfiles */
+
+/// open an uncompressed soundfile (wave, aiff, caf, or next) for random
+/// access by mapping it into memory, relative paths use the pd search path
+/// note: nothing is loaded up front, the file is paged in as it is read
+///       by a background thread
+/// returns a handle or NULL on failure
+EXTERN struct _soundmap *libpd_soundmap_open(const char *path);
+
+/// close a soundfile opened with libpd_soundmap_open()
+EXTERN void libpd_soundmap_close(struct _soundmap *map);
+
+/// get the number of channels, sample rate, and number of sample frames
+EXTERN void libpd_soundmap_info(struct _soundmap *map, int *nchannels,
+  int *samplerate, size_t *nframes);
+
+/// read nframes starting at frame onset into dest as interleaved floats,
+/// dest must hold nframes * nchannels, frames past the end are zeroed
+/// note: does not lock libpd or wait for the disk and can be called from any
+///       thread: the file is paged in by a background thread which follows
+///       the reads, frames which are not paged in yet are zeroed as well,
+///       see libpd_soundmap_prefetch()
+/// returns the number of frames read from the file
+EXTERN size_t libpd_soundmap_read(struct _soundmap *map, size_t onset,
+  size_t nframes, float *dest);
+
+/// page in nframes starting at frame onset, waiting for the disk, so a
+/// following libpd_soundmap_read() of the range is complete
+/// note: blocks, so do not call this from the audio thread
+EXTERN void libpd_soundmap_prefetch(struct _soundmap *map, size_t onset,
+  size_t nframes);
+
+/* soundfile streams */
+
+/// open a soundfile of any readable type (including flac) to read it from
+/// start to end, relative paths use the pd search path
+/// returns a handle or NULL on failure
+EXTERN struct _soundstream *libpd_soundstream_open(const char *path);
+
+/// create a soundfile to write from start to end, the type follows the file
+/// extension (wave by default) and bytespersample is 2, 3, or 4 (float)
+/// returns a handle or NULL on failure
+EXTERN struct _soundstream *libpd_soundstream_create(const char *path,
+  int nchannels, int samplerate, int bytespersample);
+
+/// get the number of channels, sample rate, and number of sample frames
+/// (frames written so far for a created file)
+EXTERN void libpd_soundstream_info(struct _soundstream *stream,
+  int *nchannels, int *samplerate, size_t *nframes);
+
+/// read the next nframes into dest as interleaved floats spaced stride floats
+/// apart, ie. dest can be a buffer with more channels than the file which
+/// other files fill too: only the file's channels are written and frames
+/// past the end of the file are zeroed
+/// note: does not lock libpd and can be called from any thread
+/// returns the number of frames read from the file
+EXTERN size_t libpd_soundstream_read(struct _soundstream *stream,
+  float *dest, size_t nframes, int stride);
+
+/// append nframes interleaved frames from src to a created file
+/// note: does not lock libpd and can be called from any thread
+/// returns 0 on success or -1 on a write error
+EXTERN int libpd_soundstream_write(struct _soundstream *stream,
+  const float *src, size_t nframes);
+
+/// close a soundfile stream, completing the header of a created file
+/// returns 0 on success or -1 on failure
+EXTERN int libpd_soundstream_close(struct _soundstream *stream);
+
 /* sending messages to pd */
 
 /// send a bang to a destination receiver
@@ -232,6 +427,39 @@ EXTERN void libpd_set_symbol(t_atom *a, const char *symbol);
 ///     libpd_list("foo", 3, v);
 EXTERN int libpd_list(const char *recv, int argc, t_atom *argv);
 
+/// send a float array of a given length as a list to a destination receiver
+/// without building it atom by atom, the floats are converted first and the
+/// list is delivered under a single lock
+/// returns 0 on success or -1 if receiver name is non-existent
+/// ex: send [list 1 2 3( to [r foo] on the next tick with:
+///     float v[3] = {1, 2, 3};
+///     libpd_floatlist("foo", 3, v);
+EXTERN int libpd_floatlist(const char *recv, int argc, const float *argv);
+
+/// intern a symbol once for repeated sends, returns an opaque symbol handle
+/// which stays valid for the lifetime of the current instance
+/// the handle can name a destination for libpd_list_to() and
+/// libpd_floatlist_to() or be written into atoms with libpd_set_interned(),
+/// saving a symbol table lookup per send
+EXTERN void *libpd_intern(const char *name);
+
+/// write a symbol interned by libpd_intern() to the given atom
+EXTERN void libpd_set_interned(t_atom *a, void *symbol);
+
+/// send an atom array as a list to a destination interned by libpd_intern()
+/// returns 0 on success or -1 if nothing is bound to the destination
+/// ex: build a list once and resend it with:
+///     void *foo = libpd_intern("foo");
+///     t_atom v[2];
+///     libpd_set_interned(v, libpd_intern("bar"));
+///     libpd_set_float(v + 1, 1);
+///     libpd_list_to(foo, 2, v);
+EXTERN int libpd_list_to(void *recv, int argc, t_atom *argv);
+
+/// send a float array as a list to a destination interned by libpd_intern()
+/// returns 0 on success or -1 if nothing is bound to the destination
+EXTERN int libpd_floatlist_to(void *recv, int argc, const float *argv);
+
 /// send a atom array of a given length as a typed message to a destination
 /// receiver, returns 0 on success or -1 if receiver name is non-existent
 /// ex: send [; pd dsp 1( on the next tick with:
@@ -9,6 +9,9 @@ to implement the "fft~", etc, Pd objects.  If using Mayer, also compile
 d_fft_mayer.c; if ooura, use d_fft_fftsg.c instead; if fftw, use d_fft_fftw.c
 and also link in the fftw library.  You can only have one of these three
 linked in.  The configure script can be used to select which one.
+
+In libpd, d_fft_fftsg.c and d_fft_simd.c are both compiled, and the
+vectorized d_fft_simd.c package is used unless PD_FFT_FFTSG is defined.
 */
 
 /* ------------------ initialization and cleanup -------------------------- */
@@ -16,6 +19,16 @@ linked in.  The configure script can be used to select which one.
 void mayer_init( void);
 void mayer_term( void);
 
+    /* FFT tables and scratch for one size, kept per Pd instance by the FFT
+    package.  DSP routines look them up once and pass them to the perform
+    routines, so mixing block sizes doesn't make the package rebuild them. */
+typedef struct _fftplan t_fftplan;
+t_fftplan *mayer_getplan(int n);
+void mayer_planfft(t_fftplan *plan, int n, t_sample *fz1, t_sample *fz2,
+    int sgn);
+void mayer_planrealfft(t_fftplan *plan, int n, t_sample *fz);
+void mayer_planrealifft(t_fftplan *plan, int n, t_sample *fz);
+
 static void fftclass_cleanup(t_class *c)
 {
     mayer_term();
@@ -86,8 +99,9 @@ static t_int *sigfft_perform(t_int *w)
     t_sample *in1 = (t_sample *)(w[1]);
     t_sample *in2 = (t_sample *)(w[2]);
     int n = (int)w[3];
-    mayer_fft(n, in1, in2);
-    return (w+4);
+    t_fftplan *plan = (t_fftplan *)(w[4]);
+    mayer_planfft(plan, n, in1, in2, -1);
+    return (w+5);
 }
 
 static t_int *sigifft_perform(t_int *w)
@@ -95,14 +109,16 @@ static t_int *sigifft_perform(t_int *w)
     t_sample *in1 = (t_sample *)(w[1]);
     t_sample *in2 = (t_sample *)(w[2]);
     int n = (int)w[3];
-    mayer_ifft(n, in1, in2);
-    return (w+4);
+    t_fftplan *plan = (t_fftplan *)(w[4]);
+    mayer_planfft(plan, n, in1, in2, 1);
+    return (w+5);
 }
 
 static void sigfft_dspx(t_sigfft *x, t_signal **sp, t_int *(*f)(t_int *w))
 {
     int length = sp[0]->s_length, nchans = (sp[0]->s_nchans < sp[1]->s_nchans ?
         sp[0]->s_nchans : sp[1]->s_nchans), ch;
+    t_fftplan *plan;
     if (sp[0]->s_nchans != sp[1]->s_nchans)
         pd_error(x,
             "FFT inputs have different channel counts - ignoring extras");
@@ -118,6 +134,8 @@ static void sigfft_dspx(t_sigfft *x, t_signal **sp, t_int *(*f)(t_int *w))
         dsp_add_zero(sp[3]->s_vec, length * nchans);
         return;
     }
+    if (!(plan = mayer_getplan(2 * length)))
+        return;
     for (ch = 0; ch < nchans; ch++)
     {
         t_sample *in1 = sp[0]->s_vec + ch * length;
@@ -136,7 +154,7 @@ static void sigfft_dspx(t_sigfft *x, t_signal **sp, t_int *(*f)(t_int *w))
             if (out1 != in1) dsp_add(copy_perform, 3, in1, out1, (t_int)length);
             if (out2 != in2) dsp_add(copy_perform, 3, in2, out2, (t_int)length);
         }
-        dsp_add(f, 3, out1, out2, (t_int)length);
+        dsp_add(f, 4, out1, out2, (t_int)length, plan);
     }
 }
 
@@ -193,14 +211,16 @@ static t_int *sigrfft_perform(t_int *w)
 {
     t_sample *in = (t_sample *)(w[1]);
     int n = (int)w[2];
-    mayer_realfft(n, in);
-    return (w+3);
+    t_fftplan *plan = (t_fftplan *)(w[3]);
+    mayer_planrealfft(plan, n, in);
+    return (w+4);
 }
 
 static void sigrfft_dsp(t_sigrfft *x, t_signal **sp)
 {
     int length = sp[0]->s_length, n2 = (length>>1), ch;
     int nchans = sp[0]->s_nchans;
+    t_fftplan *plan;
     signal_setmultiout(&sp[1], nchans);
     signal_setmultiout(&sp[2], nchans);
     if (length < 4 || (length != (1 << ilog2(length))))
@@ -213,6 +233,8 @@ static void sigrfft_dsp(t_sigrfft *x, t_signal **sp)
         dsp_add_zero(sp[2]->s_vec, length * nchans);
         return;
     }
+    if (!(plan = mayer_getplan(length)))
+        return;
     for (ch = 0; ch < nchans; ch++)
     {
         t_sample *in1 = sp[0]->s_vec + ch * length;
@@ -220,7 +242,7 @@ static void sigrfft_dsp(t_sigrfft *x, t_signal **sp)
         t_sample *out2 = sp[2]->s_vec + ch * length;
         if (in1 != out1)
             dsp_add(copy_perform, 3, in1, out1, (t_int)length);
-        dsp_add(sigrfft_perform, 2, out1, (t_int)length);
+        dsp_add(sigrfft_perform, 3, out1, (t_int)length, plan);
         dsp_add(sigrfft_flip, 3, out1 + (n2+1), out2 + n2, (t_int)(n2-1));
         dsp_add_zero(out1 + (n2+1), ((n2-1)&(~7)));
         dsp_add_zero(out1 + (n2+1) + ((n2-1)&(~7)), ((n2-1)&7));
@@ -264,8 +286,9 @@ static t_int *sigrifft_perform(t_int *w)
 {
     t_sample *in = (t_sample *)(w[1]);
     int n = (int)w[2];
-    mayer_realifft(n, in);
-    return (w+3);
+    t_fftplan *plan = (t_fftplan *)(w[3]);
+    mayer_planrealifft(plan, n, in);
+    return (w+4);
 }
 
 static void sigrifft_dsp(t_sigrifft *x, t_signal **sp)
@@ -273,6 +296,7 @@ static void sigrifft_dsp(t_sigrifft *x, t_signal **sp)
     int length = sp[0]->s_length, n2 = (length>>1),
         nchans = (sp[0]->s_nchans < sp[1]->s_nchans ?
             sp[0]->s_nchans : sp[1]->s_nchans), ch;
+    t_fftplan *plan;
     if (sp[0]->s_nchans != sp[1]->s_nchans)
         pd_error(x,
             "rifft~ inputs have different channel counts - ignoring extras");
@@ -286,6 +310,8 @@ static void sigrifft_dsp(t_sigrifft *x, t_signal **sp)
         dsp_add_zero(sp[2]->s_vec, length * nchans);
         return;
     }
+    if (!(plan = mayer_getplan(length)))
+        return;
     for (ch = 0; ch < nchans; ch++)
     {
         t_sample *in1 = sp[0]->s_vec + ch * length;
@@ -301,7 +327,7 @@ static void sigrifft_dsp(t_sigrifft *x, t_signal **sp)
             if (in1 != out1) dsp_add(copy_perform, 3, in1, out1, (t_int)(n2+1));
             dsp_add(sigrfft_flip, 3, in2+1, out1 + length, (t_int)(n2-1));
         }
-        dsp_add(sigrifft_perform, 2, out1, (t_int)length);
+        dsp_add(sigrifft_perform, 3, out1, (t_int)length, plan);
     }
 }
 
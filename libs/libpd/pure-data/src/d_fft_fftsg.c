@@ -21,6 +21,7 @@ for another, more permissive-sounding copyright notice.  -MSP
 /* ---------- Pd interface to OOURA FFT; imitate Mayer API ---------- */
 #include "m_pd.h"
 #include "m_imp.h"
+#include "s_stuff.h"
 
 #include "m_private_utils.h"
 
@@ -30,68 +31,80 @@ void rdft(int, int, FFTFLT *, int *, FFTFLT *);
 
 int ilog2(int n);
 
-static PERTHREAD int ooura_maxn;
-static PERTHREAD int *ooura_bitrev;
-static PERTHREAD int ooura_bitrevsize;
-static PERTHREAD FFTFLT *ooura_costab;
-static PERTHREAD FFTFLT *ooura_buffer;
+    /* The Mayer API below is only built with -DPD_FFT_FFTSG; otherwise
+    d_fft_simd.c provides it and Ooura's routines are just there for
+    comparison. */
+#ifdef PD_FFT_FFTSG
+
+    /* Ooura's routines compute their bit reversal and twiddle tables on
+    demand and recompute them whenever the size outgrows them, so we keep
+    one set of tables (a "plan") for each transform size, together with the
+    scratch buffer we convert samples into.  Plans belong to the Pd instance
+    and live until it is freed (or the last FFT class goes away), so DSP
+    routines can look them up once and keep the pointer in the chain. */
+typedef struct _fftplan
+{
+    int p_n;                    /* transform size in FFTFLTs */
+    int *p_bitrev;              /* Ooura's "ip" work area */
+    int p_bitrevsize;
+    FFTFLT *p_costab;           /* Ooura's "w" twiddle and cosine tables */
+    FFTFLT *p_buffer;           /* scratch buffer for the transform */
+    struct _fftplan *p_next;
+} t_fftplan;
+
+static void ooura_freeplan(t_fftplan *p)
+{
+    if (p->p_bitrev)
+        t_freebytes(p->p_bitrev, p->p_bitrevsize);
+    if (p->p_costab)
+        t_freebytes(p->p_costab, p->p_n * sizeof(FFTFLT)/2);
+    if (p->p_buffer)
+        t_freebytes(p->p_buffer, p->p_n * sizeof(FFTFLT));
+    t_freebytes(p, sizeof(*p));
+}
 
-static int ooura_init( int n)
+    /* find or make the plan for an n-point real (n/2-point complex) FFT */
+t_fftplan *mayer_getplan(int n)
 {
+    t_fftplan *p;
     n = (1 << ilog2(n));
     if (n < 4)
         return (0);
-    if (n > ooura_maxn)
+    for (p = STUFF->st_fftplans; p; p = p->p_next)
+        if (p->p_n == n)
+            return (p);
+    if (!(p = (t_fftplan *)t_getbytes(sizeof(*p))))
+        goto fail;
+    p->p_n = n;
+        /* tables are filled in by cdft() or rdft() on first use */
+    p->p_bitrevsize = sizeof(int) * (2 + (1 << (ilog2(n)/2)));
+    p->p_bitrev = (int *)t_getbytes(p->p_bitrevsize);
+    p->p_costab = (FFTFLT *)t_getbytes(n * sizeof(FFTFLT)/2);
+    p->p_buffer = (FFTFLT *)t_getbytes(n * sizeof(FFTFLT));
+    if (!p->p_bitrev || !p->p_costab || !p->p_buffer)
     {
-        if (ooura_maxn)
-        {
-            t_freebytes(ooura_bitrev, ooura_bitrevsize);
-            t_freebytes(ooura_costab, ooura_maxn * sizeof(FFTFLT) / 2);
-            t_freebytes(ooura_buffer, ooura_maxn * sizeof(FFTFLT));
-        }
-        ooura_bitrevsize = sizeof(int) * (2 + (1 << (ilog2(n)/2)));
-        ooura_bitrev = (int *)t_getbytes(ooura_bitrevsize);
-        ooura_bitrev[0] = 0;
-        if (!ooura_bitrev)
-        {
-            pd_error(0, "out of memory allocating FFT buffer");
-            ooura_maxn = 0;
-            return (0);
-        }
-        ooura_costab = (FFTFLT *)t_getbytes(n * sizeof(FFTFLT)/2);
-        if (!ooura_costab)
-        {
-            pd_error(0, "out of memory allocating FFT buffer");
-            t_freebytes(ooura_bitrev, ooura_bitrevsize);
-            ooura_maxn = 0;
-            return (0);
-        }
-        ooura_buffer = (FFTFLT *)t_getbytes(n * sizeof(FFTFLT));
-        if (!ooura_buffer)
-        {
-            pd_error(0, "out of memory allocating FFT buffer");
-            t_freebytes(ooura_bitrev, ooura_bitrevsize);
-            t_freebytes(ooura_costab, n * sizeof(FFTFLT) / 2);
-            ooura_maxn = 0;
-            return (0);
-        }
-        ooura_maxn = n;
-        ooura_bitrev[0] = 0;
+        ooura_freeplan(p);
+        goto fail;
     }
-    return (1);
+    p->p_bitrev[0] = p->p_bitrev[1] = 0;
+    p->p_next = STUFF->st_fftplans;
+    STUFF->st_fftplans = p;
+    return (p);
+fail:
+    pd_error(0, "out of memory");
+    return (0);
 }
 
-static void ooura_term( void)
+    /* free all plans of the current instance */
+void mayer_freeplans(void)
 {
-    if (!ooura_maxn)
-        return;
-    t_freebytes(ooura_bitrev, ooura_bitrevsize);
-    t_freebytes(ooura_costab, ooura_maxn * sizeof(FFTFLT)/2);
-    t_freebytes(ooura_buffer, ooura_maxn * sizeof(FFTFLT));
-    ooura_maxn = 0;
-    ooura_bitrev = 0;
-    ooura_bitrevsize = 0;
-    ooura_costab = 0;
+    t_fftplan *p, *next;
+    for (p = STUFF->st_fftplans; p; p = next)
+    {
+        next = p->p_next;
+        ooura_freeplan(p);
+    }
+    STUFF->st_fftplans = 0;
 }
 
 /* -------- initialization and cleanup -------- */
@@ -105,30 +118,24 @@ void mayer_init( void)
 void mayer_term( void)
 {
     if (--mayer_refcount == 0)  /* clean up */
-        ooura_term();
+        mayer_freeplans();
 }
 
-/* -------- public routines -------- */
-EXTERN void mayer_fht(t_sample *fz, int n)
-{
-    post("FHT: not yet implemented");
-}
+/* -------- planned transforms; "plan" must come from mayer_getplan() ---- */
 
-EXTERN void mayer_dofft(t_sample *fz1, t_sample *fz2, int n, int sgn)
+void mayer_planfft(t_fftplan *plan, int n, t_sample *fz1, t_sample *fz2,
+    int sgn)
 {
-    FFTFLT *buf, *fp3;
+    FFTFLT *buf = plan->p_buffer, *fp3;
     int i;
     t_sample *fp1, *fp2;
-    if (!ooura_init(2*n))
-        return;
-    buf = ooura_buffer;
     for (i = 0, fp1 = fz1, fp2 = fz2, fp3 = buf; i < n; i++)
     {
         fp3[0] = *fp1++;
         fp3[1] = *fp2++;
         fp3 += 2;
     }
-    cdft(2*n, sgn, buf, ooura_bitrev, ooura_costab);
+    cdft(2*n, sgn, buf, plan->p_bitrev, plan->p_costab);
     for (i = 0, fp1 = fz1, fp2 = fz2, fp3 = buf; i < n; i++)
     {
         *fp1++ = fp3[0];
@@ -137,27 +144,14 @@ EXTERN void mayer_dofft(t_sample *fz1, t_sample *fz2, int n, int sgn)
     }
 }
 
-EXTERN void mayer_fft(int n, t_sample *fz1, t_sample *fz2)
-{
-    mayer_dofft(fz1, fz2, n, -1);
-}
-
-EXTERN void mayer_ifft(int n, t_sample *fz1, t_sample *fz2)
+void mayer_planrealfft(t_fftplan *plan, int n, t_sample *fz)
 {
-    mayer_dofft(fz1, fz2, n, 1);
-}
-
-EXTERN void mayer_realfft(int n, t_sample *fz)
-{
-    FFTFLT *buf, *fp3;
+    FFTFLT *buf = plan->p_buffer, *fp3;
     int i, nover2 = n/2;
     t_sample *fp1, *fp2;
-    if (!ooura_init(n))
-        return;
-    buf = ooura_buffer;
-    for (i = 0, fp1 = fz, fp3 = buf; i < n; i++, fp1++, fp3++)
+    for (i = 0; i < n; i++)
         buf[i] = fz[i];
-    rdft(n, 1, buf, ooura_bitrev, ooura_costab);
+    rdft(n, 1, buf, plan->p_bitrev, plan->p_costab);
     fz[0] = buf[0];
     fz[nover2] = buf[1];
     for (i = 1, fp1 = fz+1, fp2 = fz+(n-1), fp3 = buf+2; i < nover2;
@@ -165,40 +159,80 @@ EXTERN void mayer_realfft(int n, t_sample *fz)
             *fp1 = fp3[0], *fp2 = fp3[1];
 }
 
-EXTERN void mayer_realifft(int n, t_sample *fz)
+void mayer_planrealifft(t_fftplan *plan, int n, t_sample *fz)
 {
-    FFTFLT *buf, *fp3;
+    FFTFLT *buf = plan->p_buffer, *fp3;
     int i, nover2 = n/2;
     t_sample *fp1, *fp2;
-    if (!ooura_init(n))
-        return;
-    buf = ooura_buffer;
     buf[0] = fz[0];
     buf[1] = fz[nover2];
     for (i = 1, fp1 = fz+1, fp2 = fz+(n-1), fp3 = buf+2; i < nover2;
         i++, fp1++, fp2--, fp3 += 2)
             fp3[0] = *fp1, fp3[1] = *fp2;
-    rdft(n, -1, buf, ooura_bitrev, ooura_costab);
-    for (i = 0, fp1 = fz, fp3 = buf; i < n; i++, fp1++, fp3++)
+    rdft(n, -1, buf, plan->p_bitrev, plan->p_costab);
+    for (i = 0; i < n; i++)
         fz[i] = 2*buf[i];
 }
 
+/* -------- public routines -------- */
+EXTERN void mayer_fht(t_sample *fz, int n)
+{
+    post("FHT: not yet implemented");
+}
+
+EXTERN void mayer_dofft(t_sample *fz1, t_sample *fz2, int n, int sgn)
+{
+    t_fftplan *plan = mayer_getplan(2*n);
+    if (plan)
+        mayer_planfft(plan, n, fz1, fz2, sgn);
+}
+
+EXTERN void mayer_fft(int n, t_sample *fz1, t_sample *fz2)
+{
+    mayer_dofft(fz1, fz2, n, -1);
+}
+
+EXTERN void mayer_ifft(int n, t_sample *fz1, t_sample *fz2)
+{
+    mayer_dofft(fz1, fz2, n, 1);
+}
+
+EXTERN void mayer_realfft(int n, t_sample *fz)
+{
+    t_fftplan *plan = mayer_getplan(n);
+    if (plan)
+        mayer_planrealfft(plan, n, fz);
+}
+
+EXTERN void mayer_realifft(int n, t_sample *fz)
+{
+    t_fftplan *plan = mayer_getplan(n);
+    if (plan)
+        mayer_planrealifft(plan, n, fz);
+}
+
     /* ancient ISPW-like version, used in fiddle~ and perhaps other externs
     here and there. */
 void pd_fft(t_float *buf, int npoints, int inverse)
 {
-    FFTFLT *buf2 = (FFTFLT *)alloca(2 * npoints * sizeof(FFTFLT)), *bp2;
+    t_fftplan *plan = mayer_getplan(2*npoints);
+    FFTFLT *bp2;
     t_float *fp;
     int i;
-    if (!ooura_init(2*npoints))
+    if (!plan)
         return;
-    for (i = 0, bp2 = buf2, fp = buf; i < 2 * npoints; i++, bp2++, fp++)
-        *bp2 = *fp;
-    cdft(2*npoints, (inverse ? 1 : -1), buf2, ooura_bitrev, ooura_costab);
-    for (i = 0, bp2 = buf2, fp = buf; i < 2 * npoints; i++, bp2++, fp++)
-        *fp = *bp2;
+    for (i = 0, bp2 = plan->p_buffer, fp = buf; i < 2 * npoints;
+        i++, bp2++, fp++)
+            *bp2 = *fp;
+    cdft(2*npoints, (inverse ? 1 : -1), plan->p_buffer,
+        plan->p_bitrev, plan->p_costab);
+    for (i = 0, bp2 = plan->p_buffer, fp = buf; i < 2 * npoints;
+        i++, bp2++, fp++)
+            *fp = *bp2;
 }
 
+#endif /* PD_FFT_FFTSG */
+
 /****************** end Pd-specific prologue ***********************/
 /*
 Fast Fourier/Cosine/Sine Transform
@@ -0,0 +1,710 @@
+/* Copyright (c) 1997- Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/* A vectorized FFT package behind the Mayer API used by d_fft.c.  It runs
+in t_sample precision, four points at a time with SSE2 or NEON where we have
+them and with plain C otherwise.  Build with -DPD_FFT_FFTSG to use the Ooura
+package in d_fft_fftsg.c instead.
+
+Complex transforms are radix-4 Stockham passes (with a last radix-2 pass when
+the size is an odd power of 2), which sort the output as they go so there is
+no bit reversal.  Data are kept as separate real and imaginary arrays, the
+format of mayer_fft(), so each vector holds four neighboring points and the
+butterflies need no shuffling.  An n-point real FFT is an n/2-point complex
+FFT of the even and odd samples followed by one pass to split the spectrum;
+the first and last passes read and write the callers' buffers directly. */
+
+#include "m_pd.h"
+#include "m_imp.h"
+#include "s_stuff.h"
+#include <math.h>
+#include <string.h>
+
+#ifndef PD_FFT_FFTSG
+
+int ilog2(int n);
+
+#ifdef _MSC_VER
+#define FFT_INLINE static __inline
+#else
+#define FFT_INLINE static inline
+#endif
+
+#define TWOPI 6.283185307179586
+
+/* ------------ four samples at a time: SSE2, NEON, or plain C ------------ */
+
+#if PD_FLOATSIZE == 32 && (defined(__SSE2__) || defined(_M_X64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+
+#include <emmintrin.h>
+
+typedef __m128 t_v4;
+#define v4_load(p) _mm_loadu_ps(p)
+#define v4_store(p, v) _mm_storeu_ps(p, v)
+#define v4_set1(f) _mm_set1_ps(f)
+#define v4_add(a, b) _mm_add_ps(a, b)
+#define v4_sub(a, b) _mm_sub_ps(a, b)
+#define v4_mul(a, b) _mm_mul_ps(a, b)
+
+    /* reverse the order of the four */
+FFT_INLINE t_v4 v4_reverse(t_v4 v)
+{
+    return (_mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 1, 2, 3)));
+}
+
+    /* split 8 interleaved samples into even and odd ones */
+FFT_INLINE void v4_deinterleave(const t_sample *p, t_v4 *even, t_v4 *odd)
+{
+    t_v4 lo = _mm_loadu_ps(p), hi = _mm_loadu_ps(p + 4);
+    *even = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0));
+    *odd = _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1));
+}
+
+FFT_INLINE void v4_interleave(t_sample *p, t_v4 even, t_v4 odd)
+{
+    _mm_storeu_ps(p, _mm_unpacklo_ps(even, odd));
+    _mm_storeu_ps(p + 4, _mm_unpackhi_ps(even, odd));
+}
+
+    /* turn four vectors' worth of columns into rows */
+FFT_INLINE void v4_transpose(t_v4 *a, t_v4 *b, t_v4 *c, t_v4 *d)
+{
+    _MM_TRANSPOSE4_PS(*a, *b, *c, *d);
+}
+
+#elif PD_FLOATSIZE == 32 && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+
+#include <arm_neon.h>
+
+typedef float32x4_t t_v4;
+#define v4_load(p) vld1q_f32(p)
+#define v4_store(p, v) vst1q_f32(p, v)
+#define v4_set1(f) vdupq_n_f32(f)
+#define v4_add(a, b) vaddq_f32(a, b)
+#define v4_sub(a, b) vsubq_f32(a, b)
+#define v4_mul(a, b) vmulq_f32(a, b)
+
+FFT_INLINE t_v4 v4_reverse(t_v4 v)
+{
+    v = vrev64q_f32(v);
+    return (vcombine_f32(vget_high_f32(v), vget_low_f32(v)));
+}
+
+FFT_INLINE void v4_deinterleave(const t_sample *p, t_v4 *even, t_v4 *odd)
+{
+    float32x4x2_t v = vld2q_f32(p);
+    *even = v.val[0];
+    *odd = v.val[1];
+}
+
+FFT_INLINE void v4_interleave(t_sample *p, t_v4 even, t_v4 odd)
+{
+    float32x4x2_t v;
+    v.val[0] = even;
+    v.val[1] = odd;
+    vst2q_f32(p, v);
+}
+
+FFT_INLINE void v4_transpose(t_v4 *a, t_v4 *b, t_v4 *c, t_v4 *d)
+{
+    float32x4x2_t ab = vtrnq_f32(*a, *b), cd = vtrnq_f32(*c, *d);
+    *a = vcombine_f32(vget_low_f32(ab.val[0]), vget_low_f32(cd.val[0]));
+    *b = vcombine_f32(vget_low_f32(ab.val[1]), vget_low_f32(cd.val[1]));
+    *c = vcombine_f32(vget_high_f32(ab.val[0]), vget_high_f32(cd.val[0]));
+    *d = vcombine_f32(vget_high_f32(ab.val[1]), vget_high_f32(cd.val[1]));
+}
+
+#else /* plain C, which the compiler may still vectorize */
+
+typedef struct _v4
+{
+    t_sample v[4];
+} t_v4;
+
+FFT_INLINE t_v4 v4_load(const t_sample *p)
+{
+    t_v4 r;
+    r.v[0] = p[0], r.v[1] = p[1], r.v[2] = p[2], r.v[3] = p[3];
+    return (r);
+}
+
+FFT_INLINE void v4_store(t_sample *p, t_v4 a)
+{
+    p[0] = a.v[0], p[1] = a.v[1], p[2] = a.v[2], p[3] = a.v[3];
+}
+
+FFT_INLINE t_v4 v4_set1(t_sample f)
+{
+    t_v4 r;
+    r.v[0] = r.v[1] = r.v[2] = r.v[3] = f;
+    return (r);
+}
+
+FFT_INLINE t_v4 v4_add(t_v4 a, t_v4 b)
+{
+    t_v4 r;
+    r.v[0] = a.v[0] + b.v[0], r.v[1] = a.v[1] + b.v[1];
+    r.v[2] = a.v[2] + b.v[2], r.v[3] = a.v[3] + b.v[3];
+    return (r);
+}
+
+FFT_INLINE t_v4 v4_sub(t_v4 a, t_v4 b)
+{
+    t_v4 r;
+    r.v[0] = a.v[0] - b.v[0], r.v[1] = a.v[1] - b.v[1];
+    r.v[2] = a.v[2] - b.v[2], r.v[3] = a.v[3] - b.v[3];
+    return (r);
+}
+
+FFT_INLINE t_v4 v4_mul(t_v4 a, t_v4 b)
+{
+    t_v4 r;
+    r.v[0] = a.v[0] * b.v[0], r.v[1] = a.v[1] * b.v[1];
+    r.v[2] = a.v[2] * b.v[2], r.v[3] = a.v[3] * b.v[3];
+    return (r);
+}
+
+FFT_INLINE t_v4 v4_reverse(t_v4 a)
+{
+    t_v4 r;
+    r.v[0] = a.v[3], r.v[1] = a.v[2], r.v[2] = a.v[1], r.v[3] = a.v[0];
+    return (r);
+}
+
+FFT_INLINE void v4_deinterleave(const t_sample *p, t_v4 *even, t_v4 *odd)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        even->v[i] = p[2*i], odd->v[i] = p[2*i+1];
+}
+
+FFT_INLINE void v4_interleave(t_sample *p, t_v4 even, t_v4 odd)
+{
+    int i;
+    for (i = 0; i < 4; i++)
+        p[2*i] = even.v[i], p[2*i+1] = odd.v[i];
+}
+
+FFT_INLINE void v4_transpose(t_v4 *a, t_v4 *b, t_v4 *c, t_v4 *d)
+{
+    t_v4 *rows[4];
+    int i, j;
+    rows[0] = a, rows[1] = b, rows[2] = c, rows[3] = d;
+    for (i = 0; i < 4; i++)
+        for (j = i + 1; j < 4; j++)
+    {
+        t_sample f = rows[i]->v[j];
+        rows[i]->v[j] = rows[j]->v[i];
+        rows[j]->v[i] = f;
+    }
+}
+
+#endif
+
+    /* complex arithmetic on four points held as real and imaginary vectors */
+#define CMUL(rr, ri, ar, ai, br, bi) \
+    (rr = v4_sub(v4_mul(ar, br), v4_mul(ai, bi)), \
+     ri = v4_add(v4_mul(ar, bi), v4_mul(ai, br)))
+
+/* ------------------------------- plans --------------------------------- */
+
+    /* A plan holds the twiddle factors for one size, kept per Pd instance
+    as in d_fft_fftsg.c.  A plan for an n-point real FFT also does n/2-point
+    complex ones, which are what mayer_fft() and pd_fft() get it for. */
+typedef struct _fftplan
+{
+    int p_n;                    /* real FFT size, complex size is p_n/2 */
+    int p_nsamps;               /* size of p_mem in t_samples */
+    t_sample *p_mem;            /* all of the following */
+    t_sample *p_twiddle;        /* twiddles for each radix-4 pass */
+    t_sample *p_cos;            /* cos and sin of 2*pi*k/p_n for the real */
+    t_sample *p_sin;            /* transforms, or all k for small sizes */
+    t_sample *p_work[2];        /* complex work buffers, real then imag */
+    struct _fftplan *p_next;
+} t_fftplan;
+
+    /* below this many complex points we just compute the DFT directly */
+#define SMALLFFT 16
+
+static void simd_makeplan(t_fftplan *p)
+{
+    int m = p->p_n/2, n, i, k;
+    t_sample *tw = p->p_twiddle;
+    if (m < SMALLFFT)
+    {
+            /* table for direct DFTs: all multiples of 2*pi/p_n */
+        for (k = 0; k < p->p_n; k++)
+        {
+            p->p_cos[k] = cos(TWOPI * k / p->p_n);
+            p->p_sin[k] = sin(TWOPI * k / p->p_n);
+        }
+        return;
+    }
+        /* first pass: twiddles w^p, w^2p, w^3p for 4 values of p at a time,
+        as real and imaginary vectors */
+    for (k = 0; k < m/4; k += 4)
+    {
+        for (n = 1; n <= 3; n++)
+            for (i = 0; i < 4; i++)
+        {
+            double phase = -TWOPI * n * (k + i) / m;
+            tw[(n-1) * 8 + i] = cos(phase);
+            tw[(n-1) * 8 + 4 + i] = sin(phase);
+        }
+        tw += 24;
+    }
+        /* later passes: the three twiddles for each p, used for all q */
+    for (n = m/4; n >= 8; n /= 4)
+        for (k = 0; k < n/4; k++)
+    {
+        for (i = 1; i <= 3; i++)
+        {
+            double phase = -TWOPI * i * k / n;
+            *tw++ = cos(phase);
+            *tw++ = sin(phase);
+        }
+    }
+        /* splitting the spectrum of a real FFT */
+    for (k = 0; k <= m/2 + 3; k++)
+    {
+        p->p_cos[k] = cos(TWOPI * k / p->p_n);
+        p->p_sin[k] = sin(TWOPI * k / p->p_n);
+    }
+}
+
+static void simd_freeplan(t_fftplan *p)
+{
+    if (p->p_mem)
+        t_freebytes(p->p_mem, p->p_nsamps * sizeof(t_sample));
+    t_freebytes(p, sizeof(*p));
+}
+
+    /* find or make the plan for an n-point real (n/2-point complex) FFT */
+t_fftplan *mayer_getplan(int n)
+{
+    t_fftplan *p;
+    int m, ntwiddle, ntab;
+    n = (1 << ilog2(n));
+    if (n < 4)
+        return (0);
+    for (p = STUFF->st_fftplans; p; p = p->p_next)
+        if (p->p_n == n)
+            return (p);
+    if (!(p = (t_fftplan *)t_getbytes(sizeof(*p))))
+        goto fail;
+    m = n/2;
+    if (m < SMALLFFT)
+        ntwiddle = 0, ntab = n;
+    else ntwiddle = 2 * m, ntab = m/2 + 4;
+    p->p_n = n;
+    p->p_nsamps = ntwiddle + 2 * ntab + 2 * n;
+    if (!(p->p_mem = (t_sample *)t_getbytes(p->p_nsamps * sizeof(t_sample))))
+    {
+        simd_freeplan(p);
+        goto fail;
+    }
+    p->p_twiddle = p->p_mem;
+    p->p_cos = p->p_twiddle + ntwiddle;
+    p->p_sin = p->p_cos + ntab;
+    p->p_work[0] = p->p_sin + ntab;
+    p->p_work[1] = p->p_work[0] + n;
+    simd_makeplan(p);
+    p->p_next = STUFF->st_fftplans;
+    STUFF->st_fftplans = p;
+    return (p);
+fail:
+    pd_error(0, "out of memory");
+    return (0);
+}
+
+    /* free all plans of the current instance */
+void mayer_freeplans(void)
+{
+    t_fftplan *p, *next;
+    for (p = STUFF->st_fftplans; p; p = next)
+    {
+        next = p->p_next;
+        simd_freeplan(p);
+    }
+    STUFF->st_fftplans = 0;
+}
+
+/* -------- initialization and cleanup -------- */
+static PERTHREAD int mayer_refcount = 0;
+
+void mayer_init( void)
+{
+    mayer_refcount++;
+}
+
+void mayer_term( void)
+{
+    if (--mayer_refcount == 0)  /* clean up */
+        mayer_freeplans();
+}
+
+/* ---------------------------- complex FFT ------------------------------ */
+
+    /* where a transform reads its input or writes its output: separate real
+    and imaginary arrays, or, if "im" is 0, interleaved pairs.  Inverse
+    transforms are forward ones with real and imaginary parts swapped on the
+    way in and out, which "swap" does for interleaved pairs. */
+typedef struct _fftio
+{
+    t_sample *io_re;
+    t_sample *io_im;
+    int io_swap;
+} t_fftio;
+
+FFT_INLINE void fftio_load(const t_fftio *io, int j, t_v4 *re, t_v4 *im)
+{
+    if (io->io_im)
+        *re = v4_load(io->io_re + j), *im = v4_load(io->io_im + j);
+    else if (io->io_swap)
+        v4_deinterleave(io->io_re + 2*j, im, re);
+    else v4_deinterleave(io->io_re + 2*j, re, im);
+}
+
+FFT_INLINE void fftio_store(const t_fftio *io, int j, t_v4 re, t_v4 im)
+{
+    if (io->io_im)
+        v4_store(io->io_re + j, re), v4_store(io->io_im + j, im);
+    else if (io->io_swap)
+        v4_interleave(io->io_re + 2*j, im, re);
+    else v4_interleave(io->io_re + 2*j, re, im);
+}
+
+    /* the radix-4 butterfly: a, b, c, d in, a..d out before twiddling */
+#define BUTTERFLY4(ar, ai, br, bi, cr, ci, dr, di) \
+{ \
+    t_v4 apcr = v4_add(ar, cr), apci = v4_add(ai, ci); \
+    t_v4 amcr = v4_sub(ar, cr), amci = v4_sub(ai, ci); \
+    t_v4 bpdr = v4_add(br, dr), bpdi = v4_add(bi, di); \
+    t_v4 bmdr = v4_sub(br, dr), bmdi = v4_sub(bi, di); \
+    ar = v4_add(apcr, bpdr), ai = v4_add(apci, bpdi); \
+    cr = v4_sub(apcr, bpdr), ci = v4_sub(apci, bpdi); \
+    br = v4_add(amcr, bmdi), bi = v4_sub(amci, bmdr); \
+    dr = v4_sub(amcr, bmdi), di = v4_add(amci, bmdr); \
+}
+
+    /* first pass, over all m points: here the butterflies for 4 values of
+    p are in neighboring points, so we transpose to write their outputs,
+    which go to points 4p ... 4p+3 */
+static void fft_firstpass(int m, const t_fftio *in, t_sample *yr,
+    t_sample *yi, const t_sample *tw)
+{
+    int m4 = m/4, p;
+    for (p = 0; p < m4; p += 4, tw += 24)
+    {
+        t_v4 ar, ai, br, bi, cr, ci, dr, di, tr, ti;
+        fftio_load(in, p, &ar, &ai);
+        fftio_load(in, p + m4, &br, &bi);
+        fftio_load(in, p + 2*m4, &cr, &ci);
+        fftio_load(in, p + 3*m4, &dr, &di);
+        BUTTERFLY4(ar, ai, br, bi, cr, ci, dr, di);
+        CMUL(tr, ti, br, bi, v4_load(tw), v4_load(tw + 4));
+        br = tr, bi = ti;
+        CMUL(tr, ti, cr, ci, v4_load(tw + 8), v4_load(tw + 12));
+        cr = tr, ci = ti;
+        CMUL(tr, ti, dr, di, v4_load(tw + 16), v4_load(tw + 20));
+        dr = tr, di = ti;
+        v4_transpose(&ar, &br, &cr, &dr);
+        v4_transpose(&ai, &bi, &ci, &di);
+        v4_store(yr + 4*p, ar), v4_store(yi + 4*p, ai);
+        v4_store(yr + 4*p + 4, br), v4_store(yi + 4*p + 4, bi);
+        v4_store(yr + 4*p + 8, cr), v4_store(yi + 4*p + 8, ci);
+        v4_store(yr + 4*p + 12, dr), v4_store(yi + 4*p + 12, di);
+    }
+}
+
+    /* a middle pass over sequences of n points, s apart (s >= 4) */
+static void fft_pass(int n, int s, const t_sample *xr, const t_sample *xi,
+    t_sample *yr, t_sample *yi, const t_sample *tw)
+{
+    int n4 = n/4, p, q;
+    for (p = 0; p < n4; p++, tw += 6)
+    {
+        t_v4 w1r = v4_set1(tw[0]), w1i = v4_set1(tw[1]),
+            w2r = v4_set1(tw[2]), w2i = v4_set1(tw[3]),
+            w3r = v4_set1(tw[4]), w3i = v4_set1(tw[5]);
+        const t_sample *ar_ = xr + s*p, *ai_ = xi + s*p;
+        t_sample *yr_ = yr + 4*s*p, *yi_ = yi + 4*s*p;
+        for (q = 0; q < s; q += 4)
+        {
+            t_v4 ar = v4_load(ar_ + q), ai = v4_load(ai_ + q),
+                br = v4_load(ar_ + q + s*n4), bi = v4_load(ai_ + q + s*n4),
+                cr = v4_load(ar_ + q + 2*s*n4), ci = v4_load(ai_ + q + 2*s*n4),
+                dr = v4_load(ar_ + q + 3*s*n4), di = v4_load(ai_ + q + 3*s*n4),
+                tr, ti;
+            BUTTERFLY4(ar, ai, br, bi, cr, ci, dr, di);
+            v4_store(yr_ + q, ar), v4_store(yi_ + q, ai);
+            CMUL(tr, ti, br, bi, w1r, w1i);
+            v4_store(yr_ + q + s, tr), v4_store(yi_ + q + s, ti);
+            CMUL(tr, ti, cr, ci, w2r, w2i);
+            v4_store(yr_ + q + 2*s, tr), v4_store(yi_ + q + 2*s, ti);
+            CMUL(tr, ti, dr, di, w3r, w3i);
+            v4_store(yr_ + q + 3*s, tr), v4_store(yi_ + q + 3*s, ti);
+        }
+    }
+}
+
+    /* last pass over 4 or 2 points, s apart, which needs no twiddles */
+static void fft_lastpass(int n, int s, const t_sample *xr, const t_sample *xi,
+    const t_fftio *out)
+{
+    int q;
+    if (n == 4) for (q = 0; q < s; q += 4)
+    {
+        t_v4 ar = v4_load(xr + q), ai = v4_load(xi + q),
+            br = v4_load(xr + q + s), bi = v4_load(xi + q + s),
+            cr = v4_load(xr + q + 2*s), ci = v4_load(xi + q + 2*s),
+            dr = v4_load(xr + q + 3*s), di = v4_load(xi + q + 3*s);
+        BUTTERFLY4(ar, ai, br, bi, cr, ci, dr, di);
+        fftio_store(out, q, ar, ai);
+        fftio_store(out, q + s, br, bi);
+        fftio_store(out, q + 2*s, cr, ci);
+        fftio_store(out, q + 3*s, dr, di);
+    }
+    else for (q = 0; q < s; q += 4)
+    {
+        t_v4 ar = v4_load(xr + q), ai = v4_load(xi + q),
+            br = v4_load(xr + q + s), bi = v4_load(xi + q + s);
+        fftio_store(out, q, v4_add(ar, br), v4_add(ai, bi));
+        fftio_store(out, q + s, v4_sub(ar, br), v4_sub(ai, bi));
+    }
+}
+
+    /* m-point forward complex FFT (m >= SMALLFFT) from "in" to "out",
+    using both work buffers.  "in" may be work buffer 1 but not 0. */
+static void simd_fft(t_fftplan *plan, int m, const t_fftio *in,
+    const t_fftio *out)
+{
+    t_sample *xr = plan->p_work[0], *xi = xr + m,
+        *yr = plan->p_work[1], *yi = yr + m, *swap;
+    const t_sample *tw = plan->p_twiddle + 6 * m/4;
+    int n, s;
+    fft_firstpass(m, in, xr, xi, plan->p_twiddle);
+    for (n = m/4, s = 4; n >= 8; n /= 4, s *= 4)
+    {
+        fft_pass(n, s, xr, xi, yr, yi, tw);
+        tw += 6 * n/4;
+        swap = xr, xr = yr, yr = swap;
+        swap = xi, xi = yi, yi = swap;
+    }
+    fft_lastpass(n, s, xr, xi, out);
+}
+
+    /* direct DFT for small sizes; "step" picks the twiddles for m points
+    out of the table for the plan's size */
+static void small_fft(t_fftplan *plan, int m, t_sample *re, t_sample *im,
+    int sgn)
+{
+    t_sample tmp[2 * SMALLFFT];
+    int step = plan->p_n / m, j, k;
+    for (k = 0; k < m; k++)
+    {
+        t_sample sumr = 0, sumi = 0;
+        for (j = 0; j < m; j++)
+        {
+            int index = (j * k * step) & (plan->p_n - 1);
+            t_sample c = plan->p_cos[index], s = sgn * plan->p_sin[index];
+            sumr += re[j] * c + im[j] * s;
+            sumi += im[j] * c - re[j] * s;
+        }
+        tmp[k] = sumr, tmp[m + k] = sumi;
+    }
+    for (k = 0; k < m; k++)
+        re[k] = tmp[k], im[k] = tmp[m + k];
+}
+
+/* -------- planned transforms; "plan" must come from mayer_getplan() ---- */
+
+    /* n-point complex FFT in place, sgn is -1 for forward or 1 for inverse */
+void mayer_planfft(t_fftplan *plan, int n, t_sample *fz1, t_sample *fz2,
+    int sgn)
+{
+    t_fftio io;
+    if (n < SMALLFFT)
+    {
+        small_fft(plan, n, fz1, fz2, -sgn);
+        return;
+    }
+    io.io_re = (sgn > 0 ? fz2 : fz1);
+    io.io_im = (sgn > 0 ? fz1 : fz2);
+    io.io_swap = 0;
+    simd_fft(plan, n, &io, &io);
+}
+
+    /* real FFT in place; the output is the real parts of bins 0 to n/2,
+    then the imaginary parts of bins n/2-1 down to 1, with the sign of
+    Ooura's rdft(), ie. the sines */
+void mayer_planrealfft(t_fftplan *plan, int n, t_sample *fz)
+{
+    int m = n/2, k;
+    t_sample *zr = plan->p_work[1], *zi = zr + m, f;
+    t_fftio in, out;
+    if (m < SMALLFFT)
+    {
+        t_sample tmp[2 * SMALLFFT];
+        for (k = 0; k <= m; k++)
+        {
+            t_sample sumr = 0, sumi = 0;
+            int j;
+            for (j = 0; j < n; j++)
+            {
+                int index = (j * k) & (n - 1);
+                sumr += fz[j] * plan->p_cos[index];
+                sumi += fz[j] * plan->p_sin[index];
+            }
+            tmp[k] = sumr;
+            if (k && k < m)
+                tmp[n - k] = sumi;
+        }
+        memcpy(fz, tmp, n * sizeof(t_sample));
+        return;
+    }
+    in.io_re = fz, in.io_im = 0, in.io_swap = 0;
+    out.io_re = zr, out.io_im = zi, out.io_swap = 0;
+    simd_fft(plan, m, &in, &out);
+        /* bins k and m-k from points k and m-k, 4 at a time */
+    f = zr[0];
+    fz[0] = f + zi[0];
+    fz[m] = f - zi[0];
+    for (k = 1; k <= m/2; k += 4)
+    {
+        t_v4 half = v4_set1(0.5), ar, ai, br, bi, er, ei, odr, odi, tr, ti,
+            c = v4_load(plan->p_cos + k), s = v4_load(plan->p_sin + k);
+        ar = v4_load(zr + k), ai = v4_load(zi + k);
+        br = v4_reverse(v4_load(zr + m - k - 3));
+        bi = v4_reverse(v4_load(zi + m - k - 3));
+        er = v4_mul(half, v4_add(ar, br)), ei = v4_mul(half, v4_sub(ai, bi));
+        odr = v4_mul(half, v4_add(ai, bi));
+        odi = v4_mul(half, v4_sub(br, ar));
+        tr = v4_add(v4_mul(c, odr), v4_mul(s, odi));
+        ti = v4_sub(v4_mul(c, odi), v4_mul(s, odr));
+        v4_store(fz + k, v4_add(er, tr));
+        v4_store(fz + m + k, v4_sub(ei, ti));
+        v4_store(fz + m - k - 3, v4_reverse(v4_sub(er, tr)));
+        v4_store(fz + n - k - 3, v4_reverse(v4_sub(v4_sub(v4_set1(0), ei),
+            ti)));
+    }
+}
+
+    /* inverse of mayer_planrealfft(), without normalization, so that
+    the two in a row multiply by n */
+void mayer_planrealifft(t_fftplan *plan, int n, t_sample *fz)
+{
+    int m = n/2, k;
+    t_sample *zr = plan->p_work[1], *zi = zr + m;
+    t_fftio in, out;
+    if (m < SMALLFFT)
+    {
+        t_sample tmp[2 * SMALLFFT];
+        int j;
+        for (j = 0; j < n; j++)
+        {
+            t_sample sum = fz[0] + ((j & 1) ? -fz[m] : fz[m]);
+            for (k = 1; k < m; k++)
+            {
+                int index = (j * k) & (n - 1);
+                sum += 2 * (fz[k] * plan->p_cos[index] +
+                    fz[n - k] * plan->p_sin[index]);
+            }
+            tmp[j] = sum;
+        }
+        memcpy(fz, tmp, n * sizeof(t_sample));
+        return;
+    }
+        /* the m-point spectrum of even + i * odd samples, from bins k
+        and m-k, 4 at a time */
+    zr[0] = fz[0] - fz[m];     /* swapped, see below */
+    zi[0] = fz[0] + fz[m];
+    for (k = 1; k <= m/2; k += 4)
+    {
+        t_v4 xr, xi, yr, yi, fer, fei, dr, di, fr, fi, c, s;
+        c = v4_load(plan->p_cos + k), s = v4_load(plan->p_sin + k);
+        xr = v4_load(fz + k);
+        xi = v4_sub(v4_set1(0), v4_reverse(v4_load(fz + n - k - 3)));
+        yr = v4_reverse(v4_load(fz + m - k - 3));
+        yi = v4_sub(v4_set1(0), v4_load(fz + m + k));
+        fer = v4_add(xr, yr), fei = v4_sub(xi, yi);
+        dr = v4_sub(xr, yr), di = v4_add(xi, yi);
+        fr = v4_sub(v4_mul(dr, c), v4_mul(di, s));
+        fi = v4_add(v4_mul(dr, s), v4_mul(di, c));
+            /* inverse by swapping real and imaginary, see t_fftio */
+        v4_store(zi + k, v4_sub(fer, fi));
+        v4_store(zr + k, v4_add(fei, fr));
+        v4_store(zi + m - k - 3, v4_reverse(v4_add(fer, fi)));
+        v4_store(zr + m - k - 3, v4_reverse(v4_sub(fr, fei)));
+    }
+    in.io_re = zr, in.io_im = zi, in.io_swap = 0;
+    out.io_re = fz, out.io_im = 0, out.io_swap = 1;
+    simd_fft(plan, m, &in, &out);
+}
+
+/* -------- public routines -------- */
+EXTERN void mayer_fht(t_sample *fz, int n)
+{
+    post("FHT: not yet implemented");
+}
+
+EXTERN void mayer_dofft(t_sample *fz1, t_sample *fz2, int n, int sgn)
+{
+    t_fftplan *plan = mayer_getplan(2*n);
+    if (plan)
+        mayer_planfft(plan, n, fz1, fz2, sgn);
+}
+
+EXTERN void mayer_fft(int n, t_sample *fz1, t_sample *fz2)
+{
+    mayer_dofft(fz1, fz2, n, -1);
+}
+
+EXTERN void mayer_ifft(int n, t_sample *fz1, t_sample *fz2)
+{
+    mayer_dofft(fz1, fz2, n, 1);
+}
+
+EXTERN void mayer_realfft(int n, t_sample *fz)
+{
+    t_fftplan *plan = mayer_getplan(n);
+    if (plan)
+        mayer_planrealfft(plan, n, fz);
+}
+
+EXTERN void mayer_realifft(int n, t_sample *fz)
+{
+    t_fftplan *plan = mayer_getplan(n);
+    if (plan)
+        mayer_planrealifft(plan, n, fz);
+}
+
+    /* ancient ISPW-like version, used in fiddle~ and perhaps other externs
+    here and there: npoints complex points, interleaved */
+void pd_fft(t_float *buf, int npoints, int inverse)
+{
+    t_fftplan *plan = mayer_getplan(2*npoints);
+    t_fftio io;
+    if (!plan)
+        return;
+    if (npoints < SMALLFFT)
+    {
+            /* deinterleave into the work buffer and back */
+        t_sample *re = plan->p_work[0], *im = re + npoints;
+        int i;
+        for (i = 0; i < npoints; i++)
+            re[i] = buf[2*i], im[i] = buf[2*i+1];
+        mayer_planfft(plan, npoints, re, im, (inverse ? 1 : -1));
+        for (i = 0; i < npoints; i++)
+            buf[2*i] = re[i], buf[2*i+1] = im[i];
+        return;
+    }
+    io.io_re = (t_sample *)buf;
+    io.io_im = 0;
+    io.io_swap = (inverse != 0);
+    simd_fft(plan, npoints, &io, &io);
+}
+
+#endif /* PD_FFT_FFTSG */
@@ -503,6 +503,12 @@ static void noise_setup(void)
 
 /******************** tabosc4~ ***********************/
 
+    /* in d_array.c */
+void array_interpolate4(const t_word *tab, const int *index,
+    const t_sample *frac, t_sample *out, int n);
+
+#define TABOSC4_CHUNK 64    /* points done per array_interpolate4() call */
+
 static t_class *tabosc4_tilde_class;
 
 typedef struct _tabosc4_tilde
@@ -541,34 +547,32 @@ static t_int *tabosc4_tilde_perform(t_int *w)
     t_float fnpoints = x->x_fnpoints;
     int mask = fnpoints - 1;
     t_float conv = fnpoints * x->x_conv;
-    t_word *tab = x->x_vec, *addr;
+    t_word *tab = x->x_vec;
     double dphase = fnpoints * x->x_phase + UNITBIT32;
 
     if (!tab) goto zero;
     tf.tf_d = UNITBIT32;
     normhipart = tf.tf_i[HIOFFSET];
 
-#if 1
-    while (n--)
+    while (n > 0)
     {
-        t_sample frac,  a,  b,  c,  d, cminusb;
-        tf.tf_d = dphase;
-        dphase += *in++ * conv;
-        addr = tab + (tf.tf_i[HIOFFSET] & mask);
-        tf.tf_i[HIOFFSET] = normhipart;
-        frac = tf.tf_d - UNITBIT32;
-        a = addr[0].w_float;
-        b = addr[1].w_float;
-        c = addr[2].w_float;
-        d = addr[3].w_float;
-        cminusb = c-b;
-        *out++ = b + frac * (
-            cminusb - 0.1666667f * (1.-frac) * (
-                (d - a - 3.0f * cminusb) * frac + (d + 2.0f*a - 3.0f*b)
-            )
-        );
+            /* find the points to interpolate, a chunk at a time */
+        int index[TABOSC4_CHUNK], i, chunk = (n < TABOSC4_CHUNK ?
+            n : TABOSC4_CHUNK);
+        t_sample frac[TABOSC4_CHUNK];
+        for (i = 0; i < chunk; i++)
+        {
+            tf.tf_d = dphase;
+            dphase += in[i] * conv;
+            index[i] = tf.tf_i[HIOFFSET] & mask;
+            tf.tf_i[HIOFFSET] = normhipart;
+            frac[i] = tf.tf_d - UNITBIT32;
+        }
+        array_interpolate4(tab, index, frac, out, chunk);
+        in += chunk;
+        out += chunk;
+        n -= chunk;
     }
-#endif
 
     tf.tf_d = UNITBIT32 * fnpoints;
     normhipart = tf.tf_i[HIOFFSET];
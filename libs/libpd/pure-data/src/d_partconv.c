@@ -0,0 +1,284 @@
+/* Copyright (c) 1997- Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/* partconv~: convolve a signal with an impulse response held in an array,
+using uniformly partitioned overlap-save FFT convolution.  The impulse
+response is cut into partitions of N points (N is the "partition size"
+argument, a power of two); each is transformed once, at 2N points, when the
+array is loaded.  Every N input samples we transform the latest 2N inputs,
+keep the spectrum in a delay line of past spectra, multiply-accumulate it
+against the impulse response spectra, and transform back.  The cost per
+sample grows with the number of partitions rather than the IR length times
+N, as direct (time-domain) convolution would.
+
+If the partition size divides the block size the output has no latency;
+otherwise (partitions larger than the block) it is delayed by N samples.
+Larger partitions are much cheaper for long impulse responses. */
+
+#include "m_pd.h"
+#include <string.h>
+
+void mayer_init( void);
+void mayer_term( void);
+typedef struct _fftplan t_fftplan;
+t_fftplan *mayer_getplan(int n);
+void mayer_planrealfft(t_fftplan *plan, int n, t_sample *fz);
+void mayer_planrealifft(t_fftplan *plan, int n, t_sample *fz);
+
+#define PARTCONV_DEFSIZE 64
+#define PARTCONV_MINSIZE 4
+#define PARTCONV_MAXSIZE 65536
+
+static t_class *partconv_tilde_class;
+
+typedef struct _partconv_tilde
+{
+    t_object x_obj;
+    t_float x_f;
+    t_symbol *x_arrayname;
+    int x_partsize;         /* partition size N; the FFT size is 2N */
+    int x_npart;            /* number of partitions, 0 if nothing loaded */
+    int x_loaded;           /* nonzero once we've tried to load the array */
+    t_fftplan *x_plan;
+    t_sample *x_irspec;     /* IR spectra, npart * 2N in Mayer layout */
+    t_sample *x_fdl;        /* spectra of past input frames, same layout */
+    int x_fdlphase;         /* slot the next input spectrum goes to */
+    t_sample *x_inbuf;      /* last 2N input samples */
+    t_sample *x_outbuf;     /* N output samples of the last frame */
+    t_sample *x_acc;        /* 2N accumulator for the output transform */
+    int x_phase;            /* position within the current partition */
+} t_partconv_tilde;
+
+static void partconv_tilde_freebuffers(t_partconv_tilde *x)
+{
+    int n2 = 2 * x->x_partsize;
+    if (x->x_npart)
+    {
+        freebytes(x->x_irspec, x->x_npart * n2 * sizeof(t_sample));
+        freebytes(x->x_fdl, x->x_npart * n2 * sizeof(t_sample));
+    }
+    x->x_irspec = x->x_fdl = 0;
+    x->x_npart = 0;
+}
+
+    /* transform the array into per-partition spectra.  The 1/2N scaling of
+    the inverse transform is folded in here. */
+static void partconv_tilde_load(t_partconv_tilde *x)
+{
+    int npoints, npart, n = x->x_partsize, n2 = 2 * n, i, j;
+    t_garray *a;
+    t_word *vec;
+    t_sample scale = 1. / n2;
+
+    partconv_tilde_freebuffers(x);
+    x->x_loaded = 1;
+    if (!*x->x_arrayname->s_name)
+        return;
+    if (!(a = (t_garray *)pd_findbyclass(x->x_arrayname, garray_class)))
+    {
+        pd_error(x, "partconv~: %s: no such array", x->x_arrayname->s_name);
+        return;
+    }
+    if (!garray_getfloatwords(a, &npoints, &vec))
+    {
+        pd_error(x, "partconv~: %s: bad template", x->x_arrayname->s_name);
+        return;
+    }
+    if (!npoints || !(x->x_plan = mayer_getplan(n2)))
+        return;
+    npart = (npoints + n - 1) / n;
+    x->x_irspec = (t_sample *)getbytes(npart * n2 * sizeof(t_sample));
+    x->x_fdl = (t_sample *)getbytes(npart * n2 * sizeof(t_sample));
+    if (!x->x_irspec || !x->x_fdl)
+    {
+        if (x->x_irspec)
+            freebytes(x->x_irspec, npart * n2 * sizeof(t_sample));
+        if (x->x_fdl)
+            freebytes(x->x_fdl, npart * n2 * sizeof(t_sample));
+        x->x_irspec = x->x_fdl = 0;
+        pd_error(x, "partconv~: out of memory");
+        return;
+    }
+    for (i = 0; i < npart; i++)
+    {
+        t_sample *spec = x->x_irspec + i * n2;
+        int onset = i * n, m = (npoints - onset < n ? npoints - onset : n);
+        for (j = 0; j < m; j++)
+            spec[j] = vec[onset + j].w_float * scale;
+            /* the upper half stays zero (getbytes zeroes it) */
+        mayer_planrealfft(x->x_plan, n2, spec);
+    }
+    x->x_npart = npart;
+    x->x_fdlphase = 0;
+    memset(x->x_inbuf, 0, n2 * sizeof(t_sample));
+    memset(x->x_outbuf, 0, n * sizeof(t_sample));
+    x->x_phase = 0;
+}
+
+    /* convolve one partition's worth of input, from the second half of
+    x_inbuf, into x_outbuf */
+static void partconv_tilde_doframe(t_partconv_tilde *x)
+{
+    int n = x->x_partsize, n2 = 2 * n, npart = x->x_npart, i, k;
+    t_sample *acc = x->x_acc, *spec;
+
+    if (!npart)
+    {
+        memset(x->x_outbuf, 0, n * sizeof(t_sample));
+        return;
+    }
+        /* transform the last 2N inputs into the delay line */
+    spec = x->x_fdl + x->x_fdlphase * n2;
+    memcpy(spec, x->x_inbuf, n2 * sizeof(t_sample));
+    mayer_planrealfft(x->x_plan, n2, spec);
+
+        /* multiply-accumulate against every partition.  In Mayer's layout
+        bin k has its real part at k and imaginary part at 2N-k; bins 0 and
+        N are real. */
+    memset(acc, 0, n2 * sizeof(t_sample));
+    for (i = 0; i < npart; i++)
+    {
+        int slot = x->x_fdlphase - i;
+        t_sample *xs, *hs, *accim, *xim, *him;
+        if (slot < 0)
+            slot += npart;
+        xs = x->x_fdl + slot * n2;
+        hs = x->x_irspec + i * n2;
+        acc[0] += xs[0] * hs[0];
+        acc[n] += xs[n] * hs[n];
+        for (k = 1, accim = acc + (n2-1), xim = xs + (n2-1),
+            him = hs + (n2-1); k < n; k++, accim--, xim--, him--)
+        {
+            t_sample xr = xs[k], xi = *xim, hr = hs[k], hi = *him;
+            acc[k] += xr * hr - xi * hi;
+            *accim += xr * hi + xi * hr;
+        }
+    }
+    mayer_planrealifft(x->x_plan, n2, acc);
+
+        /* overlap-save: only the second half is free of wraparound */
+    memcpy(x->x_outbuf, acc + n, n * sizeof(t_sample));
+    memmove(x->x_inbuf, x->x_inbuf + n, n * sizeof(t_sample));
+    if (++x->x_fdlphase == npart)
+        x->x_fdlphase = 0;
+}
+
+static t_int *partconv_tilde_perform(t_int *w)
+{
+    t_partconv_tilde *x = (t_partconv_tilde *)(w[1]);
+    t_sample *in = (t_sample *)(w[2]);
+    t_sample *out = (t_sample *)(w[3]);
+    int n = (int)(w[4]), partsize = x->x_partsize;
+    while (n > 0)
+    {
+        int m = partsize - x->x_phase;
+        if (m > n)
+            m = n;
+        memcpy(x->x_inbuf + partsize + x->x_phase, in, m * sizeof(t_sample));
+        memcpy(out, x->x_outbuf + x->x_phase, m * sizeof(t_sample));
+        if ((x->x_phase += m) == partsize)
+        {
+            partconv_tilde_doframe(x);
+            x->x_phase = 0;
+        }
+        in += m, out += m, n -= m;
+    }
+    return (w+5);
+}
+
+    /* partitions that fit the block: compute each one before outputting it,
+    so there's no latency */
+static t_int *partconv_tilde_perform_nolatency(t_int *w)
+{
+    t_partconv_tilde *x = (t_partconv_tilde *)(w[1]);
+    t_sample *in = (t_sample *)(w[2]);
+    t_sample *out = (t_sample *)(w[3]);
+    int n = (int)(w[4]), partsize = x->x_partsize;
+    for (; n > 0; in += partsize, out += partsize, n -= partsize)
+    {
+        memcpy(x->x_inbuf + partsize, in, partsize * sizeof(t_sample));
+        partconv_tilde_doframe(x);
+        memcpy(out, x->x_outbuf, partsize * sizeof(t_sample));
+    }
+    return (w+5);
+}
+
+static void partconv_tilde_dsp(t_partconv_tilde *x, t_signal **sp)
+{
+    int n = sp[0]->s_n;
+    if (!x->x_loaded)
+        partconv_tilde_load(x);
+        /* samples may still be pending from a different block size */
+    if (x->x_phase)
+    {
+        memset(x->x_outbuf, 0, x->x_partsize * sizeof(t_sample));
+        x->x_phase = 0;
+    }
+    dsp_add((n % x->x_partsize ?
+        partconv_tilde_perform : partconv_tilde_perform_nolatency), 4,
+            x, sp[0]->s_vec, sp[1]->s_vec, (t_int)n);
+}
+
+    /* "set" changes the array and (re)loads it; send it again after
+    changing the array's contents */
+static void partconv_tilde_set(t_partconv_tilde *x, t_symbol *s)
+{
+    x->x_arrayname = s;
+    partconv_tilde_load(x);
+}
+
+static void *partconv_tilde_new(t_symbol *s, t_floatarg f)
+{
+    t_partconv_tilde *x = (t_partconv_tilde *)pd_new(partconv_tilde_class);
+    int partsize = (f > 0 ? f : PARTCONV_DEFSIZE);
+    if (partsize < PARTCONV_MINSIZE)
+        partsize = PARTCONV_MINSIZE;
+    else if (partsize > PARTCONV_MAXSIZE)
+        partsize = PARTCONV_MAXSIZE;
+    if (partsize != (1 << ilog2(partsize)))
+    {
+        partsize = (1 << (ilog2(partsize) + 1));
+        pd_error(x, "partconv~: partition size rounded up to %d", partsize);
+    }
+    x->x_arrayname = s;
+    x->x_partsize = partsize;
+    x->x_npart = x->x_loaded = 0;
+    x->x_plan = 0;
+    x->x_irspec = x->x_fdl = 0;
+    x->x_fdlphase = x->x_phase = 0;
+    x->x_inbuf = (t_sample *)getbytes(2 * partsize * sizeof(t_sample));
+    x->x_outbuf = (t_sample *)getbytes(partsize * sizeof(t_sample));
+    x->x_acc = (t_sample *)getbytes(2 * partsize * sizeof(t_sample));
+    outlet_new(&x->x_obj, &s_signal);
+    x->x_f = 0;
+    return (x);
+}
+
+static void partconv_tilde_free(t_partconv_tilde *x)
+{
+    int partsize = x->x_partsize;
+    partconv_tilde_freebuffers(x);
+    freebytes(x->x_inbuf, 2 * partsize * sizeof(t_sample));
+    freebytes(x->x_outbuf, partsize * sizeof(t_sample));
+    freebytes(x->x_acc, 2 * partsize * sizeof(t_sample));
+}
+
+static void partconv_tilde_cleanup(t_class *c)
+{
+    mayer_term();
+}
+
+void d_partconv_setup(void)
+{
+    partconv_tilde_class = class_new(gensym("partconv~"),
+        (t_newmethod)partconv_tilde_new, (t_method)partconv_tilde_free,
+        sizeof(t_partconv_tilde), 0, A_DEFSYM, A_DEFFLOAT, 0);
+    CLASS_MAINSIGNALIN(partconv_tilde_class, t_partconv_tilde, x_f);
+    class_addmethod(partconv_tilde_class, (t_method)partconv_tilde_dsp,
+        gensym("dsp"), A_CANT, 0);
+    class_addmethod(partconv_tilde_class, (t_method)partconv_tilde_set,
+        gensym("set"), A_SYMBOL, 0);
+    class_setfreefn(partconv_tilde_class, partconv_tilde_cleanup);
+    mayer_init();
+}
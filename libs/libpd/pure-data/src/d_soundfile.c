@@ -12,12 +12,18 @@ thread so that they can be used in real time.  The readsf~ and writesf~
 objects use Posix-like threads. */
 
 #include "d_soundfile.h"
+#include "s_stuff.h"
 #ifdef _WIN32
 #include <io.h>
 #endif
 #include <fcntl.h>
 #include <stdio.h>
 #include <pthread.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
 
 /* Supported sample formats: LPCM (16 or 24 bit int) & 32 bit float */
 
@@ -44,6 +50,51 @@ typedef union _floatuint
   uint32_t ui;
 } t_floatuint;
 
+    /* ints read and written across threads without a mutex: the stream
+    FIFO indices, flags and request codes, and the paged-in marks of mapped
+    soundfiles */
+#if __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+#define SFIO_LOAD(ptr) atomic_load_explicit((_Atomic int *)(ptr), \
+    memory_order_acquire)
+#define SFIO_STORE(ptr, val) atomic_store_explicit((_Atomic int *)(ptr), \
+    (val), memory_order_release)
+#define SFIO_ADD(ptr, val) atomic_fetch_add((_Atomic int *)(ptr), (val))
+#define SFIO_EXCHANGE(ptr, val) atomic_exchange((_Atomic int *)(ptr), (val))
+#elif defined(_MSC_VER)
+#define SFIO_LOAD(ptr) InterlockedOr((volatile long *)(ptr), 0)
+#define SFIO_STORE(ptr, val) InterlockedExchange((volatile long *)(ptr), (val))
+#define SFIO_ADD(ptr, val) InterlockedExchangeAdd((volatile long *)(ptr), (val))
+#define SFIO_EXCHANGE(ptr, val) InterlockedExchange((volatile long *)(ptr), \
+    (val))
+#else
+#define SFIO_LOAD(ptr) __atomic_load_n((int *)(ptr), __ATOMIC_ACQUIRE)
+#define SFIO_STORE(ptr, val) __atomic_store_n((int *)(ptr), (val), \
+    __ATOMIC_RELEASE)
+#define SFIO_ADD(ptr, val) __atomic_fetch_add((int *)(ptr), (val), \
+    __ATOMIC_SEQ_CST)
+#define SFIO_EXCHANGE(ptr, val) __atomic_exchange_n((int *)(ptr), (val), \
+    __ATOMIC_SEQ_CST)
+#endif
+
+    /* the semaphore that wakes the I/O and paging threads; posting it is
+    safe from the audio thread */
+#ifdef __APPLE__
+#include <dispatch/dispatch.h>
+typedef dispatch_semaphore_t t_sfio_sem;
+#define sfio_sem_init(s) (*(s) = dispatch_semaphore_create(0))
+#define sfio_sem_destroy(s) dispatch_release(*(s))
+#define sfio_sem_post(s) dispatch_semaphore_signal(*(s))
+#define sfio_sem_wait(s) dispatch_semaphore_wait(*(s), DISPATCH_TIME_FOREVER)
+#else
+#include <semaphore.h>
+typedef sem_t t_sfio_sem;
+#define sfio_sem_init(s) sem_init((s), 0, 0)
+#define sfio_sem_destroy(s) sem_destroy(s)
+#define sfio_sem_post(s) sem_post(s)
+#define sfio_sem_wait(s) while (sem_wait(s) && errno == EINTR)
+#endif
+
 /* ----- soundfile ----- */
 
 void soundfile_clear(t_soundfile *sf)
@@ -64,6 +115,23 @@ int soundfile_needsbyteswap(const t_soundfile *sf)
     return sf->sf_bigendian != sys_isbigendian();
 }
 
+ssize_t soundfile_readsamples(t_soundfile *sf, void *buf, size_t size)
+{
+    if (sf->sf_data)
+        return sf->sf_type->t_readsamplesfn(sf, buf, size);
+    return read(sf->sf_fd, buf, size);
+}
+
+void soundfile_close(t_soundfile *sf)
+{
+    if (sf->sf_data)
+        sf->sf_type->t_closefn(sf);
+    sf->sf_data = NULL;
+    if (sf->sf_fd >= 0)
+        sys_close(sf->sf_fd);
+    sf->sf_fd = -1;
+}
+
 const char* soundfile_strerror(int errnum)
 {
     switch (errnum)
@@ -107,7 +175,7 @@ static void object_sferror(const void *x, const char *header,
 
 /* ----- soundfile type ----- */
 
-#define SFMAXTYPES 4
+#define SFMAXTYPES 5
 
 /* should these globals be PERTHREAD? */
 
@@ -129,6 +197,7 @@ void soundfile_wave_setup(void);
 void soundfile_aiff_setup(void);
 void soundfile_caf_setup(void);
 void soundfile_next_setup(void);
+void soundfile_flac_setup(void);
 
     /** set up built-in types */
 void soundfile_type_setup(void)
@@ -137,6 +206,7 @@ void soundfile_type_setup(void)
     soundfile_aiff_setup();
     soundfile_caf_setup();
     soundfile_next_setup();
+    soundfile_flac_setup();
 }
 
 int soundfile_addtype(const t_soundfile_type *type)
@@ -325,6 +395,7 @@ int open_soundfile_via_fd(int fd, t_soundfile *sf, size_t skipframes)
 {
     off_t offset;
     errno = 0;
+    sf->sf_data = NULL;
     if (sf->sf_headersize >= 0) /* header detection overridden */
     {
             /* interpret data size from file size */
@@ -376,10 +447,19 @@ int open_soundfile_via_fd(int fd, t_soundfile *sf, size_t skipframes)
             goto badheader;
     }
 
-        /* seek past header and any sample frames to skip */
-    offset = sf->sf_headersize + (skipframes * sf->sf_bytesperframe);
-    if (lseek(sf->sf_fd, offset, 0) < offset)
-        goto badheader;
+        /* seek past header and any sample frames to skip; compressed
+        types find the frame themselves */
+    if (sf->sf_data)
+    {
+        if (!sf->sf_type->t_seekfn(sf, skipframes))
+            goto badheader;
+    }
+    else
+    {
+        offset = sf->sf_headersize + (skipframes * sf->sf_bytesperframe);
+        if (lseek(sf->sf_fd, offset, 0) < offset)
+            goto badheader;
+    }
     sf->sf_bytelimit -= skipframes * sf->sf_bytesperframe;
     if (sf->sf_bytelimit < 0)
         sf->sf_bytelimit = 0;
@@ -392,6 +472,9 @@ badheader:
         print out the error... */
     if (!errno)
         errno = SOUNDFILE_ERRMALFORMED;
+    if (sf->sf_data)
+        sf->sf_type->t_closefn(sf);
+    sf->sf_data = NULL;
     sf->sf_fd = -1;
     if (fd >= 0)
         sys_close(fd);
@@ -430,71 +513,210 @@ int open_soundfile_via_canvas(t_canvas *canvas, const char *filename,
     return sf_fd;
 }
 
+/* ----- sample format conversion ----- */
+
+    /* Each sample format (2, 3 or 4 bytes, little or big endian) has its own
+    pair of converters between one channel of interleaved file data and a
+    vector of samples, looked up once per call rather than branched on for
+    every channel.  "stride" is the distance between frames in bytes and
+    "fstride" the distance between samples, so that the same converters serve
+    both signal vectors and arrays.  Integer samples are scaled by a power of
+    two in single precision, which is exact, so the results are the same as
+    ever. */
+
+typedef void (*t_sfdecodefn)(const unsigned char *sp, size_t stride,
+    t_sample *fp, size_t fstride, size_t n);
+typedef void (*t_sfencodefn)(unsigned char *sp, size_t stride,
+    const t_sample *fp, size_t fstride, size_t n, t_sample normalfactor);
+
+#define SFSCALE16 ((t_sample)(1. / 32768.))
+#define SFSCALE24 ((t_sample)(1. / 2147483648.))
+
+static void sfdecode_16le(const unsigned char *sp, size_t stride,
+    t_sample *fp, size_t fstride, size_t n)
+{
+    size_t j;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+        *fp = (int16_t)(sp[0] | (sp[1] << 8)) * SFSCALE16;
+}
+
+static void sfdecode_16be(const unsigned char *sp, size_t stride,
+    t_sample *fp, size_t fstride, size_t n)
+{
+    size_t j;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+        *fp = (int16_t)(sp[1] | (sp[0] << 8)) * SFSCALE16;
+}
+
+    /* 24 bit samples go in the top of an int so that the sign comes along */
+static void sfdecode_24le(const unsigned char *sp, size_t stride,
+    t_sample *fp, size_t fstride, size_t n)
+{
+    size_t j;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+        *fp = (int32_t)(((uint32_t)sp[2] << 24) | (sp[1] << 16) |
+            (sp[0] << 8)) * SFSCALE24;
+}
+
+static void sfdecode_24be(const unsigned char *sp, size_t stride,
+    t_sample *fp, size_t fstride, size_t n)
+{
+    size_t j;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+        *fp = (int32_t)(((uint32_t)sp[0] << 24) | (sp[1] << 16) |
+            (sp[2] << 8)) * SFSCALE24;
+}
+
+static void sfdecode_32le(const unsigned char *sp, size_t stride,
+    t_sample *fp, size_t fstride, size_t n)
+{
+    size_t j;
+    t_floatuint alias;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+    {
+        alias.ui = ((uint32_t)sp[3] << 24) | (sp[2] << 16) |
+            (sp[1] << 8) | sp[0];
+        *fp = (t_sample)alias.f;
+    }
+}
+
+static void sfdecode_32be(const unsigned char *sp, size_t stride,
+    t_sample *fp, size_t fstride, size_t n)
+{
+    size_t j;
+    t_floatuint alias;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+    {
+        alias.ui = ((uint32_t)sp[0] << 24) | (sp[1] << 16) |
+            (sp[2] << 8) | sp[3];
+        *fp = (t_sample)alias.f;
+    }
+}
+
+    /* round down by offsetting into positive range before truncating,
+    then clip */
+#define SFROUND(f, max, xx) \
+    (xx) = (max + 1.) + (f), (xx) -= (max + 1), \
+    (xx) = ((xx) < -(max) ? -(max) : ((xx) > (max) ? (max) : (xx)))
+
+static void sfencode_16le(unsigned char *sp, size_t stride,
+    const t_sample *fp, size_t fstride, size_t n, t_sample normalfactor)
+{
+    t_sample ff = normalfactor * 32768.;
+    size_t j;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+    {
+        t_sample f = *fp * ff;
+        int xx;
+        SFROUND(f, 32767, xx);
+        sp[0] = xx;
+        sp[1] = (xx >> 8);
+    }
+}
+
+static void sfencode_16be(unsigned char *sp, size_t stride,
+    const t_sample *fp, size_t fstride, size_t n, t_sample normalfactor)
+{
+    t_sample ff = normalfactor * 32768.;
+    size_t j;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+    {
+        t_sample f = *fp * ff;
+        int xx;
+        SFROUND(f, 32767, xx);
+        sp[0] = (xx >> 8);
+        sp[1] = xx;
+    }
+}
+
+static void sfencode_24le(unsigned char *sp, size_t stride,
+    const t_sample *fp, size_t fstride, size_t n, t_sample normalfactor)
+{
+    t_sample ff = normalfactor * 8388608.;
+    size_t j;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+    {
+        t_sample f = *fp * ff;
+        int xx;
+        SFROUND(f, 8388607, xx);
+        sp[0] = xx;
+        sp[1] = (xx >> 8);
+        sp[2] = (xx >> 16);
+    }
+}
+
+static void sfencode_24be(unsigned char *sp, size_t stride,
+    const t_sample *fp, size_t fstride, size_t n, t_sample normalfactor)
+{
+    t_sample ff = normalfactor * 8388608.;
+    size_t j;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+    {
+        t_sample f = *fp * ff;
+        int xx;
+        SFROUND(f, 8388607, xx);
+        sp[0] = (xx >> 16);
+        sp[1] = (xx >> 8);
+        sp[2] = xx;
+    }
+}
+
+static void sfencode_32le(unsigned char *sp, size_t stride,
+    const t_sample *fp, size_t fstride, size_t n, t_sample normalfactor)
+{
+    size_t j;
+    t_floatuint f2;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+    {
+        f2.f = *fp * normalfactor;
+        sp[3] = (f2.ui >> 24); sp[2] = (f2.ui >> 16);
+        sp[1] = (f2.ui >> 8);  sp[0] = f2.ui;
+    }
+}
+
+static void sfencode_32be(unsigned char *sp, size_t stride,
+    const t_sample *fp, size_t fstride, size_t n, t_sample normalfactor)
+{
+    size_t j;
+    t_floatuint f2;
+    for (j = 0; j < n; j++, sp += stride, fp += fstride)
+    {
+        f2.f = *fp * normalfactor;
+        sp[0] = (f2.ui >> 24); sp[1] = (f2.ui >> 16);
+        sp[2] = (f2.ui >> 8);  sp[3] = f2.ui;
+    }
+}
+
+    /* indexed by bytes per sample - 2, then big endian */
+static const t_sfdecodefn sf_decoders[3][2] = {
+    {sfdecode_16le, sfdecode_16be},
+    {sfdecode_24le, sfdecode_24be},
+    {sfdecode_32le, sfdecode_32be}
+};
+
+static const t_sfencodefn sf_encoders[3][2] = {
+    {sfencode_16le, sfencode_16be},
+    {sfencode_24le, sfencode_24be},
+    {sfencode_32le, sfencode_32be}
+};
+
+    /* arrays are converted in place: w_float is the first member of a
+    t_word, so its samples are just spaced further apart */
+#define SFWORDSTRIDE (sizeof(t_word) / sizeof(t_sample))
+
 static void soundfile_xferin_sample(const t_soundfile *sf, int nvecs,
     t_sample **vecs, size_t framesread, unsigned char *buf, size_t nframes)
 {
     int nchannels = (sf->sf_nchannels < nvecs ? sf->sf_nchannels : nvecs), i;
     size_t j;
-    unsigned char *sp, *sp2;
     t_sample *fp;
-    for (i = 0, sp = buf; i < nchannels; i++, sp += sf->sf_bytespersample)
+    if (sf->sf_bytespersample >= 2 && sf->sf_bytespersample <= 4)
     {
-        if (sf->sf_bytespersample == 2)
-        {
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                        *fp = SCALE * ((sp2[0] << 24) | (sp2[1] << 16));
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                        *fp = SCALE * ((sp2[1] << 24) | (sp2[0] << 16));
-            }
-        }
-        else if (sf->sf_bytespersample == 3)
-        {
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                        *fp = SCALE * ((sp2[0] << 24) | (sp2[1] << 16) |
-                                       (sp2[2] << 8));
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                        *fp = SCALE * ((sp2[2] << 24) | (sp2[1] << 16) |
-                                       (sp2[0] << 8));
-            }
-        }
-        else if (sf->sf_bytespersample == 4)
-        {
-            t_floatuint alias;
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                {
-                    alias.ui = ((sp2[0] << 24) | (sp2[1] << 16) |
-                                (sp2[2] << 8)  |  sp2[3]);
-                    *fp = (t_sample)alias.f;
-                }
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                {
-                    alias.ui = ((sp2[3] << 24) | (sp2[2] << 16) |
-                                (sp2[1] << 8)  |  sp2[0]);
-                    *fp = (t_sample)alias.f;
-                }
-            }
-        }
+        t_sfdecodefn decode =
+            sf_decoders[sf->sf_bytespersample - 2][sf->sf_bigendian != 0];
+        for (i = 0; i < nchannels; i++)
+            (*decode)(buf + i * sf->sf_bytespersample, sf->sf_bytesperframe,
+                vecs[i] + framesread, 1, nframes);
     }
         /* zero out other outputs */
     for (i = sf->sf_nchannels; i < nvecs; i++)
@@ -505,68 +727,16 @@ static void soundfile_xferin_sample(const t_soundfile *sf, int nvecs,
 static void soundfile_xferin_words(const t_soundfile *sf, int nvecs,
     t_word **vecs, size_t framesread, unsigned char *buf, size_t nframes)
 {
-    unsigned char *sp, *sp2;
     t_word *wp;
     int nchannels = (sf->sf_nchannels < nvecs ? sf->sf_nchannels : nvecs), i;
     size_t j;
-    for (i = 0, sp = buf; i < nchannels; i++, sp += sf->sf_bytespersample)
+    if (sf->sf_bytespersample >= 2 && sf->sf_bytespersample <= 4)
     {
-        if (sf->sf_bytespersample == 2)
-        {
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                        wp->w_float = SCALE * ((sp2[0] << 24) | (sp2[1] << 16));
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                        wp->w_float = SCALE * ((sp2[1] << 24) | (sp2[0] << 16));
-            }
-        }
-        else if (sf->sf_bytespersample == 3)
-        {
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                        wp->w_float = SCALE * ((sp2[0] << 24) | (sp2[1] << 16) |
-                                               (sp2[2] << 8));
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                        wp->w_float = SCALE * ((sp2[2] << 24) | (sp2[1] << 16) |
-                                               (sp2[0] << 8));
-            }
-        }
-        else if (sf->sf_bytespersample == 4)
-        {
-            t_floatuint alias;
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                {
-                    alias.ui = ((sp2[0] << 24) | (sp2[1] << 16) |
-                                (sp2[2] << 8)  |  sp2[3]);
-                    wp->w_float = (t_float)alias.f;
-                }
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + framesread;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                {
-                    alias.ui = ((sp2[3] << 24) | (sp2[2] << 16) |
-                                (sp2[1] << 8)  |  sp2[0]);
-                    wp->w_float = (t_float)alias.f;
-                }
-            }
-        }
+        t_sfdecodefn decode =
+            sf_decoders[sf->sf_bytespersample - 2][sf->sf_bigendian != 0];
+        for (i = 0; i < nchannels; i++)
+            (*decode)(buf + i * sf->sf_bytespersample, sf->sf_bytesperframe,
+                &vecs[i][framesread].w_float, SFWORDSTRIDE, nframes);
     }
         /* zero out other outputs */
     for (i = sf->sf_nchannels; i < nvecs; i++)
@@ -574,6 +744,297 @@ static void soundfile_xferin_words(const t_soundfile *sf, int nvecs,
             (wp++)->w_float = 0;
 }
 
+/* ----------------------- memory-mapped soundfiles ----------------------- */
+
+    /* Reading a mapped page that isn't in memory yet blocks until the disk
+    delivers it, which the audio thread mustn't do.  So each map has a pager
+    thread that touches the pages ahead of the reader, a chunk at a time,
+    and marks the chunks it has paged in.  Readers only read marked chunks,
+    giving zeros otherwise, and tell the pager where they are.  Chunks that
+    fall far behind are unmarked again since the system may page them out.
+    Non-realtime callers can page in a range themselves with
+    soundmap_prefetch(). */
+
+#define SOUNDMAP_CHUNK 262144   /* bytes per chunk, a multiple of pages */
+#define SOUNDMAP_AHEAD 8        /* chunks paged in ahead of the reader */
+#define SOUNDMAP_KEEP 8         /* chunks kept marked around that window */
+#define SOUNDMAP_PAGE 4096      /* touch stride, no larger than a page */
+
+typedef struct _soundpager
+{
+    pthread_t p_thread;
+    t_sfio_sem p_sem;       /**< posted when the reader moves or on close */
+    int p_want;             /**< chunk the reader is at */
+    int p_quit;
+    int p_nchunks;
+    int p_ready[1];         /**< per chunk: nonzero if paged in */
+} t_soundpager;
+
+    /* read a byte of every page of a chunk so it is in memory */
+static void soundmap_touch(const t_soundmap *m, int chunk)
+{
+    const volatile unsigned char *bp =
+        (const unsigned char *)m->sm_base + (size_t)chunk * SOUNDMAP_CHUNK;
+    size_t size = m->sm_mapsize - (size_t)chunk * SOUNDMAP_CHUNK, i;
+    unsigned char sum = 0;
+    if (size > SOUNDMAP_CHUNK)
+        size = SOUNDMAP_CHUNK;
+    for (i = 0; i < size; i += SOUNDMAP_PAGE)
+        sum += bp[i];
+    (void)sum;
+}
+
+static void *soundmap_pagerthread(void *z)
+{
+    t_soundmap *m = (t_soundmap *)z;
+    t_soundpager *p = m->sm_pager;
+    int lo = 0, hi = 0;     /* chunks which may be marked */
+    while (!SFIO_LOAD(&p->p_quit))
+    {
+        int want = SFIO_LOAD(&p->p_want), first, last, c;
+        first = (want > 0 ? want - 1 : 0);
+        last = (want + SOUNDMAP_AHEAD < p->p_nchunks ?
+            want + SOUNDMAP_AHEAD : p->p_nchunks);
+            /* forget what is out of reach, except for the start of the
+            file where looped playback returns to */
+        for (c = lo; c < hi; c++)
+            if ((c < first - SOUNDMAP_KEEP || c >= last + SOUNDMAP_KEEP) &&
+                c >= SOUNDMAP_AHEAD)
+                    SFIO_STORE(&p->p_ready[c], 0);
+        lo = (first > SOUNDMAP_KEEP ? first - SOUNDMAP_KEEP : 0);
+        hi = (last + SOUNDMAP_KEEP < p->p_nchunks ?
+            last + SOUNDMAP_KEEP : p->p_nchunks);
+#ifndef _WIN32
+        madvise((char *)m->sm_base + (size_t)first * SOUNDMAP_CHUNK,
+            (size_t)(last - first) * SOUNDMAP_CHUNK, MADV_WILLNEED);
+#endif
+        for (c = first; c < last; c++)
+        {
+            if (SFIO_LOAD(&p->p_want) != want || SFIO_LOAD(&p->p_quit))
+                break;
+            if (!SFIO_LOAD(&p->p_ready[c]))
+            {
+                soundmap_touch(m, c);
+                SFIO_STORE(&p->p_ready[c], 1);
+            }
+        }
+        if (SFIO_LOAD(&p->p_want) == want)
+            sfio_sem_wait(&p->p_sem);
+    }
+    return (0);
+}
+
+    /* chunk holding a frame's first byte */
+#define SOUNDMAP_CHUNKOF(m, frame) (int)(((size_t)(m)->sm_sf.sf_headersize + \
+    (frame) * (m)->sm_sf.sf_bytesperframe) / SOUNDMAP_CHUNK)
+
+void soundmap_request(t_soundmap *m, size_t frame)
+{
+    t_soundpager *p = m->sm_pager;
+    int chunk;
+    if (!p || frame >= m->sm_nframes)
+        return;
+    chunk = SOUNDMAP_CHUNKOF(m, frame);
+    if (SFIO_LOAD(&p->p_want) != chunk)
+    {
+        SFIO_STORE(&p->p_want, chunk);
+        sfio_sem_post(&p->p_sem);
+    }
+}
+
+int soundmap_ready(const t_soundmap *m, size_t onset, size_t nframes)
+{
+    t_soundpager *p = m->sm_pager;
+    int c, last;
+    if (!p || !nframes)
+        return (1);
+    last = (int)(((size_t)m->sm_sf.sf_headersize +
+        (onset + nframes) * m->sm_sf.sf_bytesperframe - 1) / SOUNDMAP_CHUNK);
+    for (c = SOUNDMAP_CHUNKOF(m, onset); c <= last; c++)
+        if (!SFIO_LOAD(&p->p_ready[c]))
+            return (0);
+    return (1);
+}
+
+    /** map the whole file rather than just the sample data so that the
+        mapping offset is page aligned; only the pages actually read are
+        ever loaded */
+t_soundmap *soundmap_open(const t_canvas *canvas, const char *filename)
+{
+    t_soundmap *m;
+    t_soundfile sf;
+    t_soundpager *p;
+    off_t filesize;
+    size_t mapsize;
+    void *base;
+    int fd, nchunks;
+
+    soundfile_clear(&sf);
+    sf.sf_headersize = -1;
+    if ((fd = open_soundfile_via_canvas((t_canvas *)canvas, filename, &sf, 0))
+        < 0)
+            return (0);
+        /* compressed files have no samples to map */
+    if (sf.sf_data || sf.sf_bytespersample < 2 || sf.sf_bytespersample > 4)
+    {
+        soundfile_close(&sf);
+        errno = SOUNDFILE_ERRSAMPLEFMT;
+        return (0);
+    }
+    if ((filesize = lseek(fd, 0, SEEK_END)) <= sf.sf_headersize)
+    {
+        errno = SOUNDFILE_ERRMALFORMED;
+        sys_close(fd);
+        return (0);
+    }
+        /* the header's data size may be a placeholder, so trust the file */
+    if (sf.sf_bytelimit > filesize - sf.sf_headersize)
+        sf.sf_bytelimit = filesize - sf.sf_headersize;
+    mapsize = (size_t)(sf.sf_headersize + sf.sf_bytelimit);
+    if ((off_t)mapsize != sf.sf_headersize + sf.sf_bytelimit)
+    {
+        errno = EFBIG;  /* larger than the address space */
+        sys_close(fd);
+        return (0);
+    }
+    m = (t_soundmap *)getbytes(sizeof(*m));
+#ifdef _WIN32
+    m->sm_handle = CreateFileMapping((HANDLE)_get_osfhandle(fd), NULL,
+        PAGE_READONLY, 0, 0, NULL);
+    base = (m->sm_handle ?
+        MapViewOfFile(m->sm_handle, FILE_MAP_READ, 0, 0, mapsize) : NULL);
+    if (!base)
+    {
+        if (m->sm_handle)
+            CloseHandle(m->sm_handle);
+        freebytes(m, sizeof(*m));
+        errno = ENOMEM;
+        sys_close(fd);
+        return (0);
+    }
+#else
+    base = mmap(NULL, mapsize, PROT_READ, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED)
+    {
+        freebytes(m, sizeof(*m));
+        sys_close(fd);
+        return (0);
+    }
+#endif
+        /* the mapping stays valid after the descriptor is closed */
+    sys_close(fd);
+    sf.sf_fd = -1;
+    soundfile_copy(&m->sm_sf, &sf);
+    m->sm_nframes = sf.sf_bytelimit / sf.sf_bytesperframe;
+    m->sm_base = base;
+    m->sm_mapsize = mapsize;
+    m->sm_data = (const unsigned char *)base + sf.sf_headersize;
+
+        /* start paging in from the beginning.  If the thread can't be
+        started, reads go straight to the mapping and may block. */
+    nchunks = (int)((mapsize + SOUNDMAP_CHUNK - 1) / SOUNDMAP_CHUNK);
+    p = (t_soundpager *)getbytes(sizeof(*p) + (nchunks - 1) * sizeof(int));
+    p->p_nchunks = nchunks;
+    p->p_want = SOUNDMAP_CHUNKOF(m, 0);
+    sfio_sem_init(&p->p_sem);
+    m->sm_pager = p;
+    if (pthread_create(&p->p_thread, 0, soundmap_pagerthread, m))
+    {
+        sfio_sem_destroy(&p->p_sem);
+        freebytes(p, sizeof(*p) + (nchunks - 1) * sizeof(int));
+        m->sm_pager = 0;
+    }
+    return (m);
+}
+
+void soundmap_close(t_soundmap *m)
+{
+    t_soundpager *p = m->sm_pager;
+    if (p)
+    {
+        SFIO_STORE(&p->p_quit, 1);
+        sfio_sem_post(&p->p_sem);
+        pthread_join(p->p_thread, 0);
+        sfio_sem_destroy(&p->p_sem);
+        freebytes(p, sizeof(*p) + (p->p_nchunks - 1) * sizeof(int));
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(m->sm_base);
+    CloseHandle(m->sm_handle);
+#else
+    munmap(m->sm_base, m->sm_mapsize);
+#endif
+    freebytes(m, sizeof(*m));
+}
+
+    /* the sample format's decoder; soundmap_open() checked the size */
+#define SOUNDMAP_DECODER(m) \
+    sf_decoders[(m)->sm_sf.sf_bytespersample - 2][(m)->sm_sf.sf_bigendian != 0]
+
+void soundmap_getsamples(const t_soundmap *m, size_t frame, int channel,
+    int n, t_sample *dest)
+{
+    (*SOUNDMAP_DECODER(m))(m->sm_data + frame * m->sm_sf.sf_bytesperframe +
+        channel * m->sm_sf.sf_bytespersample, m->sm_sf.sf_bytesperframe,
+            dest, 1, n);
+}
+
+size_t soundmap_read(t_soundmap *m, size_t onset, size_t nframes,
+    t_sample *dest)
+{
+    t_soundpager *p = m->sm_pager;
+    int nchannels = m->sm_sf.sf_nchannels, ch;
+    size_t nread = (onset < m->sm_nframes ? m->sm_nframes - onset : 0), i;
+    if (nread > nframes)
+        nread = nframes;
+    soundmap_request(m, onset);
+    if (p && nread)
+    {
+            /* stop at the first chunk that isn't paged in yet */
+        size_t start = m->sm_sf.sf_headersize +
+            onset * m->sm_sf.sf_bytesperframe,
+            end = start + nread * m->sm_sf.sf_bytesperframe,
+            avail;
+        int c = (int)(start / SOUNDMAP_CHUNK);
+        while ((size_t)c * SOUNDMAP_CHUNK < end && SFIO_LOAD(&p->p_ready[c]))
+            c++;
+        avail = (size_t)c * SOUNDMAP_CHUNK;
+        if (avail < end)
+            nread = (avail > start ?
+                (avail - start) / m->sm_sf.sf_bytesperframe : 0);
+    }
+    if (nread)
+        for (ch = 0; ch < nchannels; ch++)
+            (*SOUNDMAP_DECODER(m))(m->sm_data +
+                onset * m->sm_sf.sf_bytesperframe +
+                    ch * m->sm_sf.sf_bytespersample,
+                        m->sm_sf.sf_bytesperframe, dest + ch, nchannels, nread);
+    for (i = nread * nchannels; i < nframes * nchannels; i++)
+        dest[i] = 0;
+    return (nread);
+}
+
+void soundmap_prefetch(t_soundmap *m, size_t onset, size_t nframes)
+{
+    t_soundpager *p = m->sm_pager;
+    int c, last;
+    if (onset >= m->sm_nframes || !nframes)
+        return;
+    if (nframes > m->sm_nframes - onset)
+        nframes = m->sm_nframes - onset;
+    last = (int)(((size_t)m->sm_sf.sf_headersize +
+        (onset + nframes) * m->sm_sf.sf_bytesperframe - 1) / SOUNDMAP_CHUNK);
+    soundmap_request(m, onset);
+    for (c = SOUNDMAP_CHUNKOF(m, onset); c <= last; c++)
+    {
+        if (p && SFIO_LOAD(&p->p_ready[c]))
+            continue;
+        soundmap_touch(m, c);
+        if (p)
+            SFIO_STORE(&p->p_ready[c], 1);
+    }
+}
+
     /* soundfiler_write ...
 
        usage: write [flags] filename table ...
@@ -755,7 +1216,9 @@ static int create_soundfile(t_canvas *canvas, const char *filename,
         if (!sf->sf_type->t_addextensionfn(filenamebuf, MAXPDSTRING-10))
             return -1;
     filenamebuf[MAXPDSTRING-10] = 0; /* FIXME: what is the 10 for? */
-    canvas_makefilename(canvas, filenamebuf, pathbuf, MAXPDSTRING);
+    if (canvas)
+        canvas_makefilename(canvas, filenamebuf, pathbuf, MAXPDSTRING);
+    else strcpy(pathbuf, filenamebuf);
     if ((fd = sys_open(pathbuf, O_WRONLY | O_CREAT | O_TRUNC, 0666)) < 0)
         return -1;
     sf->sf_fd = fd;
@@ -791,107 +1254,13 @@ static void soundfile_xferout_sample(const t_soundfile *sf,
     t_sample normalfactor)
 {
     int i;
-    size_t j;
-    unsigned char *sp, *sp2;
-    t_sample *fp;
-    for (i = 0, sp = buf; i < sf->sf_nchannels; i++,
-        sp += sf->sf_bytespersample)
-    {
-        if (sf->sf_bytespersample == 2)
-        {
-            t_sample ff = normalfactor * 32768.;
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                {
-                    int xx = 32768. + (*fp * ff);
-                    xx -= 32768;
-                    if (xx < -32767)
-                        xx = -32767;
-                    if (xx > 32767)
-                        xx = 32767;
-                    sp2[0] = (xx >> 8);
-                    sp2[1] = xx;
-                }
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                {
-                    int xx = 32768. + (*fp * ff);
-                    xx -= 32768;
-                    if (xx < -32767)
-                        xx = -32767;
-                    if (xx > 32767)
-                        xx = 32767;
-                    sp2[1] = (xx >> 8);
-                    sp2[0] = xx;
-                }
-            }
-        }
-        else if (sf->sf_bytespersample == 3)
-        {
-            t_sample ff = normalfactor * 8388608.;
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                {
-                    int xx = 8388608. + (*fp * ff);
-                    xx -= 8388608;
-                    if (xx < -8388607)
-                        xx = -8388607;
-                    if (xx > 8388607)
-                        xx = 8388607;
-                    sp2[0] = (xx >> 16);
-                    sp2[1] = (xx >> 8);
-                    sp2[2] = xx;
-                }
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                {
-                    int xx = 8388608. + (*fp * ff);
-                    xx -= 8388608;
-                    if (xx < -8388607)
-                        xx = -8388607;
-                    if (xx > 8388607)
-                        xx = 8388607;
-                    sp2[2] = (xx >> 16);
-                    sp2[1] = (xx >> 8);
-                    sp2[0] = xx;
-                }
-            }
-        }
-        else if (sf->sf_bytespersample == 4)
-        {
-            t_floatuint f2;
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                {
-                    f2.f = *fp * normalfactor;
-                    sp2[0] = (f2.ui >> 24); sp2[1] = (f2.ui >> 16);
-                    sp2[2] = (f2.ui >> 8);  sp2[3] = f2.ui;
-                }
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, fp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, fp++)
-                {
-                    f2.f = *fp * normalfactor;
-                    sp2[3] = (f2.ui >> 24); sp2[2] = (f2.ui >> 16);
-                    sp2[1] = (f2.ui >> 8);  sp2[0] = f2.ui;
-                }
-            }
-        }
-    }
+    t_sfencodefn encode;
+    if (sf->sf_bytespersample < 2 || sf->sf_bytespersample > 4)
+        return;
+    encode = sf_encoders[sf->sf_bytespersample - 2][sf->sf_bigendian != 0];
+    for (i = 0; i < sf->sf_nchannels; i++)
+        (*encode)(buf + i * sf->sf_bytespersample, sf->sf_bytesperframe,
+            vecs[i] + onsetframes, 1, nframes, normalfactor);
 }
 
 static void soundfile_xferout_words(const t_soundfile *sf, t_word **vecs,
@@ -899,112 +1268,181 @@ static void soundfile_xferout_words(const t_soundfile *sf, t_word **vecs,
     t_sample normalfactor)
 {
     int i;
-    size_t j;
-    unsigned char *sp, *sp2;
-    t_word *wp;
-    for (i = 0, sp = buf; i < sf->sf_nchannels;
-         i++, sp += sf->sf_bytespersample)
-    {
-        if (sf->sf_bytespersample == 2)
-        {
-            t_sample ff = normalfactor * 32768.;
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                {
-                    int xx = 32768. + (wp->w_float * ff);
-                    xx -= 32768;
-                    if (xx < -32767)
-                        xx = -32767;
-                    if (xx > 32767)
-                        xx = 32767;
-                    sp2[0] = (xx >> 8);
-                    sp2[1] = xx;
-                }
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                {
-                    int xx = 32768. + (wp->w_float * ff);
-                    xx -= 32768;
-                    if (xx < -32767)
-                        xx = -32767;
-                    if (xx > 32767)
-                        xx = 32767;
-                    sp2[1] = (xx >> 8);
-                    sp2[0] = xx;
-                }
-            }
-        }
-        else if (sf->sf_bytespersample == 3)
+    t_sfencodefn encode;
+    if (sf->sf_bytespersample < 2 || sf->sf_bytespersample > 4)
+        return;
+    encode = sf_encoders[sf->sf_bytespersample - 2][sf->sf_bigendian != 0];
+    for (i = 0; i < sf->sf_nchannels; i++)
+        (*encode)(buf + i * sf->sf_bytespersample, sf->sf_bytesperframe,
+            &vecs[i][onsetframes].w_float, SFWORDSTRIDE, nframes,
+                normalfactor);
+}
+
+/* ---------------------- sequential soundfile streams -------------------- */
+
+    /* interleaved frames are converted through a buffer on the stack, one
+    channel at a time like readsf~ and writesf~ do */
+#define STREAMBUFSIZE 16384
+
+t_soundstream *soundstream_open(const t_canvas *canvas, const char *filename)
+{
+    t_soundstream *s;
+    t_soundfile sf;
+    off_t filesize;
+
+    soundfile_clear(&sf);
+    sf.sf_headersize = -1;
+    if (open_soundfile_via_canvas((t_canvas *)canvas, filename, &sf, 0) < 0)
+        return (0);
+        /* the header's data size may be a placeholder, so trust the file
+        (compressed types know their decoded size) */
+    if (!sf.sf_data)
+    {
+        if ((filesize = lseek(sf.sf_fd, 0, SEEK_END)) < sf.sf_headersize ||
+            lseek(sf.sf_fd, sf.sf_headersize, SEEK_SET) < 0)
         {
-            t_sample ff = normalfactor * 8388608.;
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                {
-                    int xx = 8388608. + (wp->w_float * ff);
-                    xx -= 8388608;
-                    if (xx < -8388607)
-                        xx = -8388607;
-                    if (xx > 8388607)
-                        xx = 8388607;
-                    sp2[0] = (xx >> 16);
-                    sp2[1] = (xx >> 8);
-                    sp2[2] = xx;
-                }
-            }
-            else
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                {
-                    int xx = 8388608. + (wp->w_float * ff);
-                    xx -= 8388608;
-                    if (xx < -8388607)
-                        xx = -8388607;
-                    if (xx > 8388607)
-                        xx = 8388607;
-                    sp2[2] = (xx >> 16);
-                    sp2[1] = (xx >> 8);
-                    sp2[0] = xx;
-                }
-            }
+            errno = SOUNDFILE_ERRMALFORMED;
+            sys_close(sf.sf_fd);
+            return (0);
         }
-        else if (sf->sf_bytespersample == 4)
+        if (sf.sf_bytelimit > filesize - sf.sf_headersize)
+            sf.sf_bytelimit = filesize - sf.sf_headersize;
+    }
+    s = (t_soundstream *)getbytes(sizeof(*s));
+    soundfile_copy(&s->ss_sf, &sf);
+    s->ss_nframes = sf.sf_bytelimit / sf.sf_bytesperframe;
+    s->ss_pos = 0;
+    s->ss_write = 0;
+    return (s);
+}
+
+t_soundstream *soundstream_create(const t_canvas *canvas, const char *filename,
+    int nchannels, int samplerate, int bytespersample)
+{
+    t_soundstream *s;
+    t_soundfile sf;
+    t_soundfile_type **t = soundfile_firsttype();
+
+    if (nchannels < 1 || nchannels > MAXSFCHANS || samplerate <= 0 ||
+        bytespersample < 2 || bytespersample > 4)
+    {
+        errno = EINVAL;
+        return (0);
+    }
+    while (t && !(*t)->t_hasextensionfn(filename, MAXPDSTRING))
+        t = soundfile_nexttype(t);
+    soundfile_clear(&sf);
+    sf.sf_type = (t ? *t : *soundfile_firsttype());
+    sf.sf_nchannels = nchannels;
+    sf.sf_samplerate = samplerate;
+    sf.sf_bytespersample = bytespersample;
+    sf.sf_bigendian = sf.sf_type->t_endiannessfn(-1);
+    sf.sf_bytesperframe = nchannels * bytespersample;
+    if (create_soundfile((t_canvas *)canvas, filename, &sf, 0) < 0)
+        return (0);
+    s = (t_soundstream *)getbytes(sizeof(*s));
+    soundfile_copy(&s->ss_sf, &sf);
+    s->ss_nframes = s->ss_pos = 0;
+    s->ss_write = 1;
+    return (s);
+}
+
+size_t soundstream_read(t_soundstream *s, t_sample *frames, size_t nframes,
+    int stride)
+{
+    t_soundfile *sf = &s->ss_sf;
+    unsigned char buf[STREAMBUFSIZE];
+    size_t bufframes = STREAMBUFSIZE / sf->sf_bytesperframe, nread = 0, j;
+    int nchannels = (sf->sf_nchannels < stride ? sf->sf_nchannels : stride),
+        i;
+    t_sfdecodefn decode =
+        sf_decoders[sf->sf_bytespersample - 2][sf->sf_bigendian != 0];
+    t_sample *fp;
+
+    if (!s->ss_write)
+    {
+        while (nread < nframes && s->ss_pos < s->ss_nframes)
         {
-            t_floatuint f2;
-            if (sf->sf_bigendian)
-            {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                {
-                    f2.f = wp->w_float * normalfactor;
-                    sp2[0] = (f2.ui >> 24); sp2[1] = (f2.ui >> 16);
-                    sp2[2] = (f2.ui >> 8);  sp2[3] = f2.ui;
-                }
-            }
-            else
+            size_t thisread = nframes - nread;
+            ssize_t n;
+            if (thisread > bufframes)
+                thisread = bufframes;
+            if (thisread > s->ss_nframes - s->ss_pos)
+                thisread = s->ss_nframes - s->ss_pos;
+            if ((n = soundfile_readsamples(sf, buf,
+                thisread * sf->sf_bytesperframe) / sf->sf_bytesperframe) <= 0)
             {
-                for (j = 0, sp2 = sp, wp = vecs[i] + onsetframes;
-                    j < nframes; j++, sp2 += sf->sf_bytesperframe, wp++)
-                {
-                    f2.f = wp->w_float * normalfactor;
-                    sp2[3] = (f2.ui >> 24); sp2[2] = (f2.ui >> 16);
-                    sp2[1] = (f2.ui >> 8);  sp2[0] = f2.ui;
-                }
+                s->ss_nframes = s->ss_pos;  /* truncated, stop here */
+                break;
             }
+            for (i = 0; i < nchannels; i++)
+                (*decode)(buf + i * sf->sf_bytespersample,
+                    sf->sf_bytesperframe, frames + nread * stride + i,
+                        stride, n);
+            nread += n;
+            s->ss_pos += n;
         }
     }
+        /* zero out whatever is past the end */
+    for (i = 0; i < nchannels; i++)
+        for (j = nread, fp = frames + j * stride + i; j < nframes;
+            j++, fp += stride)
+                *fp = 0;
+    return (nread);
+}
+
+ssize_t soundstream_write(t_soundstream *s, const t_sample *frames,
+    size_t nframes)
+{
+    t_soundfile *sf = &s->ss_sf;
+    unsigned char buf[STREAMBUFSIZE];
+    size_t bufframes = STREAMBUFSIZE / sf->sf_bytesperframe, nwritten = 0;
+    t_sfencodefn encode =
+        sf_encoders[sf->sf_bytespersample - 2][sf->sf_bigendian != 0];
+    int i;
+
+    if (!s->ss_write)
+    {
+        errno = EBADF;
+        return (-1);
+    }
+    while (nwritten < nframes)
+    {
+        size_t thiswrite = nframes - nwritten,
+            nbytes = (thiswrite > bufframes ? bufframes : thiswrite) *
+                sf->sf_bytesperframe;
+        thiswrite = nbytes / sf->sf_bytesperframe;
+        for (i = 0; i < sf->sf_nchannels; i++)
+            (*encode)(buf + i * sf->sf_bytespersample, sf->sf_bytesperframe,
+                frames + nwritten * sf->sf_nchannels + i, sf->sf_nchannels,
+                    thiswrite, 1);
+        if (write(sf->sf_fd, buf, nbytes) < (ssize_t)nbytes)
+            return (-1);
+        nwritten += thiswrite;
+        s->ss_nframes += thiswrite;
+    }
+    return (nwritten);
+}
+
+int soundstream_close(t_soundstream *s)
+{
+    int ret = 0;
+    if (s->ss_write)
+    {
+        if (!s->ss_sf.sf_type->t_updateheaderfn(&s->ss_sf, s->ss_nframes))
+            ret = -1;
+        sys_close(s->ss_sf.sf_fd);
+    }
+    else soundfile_close(&s->ss_sf);
+    freebytes(s, sizeof(*s));
+    return (ret);
 }
 
 /* ----- soundfiler - reads and writes soundfiles to/from "garrays" ----- */
 
-#define SAMPBUFSIZE 1024
+    /* file data is read and written through a buffer on the stack; big
+    enough that whole arrays don't take thousands of system calls */
+#define SAMPBUFSIZE 16384
 
 static t_class *soundfiler_class;
 
@@ -1013,12 +1451,14 @@ typedef struct _soundfiler
     t_object x_obj;
     t_outlet *x_out2;
     t_canvas *x_canvas;
+    struct _sfbatch *x_batches;     /* "readbatch" batches still running */
 } t_soundfiler;
 
 static t_soundfiler *soundfiler_new(void)
 {
     t_soundfiler *x = (t_soundfiler *)pd_new(soundfiler_class);
     x->x_canvas = canvas_getcurrent();
+    x->x_batches = 0;
     outlet_new(&x->x_obj, &s_float);
     x->x_out2 = outlet_new(&x->x_obj, &s_float);
     return x;
@@ -1324,7 +1764,7 @@ static void soundfiler_read(t_soundfiler *x, t_symbol *s,
     {
         size_t thisread = finalsize - framesread;
         thisread = (thisread > bufframes ? bufframes : thisread);
-        nframes = read(sf.sf_fd, sampbuf,
+        nframes = soundfile_readsamples(&sf, sampbuf,
             thisread * sf.sf_bytesperframe) / sf.sf_bytesperframe;
         if (nframes <= 0) break;
         soundfile_xferin_words(&sf, argc, vecs, framesread,
@@ -1365,9 +1805,8 @@ usage:
     post("-raw <headerbytes> <channels> <bytespersample> "
          "<endian (b, l, or n)>");
 done:
-    sf.sf_fd = -1;
     if (fd >= 0)
-        sys_close(fd);
+        soundfile_close(&sf);
     outlet_soundfileinfo(x->x_out2, &sf);
     outlet_float(x->x_obj.ob_outlet, (t_float)framesread);
 }
@@ -1565,15 +2004,414 @@ static void soundfiler_write(t_soundfiler *x, t_symbol *s,
     outlet_float(x->x_obj.ob_outlet, (t_float)frameswritten);
 }
 
+/* ------------------- asynchronous batch reading ---------------------- */
+
+    /* "readbatch" reads many soundfiles into arrays without blocking Pd:
+    file names are resolved here, then a few worker threads each claim the
+    next file and decode it outside the Pd lock.  The workers never take the
+    Pd lock; a clock polls for decoded files, resizes and fills their arrays
+    from the scheduler and sends "progress <ndone> <nfiles>" and, at the end,
+    "done <nread> <nfailed>" to a receive name.  A batch belongs to the
+    soundfiler that started it, or to the Pd instance if started through
+    libpd; freeing the owner cancels the batch and joins its threads. */
+
+#define SFBATCH_MAXTHREADS 4
+#define SFBATCH_BUFSIZE 65536
+#define SFBATCH_POLLMS 5
+
+#define SFBATCH_QUEUED 0        /* waiting for a worker */
+#define SFBATCH_DECODED 1       /* decoded, waiting for the clock */
+#define SFBATCH_DELIVERED 2     /* copied into the arrays (or reported) */
+
+typedef struct _sfbatchfile
+{
+    char *f_path;               /* resolved file path, NULL if not found */
+    int f_state;                /* protected by b_mutex */
+    ssize_t f_nframes;          /* frames decoded, or -1 on error */
+    int f_err;                  /* errno if f_nframes < 0 */
+    t_soundfile f_sf;           /* header info for error messages */
+    t_sample **f_vecs;          /* b_nchannels decoded vectors */
+} t_sfbatchfile;
+
+typedef struct _sfbatch
+{
+#ifdef PDINSTANCE
+    t_pdinstance *b_pd_this;    /* instance the arrays belong to */
+#endif
+    struct _sfbatch *b_next;    /* next batch of the same owner */
+    struct _sfbatch **b_owner;  /* list the batch is on, or 0 */
+    t_symbol *b_receiver;       /* where to send progress and completion */
+    t_clock *b_clock;           /* polls for decoded files */
+    int b_nchannels;            /* arrays per file */
+    int b_nfiles;
+    t_sfbatchfile *b_files;
+    t_symbol **b_arrays;        /* nfiles * nchannels array names */
+    pthread_mutex_t b_mutex;    /* protects b_claim and the f_state fields */
+    int b_claim;                /* next file to claim */
+    int b_cancel;               /* atomic: workers stop early */
+    int b_nthreads;
+    pthread_t b_threads[SFBATCH_MAXTHREADS];
+    int b_nfailed;              /* these three only touched with Pd locked */
+    int b_ndone;
+    int b_busy;                 /* the clock is sending messages */
+} t_sfbatch;
+
+static void sfbatch_freevecs(t_sfbatch *b, t_sfbatchfile *f)
+{
+    int i;
+    if (!f->f_vecs)
+        return;
+    for (i = 0; i < b->b_nchannels; i++)
+        freebytes(f->f_vecs[i], (f->f_nframes > 0 ? f->f_nframes : 1) *
+            sizeof(t_sample));
+    freebytes(f->f_vecs, b->b_nchannels * sizeof(t_sample *));
+    f->f_vecs = 0;
+}
+
+    /* free a batch whose threads have been joined */
+static void sfbatch_free(t_sfbatch *b)
+{
+    int i;
+    for (i = 0; i < b->b_nfiles; i++)
+    {
+        t_sfbatchfile *f = &b->b_files[i];
+        sfbatch_freevecs(b, f);
+        if (f->f_path)
+            freebytes(f->f_path, strlen(f->f_path) + 1);
+    }
+    freebytes(b->b_files, b->b_nfiles * sizeof(t_sfbatchfile));
+    freebytes(b->b_arrays, b->b_nfiles * b->b_nchannels * sizeof(t_symbol *));
+    clock_free(b->b_clock);
+    pthread_mutex_destroy(&b->b_mutex);
+    freebytes(b, sizeof(*b));
+}
+
+static void sfbatch_unlink(t_sfbatch *b)
+{
+    t_sfbatch **bp;
+    if (!b->b_owner)
+        return;
+    for (bp = b->b_owner; *bp; bp = &(*bp)->b_next)
+        if (*bp == b)
+    {
+        *bp = b->b_next;
+        break;
+    }
+    b->b_owner = 0;
+}
+
+static void sfbatch_join(t_sfbatch *b)
+{
+    int i;
+#if PDTHREADS
+    for (i = 0; i < b->b_nthreads; i++)
+        pthread_join(b->b_threads[i], 0);
+#endif
+    b->b_nthreads = 0;
+}
+
+    /* stop a batch and wait for its threads, called with Pd locked when its
+    owner goes away.  If the batch's clock is in the middle of sending (and
+    the receiver deleted the owner) the clock frees the batch afterwards. */
+static void sfbatch_cancel(t_sfbatch *b)
+{
+    SFIO_STORE(&b->b_cancel, 1);
+    sfbatch_unlink(b);
+    sfbatch_join(b);
+    if (!b->b_busy)
+        sfbatch_free(b);
+}
+
+static void sfbatch_send(t_sfbatch *b, const char *sel, t_float f1,
+    t_float f2)
+{
+    t_atom at[2];
+    if (!b->b_receiver->s_thing)
+        return;
+    SETFLOAT(at, f1);
+    SETFLOAT(at+1, f2);
+    pd_typedmess(b->b_receiver->s_thing, gensym(sel), 2, at);
+}
+
+    /* decode a whole file into freshly allocated vectors, called without
+    the Pd lock.  Sets f_nframes to the number of frames or to -1 on error
+    (with f_err set); a cancelled batch stops reading early. */
+static void sfbatch_decode(t_sfbatch *b, t_sfbatchfile *f)
+{
+    t_soundfile *sf = &f->f_sf;
+    unsigned char *buf;
+    ssize_t framesinfile, framesread = 0, nframes, filesize;
+    size_t bufframes;
+    int fd, i, nvecs = b->b_nchannels;
+
+    soundfile_clear(sf);
+    sf->sf_headersize = -1;
+    f->f_nframes = -1;
+    if (!f->f_path)     /* already reported */
+        return;
+    if ((fd = sys_open(f->f_path, O_RDONLY)) < 0 ||
+        open_soundfile_via_fd(fd, sf, 0) < 0)
+    {
+        f->f_err = errno;
+        return;
+    }
+        /* the header's data size may be a placeholder, so trust the file
+        (compressed types know their decoded size) */
+    if (!sf->sf_data)
+    {
+        if ((filesize = lseek(sf->sf_fd, 0, SEEK_END)) < sf->sf_headersize ||
+            lseek(sf->sf_fd, sf->sf_headersize, SEEK_SET) < 0)
+        {
+            f->f_err = SOUNDFILE_ERRMALFORMED;
+            sys_close(sf->sf_fd);
+            return;
+        }
+        if (sf->sf_bytelimit > filesize - sf->sf_headersize)
+            sf->sf_bytelimit = filesize - sf->sf_headersize;
+    }
+    framesinfile = sf->sf_bytelimit / sf->sf_bytesperframe;
+    f->f_vecs = (t_sample **)getbytes(nvecs * sizeof(t_sample *));
+    for (i = 0; i < nvecs; i++)
+        f->f_vecs[i] = (t_sample *)getbytes((framesinfile ? framesinfile : 1) *
+            sizeof(t_sample));
+    bufframes = SFBATCH_BUFSIZE / sf->sf_bytesperframe;
+    buf = (unsigned char *)getbytes(bufframes * sf->sf_bytesperframe);
+    while (framesread < framesinfile && !SFIO_LOAD(&b->b_cancel))
+    {
+        size_t thisread = framesinfile - framesread;
+        if (thisread > bufframes)
+            thisread = bufframes;
+        if ((nframes = soundfile_readsamples(sf, buf,
+            thisread * sf->sf_bytesperframe) / sf->sf_bytesperframe) <= 0)
+                break;
+        soundfile_xferin_sample(sf, nvecs, f->f_vecs, framesread,
+            buf, nframes);
+        framesread += nframes;
+    }
+    f->f_nframes = framesread;
+    freebytes(buf, bufframes * sf->sf_bytesperframe);
+    soundfile_close(sf);
+}
+
+    /* copy one decoded file into its arrays, called with Pd locked.  Arrays
+    can't be empty, so a file without frames leaves them 1 point long and
+    zeroed, which still counts as read. */
+static int sfbatch_fill(t_sfbatch *b, int file)
+{
+    t_sfbatchfile *f = &b->b_files[file];
+    int i, vecsize, ok = 1, nvecs = b->b_nchannels,
+        size = (f->f_nframes > 0 ? (int)f->f_nframes : 1);
+    for (i = 0; i < nvecs; i++)
+    {
+        t_symbol *arrayname = b->b_arrays[file * nvecs + i];
+        t_garray *a;
+        t_word *wp;
+        ssize_t j;
+        if (!(a = (t_garray *)pd_findbyclass(arrayname, garray_class)))
+        {
+            pd_error(0, "soundfiler readbatch: %s: no such table",
+                arrayname->s_name);
+            ok = 0;
+            continue;
+        }
+        garray_resize_long(a, size);
+        garray_setsaveit(a, 0);
+        if (!garray_getfloatwords(a, &vecsize, &wp) || vecsize != size)
+        {
+            pd_error(0, "soundfiler readbatch: %s: resize failed",
+                arrayname->s_name);
+            ok = 0;
+            continue;
+        }
+        for (j = 0; j < f->f_nframes; j++)
+            wp[j].w_float = f->f_vecs[i][j];
+        for (; j < size; j++)
+            wp[j].w_float = 0;
+        garray_redraw(a);
+    }
+    return (ok);
+}
+
+    /* worker: decode files until there are none left; no Pd lock taken */
+static void *sfbatch_thread(void *z)
+{
+    t_sfbatch *b = (t_sfbatch *)z;
+    int file;
+#ifdef PDINSTANCE
+    pd_this = b->b_pd_this;
+#endif
+    while (!SFIO_LOAD(&b->b_cancel))
+    {
+        pthread_mutex_lock(&b->b_mutex);
+        file = b->b_claim++;
+        pthread_mutex_unlock(&b->b_mutex);
+        if (file >= b->b_nfiles)
+            break;
+        sfbatch_decode(b, &b->b_files[file]);
+        pthread_mutex_lock(&b->b_mutex);
+        b->b_files[file].f_state = SFBATCH_DECODED;
+        pthread_mutex_unlock(&b->b_mutex);
+    }
+    return (0);
+}
+
+    /* clock: hand decoded files to their arrays, then send "done" and free
+    the batch once all files are through */
+static void sfbatch_tick(t_sfbatch *b)
+{
+    int i;
+    b->b_busy = 1;
+    for (i = 0; i < b->b_nfiles && !SFIO_LOAD(&b->b_cancel); i++)
+    {
+        t_sfbatchfile *f = &b->b_files[i];
+        int decoded, ok = 0;
+        pthread_mutex_lock(&b->b_mutex);
+        decoded = (f->f_state == SFBATCH_DECODED);
+        pthread_mutex_unlock(&b->b_mutex);
+        if (!decoded)
+            continue;
+        if (f->f_nframes >= 0)
+            ok = sfbatch_fill(b, i);
+        else if (f->f_path)
+            object_sferror(0, "soundfiler readbatch", f->f_path,
+                f->f_err, &f->f_sf);
+        sfbatch_freevecs(b, f);
+        f->f_state = SFBATCH_DELIVERED;
+        if (!ok)
+            b->b_nfailed++;
+        b->b_ndone++;
+        sfbatch_send(b, "progress", b->b_ndone, b->b_nfiles);
+    }
+    if (!SFIO_LOAD(&b->b_cancel))
+    {
+        if (b->b_ndone < b->b_nfiles)
+        {
+            clock_delay(b->b_clock, SFBATCH_POLLMS);
+            b->b_busy = 0;
+            return;
+        }
+        sfbatch_unlink(b);
+        sfbatch_join(b);
+        sfbatch_send(b, "done", b->b_nfiles - b->b_nfailed, b->b_nfailed);
+    }
+    sfbatch_free(b);
+}
+
+    /* cancel all batches started through libpd, from pdinstance_free() */
+void soundfiler_freebatches(void)
+{
+    while (STUFF->st_sfbatches)
+        sfbatch_cancel(STUFF->st_sfbatches);
+}
+
+    /* start reading pairs (or, with nchannels > 1, groups) of
+    "file array..." atoms.  Relative file names are resolved against the
+    soundfiler's canvas; with no soundfiler the batch belongs to the Pd
+    instance.  Returns 1 if the batch was started. */
+int soundfiler_readbatch(t_soundfiler *x, t_symbol *receiver,
+    int nchannels, int argc, t_atom *argv)
+{
+    t_sfbatch *b;
+    int nfiles, i, j;
+    if (nchannels < 1 || nchannels > MAXSFCHANS || !argc ||
+        argc % (nchannels + 1))
+            return (0);
+    for (i = 0; i < argc; i++)
+        if (argv[i].a_type != A_SYMBOL)
+            return (0);
+    nfiles = argc / (nchannels + 1);
+    b = (t_sfbatch *)getbytes(sizeof(*b));
+#ifdef PDINSTANCE
+    b->b_pd_this = pd_this;
+#endif
+    b->b_receiver = receiver;
+    b->b_clock = clock_new(b, (t_method)sfbatch_tick);
+    b->b_nchannels = nchannels;
+    b->b_nfiles = nfiles;
+    b->b_files = (t_sfbatchfile *)getbytes(nfiles * sizeof(t_sfbatchfile));
+    b->b_arrays = (t_symbol **)getbytes(nfiles * nchannels * sizeof(t_symbol *));
+    pthread_mutex_init(&b->b_mutex, 0);
+    b->b_claim = b->b_cancel = b->b_nthreads = 0;
+    b->b_nfailed = b->b_ndone = b->b_busy = 0;
+    for (i = 0; i < nfiles; i++, argv += nchannels + 1)
+    {
+        char dirbuf[MAXPDSTRING], *nameptr, path[2*MAXPDSTRING];
+        int fd = canvas_open((x ? x->x_canvas : 0),
+            argv[0].a_w.w_symbol->s_name, "", dirbuf, &nameptr,
+                MAXPDSTRING, 1);
+        if (fd >= 0)
+        {
+            sys_close(fd);
+            snprintf(path, sizeof(path), "%s/%s", dirbuf, nameptr);
+            b->b_files[i].f_path = (char *)getbytes(strlen(path) + 1);
+            strcpy(b->b_files[i].f_path, path);
+        }
+        else pd_error(0, "soundfiler readbatch: %s: can't open",
+            argv[0].a_w.w_symbol->s_name);
+        for (j = 0; j < nchannels; j++)
+            b->b_arrays[i * nchannels + j] = argv[j+1].a_w.w_symbol;
+    }
+    b->b_owner = (x ? &x->x_batches : &STUFF->st_sfbatches);
+    b->b_next = *b->b_owner;
+    *b->b_owner = b;
+#if PDTHREADS
+    while (b->b_nthreads < nfiles && b->b_nthreads < SFBATCH_MAXTHREADS &&
+        !pthread_create(&b->b_threads[b->b_nthreads], 0, sfbatch_thread, b))
+            b->b_nthreads++;
+    if (b->b_nthreads)
+    {
+        clock_delay(b->b_clock, SFBATCH_POLLMS);
+        return (1);
+    }
+#endif
+        /* without threads (or if none could start) read synchronously */
+    sfbatch_thread(b);
+    sfbatch_tick(b);
+    return (1);
+}
+
+static void soundfiler_free(t_soundfiler *x)
+{
+    while (x->x_batches)
+        sfbatch_cancel(x->x_batches);
+}
+
+static void soundfiler_readbatch_method(t_soundfiler *x, t_symbol *s,
+    int argc, t_atom *argv)
+{
+    int nchannels = 1;
+    t_symbol *receiver;
+    if (argc >= 2 && argv->a_type == A_SYMBOL &&
+        !strcmp(argv->a_w.w_symbol->s_name, "-channels"))
+    {
+        if (argv[1].a_type != A_FLOAT)
+            goto usage;
+        nchannels = argv[1].a_w.w_float;
+        argc -= 2; argv += 2;
+    }
+    if (argc < 1 || argv->a_type != A_SYMBOL)
+        goto usage;
+    receiver = argv->a_w.w_symbol;
+    if (!soundfiler_readbatch(x, receiver, nchannels,
+        argc - 1, argv + 1))
+            goto usage;
+    return;
+usage:
+    pd_error(x, "usage: readbatch [-channels <n>] receive-name "
+        "filename tablename... [filename tablename...]");
+}
+
 static void soundfiler_setup(void)
 {
     soundfiler_class = class_new(gensym("soundfiler"),
-        (t_newmethod)soundfiler_new, 0,
+        (t_newmethod)soundfiler_new, (t_method)soundfiler_free,
         sizeof(t_soundfiler), 0, 0);
     class_addmethod(soundfiler_class, (t_method)soundfiler_read,
         gensym("read"), A_GIMME, 0);
     class_addmethod(soundfiler_class, (t_method)soundfiler_write,
         gensym("write"), A_GIMME, 0);
+    class_addmethod(soundfiler_class, (t_method)soundfiler_readbatch_method,
+        gensym("readbatch"), A_GIMME, 0);
 }
 
 /* ------------------------- readsf object ------------------------- */
@@ -1581,21 +2419,28 @@ static void soundfiler_setup(void)
 /* READSF uses the Posix threads package; for the moment we're Linux
 only although this should be portable to the other platforms.
 
-Each instance of readsf~ owns a "child" thread for doing the Posix file reading.
-The parent thread signals the child each time:
-    (1) a file wants opening or closing;
-    (2) we've eaten another 1/16 of the shared buffer (so that the
-        child thread should check if it's time to read some more.)
-The child signals the parent whenever a read has completed.  Signaling
-is done by setting "conditions" and putting data in mutex-controlled common
-areas.
+All readsf~ and writesf~ objects, in all Pd instances, share a small pool of
+I/O threads (see "shared I/O threads" below) rather than owning one each.
+Each object has a FIFO between its perform routine and the I/O threads with
+a single producer and a single consumer: the perform routine owns one end
+(the tail for readsf~, the head for writesf~) and the I/O thread the other,
+and each side publishes its index with an atomic store.  The perform
+routine never takes a lock; it just posts a semaphore to wake the I/O
+threads each time it has eaten (or, for writesf~, filled) another 1/16 of
+the buffer.  If the FIFO runs dry the block is dropped and counted as an
+underrun, unless the object (or all objects, for offline rendering) was
+told to wait for the disk.
+
+Opening and closing still go through "requests" in mutex-controlled common
+areas; the I/O threads signal the "answer" condition whenever a request has
+been handled or more data has arrived, for the Pd thread to wait on.
 */
 
 #define MAXVECSIZE 128
 
 #define READSIZE 65536
 #define WRITESIZE 65536
-#define DEFBUFPERCHAN 262144
+#define DEFBUFPERCHAN 524288
 #define MINBUFSIZE (4 * READSIZE)
 #define MAXBUFSIZE 16777216     /* arbitrary; just don't want to hang malloc */
 
@@ -1642,20 +2487,25 @@ typedef struct _readsf
     int x_fifohead;           /**< index of next byte to get from file */
     int x_fifotail;           /**< index of next byte the ugen will read */
     int x_eof;                /**< true if fifohead has stopped changing */
-    int x_sigcountdown;       /**< counter for signaling child for more data */
-    int x_sigperiod;          /**< number of ticks per signal */
+    int x_sigcountdown;       /**< bytes left until we wake the I/O threads */
+    int x_sigperiod;          /**< bytes between wakeups */
+    int x_wait;               /**< wait for the disk instead of dropping out */
+    int x_underruns;          /**< blocks dropped because the FIFO ran dry */
     size_t x_frameswritten;   /**< writesf~ only; frames written */
     t_float x_f;              /**< writesf~ only; scalar for signal inlet */
     pthread_mutex_t x_mutex;
-    pthread_cond_t x_requestcondition;
     pthread_cond_t x_answercondition;
-    pthread_t x_childthread;
+        /* owned by the I/O threads */
+    t_soundfile x_iosf;       /**< the I/O thread's copy, holding the fd */
+    int x_iswriter;           /**< writesf~ rather than readsf~ */
+    int x_claimed;            /**< an I/O thread is servicing us */
+    struct _readsf *x_next;   /**< next in the I/O threads' list */
 #ifdef PDINSTANCE
     t_pdinstance *x_pd_this;  /**< pointer to the owner pd instance */
 #endif
 } t_readsf;
 
-/* ----- the child thread which performs file I/O ----- */
+/* ----- shared I/O threads ----- */
 
     /** thread state debug prints to stderr */
 //#define DEBUG_SOUNDFILE_THREADS
@@ -1680,288 +2530,414 @@ static void readsf_fakewait(pthread_mutex_t *b)
 #define sfread_cond_signal(a)
 #endif
 
-static void *readsf_child_main(void *zz)
+#define SFIO_NTHREADS 2
+
+    /* The threads keep a list of every stream.  When woken, a thread picks
+    the unclaimed stream whose deadline is nearest - pending open and close
+    requests first, then the reader with the fewest frames buffered or the
+    writer with the least room left - and does one chunk of work on it,
+    until no stream needs anything. */
+typedef struct _sfio
 {
-    t_readsf *x = zz;
-    t_soundfile sf = {0};
-    soundfile_clear(&sf);
+    pthread_mutex_t io_mutex;       /**< protects the list and claims */
+    pthread_cond_t io_releasecond;  /**< signaled when a claim is released */
+    t_sfio_sem io_sem;
+    pthread_t io_threads[SFIO_NTHREADS];
+    int io_nthreads;
+    int io_quit;
+    t_readsf *io_streams;
+    int io_nstreams;
+} t_sfio;
+
+static t_sfio sfio = {PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER};
+    /* held while starting or stopping the threads */
+static pthread_mutex_t sfio_lifemutex = PTHREAD_MUTEX_INITIALIZER;
+static int sfio_underruns;      /* total over all streams */
+static int sfio_wait;           /* make every stream wait for the disk */
+
+static long readsf_deadline(t_readsf *x);
+static long writesf_deadline(t_readsf *x);
+static void readsf_service(t_readsf *x);
+static void writesf_service(t_readsf *x);
+
+    /** wake the I/O threads.  Called from the perform routines too. */
+static void sfio_post(void)
+{
+    sfio_sem_post(&sfio.io_sem);
+}
+
+    /* pick and claim the most urgent stream; called with io_mutex locked */
+static t_readsf *sfio_next(void)
+{
+    t_readsf *x, *best = 0;
+    long bestdeadline = 0;
+    for (x = sfio.io_streams; x; x = x->x_next)
+    {
+        long deadline;
+        if (x->x_claimed)
+            continue;
+        deadline = (x->x_iswriter ? writesf_deadline(x) : readsf_deadline(x));
+        if (deadline >= 0 && (!best || deadline < bestdeadline))
+        {
+            best = x;
+            bestdeadline = deadline;
+        }
+    }
+    if (best)
+        best->x_claimed = 1;
+    return (best);
+}
+
+static void *sfio_thread(void *dummy)
+{
+    pthread_mutex_lock(&sfio.io_mutex);
+    while (!sfio.io_quit)
+    {
+        t_readsf *x = sfio_next();
+        if (!x)
+        {
+            pthread_mutex_unlock(&sfio.io_mutex);
+            sfio_sem_wait(&sfio.io_sem);
+            pthread_mutex_lock(&sfio.io_mutex);
+            continue;
+        }
+        pthread_mutex_unlock(&sfio.io_mutex);
 #ifdef PDINSTANCE
-    pd_this = x->x_pd_this;
+        pd_this = x->x_pd_this;
 #endif
-#ifdef DEBUG_SOUNDFILE_THREADS
-    fprintf(stderr, "readsf~: 1\n");
-#endif
-    pthread_mutex_lock(&x->x_mutex);
-    while (1)
+        if (x->x_iswriter)
+            writesf_service(x);
+        else readsf_service(x);
+        pthread_mutex_lock(&sfio.io_mutex);
+        x->x_claimed = 0;
+        pthread_cond_broadcast(&sfio.io_releasecond);
+    }
+    pthread_mutex_unlock(&sfio.io_mutex);
+    return (0);
+}
+
+    /** count a new stream, starting the threads for the first one.  Returns
+        0 if no thread could start: the object must not be created then, as
+        nothing would ever answer its requests. */
+static int sfio_start(const char *name)
+{
+    pthread_mutex_lock(&sfio_lifemutex);
+    pthread_mutex_lock(&sfio.io_mutex);
+    if (!sfio.io_nstreams)
     {
-        int fifohead;
-        char *buf;
-#ifdef DEBUG_SOUNDFILE_THREADS
-        fprintf(stderr, "readsf~: 0\n");
-#endif
-        if (x->x_requestcode == REQUEST_NOTHING)
+        int i;
+        sfio_sem_init(&sfio.io_sem);
+        sfio.io_quit = 0;
+        for (i = sfio.io_nthreads = 0; i < SFIO_NTHREADS; i++)
+            if (!pthread_create(&sfio.io_threads[sfio.io_nthreads],
+                0, sfio_thread, 0))
+                    sfio.io_nthreads++;
+        if (!sfio.io_nthreads)
         {
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "readsf~: wait 2\n");
-#endif
-            sfread_cond_signal(&x->x_answercondition);
-            sfread_cond_wait(&x->x_requestcondition, &x->x_mutex);
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "readsf~: 3\n");
-#endif
+            sfio_sem_destroy(&sfio.io_sem);
+            pthread_mutex_unlock(&sfio.io_mutex);
+            pthread_mutex_unlock(&sfio_lifemutex);
+            pd_error(0, "%s: couldn't start I/O thread", name);
+            return (0);
         }
-        else if (x->x_requestcode == REQUEST_OPEN)
-        {
-            ssize_t bytesread;
-            size_t wantbytes;
+    }
+    sfio.io_nstreams++;
+    pthread_mutex_unlock(&sfio.io_mutex);
+    pthread_mutex_unlock(&sfio_lifemutex);
+    return (1);
+}
 
-                /* copy file stuff out of the data structure so we can
-                relinquish the mutex while we're in open_soundfile_via_path() */
-            size_t onsetframes = x->x_onsetframes;
-            const char *filename = x->x_filename;
-            const char *dirname = canvas_getdir(x->x_canvas)->s_name;
+    /** add a stream counted by sfio_start() to the list */
+static void sfio_addstream(t_readsf *x)
+{
+    pthread_mutex_lock(&sfio.io_mutex);
+    x->x_claimed = 0;
+    x->x_next = sfio.io_streams;
+    sfio.io_streams = x;
+    pthread_mutex_unlock(&sfio.io_mutex);
+}
 
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "readsf~: 4\n");
-#endif
-                /* alter the request code so that an ensuing "open" will get
-                noticed. */
-            x->x_requestcode = REQUEST_BUSY;
-            x->x_fileerror = 0;
+    /** remove a stream once no thread is servicing it, stopping the threads
+        after the last one */
+static void sfio_removestream(t_readsf *x)
+{
+    t_readsf **xp;
+    pthread_mutex_lock(&sfio_lifemutex);
+    pthread_mutex_lock(&sfio.io_mutex);
+    while (x->x_claimed)
+        pthread_cond_wait(&sfio.io_releasecond, &sfio.io_mutex);
+    for (xp = &sfio.io_streams; *xp; xp = &(*xp)->x_next)
+        if (*xp == x)
+    {
+        *xp = x->x_next;
+        break;
+    }
+    if (!--sfio.io_nstreams)
+    {
+        int i;
+        sfio.io_quit = 1;
+        pthread_mutex_unlock(&sfio.io_mutex);
+        for (i = 0; i < sfio.io_nthreads; i++)
+            sfio_post();
+        for (i = 0; i < sfio.io_nthreads; i++)
+            pthread_join(sfio.io_threads[i], 0);
+        sfio.io_nthreads = 0;
+        sfio_sem_destroy(&sfio.io_sem);
+    }
+    else pthread_mutex_unlock(&sfio.io_mutex);
+    pthread_mutex_unlock(&sfio_lifemutex);
+}
 
-                /* if there's already a file open, close it */
-            if (sf.sf_fd >= 0)
-            {
-                pthread_mutex_unlock(&x->x_mutex);
-                sys_close(sf.sf_fd);
-                sf.sf_fd = -1;
-                pthread_mutex_lock(&x->x_mutex);
-                x->x_sf.sf_fd = -1;
-                if (x->x_requestcode != REQUEST_BUSY)
-                    goto lost;
-            }
-                /* cache sf *after* closing as x->sf's type
-                    may have changed in readsf_open() */
-            soundfile_copy(&sf, &x->x_sf);
+    /** count a dropped block, for the object and the total */
+static void sfio_underrun(t_readsf *x)
+{
+    x->x_underruns++;
+    SFIO_ADD(&sfio_underruns, 1);
+    sfio_post();
+}
 
-                /* open the soundfile with the mutex unlocked */
-            pthread_mutex_unlock(&x->x_mutex);
-            open_soundfile_via_path(dirname, filename, &sf, onsetframes);
-            pthread_mutex_lock(&x->x_mutex);
+void soundfile_setstreamwait(int wait)
+{
+    SFIO_STORE(&sfio_wait, (wait != 0));
+}
 
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "readsf~: 5\n");
-#endif
-            if (sf.sf_fd < 0)
-            {
-                x->x_fileerror = errno;
-                x->x_eof = 1;
-#ifdef DEBUG_SOUNDFILE_THREADS
-                fprintf(stderr, "readsf~: open failed %s %s\n",
-                    filename, dirname);
-#endif
-                goto lost;
-            }
-                /* copy back into the instance structure. */
-            soundfile_copy(&x->x_sf, &sf);
-                /* check if another request has been made; if so, field it */
-            if (x->x_requestcode != REQUEST_BUSY)
-                goto lost;
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "readsf~: 6\n");
-#endif
-            x->x_fifohead = 0;
-                    /* set fifosize from bufsize.  fifosize must be a
-                    multiple of the number of bytes eaten for each DSP
-                    tick.  We pessimistically assume MAXVECSIZE samples
-                    per tick since that could change.  There could be a
-                    problem here if the vector size increases while a
-                    soundfile is being played...  */
-            x->x_fifosize = x->x_bufsize - (x->x_bufsize %
-                (sf.sf_bytesperframe * MAXVECSIZE));
-                    /* arrange for the "request" condition to be signaled 16
-                    times per buffer */
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "readsf~: fifosize %d\n", x->x_fifosize);
-#endif
-            x->x_sigcountdown = x->x_sigperiod = (x->x_fifosize /
-                (16 * sf.sf_bytesperframe * x->x_vecsize));
-                /* in a loop, wait for the fifo to get hungry and feed it */
+int soundfile_getunderruns(int reset)
+{
+    return (reset ? SFIO_EXCHANGE(&sfio_underruns, 0) :
+        SFIO_LOAD(&sfio_underruns));
+}
 
-            while (x->x_requestcode == REQUEST_BUSY)
-            {
-                int fifosize = x->x_fifosize;
-#ifdef DEBUG_SOUNDFILE_THREADS
-                fprintf(stderr, "readsf~: 77\n");
-#endif
-                if (x->x_eof)
-                    break;
-                if (x->x_fifohead >= x->x_fifotail)
-                {
-                        /* if the head is >= the tail, we can immediately read
-                        to the end of the fifo.  Unless, that is, we would
-                        read all the way to the end of the buffer and the
-                        "tail" is zero; this would fill the buffer completely
-                        which isn't allowed because you can't tell a completely
-                        full buffer from an empty one. */
-                    if (x->x_fifotail || (fifosize - x->x_fifohead > READSIZE))
-                    {
-                        wantbytes = fifosize - x->x_fifohead;
-                        if (wantbytes > READSIZE)
-                            wantbytes = READSIZE;
-                        if (sf.sf_bytelimit >= 0 && wantbytes > (size_t)sf.sf_bytelimit)
-                            wantbytes = sf.sf_bytelimit;
-#ifdef DEBUG_SOUNDFILE_THREADS
-                        fprintf(stderr, "readsf~: head %d, tail %d, size %ld\n",
-                            x->x_fifohead, x->x_fifotail, wantbytes);
-#endif
-                    }
-                    else
-                    {
-#ifdef DEBUG_SOUNDFILE_THREADS
-                        fprintf(stderr, "readsf~: wait 7a...\n");
-#endif
-                        sfread_cond_signal(&x->x_answercondition);
-#ifdef DEBUG_SOUNDFILE_THREADS
-                        fprintf(stderr, "readsf~: signaled...\n");
-#endif
-                        sfread_cond_wait(&x->x_requestcondition, &x->x_mutex);
-#ifdef DEBUG_SOUNDFILE_THREADS
-                        fprintf(stderr, "readsf~: 7a ... done\n");
-#endif
-                        continue;
-                    }
-                }
-                else
-                {
-                        /* otherwise check if there are at least READSIZE
-                        bytes to read.  If not, wait and loop back. */
-                    wantbytes =  x->x_fifotail - x->x_fifohead - 1;
-                    if (wantbytes < READSIZE)
-                    {
-#ifdef DEBUG_SOUNDFILE_THREADS
-                        fprintf(stderr, "readsf~: wait 7...\n");
-#endif
-                        sfread_cond_signal(&x->x_answercondition);
-                        sfread_cond_wait(&x->x_requestcondition, &x->x_mutex);
-#ifdef DEBUG_SOUNDFILE_THREADS
-                        fprintf(stderr, "readsf~: 7 ... done\n");
-#endif
-                        continue;
-                    }
-                    else wantbytes = READSIZE;
-                    if (sf.sf_bytelimit >= 0 && wantbytes > (size_t)sf.sf_bytelimit)
-                        wantbytes = sf.sf_bytelimit;
-                }
-#ifdef DEBUG_SOUNDFILE_THREADS
-                fprintf(stderr, "readsf~: 8\n");
-#endif
-                buf = x->x_buf;
-                fifohead = x->x_fifohead;
-                pthread_mutex_unlock(&x->x_mutex);
-                bytesread = read(sf.sf_fd, buf + fifohead, wantbytes);
-                pthread_mutex_lock(&x->x_mutex);
-                if (x->x_requestcode != REQUEST_BUSY)
-                    break;
-                if (bytesread < 0)
-                {
+/* ----- readsf~ work done by the I/O threads ----- */
+
+    /** how many bytes we can read into the FIFO right now, or 0 */
+static size_t readsf_readsize(t_readsf *x, int head, int tail)
+{
+    int fifosize = SFIO_LOAD(&x->x_fifosize);
+    size_t wantbytes;
+    if (head >= tail)
+    {
+            /* if the head is >= the tail, we can immediately read
+            to the end of the fifo.  Unless, that is, we would
+            read all the way to the end of the buffer and the
+            "tail" is zero; this would fill the buffer completely
+            which isn't allowed because you can't tell a completely
+            full buffer from an empty one. */
+        if (!tail && fifosize - head <= READSIZE)
+            return (0);
+        wantbytes = fifosize - head;
+        if (wantbytes > READSIZE)
+            wantbytes = READSIZE;
+    }
+    else
+    {
+            /* otherwise check if there are at least READSIZE
+            bytes to read. */
+        if (tail - head - 1 < READSIZE)
+            return (0);
+        wantbytes = READSIZE;
+    }
+    if (x->x_iosf.sf_bytelimit >= 0 &&
+        wantbytes > (size_t)x->x_iosf.sf_bytelimit)
+            wantbytes = x->x_iosf.sf_bytelimit;
+    return (wantbytes);
+}
+
+    /** 0 for a pending request, otherwise 1 + frames left in the FIFO, or
+        -1 if there's nothing to do; called without the mutex */
+static long readsf_deadline(t_readsf *x)
+{
+    int request = SFIO_LOAD(&x->x_requestcode), head, tail, fifosize;
+    if (request == REQUEST_NOTHING)
+        return (-1);
+    else if (request != REQUEST_BUSY)
+        return (0);
+    head = SFIO_LOAD(&x->x_fifohead);
+    tail = SFIO_LOAD(&x->x_fifotail);
+    fifosize = SFIO_LOAD(&x->x_fifosize);
+    if (SFIO_LOAD(&x->x_eof) || !readsf_readsize(x, head, tail))
+        return (-1);
+    return (1 + ((head - tail + fifosize) % fifosize) /
+        x->x_iosf.sf_bytesperframe);
+}
+
+    /** close the file, if any, with the mutex unlocked */
+static void readsf_closefile(t_readsf *x)
+{
+    if (x->x_iosf.sf_fd >= 0)
+    {
+        t_soundfile sf;
+        soundfile_copy(&sf, &x->x_iosf);
+        x->x_iosf.sf_fd = x->x_sf.sf_fd = -1;
+        x->x_iosf.sf_data = x->x_sf.sf_data = NULL;
+        pthread_mutex_unlock(&x->x_mutex);
+        soundfile_close(&sf);
+        pthread_mutex_lock(&x->x_mutex);
+    }
+}
+
+    /** stop streaming: close the file, set EOF and signal once more */
+static void readsf_lost(t_readsf *x)
+{
+    if (x->x_requestcode == REQUEST_BUSY)
+        SFIO_STORE(&x->x_requestcode, REQUEST_NOTHING);
+    if (x->x_iosf.sf_fd >= 0)
+    {
+            /* only set EOF if there is no pending "open" request!
+            Otherwise, we might accidentally set EOF after it has been
+            unset in readsf_open() and the stream would fail silently. */
+        if (x->x_requestcode != REQUEST_OPEN)
+            SFIO_STORE(&x->x_eof, 1);
+        readsf_closefile(x);
+    }
+    sfread_cond_signal(&x->x_answercondition);
+}
+
+static void readsf_doopen(t_readsf *x)
+{
+    t_soundfile *sf = &x->x_iosf;
+        /* copy file stuff out of the data structure so we can
+        relinquish the mutex while we're in open_soundfile_via_path() */
+    size_t onsetframes = x->x_onsetframes;
+    const char *filename = x->x_filename;
+    const char *dirname = canvas_getdir(x->x_canvas)->s_name;
+    int err;
+
+        /* alter the request code so that an ensuing "open" will get
+        noticed. */
+    SFIO_STORE(&x->x_requestcode, REQUEST_BUSY);
+    x->x_fileerror = 0;
+
+        /* if there's already a file open, close it */
+    if (sf->sf_fd >= 0)
+    {
+        readsf_closefile(x);
+        if (x->x_requestcode != REQUEST_BUSY)
+            return;
+    }
+        /* cache sf *after* closing as x->sf's type
+            may have changed in readsf_open() */
+    soundfile_copy(sf, &x->x_sf);
+
+        /* open the soundfile with the mutex unlocked */
+    pthread_mutex_unlock(&x->x_mutex);
+    open_soundfile_via_path(dirname, filename, sf, onsetframes);
+    err = errno;
+    pthread_mutex_lock(&x->x_mutex);
+
+    if (sf->sf_fd < 0)
+    {
+        x->x_fileerror = err;
+        SFIO_STORE(&x->x_eof, 1);
 #ifdef DEBUG_SOUNDFILE_THREADS
-                    fprintf(stderr, "readsf~: fileerror %d\n", errno);
+        fprintf(stderr, "readsf~: open failed %s %s\n", filename, dirname);
 #endif
-                    x->x_fileerror = errno;
-                    break;
-                }
-                else if (bytesread == 0)
-                {
-                    x->x_eof = 1;
-                    break;
-                }
-                else
-                {
-                    x->x_fifohead += bytesread;
-                    sf.sf_bytelimit -= bytesread;
-                    if (x->x_fifohead == fifosize)
-                        x->x_fifohead = 0;
-                    if (sf.sf_bytelimit <= 0)
-                    {
-                        x->x_eof = 1;
-                        break;
-                    }
-                }
+        readsf_lost(x);
+        return;
+    }
+        /* check if another request has been made; if so, field it */
+    if (x->x_requestcode != REQUEST_BUSY)
+    {
+        readsf_lost(x);
+        return;
+    }
+        /* copy back into the instance structure; the perform routine
+        only looks at it once the head has moved. */
+    soundfile_copy(&x->x_sf, sf);
+        /* set fifosize from bufsize.  fifosize must be a
+        multiple of the number of bytes eaten for each DSP
+        tick.  We pessimistically assume MAXVECSIZE samples
+        per tick since that could change.  There could be a
+        problem here if the vector size increases while a
+        soundfile is being played...  The perform routine
+        and the other I/O threads read both indices without
+        the mutex, so publish them atomically. */
+    SFIO_STORE(&x->x_fifosize, x->x_bufsize - (x->x_bufsize %
+        (sf->sf_bytesperframe * MAXVECSIZE)));
+    SFIO_STORE(&x->x_fifohead, 0);
 #ifdef DEBUG_SOUNDFILE_THREADS
-                fprintf(stderr, "readsf~: after, head %d tail %d\n",
-                    x->x_fifohead, x->x_fifotail);
+    fprintf(stderr, "readsf~: fifosize %d\n", x->x_fifosize);
 #endif
-                    /* signal parent in case it's waiting for data */
-                sfread_cond_signal(&x->x_answercondition);
-            }
+        /* nothing to read (a file without sample frames, or an onset at or
+        past its end): we're at EOF already, which "start" would otherwise
+        wait for forever since readsf_doread() has nothing to do */
+    if (sf->sf_bytelimit <= 0)
+    {
+        readsf_lost(x);
+        return;
+    }
+    sfread_cond_signal(&x->x_answercondition);
+}
 
-        lost:
-            if (x->x_requestcode == REQUEST_BUSY)
-                x->x_requestcode = REQUEST_NOTHING;
-#ifdef DEBUG_SOUNDFILE_THREADS
-                fprintf(stderr, "readsf~: lost\n");
-#endif
-                /* fell out of read loop: close file if necessary,
-                set EOF and signal once more */
-            if (sf.sf_fd >= 0)
-            {
-                    /* only set EOF if there is no pending "open" request!
-                    Otherwise, we might accidentally set EOF after it has been
-                    unset in readsf_open() and the stream would fail silently. */
-                if (x->x_requestcode != REQUEST_OPEN)
-                    x->x_eof = 1;
-                x->x_sf.sf_fd = -1;
-                    /* use cached sf */
-                pthread_mutex_unlock(&x->x_mutex);
-                sys_close(sf.sf_fd);
-                sf.sf_fd = -1;
-                pthread_mutex_lock(&x->x_mutex);
-            }
-            sfread_cond_signal(&x->x_answercondition);
-        }
-        else if (x->x_requestcode == REQUEST_CLOSE)
-        {
-            if (sf.sf_fd >= 0)
-            {
-                x->x_sf.sf_fd = -1;
-                    /* use cached sf */
-                pthread_mutex_unlock(&x->x_mutex);
-                sys_close(sf.sf_fd);
-                sf.sf_fd = -1;
-                pthread_mutex_lock(&x->x_mutex);
-            }
-            if (x->x_requestcode == REQUEST_CLOSE)
-                x->x_requestcode = REQUEST_NOTHING;
-            sfread_cond_signal(&x->x_answercondition);
-        }
-        else if (x->x_requestcode == REQUEST_QUIT)
-        {
-            if (sf.sf_fd >= 0)
-            {
-                x->x_sf.sf_fd = -1;
-                    /* use cached sf */
-                pthread_mutex_unlock(&x->x_mutex);
-                sys_close(sf.sf_fd);
-                sf.sf_fd = -1;
-                pthread_mutex_lock(&x->x_mutex);
-            }
-            x->x_requestcode = REQUEST_NOTHING;
-            sfread_cond_signal(&x->x_answercondition);
-            break;
-        }
-        else
-        {
+    /* read one chunk into the FIFO, if there's room for one */
+static void readsf_doread(t_readsf *x)
+{
+    t_soundfile *sf = &x->x_iosf;
+    int head = SFIO_LOAD(&x->x_fifohead), err;
+    size_t wantbytes = readsf_readsize(x, head, SFIO_LOAD(&x->x_fifotail));
+    ssize_t bytesread;
+    if (SFIO_LOAD(&x->x_eof) || !wantbytes)
+        return;
+    pthread_mutex_unlock(&x->x_mutex);
+    bytesread = soundfile_readsamples(sf, x->x_buf + head, wantbytes);
+    err = errno;
+    pthread_mutex_lock(&x->x_mutex);
+    if (x->x_requestcode != REQUEST_BUSY)
+        return;
+    if (bytesread < 0)
+    {
 #ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "readsf~: 13\n");
+        fprintf(stderr, "readsf~: fileerror %d\n", err);
 #endif
-        }
+        x->x_fileerror = err;
+        readsf_lost(x);
+        return;
+    }
+    else if (bytesread == 0)
+    {
+        readsf_lost(x);
+        return;
+    }
+    head += bytesread;
+    if (head == SFIO_LOAD(&x->x_fifosize))
+        head = 0;
+    SFIO_STORE(&x->x_fifohead, head);
+    sf->sf_bytelimit -= bytesread;
+    if (sf->sf_bytelimit <= 0)
+    {
+        readsf_lost(x);
+        return;
     }
 #ifdef DEBUG_SOUNDFILE_THREADS
-    fprintf(stderr, "readsf~: thread exit\n");
+    fprintf(stderr, "readsf~: after, head %d tail %d\n",
+        x->x_fifohead, x->x_fifotail);
 #endif
+        /* signal parent in case it's waiting for data */
+    sfread_cond_signal(&x->x_answercondition);
+}
+
+static void readsf_service(t_readsf *x)
+{
+    pthread_mutex_lock(&x->x_mutex);
+    switch (x->x_requestcode)
+    {
+    case REQUEST_OPEN:
+        readsf_doopen(x);
+        break;
+    case REQUEST_BUSY:
+        readsf_doread(x);
+        break;
+    case REQUEST_CLOSE:
+    case REQUEST_QUIT:
+        readsf_closefile(x);
+        if (x->x_requestcode == REQUEST_CLOSE ||
+            x->x_requestcode == REQUEST_QUIT)
+                SFIO_STORE(&x->x_requestcode, REQUEST_NOTHING);
+        sfread_cond_signal(&x->x_answercondition);
+        break;
+    default:
+        break;
+    }
     pthread_mutex_unlock(&x->x_mutex);
-    return 0;
 }
 
 /* ----- the object proper runs in the calling (parent) thread ----- */
@@ -1985,6 +2961,11 @@ static void *readsf_new(t_floatarg fnchannels, t_floatarg fbufsize)
         bufsize = MAXBUFSIZE;
     buf = getbytes(bufsize);
     if (!buf) return 0;
+    if (!sfio_start("readsf~"))
+    {
+        freebytes(buf, bufsize);
+        return 0;
+    }
 
     x = (t_readsf *)pd_new(readsf_class);
 
@@ -1993,7 +2974,6 @@ static void *readsf_new(t_floatarg fnchannels, t_floatarg fbufsize)
     x->x_noutlets = nchannels;
     x->x_bangout = outlet_new(&x->x_obj, &s_bang);
     pthread_mutex_init(&x->x_mutex, 0);
-    pthread_cond_init(&x->x_requestcondition, 0);
     pthread_cond_init(&x->x_answercondition, 0);
     x->x_vecsize = MAXVECSIZE;
     x->x_state = STATE_IDLE;
@@ -2003,13 +2983,17 @@ static void *readsf_new(t_floatarg fnchannels, t_floatarg fbufsize)
     x->x_sf.sf_bytespersample = 2;
     x->x_sf.sf_nchannels = 1;
     x->x_sf.sf_bytesperframe = 2;
+    soundfile_clear(&x->x_iosf);
     x->x_buf = buf;
     x->x_bufsize = bufsize;
     x->x_fifosize = x->x_fifohead = x->x_fifotail = x->x_requestcode = 0;
+    x->x_sigcountdown = x->x_sigperiod = bufsize / 16;
+    x->x_wait = x->x_underruns = 0;
+    x->x_iswriter = 0;
 #ifdef PDINSTANCE
     x->x_pd_this = pd_this;
 #endif
-    pthread_create(&x->x_childthread, 0, readsf_child_main, x);
+    sfio_addstream(x);
     return x;
 }
 
@@ -2018,101 +3002,121 @@ static void readsf_tick(t_readsf *x)
     outlet_bang(x->x_bangout);
 }
 
+    /** block until the I/O thread has put at least a block's worth into
+        the FIFO or hit the end of the file */
+static void readsf_waitfordata(t_readsf *x)
+{
+    int head, tail = x->x_fifotail;
+    pthread_mutex_lock(&x->x_mutex);
+    while (!SFIO_LOAD(&x->x_eof) && (head = SFIO_LOAD(&x->x_fifohead),
+        head >= tail && (head == tail || head < tail +
+            x->x_vecsize * x->x_sf.sf_bytesperframe - 1)))
+    {
+#ifdef DEBUG_SOUNDFILE_THREADS
+        fprintf(stderr, "readsf~: wait...\n");
+#endif
+        sfio_post();
+        sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
+    }
+    pthread_mutex_unlock(&x->x_mutex);
+}
+
 static t_int *readsf_perform(t_int *w)
 {
     t_readsf *x = (t_readsf *)(w[1]);
-    int vecsize = x->x_vecsize, noutlets = x->x_noutlets, i;
+    int vecsize = x->x_vecsize, noutlets = x->x_noutlets, xfersize = 0, i;
     size_t j;
     t_sample *fp;
     if (x->x_state == STATE_STREAM)
     {
-        int wantbytes;
-        t_soundfile sf = {0};
-        pthread_mutex_lock(&x->x_mutex);
-            /* copy with mutex locked! */
-        soundfile_copy(&sf, &x->x_sf);
-        wantbytes = vecsize * sf.sf_bytesperframe;
-        while (!x->x_eof && x->x_fifohead >= x->x_fifotail &&
-                x->x_fifohead < x->x_fifotail + wantbytes-1)
-        {
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "readsf~: wait...\n");
-#endif
-            sfread_cond_signal(&x->x_requestcondition);
-            sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
-                /* resync local variables -- bug fix thanks to Shahrokh */
-            vecsize = x->x_vecsize;
-            soundfile_copy(&sf, &x->x_sf);
-            wantbytes = vecsize * sf.sf_bytesperframe;
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "readsf~: ... done\n");
-#endif
-        }
-        if (x->x_eof && x->x_fifohead >= x->x_fifotail &&
-            x->x_fifohead < x->x_fifotail + wantbytes-1)
+        int wantbytes = 0, eof, head, tail = x->x_fifotail;
+            /* load eof before the head: once eof is set the head is final.
+            The format in x_sf is only safe to look at once the head has
+            moved since the I/O thread publishes it first. */
+        eof = SFIO_LOAD(&x->x_eof);
+        head = SFIO_LOAD(&x->x_fifohead);
+        if (head != tail)
+            wantbytes = vecsize * x->x_sf.sf_bytesperframe;
+        if (head >= tail && (head == tail || head < tail + wantbytes - 1))
         {
-            int xfersize;
-            if (x->x_fileerror)
-                object_sferror(x, "readsf~", x->x_filename,
-                    x->x_fileerror, &x->x_sf);
-                /* if there's a partial buffer left, copy it out */
-            xfersize = (x->x_fifohead - x->x_fifotail + 1) /
-                       sf.sf_bytesperframe;
-            if (xfersize)
+            if (!eof)
             {
-                soundfile_xferin_sample(&sf, noutlets, x->x_outvec, 0,
-                    (unsigned char *)(x->x_buf + x->x_fifotail), xfersize);
-                vecsize -= xfersize;
+                if (!x->x_wait && !SFIO_LOAD(&sfio_wait))
+                {
+                        /* drop the block rather than wait for the disk */
+                    sfio_underrun(x);
+                    goto zero;
+                }
+                readsf_waitfordata(x);
+                eof = SFIO_LOAD(&x->x_eof);
+                head = SFIO_LOAD(&x->x_fifohead);
+                if (head != tail)
+                    wantbytes = vecsize * x->x_sf.sf_bytesperframe;
+            }
+            if (eof && head >= tail &&
+                (head == tail || head < tail + wantbytes - 1))
+            {
+                if (x->x_fileerror)
+                    object_sferror(x, "readsf~", x->x_filename,
+                        x->x_fileerror, &x->x_sf);
+                    /* if there's a partial buffer left, copy it out */
+                if (head != tail)
+                    xfersize = (head - tail + 1) / x->x_sf.sf_bytesperframe;
+                if (xfersize)
+                {
+                    soundfile_xferin_sample(&x->x_sf, noutlets, x->x_outvec,
+                        0, (unsigned char *)(x->x_buf + tail), xfersize);
+                    vecsize -= xfersize;
+                }
+                    /* send bang and zero out the (rest of the) output */
+                clock_delay(x->x_clock, 0);
+                x->x_state = STATE_IDLE;
+                goto zero;
             }
-            pthread_mutex_unlock(&x->x_mutex);
-                /* send bang and zero out the (rest of the) output */
-            clock_delay(x->x_clock, 0);
-            x->x_state = STATE_IDLE;
-            for (i = 0; i < noutlets; i++)
-                for (j = vecsize, fp = x->x_outvec[i] + xfersize; j--;)
-                    *fp++ = 0;
-            return w + 2;
         }
 
-        soundfile_xferin_sample(&sf, noutlets, x->x_outvec, 0,
-            (unsigned char *)(x->x_buf + x->x_fifotail), vecsize);
+        soundfile_xferin_sample(&x->x_sf, noutlets, x->x_outvec, 0,
+            (unsigned char *)(x->x_buf + tail), vecsize);
 
-        x->x_fifotail += wantbytes;
-        if (x->x_fifotail >= x->x_fifosize)
-            x->x_fifotail = 0;
-        if ((--x->x_sigcountdown) <= 0)
+        tail += wantbytes;
+        if (tail >= SFIO_LOAD(&x->x_fifosize))
+            tail = 0;
+        SFIO_STORE(&x->x_fifotail, tail);
+        if ((x->x_sigcountdown -= wantbytes) <= 0)
         {
-            sfread_cond_signal(&x->x_requestcondition);
+            sfio_post();
             x->x_sigcountdown = x->x_sigperiod;
         }
-        pthread_mutex_unlock(&x->x_mutex);
-    }
-    else
-    {
-        for (i = 0; i < noutlets; i++)
-            for (j = vecsize, fp = x->x_outvec[i]; j--;)
-                *fp++ = 0;
+        return w + 2;
     }
+zero:
+    for (i = 0; i < noutlets; i++)
+        for (j = vecsize, fp = x->x_outvec[i] + xfersize; j--;)
+            *fp++ = 0;
     return w + 2;
 }
 
     /** start making output.  If we're in the "startup" state change
-        to the "running" state. */
+        to the "running" state, first waiting for the beginning of the
+        file so that "open" followed right away by "start" doesn't drop
+        the first blocks. */
 static void readsf_start(t_readsf *x)
 {
     if (x->x_state == STATE_STARTUP)
+    {
+        readsf_waitfordata(x);
         x->x_state = STATE_STREAM;
+    }
     else pd_error(x, "readsf~: start requested with no prior 'open'");
 }
 
-    /** LATER rethink whether you need the mutex just to set a variable? */
 static void readsf_stop(t_readsf *x)
 {
     pthread_mutex_lock(&x->x_mutex);
     x->x_state = STATE_IDLE;
-    x->x_requestcode = REQUEST_CLOSE;
-    sfread_cond_signal(&x->x_requestcondition);
+    SFIO_STORE(&x->x_requestcode, REQUEST_CLOSE);
     pthread_mutex_unlock(&x->x_mutex);
+    sfio_post();
 }
 
 static void readsf_float(t_readsf *x, t_floatarg f)
@@ -2153,10 +3157,10 @@ static void readsf_open(t_readsf *x, t_symbol *s, int argc, t_atom *argv)
 
     pthread_mutex_lock(&x->x_mutex);
     soundfile_clear(&x->x_sf);
-    x->x_requestcode = REQUEST_OPEN;
+    SFIO_STORE(&x->x_requestcode, REQUEST_OPEN);
     x->x_filename = filesym->s_name;
-    x->x_fifotail = 0;
-    x->x_fifohead = 0;
+    SFIO_STORE(&x->x_fifotail, 0);
+    SFIO_STORE(&x->x_fifohead, 0);
     if (*endian->s_name == 'b')
          x->x_sf.sf_bigendian = 1;
     else if (*endian->s_name == 'l')
@@ -2177,11 +3181,11 @@ static void readsf_open(t_readsf *x, t_symbol *s, int argc, t_atom *argv)
     }
     else
         x->x_sf.sf_type = type;
-    x->x_eof = 0;
+    SFIO_STORE(&x->x_eof, 0);
     x->x_fileerror = 0;
     x->x_state = STATE_STARTUP;
-    sfread_cond_signal(&x->x_requestcondition);
     pthread_mutex_unlock(&x->x_mutex);
+    sfio_post();
     return;
 usage:
     pd_error(x, "usage: open [flags] filename [onset] [headersize]...");
@@ -2192,42 +3196,45 @@ usage:
 static void readsf_dsp(t_readsf *x, t_signal **sp)
 {
     int i, noutlets = x->x_noutlets;
-    pthread_mutex_lock(&x->x_mutex);
     x->x_vecsize = sp[0]->s_n;
-    x->x_sigperiod = x->x_fifosize / (x->x_sf.sf_bytesperframe * x->x_vecsize);
     for (i = 0; i < noutlets; i++)
         x->x_outvec[i] = sp[i]->s_vec;
-    pthread_mutex_unlock(&x->x_mutex);
     dsp_add(readsf_perform, 1, x);
 }
 
+    /** "wait 1" makes the perform routine wait for the disk when the
+        FIFO runs dry (or, for writesf~, full) instead of dropping the
+        block, as for non-realtime use; this can stall the whole audio
+        thread.  readsf~ starts with "wait 0", writesf~ with "wait 1". */
+static void readsf_wait(t_readsf *x, t_floatarg f)
+{
+    x->x_wait = (f != 0);
+}
+
 static void readsf_print(t_readsf *x)
 {
     post("state %d", x->x_state);
-    post("fifo head %d", x->x_fifohead);
-    post("fifo tail %d", x->x_fifotail);
-    post("fifo size %d", x->x_fifosize);
+    post("fifo head %d", SFIO_LOAD(&x->x_fifohead));
+    post("fifo tail %d", SFIO_LOAD(&x->x_fifotail));
+    post("fifo size %d", SFIO_LOAD(&x->x_fifosize));
     post("fd %d", x->x_sf.sf_fd);
-    post("eof %d", x->x_eof);
+    post("eof %d", SFIO_LOAD(&x->x_eof));
+    post("underruns %d", x->x_underruns);
 }
 
     /** request QUIT and wait for acknowledge */
 static void readsf_free(t_readsf *x)
 {
-    void *threadrtn;
     pthread_mutex_lock(&x->x_mutex);
-    x->x_requestcode = REQUEST_QUIT;
-    sfread_cond_signal(&x->x_requestcondition);
+    SFIO_STORE(&x->x_requestcode, REQUEST_QUIT);
     while (x->x_requestcode != REQUEST_NOTHING)
     {
-        sfread_cond_signal(&x->x_requestcondition);
+        sfio_post();
         sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
     }
     pthread_mutex_unlock(&x->x_mutex);
-    if (pthread_join(x->x_childthread, &threadrtn))
-        pd_error(x, "readsf_free: join failed");
+    sfio_removestream(x);
 
-    pthread_cond_destroy(&x->x_requestcondition);
     pthread_cond_destroy(&x->x_answercondition);
     pthread_mutex_destroy(&x->x_mutex);
     freebytes(x->x_buf, x->x_bufsize);
@@ -2246,6 +3253,8 @@ static void readsf_setup(void)
         gensym("dsp"), A_CANT, 0);
     class_addmethod(readsf_class, (t_method)readsf_open,
         gensym("open"), A_GIMME, 0);
+    class_addmethod(readsf_class, (t_method)readsf_wait,
+        gensym("wait"), A_FLOAT, 0);
     class_addmethod(readsf_class, (t_method)readsf_print, gensym("print"), 0);
 }
 
@@ -2255,240 +3264,203 @@ static t_class *writesf_class;
 
 typedef t_readsf t_writesf; /* just re-use the structure */
 
-/* ----- the child thread which performs file I/O ----- */
+/* ----- writesf~ work done by the I/O threads ----- */
 
-static void *writesf_child_main(void *zz)
+    /** how many bytes we can write from the FIFO right now, or 0.  If the
+        head is < the tail, we can immediately write from tail to end of
+        fifo to disk; otherwise we hold off writing until there are at
+        least WRITESIZE bytes in the buffer, unless we're closing. */
+static size_t writesf_writesize(t_writesf *x, int head, int tail, int flush)
 {
-    t_writesf *x = zz;
-    t_soundfile sf = {0};
-    soundfile_clear(&sf);
-#ifdef PDINSTANCE
-    pd_this = x->x_pd_this;
-#endif
-#ifdef DEBUG_SOUNDFILE_THREADS
-    fprintf(stderr, "writesf~: 1\n");
-#endif
-    pthread_mutex_lock(&x->x_mutex);
-    while (1)
+    size_t writebytes;
+    if (head < tail || head >= tail + WRITESIZE || (flush && head != tail))
     {
-#ifdef DEBUG_SOUNDFILE_THREADS
-        fprintf(stderr, "writesf~: 0\n");
-#endif
-        if (x->x_requestcode == REQUEST_NOTHING)
-        {
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "writesf~: wait 2\n");
-#endif
-            sfread_cond_signal(&x->x_answercondition);
-            sfread_cond_wait(&x->x_requestcondition, &x->x_mutex);
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "writesf~: 3\n");
-#endif
-        }
-        else if (x->x_requestcode == REQUEST_OPEN)
-        {
-            ssize_t byteswritten;
-            size_t writebytes;
+        writebytes = (head < tail ? SFIO_LOAD(&x->x_fifosize) : head) - tail;
+        if (writebytes > WRITESIZE)
+            writebytes = WRITESIZE;
+        return (writebytes);
+    }
+    else return (0);
+}
 
-                /* copy file stuff out of the data structure so we can
-                relinquish the mutex while we're in open_soundfile_via_path() */
-            const char *filename = x->x_filename;
-            t_canvas *canvas = x->x_canvas;
-            soundfile_copy(&sf, &x->x_sf);
+    /** 0 for a pending request, otherwise 1 + frames of room left in the
+        FIFO, or -1 if there's nothing to do; called without the mutex */
+static long writesf_deadline(t_writesf *x)
+{
+    int request = SFIO_LOAD(&x->x_requestcode), head, tail, fifosize;
+    if (request == REQUEST_NOTHING)
+        return (-1);
+    else if (request != REQUEST_BUSY)
+        return (0);
+    head = SFIO_LOAD(&x->x_fifohead);
+    tail = SFIO_LOAD(&x->x_fifotail);
+    fifosize = SFIO_LOAD(&x->x_fifosize);
+    if (!writesf_writesize(x, head, tail, 0))
+        return (-1);
+    return (1 + ((tail - head + fifosize) % fifosize) /
+        x->x_iosf.sf_bytesperframe);
+}
 
-                /* alter the request code so that an ensuing "open" will get
-                noticed. */
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "writesf~: 4\n");
-#endif
-            x->x_requestcode = REQUEST_BUSY;
-            x->x_fileerror = 0;
+    /** finish the header and close the file, if any, with the mutex
+        unlocked */
+static void writesf_closefile(t_writesf *x)
+{
+    t_soundfile *sf = &x->x_iosf;
+    if (sf->sf_fd >= 0)
+    {
+        const char *filename = x->x_filename;
+        size_t frameswritten = x->x_frameswritten;
+        pthread_mutex_unlock(&x->x_mutex);
+        soundfile_finishwrite(x, filename, sf, SFMAXFRAMES, frameswritten);
+        sys_close(sf->sf_fd);
+        sf->sf_fd = -1;
+        pthread_mutex_lock(&x->x_mutex);
+        x->x_sf.sf_fd = -1;
+    }
+}
 
-                /* if there's already a file open, close it.  This
-                should never happen since writesf_open() calls stop if
-                needed and then waits until we're idle. */
-            if (sf.sf_fd >= 0)
-            {
-                size_t frameswritten = x->x_frameswritten;
+    /** hit an error; close file if necessary, set EOF and signal once more */
+static void writesf_bail(t_writesf *x)
+{
+    if (x->x_requestcode == REQUEST_BUSY)
+        SFIO_STORE(&x->x_requestcode, REQUEST_NOTHING);
+    if (x->x_iosf.sf_fd >= 0)
+    {
+        int fd = x->x_iosf.sf_fd;
+        x->x_iosf.sf_fd = -1;
+        pthread_mutex_unlock(&x->x_mutex);
+        sys_close(fd);
+        pthread_mutex_lock(&x->x_mutex);
+        SFIO_STORE(&x->x_eof, 1);
+        x->x_sf.sf_fd = -1;
+    }
+    sfread_cond_signal(&x->x_answercondition);
+}
 
-                pthread_mutex_unlock(&x->x_mutex);
-                soundfile_finishwrite(x, filename, &sf,
-                    SFMAXFRAMES, frameswritten);
-                sys_close(sf.sf_fd);
-                sf.sf_fd = -1;
-                pthread_mutex_lock(&x->x_mutex);
-                x->x_sf.sf_fd = -1;
-#ifdef DEBUG_SOUNDFILE_THREADS
-                fprintf(stderr, "writesf~: bug? ditched %ld\n", frameswritten);
-#endif
-                if (x->x_requestcode != REQUEST_BUSY)
-                    continue;
-            }
-                /* cache sf *after* closing as x->sf's type
-                    may have changed in writesf_open() */
-            soundfile_copy(&sf, &x->x_sf);
+static void writesf_doopen(t_writesf *x)
+{
+    t_soundfile *sf = &x->x_iosf;
+        /* copy file stuff out of the data structure so we can
+        relinquish the mutex while we're in create_soundfile() */
+    const char *filename = x->x_filename;
+    t_canvas *canvas = x->x_canvas;
+    int err;
 
-                /* open the soundfile with the mutex unlocked */
-            pthread_mutex_unlock(&x->x_mutex);
-            create_soundfile(canvas, filename, &sf, 0);
-            pthread_mutex_lock(&x->x_mutex);
+        /* alter the request code so that an ensuing "open" will get
+        noticed. */
+    SFIO_STORE(&x->x_requestcode, REQUEST_BUSY);
+    x->x_fileerror = 0;
 
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "writesf~: 5\n");
-#endif
+        /* if there's already a file open, close it.  This
+        should never happen since writesf_open() calls stop if
+        needed and then waits until we're idle. */
+    if (sf->sf_fd >= 0)
+    {
+        writesf_closefile(x);
+        if (x->x_requestcode != REQUEST_BUSY)
+            return;
+    }
+        /* cache sf *after* closing as x->sf's type
+            may have changed in writesf_open() */
+    soundfile_copy(sf, &x->x_sf);
 
-            if (sf.sf_fd < 0)
-            {
-                x->x_sf.sf_fd = -1;
-                x->x_eof = 1;
-                x->x_fileerror = errno;
-#ifdef DEBUG_SOUNDFILE_THREADS
-                fprintf(stderr, "writesf~: open failed %s\n", filename);
-#endif
-                goto bail;
-            }
-                /* check if another request has been made; if so, field it */
-            if (x->x_requestcode != REQUEST_BUSY)
-                continue;
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "writesf~: 6\n");
-#endif
-                /* copy back into the instance structure. */
-            soundfile_copy(&x->x_sf, &sf);
-            x->x_fifotail = 0;
-            x->x_frameswritten = 0;
-                /* in a loop, wait for the fifo to have data and write it
-                    to disk */
-            while (x->x_requestcode == REQUEST_BUSY ||
-                (x->x_requestcode == REQUEST_CLOSE &&
-                    x->x_fifohead != x->x_fifotail))
-            {
-                int fifosize = x->x_fifosize, fifotail;
-                char *buf = x->x_buf;
-#ifdef DEBUG_SOUNDFILE_THREADS
-                fprintf(stderr, "writesf~: 77\n");
-#endif
-                    /* if the head is < the tail, we can immediately write
-                    from tail to end of fifo to disk; otherwise we hold off
-                    writing until there are at least WRITESIZE bytes in the
-                    buffer */
-                if (x->x_fifohead < x->x_fifotail ||
-                    x->x_fifohead >= x->x_fifotail + WRITESIZE
-                    || (x->x_requestcode == REQUEST_CLOSE &&
-                        x->x_fifohead != x->x_fifotail))
-                {
-                    writebytes = (x->x_fifohead < x->x_fifotail ?
-                        fifosize : x->x_fifohead) - x->x_fifotail;
-                    if (writebytes > READSIZE)
-                        writebytes = READSIZE;
-                }
-                else
-                {
-#ifdef DEBUG_SOUNDFILE_THREADS
-                    fprintf(stderr, "writesf~: wait 7a...\n");
-#endif
-                    sfread_cond_signal(&x->x_answercondition);
-#ifdef DEBUG_SOUNDFILE_THREADS
-                    fprintf(stderr, "writesf~: signaled...\n");
-#endif
-                    sfread_cond_wait(&x->x_requestcondition,
-                        &x->x_mutex);
-#ifdef DEBUG_SOUNDFILE_THREADS
-                    fprintf(stderr, "writesf~: 7a ... done\n");
-#endif
-                    continue;
-                }
+        /* open the soundfile with the mutex unlocked */
+    pthread_mutex_unlock(&x->x_mutex);
+    create_soundfile(canvas, filename, sf, 0);
+    err = errno;
+    pthread_mutex_lock(&x->x_mutex);
+
+    if (sf->sf_fd < 0)
+    {
+        x->x_sf.sf_fd = -1;
+        SFIO_STORE(&x->x_eof, 1);
+        x->x_fileerror = err;
 #ifdef DEBUG_SOUNDFILE_THREADS
-                fprintf(stderr, "writesf~: 8\n");
+        fprintf(stderr, "writesf~: open failed %s\n", filename);
 #endif
-                fifotail = x->x_fifotail;
-                soundfile_copy(&sf, &x->x_sf);
-                pthread_mutex_unlock(&x->x_mutex);
-                byteswritten = write(sf.sf_fd, buf + fifotail, writebytes);
-                pthread_mutex_lock(&x->x_mutex);
-                if (x->x_requestcode != REQUEST_BUSY &&
-                    x->x_requestcode != REQUEST_CLOSE)
-                        break;
-                if (byteswritten < 0 || (size_t)byteswritten < writebytes)
-                {
+        writesf_bail(x);
+        return;
+    }
+        /* only the fd goes back into the instance structure; the perform
+        routine reads the format from it without locking. */
+    x->x_sf.sf_fd = sf->sf_fd;
+    SFIO_STORE(&x->x_fifotail, 0);
+    x->x_frameswritten = 0;
+    sfread_cond_signal(&x->x_answercondition);
+}
+
+    /* write one chunk from the FIFO to disk, if there's enough in it */
+static void writesf_dowrite(t_writesf *x)
+{
+    t_soundfile *sf = &x->x_iosf;
+    int tail = SFIO_LOAD(&x->x_fifotail), err;
+    size_t writebytes = writesf_writesize(x, SFIO_LOAD(&x->x_fifohead), tail,
+        (x->x_requestcode == REQUEST_CLOSE));
+    ssize_t byteswritten;
+    if (!writebytes)
+        return;
+    pthread_mutex_unlock(&x->x_mutex);
+    byteswritten = write(sf->sf_fd, x->x_buf + tail, writebytes);
+    err = errno;
+    pthread_mutex_lock(&x->x_mutex);
+    if (x->x_requestcode != REQUEST_BUSY &&
+        x->x_requestcode != REQUEST_CLOSE)
+            return;
+    if (byteswritten < 0 || (size_t)byteswritten < writebytes)
+    {
 #ifdef DEBUG_SOUNDFILE_THREADS
-                    fprintf(stderr, "writesf~: fileerror %d\n", errno);
+        fprintf(stderr, "writesf~: fileerror %d\n", err);
 #endif
-                    x->x_fileerror = errno;
-                    goto bail;
-                }
-                else
-                {
-                    x->x_fifotail += byteswritten;
-                    if (x->x_fifotail == fifosize)
-                        x->x_fifotail = 0;
-                }
-                x->x_frameswritten += byteswritten / sf.sf_bytesperframe;
+        x->x_fileerror = err;
+        writesf_bail(x);
+        return;
+    }
+    tail += byteswritten;
+    if (tail == SFIO_LOAD(&x->x_fifosize))
+        tail = 0;
+    SFIO_STORE(&x->x_fifotail, tail);
+    x->x_frameswritten += byteswritten / sf->sf_bytesperframe;
 #ifdef DEBUG_SOUNDFILE_THREADS
-                fprintf(stderr, "writesf~: after head %d tail %d written %ld\n",
-                    x->x_fifohead, x->x_fifotail, x->x_frameswritten);
+    fprintf(stderr, "writesf~: after head %d tail %d written %ld\n",
+        x->x_fifohead, x->x_fifotail, x->x_frameswritten);
 #endif
-                    /* signal parent in case it's waiting for data */
-                sfread_cond_signal(&x->x_answercondition);
-                continue;
-
-             bail:
-                 if (x->x_requestcode == REQUEST_BUSY)
-                     x->x_requestcode = REQUEST_NOTHING;
-                     /* hit an error; close file if necessary,
-                     set EOF and signal once more */
-                 if (sf.sf_fd >= 0)
-                 {
-                     pthread_mutex_unlock(&x->x_mutex);
-                     sys_close(sf.sf_fd);
-                     sf.sf_fd = -1;
-                     pthread_mutex_lock(&x->x_mutex);
-                     x->x_eof = 1;
-                     x->x_sf.sf_fd = -1;
-                 }
-                 sfread_cond_signal(&x->x_answercondition);
-            }
-        }
-        else if (x->x_requestcode == REQUEST_CLOSE ||
-            x->x_requestcode == REQUEST_QUIT)
-        {
-            int quit = (x->x_requestcode == REQUEST_QUIT);
-            if (sf.sf_fd >= 0)
-            {
-                const char *filename = x->x_filename;
-                size_t frameswritten = x->x_frameswritten;
-                soundfile_copy(&sf, &x->x_sf);
-                pthread_mutex_unlock(&x->x_mutex);
-                soundfile_finishwrite(x, filename, &sf,
-                    SFMAXFRAMES, frameswritten);
-                sys_close(sf.sf_fd);
-                sf.sf_fd = -1;
-                pthread_mutex_lock(&x->x_mutex);
-                x->x_sf.sf_fd = -1;
-            }
-            x->x_requestcode = REQUEST_NOTHING;
-            sfread_cond_signal(&x->x_answercondition);
-            if (quit)
-                break;
-        }
-        else
+        /* signal parent in case it's waiting for room */
+    sfread_cond_signal(&x->x_answercondition);
+}
+
+static void writesf_service(t_writesf *x)
+{
+    pthread_mutex_lock(&x->x_mutex);
+    switch (x->x_requestcode)
+    {
+    case REQUEST_OPEN:
+        writesf_doopen(x);
+        break;
+    case REQUEST_BUSY:
+        writesf_dowrite(x);
+        break;
+    case REQUEST_CLOSE:
+            /* write out what's left before closing */
+        if (x->x_iosf.sf_fd >= 0 &&
+            SFIO_LOAD(&x->x_fifohead) != SFIO_LOAD(&x->x_fifotail))
         {
-#ifdef DEBUG_SOUNDFILE_THREADS
-            fprintf(stderr, "writesf~: 13\n");
-#endif
+            writesf_dowrite(x);
+            break;
         }
+        /* fall through */
+    case REQUEST_QUIT:
+        writesf_closefile(x);
+        SFIO_STORE(&x->x_requestcode, REQUEST_NOTHING);
+        sfread_cond_signal(&x->x_answercondition);
+        break;
+    default:
+        break;
     }
-#ifdef DEBUG_SOUNDFILE_THREADS
-    fprintf(stderr, "writesf~: thread exit\n");
-#endif
     pthread_mutex_unlock(&x->x_mutex);
-    return 0;
 }
 
 /* ----- the object proper runs in the calling (parent) thread ----- */
 
-static void writesf_tick(t_writesf *x);
-
 static void *writesf_new(t_floatarg fnchannels, t_floatarg fbufsize)
 {
     t_writesf *x;
@@ -2506,6 +3478,11 @@ static void *writesf_new(t_floatarg fnchannels, t_floatarg fbufsize)
         bufsize = MAXBUFSIZE;
     buf = getbytes(bufsize);
     if (!buf) return 0;
+    if (!sfio_start("writesf~"))
+    {
+        freebytes(buf, bufsize);
+        return 0;
+    }
 
     x = (t_writesf *)pd_new(writesf_class);
 
@@ -2514,7 +3491,6 @@ static void *writesf_new(t_floatarg fnchannels, t_floatarg fbufsize)
 
     x->x_f = 0;
     pthread_mutex_init(&x->x_mutex, 0);
-    pthread_cond_init(&x->x_requestcondition, 0);
     pthread_cond_init(&x->x_answercondition, 0);
     x->x_vecsize = MAXVECSIZE;
     x->x_insamplerate = 0;
@@ -2525,13 +3501,20 @@ static void *writesf_new(t_floatarg fnchannels, t_floatarg fbufsize)
     x->x_sf.sf_nchannels = nchannels;
     x->x_sf.sf_bytespersample = 2;
     x->x_sf.sf_bytesperframe = nchannels * 2;
+    soundfile_clear(&x->x_iosf);
     x->x_buf = buf;
     x->x_bufsize = bufsize;
     x->x_fifosize = x->x_fifohead = x->x_fifotail = x->x_requestcode = 0;
+    x->x_sigcountdown = x->x_sigperiod = bufsize / 16;
+        /* unlike readsf~, wait for the disk unless told to drop blocks,
+        since a dropped block is lost from the file for good */
+    x->x_wait = 1;
+    x->x_underruns = 0;
+    x->x_iswriter = 1;
 #ifdef PDINSTANCE
     x->x_pd_this = pd_this;
 #endif
-    pthread_create(&x->x_childthread, 0, writesf_child_main, x);
+    sfio_addstream(x);
     return x;
 }
 
@@ -2540,56 +3523,61 @@ static t_int *writesf_perform(t_int *w)
     t_writesf *x = (t_writesf *)(w[1]);
     if (x->x_state == STATE_STREAM)
     {
-        size_t roominfifo;
-        size_t wantbytes;
-        int vecsize = x->x_vecsize;
-        t_soundfile sf = {0};
-        pthread_mutex_lock(&x->x_mutex);
-            /* copy with mutex locked! */
-        soundfile_copy(&sf, &x->x_sf);
-        wantbytes = vecsize * sf.sf_bytesperframe;
-        roominfifo = x->x_fifotail - x->x_fifohead;
-        if (roominfifo <= 0)
-            roominfifo += x->x_fifosize;
-        while (!x->x_eof && roominfifo < wantbytes + 1)
+        int vecsize = x->x_vecsize, head = x->x_fifohead, roominfifo;
+        int wantbytes = vecsize * x->x_sf.sf_bytesperframe;
+        if (!SFIO_LOAD(&x->x_eof))
         {
-            fprintf(stderr, "writesf waiting for disk write..\n");
-            fprintf(stderr, "(head %d, tail %d, room %d, want %ld)\n",
-                (int)x->x_fifohead, (int)x->x_fifotail,
-                (int)roominfifo, (long)wantbytes);
-            sfread_cond_signal(&x->x_requestcondition);
-            sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
-            fprintf(stderr, "... done waiting.\n");
-            roominfifo = x->x_fifotail - x->x_fifohead;
+            roominfifo = SFIO_LOAD(&x->x_fifotail) - head;
             if (roominfifo <= 0)
                 roominfifo += x->x_fifosize;
+            if (roominfifo < wantbytes + 1)
+            {
+                if (!x->x_wait && !SFIO_LOAD(&sfio_wait))
+                {
+                        /* drop the block rather than wait for the disk */
+                    sfio_underrun(x);
+                    return w + 2;
+                }
+                pthread_mutex_lock(&x->x_mutex);
+                while (!SFIO_LOAD(&x->x_eof) && roominfifo < wantbytes + 1)
+                {
+#ifdef DEBUG_SOUNDFILE_THREADS
+                    fprintf(stderr, "writesf~: waiting for disk write..\n");
+#endif
+                    sfio_post();
+                    sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
+                    roominfifo = SFIO_LOAD(&x->x_fifotail) - head;
+                    if (roominfifo <= 0)
+                        roominfifo += x->x_fifosize;
+                }
+                pthread_mutex_unlock(&x->x_mutex);
+            }
         }
-        if (x->x_eof)
+        if (SFIO_LOAD(&x->x_eof))
         {
             if (x->x_fileerror)
                 object_sferror(x, "writesf~", x->x_filename,
                     x->x_fileerror, &x->x_sf);
             x->x_state = STATE_IDLE;
-            sfread_cond_signal(&x->x_requestcondition);
-            pthread_mutex_unlock(&x->x_mutex);
+            sfio_post();
             return w + 2;
         }
 
-        soundfile_xferout_sample(&sf, x->x_outvec,
-            (unsigned char *)(x->x_buf + x->x_fifohead), vecsize, 0, 1.);
+        soundfile_xferout_sample(&x->x_sf, x->x_outvec,
+            (unsigned char *)(x->x_buf + head), vecsize, 0, 1.);
 
-        x->x_fifohead += wantbytes;
-        if (x->x_fifohead >= x->x_fifosize)
-            x->x_fifohead = 0;
-        if ((--x->x_sigcountdown) <= 0)
+        head += wantbytes;
+        if (head >= x->x_fifosize)
+            head = 0;
+        SFIO_STORE(&x->x_fifohead, head);
+        if ((x->x_sigcountdown -= wantbytes) <= 0)
         {
 #ifdef DEBUG_SOUNDFILE_THREADS
             fprintf(stderr, "writesf~: signal 1\n");
 #endif
-            sfread_cond_signal(&x->x_requestcondition);
+            sfio_post();
             x->x_sigcountdown = x->x_sigperiod;
         }
-        pthread_mutex_unlock(&x->x_mutex);
     }
     return w + 2;
 }
@@ -2604,17 +3592,22 @@ static void writesf_start(t_writesf *x)
         pd_error(x, "writesf~: start requested with no prior 'open'");
 }
 
-    /** LATER rethink whether you need the mutex just to set a variable? */
 static void writesf_stop(t_writesf *x)
 {
     pthread_mutex_lock(&x->x_mutex);
+        /* don't overwrite an "open" the I/O threads haven't got to yet */
+    while (x->x_requestcode == REQUEST_OPEN)
+    {
+        sfio_post();
+        sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
+    }
     x->x_state = STATE_IDLE;
-    x->x_requestcode = REQUEST_CLOSE;
+    SFIO_STORE(&x->x_requestcode, REQUEST_CLOSE);
 #ifdef DEBUG_SOUNDFILE_THREADS
     fprintf(stderr, "writesf~: signal 2\n");
 #endif
-    sfread_cond_signal(&x->x_requestcondition);
     pthread_mutex_unlock(&x->x_mutex);
+    sfio_post();
 }
 
     /** open method.  Called as: open [flags] filename with args as in
@@ -2635,10 +3628,10 @@ static void writesf_open(t_writesf *x, t_symbol *s, int argc, t_atom *argv)
     if (argc)
         pd_error(x, "writesf~ open: extra argument(s) ignored");
     pthread_mutex_lock(&x->x_mutex);
-        /* make sure that the child thread has finished writing */
+        /* make sure that the I/O thread has finished writing */
     while (x->x_requestcode != REQUEST_NOTHING)
     {
-        sfread_cond_signal(&x->x_requestcondition);
+        sfio_post();
         sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
     }
     x->x_filename = wa.wa_filesym->s_name;
@@ -2653,75 +3646,67 @@ static void writesf_open(t_writesf *x, t_symbol *s, int argc, t_atom *argv)
     x->x_sf.sf_bigendian = wa.wa_bigendian;
     x->x_sf.sf_bytesperframe = x->x_sf.sf_nchannels * x->x_sf.sf_bytespersample;
     x->x_frameswritten = 0;
-    x->x_requestcode = REQUEST_OPEN;
-    x->x_fifotail = 0;
-    x->x_fifohead = 0;
-    x->x_eof = 0;
-    x->x_fileerror = 0;
-    x->x_state = STATE_STARTUP;
         /* set fifosize from bufsize.  fifosize must be a
         multiple of the number of bytes eaten for each DSP
         tick.  */
-    x->x_fifosize = x->x_bufsize - (x->x_bufsize %
-        (x->x_sf.sf_bytesperframe * MAXVECSIZE));
-        /* arrange for the "request" condition to be signaled 16
-            times per buffer */
-    x->x_sigcountdown = x->x_sigperiod = (x->x_fifosize /
-            (16 * (x->x_sf.sf_bytesperframe * x->x_vecsize)));
-    sfread_cond_signal(&x->x_requestcondition);
+    SFIO_STORE(&x->x_fifosize, x->x_bufsize - (x->x_bufsize %
+        (x->x_sf.sf_bytesperframe * MAXVECSIZE)));
+    SFIO_STORE(&x->x_fifotail, 0);
+    SFIO_STORE(&x->x_fifohead, 0);
+    SFIO_STORE(&x->x_eof, 0);
+    x->x_fileerror = 0;
+    x->x_state = STATE_STARTUP;
+    SFIO_STORE(&x->x_requestcode, REQUEST_OPEN);
     pthread_mutex_unlock(&x->x_mutex);
+    sfio_post();
 }
 
 static void writesf_dsp(t_writesf *x, t_signal **sp)
 {
     int i, ninlets = x->x_sf.sf_nchannels;
-    pthread_mutex_lock(&x->x_mutex);
     x->x_vecsize = sp[0]->s_n;
-    x->x_sigperiod = (x->x_fifosize /
-            (16 * x->x_sf.sf_bytesperframe * x->x_vecsize));
     for (i = 0; i < ninlets; i++)
         x->x_outvec[i] = sp[i]->s_vec;
     x->x_insamplerate = sp[0]->s_sr;
-    pthread_mutex_unlock(&x->x_mutex);
     dsp_add(writesf_perform, 1, x);
 }
 
 static void writesf_print(t_writesf *x)
 {
     post("state %d", x->x_state);
-    post("fifo head %d", x->x_fifohead);
-    post("fifo tail %d", x->x_fifotail);
-    post("fifo size %d", x->x_fifosize);
+    post("fifo head %d", SFIO_LOAD(&x->x_fifohead));
+    post("fifo tail %d", SFIO_LOAD(&x->x_fifotail));
+    post("fifo size %d", SFIO_LOAD(&x->x_fifosize));
     post("fd %d", x->x_sf.sf_fd);
-    post("eof %d", x->x_eof);
+    post("eof %d", SFIO_LOAD(&x->x_eof));
+    post("overruns %d", x->x_underruns);
 }
 
     /** request QUIT and wait for acknowledge */
 static void writesf_free(t_writesf *x)
 {
-    void *threadrtn;
     pthread_mutex_lock(&x->x_mutex);
-    x->x_requestcode = REQUEST_QUIT;
+        /* let a pending close write out the rest of the FIFO first */
+    while (x->x_requestcode == REQUEST_CLOSE)
+    {
+        sfio_post();
+        sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
+    }
+    SFIO_STORE(&x->x_requestcode, REQUEST_QUIT);
 #ifdef DEBUG_SOUNDFILE_THREADS
     fprintf(stderr, "writesf~: stopping thread...\n");
 #endif
-    sfread_cond_signal(&x->x_requestcondition);
     while (x->x_requestcode != REQUEST_NOTHING)
     {
-#ifdef DEBUG_SOUNDFILE_THREADS
-        fprintf(stderr, "writesf~: signaling...\n");
-#endif
-        sfread_cond_signal(&x->x_requestcondition);
+        sfio_post();
         sfread_cond_wait(&x->x_answercondition, &x->x_mutex);
     }
     pthread_mutex_unlock(&x->x_mutex);
-    if (pthread_join(x->x_childthread, &threadrtn))
-        pd_error(x, "writesf_free: join failed");
+    sfio_removestream(x);
 #ifdef DEBUG_SOUNDFILE_THREADS
     fprintf(stderr, "writesf~: ... done\n");
 #endif
 
-    pthread_cond_destroy(&x->x_requestcondition);
     pthread_cond_destroy(&x->x_answercondition);
     pthread_mutex_destroy(&x->x_mutex);
     freebytes(x->x_buf, x->x_bufsize);
@@ -2738,10 +3723,168 @@ static void writesf_setup(void)
         gensym("dsp"), A_CANT, 0);
     class_addmethod(writesf_class, (t_method)writesf_open,
         gensym("open"), A_GIMME, 0);
+    class_addmethod(writesf_class, (t_method)readsf_wait,
+        gensym("wait"), A_FLOAT, 0);
     class_addmethod(writesf_class, (t_method)writesf_print, gensym("print"), 0);
     CLASS_MAINSIGNALIN(writesf_class, t_writesf, x_f);
 }
 
+/******************** sfread4~ ***********************/
+
+    /* 4-point interpolating reader, like tabread4~, straight from a
+    memory-mapped soundfile.  Only the pages around the read position are
+    loaded, by the map's pager thread; samples whose pages aren't in yet
+    come out as zeros, counted as an underrun, rather than stalling DSP. */
+
+static t_class *sfread4_tilde_class;
+
+typedef struct _sfread4_tilde
+{
+    t_object x_obj;
+    t_float x_f;
+    t_float x_onset;
+    int x_noutlets;
+    t_outlet *x_nframesout;
+    t_canvas *x_canvas;
+    t_soundmap *x_map;
+    t_sample **x_outvec;
+} t_sfread4_tilde;
+
+static t_int *sfread4_tilde_perform(t_int *w)
+{
+    t_sfread4_tilde *x = (t_sfread4_tilde *)(w[1]);
+    t_sample *in = (t_sample *)(w[2]);
+    int n = (int)(w[3]), noutlets = x->x_noutlets, nchannels, i, ch;
+    int underrun = 0;
+    double onset = x->x_onset;
+    t_soundmap *m = x->x_map;
+    long maxindex;
+    const t_sample one_over_six = 1./6.;
+
+    if (!m || (maxindex = (long)m->sm_nframes - 3) < 1)
+        goto zero;
+    nchannels = (m->sm_sf.sf_nchannels < noutlets ?
+        m->sm_sf.sf_nchannels : noutlets);
+
+        /* keep the pager ahead of us */
+    if (in[0] + onset >= 0)
+        soundmap_request(m, (size_t)(in[0] + onset));
+
+        /* the input may share memory with the first output, so read
+        each input before writing any output for it */
+    for (i = 0; i < n; i++)
+    {
+        double findex = *in++ + onset;
+        long index = findex;
+        t_sample frac;
+        if (index < 1)
+            index = 1, frac = 0;
+        else if (index > maxindex)
+            index = maxindex, frac = 1;
+        else frac = findex - index;
+        if (!soundmap_ready(m, index-1, 4))
+        {
+            underrun = 1;
+            for (ch = 0; ch < noutlets; ch++)
+                x->x_outvec[ch][i] = 0;
+            continue;
+        }
+        for (ch = 0; ch < nchannels; ch++)
+        {
+            t_sample v[4], a, b, c, d, cminusb;
+            soundmap_getsamples(m, index-1, ch, 4, v);
+            a = v[0], b = v[1], c = v[2], d = v[3], cminusb = c-b;
+            x->x_outvec[ch][i] = b + frac * (
+                cminusb - one_over_six * ((t_sample)1.-frac) * (
+                    (d - a - (t_sample)3.0 * cminusb) * frac +
+                    (d + a*(t_sample)2.0 - b*(t_sample)3.0)
+                )
+            );
+        }
+        for (; ch < noutlets; ch++)
+            x->x_outvec[ch][i] = 0;
+    }
+    if (underrun)
+        SFIO_ADD(&sfio_underruns, 1);
+    return (w+4);
+zero:
+    for (ch = 0; ch < noutlets; ch++)
+        for (i = 0; i < n; i++)
+            x->x_outvec[ch][i] = 0;
+    return (w+4);
+}
+
+static void sfread4_tilde_close(t_sfread4_tilde *x)
+{
+    if (x->x_map)
+        soundmap_close(x->x_map);
+    x->x_map = 0;
+}
+
+static void sfread4_tilde_open(t_sfread4_tilde *x, t_symbol *s)
+{
+    t_soundmap *m;
+    sfread4_tilde_close(x);
+    if (!*s->s_name)
+        return;
+    if (!(m = soundmap_open(x->x_canvas, s->s_name)))
+    {
+        object_sferror(x, "sfread4~ open", s->s_name, errno, 0);
+        return;
+    }
+    x->x_map = m;
+    outlet_float(x->x_nframesout, (t_float)m->sm_nframes);
+}
+
+static void sfread4_tilde_dsp(t_sfread4_tilde *x, t_signal **sp)
+{
+    int i;
+    for (i = 0; i < x->x_noutlets; i++)
+        x->x_outvec[i] = sp[i+1]->s_vec;
+    dsp_add(sfread4_tilde_perform, 3, x, sp[0]->s_vec, (t_int)sp[0]->s_n);
+}
+
+static void *sfread4_tilde_new(t_floatarg fnchannels)
+{
+    t_sfread4_tilde *x = (t_sfread4_tilde *)pd_new(sfread4_tilde_class);
+    int nchannels = fnchannels, i;
+    if (nchannels < 1)
+        nchannels = 1;
+    else if (nchannels > MAXSFCHANS)
+        nchannels = MAXSFCHANS;
+    floatinlet_new(&x->x_obj, &x->x_onset);
+    for (i = 0; i < nchannels; i++)
+        outlet_new(&x->x_obj, &s_signal);
+    x->x_nframesout = outlet_new(&x->x_obj, &s_float);
+    x->x_noutlets = nchannels;
+    x->x_outvec = (t_sample **)getbytes(nchannels * sizeof(t_sample *));
+    x->x_canvas = canvas_getcurrent();
+    x->x_map = 0;
+    x->x_onset = 0;
+    x->x_f = 0;
+    return (x);
+}
+
+static void sfread4_tilde_free(t_sfread4_tilde *x)
+{
+    sfread4_tilde_close(x);
+    freebytes(x->x_outvec, x->x_noutlets * sizeof(t_sample *));
+}
+
+static void sfread4_tilde_setup(void)
+{
+    sfread4_tilde_class = class_new(gensym("sfread4~"),
+        (t_newmethod)sfread4_tilde_new, (t_method)sfread4_tilde_free,
+        sizeof(t_sfread4_tilde), 0, A_DEFFLOAT, 0);
+    CLASS_MAINSIGNALIN(sfread4_tilde_class, t_sfread4_tilde, x_f);
+    class_addmethod(sfread4_tilde_class, (t_method)sfread4_tilde_dsp,
+        gensym("dsp"), A_CANT, 0);
+    class_addmethod(sfread4_tilde_class, (t_method)sfread4_tilde_open,
+        gensym("open"), A_SYMBOL, 0);
+    class_addmethod(sfread4_tilde_class, (t_method)sfread4_tilde_close,
+        gensym("close"), 0);
+}
+
 /* ------------------------- global setup routine ------------------------ */
 
 void d_soundfile_setup(void)
@@ -2750,4 +3893,5 @@ void d_soundfile_setup(void)
     soundfiler_setup();
     readsf_setup();
     writesf_setup();
+    sfread4_tilde_setup();
 }
@@ -65,6 +65,7 @@ typedef struct _soundfile
     int sf_bigendian;      /**< sample endianness, 1 : big or 0 : little  */
     int sf_bytesperframe;  /**< number of bytes per sample frame          */
     ssize_t sf_bytelimit;  /**< number of sound data bytes to read/write  */
+    void *sf_data;         /**< decoder state for compressed types or NULL */
 } t_soundfile;
 
     /** clear soundfile struct to defaults, does not close or free */
@@ -76,6 +77,14 @@ void soundfile_copy(t_soundfile *dst, const t_soundfile *src);
     /** returns 1 if bytes need to be swapped due to endianness, otherwise 0 */
 int soundfile_needsbyteswap(const t_soundfile *sf);
 
+    /** read size bytes of sample data from the current position, decoding
+        compressed types, returns bytes read or -1 on error
+        this may be called in a background thread */
+ssize_t soundfile_readsamples(t_soundfile *sf, void *buf, size_t size);
+
+    /** close the file and free any decoder state */
+void soundfile_close(t_soundfile *sf);
+
     /** generic soundfile errors */
 typedef enum _soundfile_errno
 {
@@ -124,6 +133,23 @@ typedef int (*t_soundfile_addextensionfn)(char *filename, size_t size);
         returns 1 for big endian, 0 for little endian */
 typedef int (*t_soundfile_endiannessfn)(int endianness);
 
+    /** compressed types only: decode up to size bytes of sample data in the
+        format given by the header info (normally whole frames), returns
+        bytes decoded, 0 at the end of the file or -1 on error
+        this may be called in a background thread */
+typedef ssize_t (*t_soundfile_readsamplesfn)(t_soundfile *sf, void *buf,
+    size_t size);
+
+    /** compressed types only: position the decoder at a sample frame,
+        returns 1 on success or 0 on error
+        this may be called in a background thread */
+typedef int (*t_soundfile_seekfn)(t_soundfile *sf, size_t frame);
+
+    /** compressed types only: free the decoder state in sf_data,
+        the file itself is closed by the caller
+        this may be called in a background thread */
+typedef void (*t_soundfile_closefn)(t_soundfile *sf);
+
     /* type implementation for a single file format */
 typedef struct _soundfile_type
 {
@@ -136,6 +162,12 @@ typedef struct _soundfile_type
     t_soundfile_hasextensionfn t_hasextensionfn; /**< must be non-NULL      */
     t_soundfile_addextensionfn t_addextensionfn; /**< must be non-NULL      */
     t_soundfile_endiannessfn t_endiannessfn;     /**< must be non-NULL      */
+        /* the following are for compressed types, which set sf_data when
+        reading the header; uncompressed types leave them NULL and the
+        sample data is read straight from the file */
+    t_soundfile_readsamplesfn t_readsamplesfn;
+    t_soundfile_seekfn t_seekfn;
+    t_soundfile_closefn t_closefn;
 } t_soundfile_type;
 
     /** add a new type implementation
@@ -178,3 +210,119 @@ void swapstring4(char *foo, int doit);
 
     /** swap an 8 byte string in place if doit = 1, otherwise do nothing */
 void swapstring8(char *foo, int doit);
+
+/* ----- readsf~ & writesf~ streams ----- */
+
+    /** make all readsf~ and writesf~ objects wait for the disk when their
+        buffers run dry instead of dropping blocks, as when rendering
+        faster than realtime; this can stall the audio thread.  writesf~
+        waits anyway unless it was sent "wait 0" */
+void soundfile_setstreamwait(int wait);
+
+    /** total blocks dropped by readsf~ and writesf~ objects because their
+        buffers ran dry (or full), optionally resetting the count to 0 */
+int soundfile_getunderruns(int reset);
+
+/* ----- asynchronous batch reading ----- */
+
+struct _soundfiler;
+
+    /** read soundfiles into arrays on background threads, argv holds groups
+        of a filename followed by nchannels array names; progress and
+        completion are sent to receiver from the scheduler as
+        "progress <ndone> <nfiles>" and "done <nread> <nfailed>"
+        the batch is cancelled when the soundfiler is freed; if it is NULL
+        the batch belongs to the Pd instance and ends with it
+        returns 1 if the batch was started or 0 if the arguments are bad */
+int soundfiler_readbatch(struct _soundfiler *x, t_symbol *receiver,
+    int nchannels, int argc, t_atom *argv);
+
+
+/* ----- memory-mapped soundfiles ----- */
+
+    /** an uncompressed soundfile whose contents are mapped read-only into
+        memory so sample frames can be read at random without loading them;
+        a thread pages the file in ahead of the reader */
+typedef struct _soundmap
+{
+    t_soundfile sm_sf;            /**< format info, sf_fd is closed (-1)  */
+    size_t sm_nframes;            /**< number of sample frames            */
+    const unsigned char *sm_data; /**< first sample frame                 */
+    void *sm_base;                /**< start of the mapping               */
+    size_t sm_mapsize;            /**< size of the mapping in bytes       */
+    struct _soundpager *sm_pager; /**< paging thread state, may be NULL   */
+#ifdef _WIN32
+    void *sm_handle;              /**< file mapping object handle         */
+#endif
+} t_soundmap;
+
+    /** open a soundfile via the canvas search paths (canvas may be NULL)
+        and map it into memory, returns NULL on error and sets errno */
+t_soundmap *soundmap_open(const t_canvas *canvas, const char *filename);
+
+    /** stop paging, unmap and free a mapped soundfile */
+void soundmap_close(t_soundmap *m);
+
+    /** tell the pager that reading continues at frame, safe in the audio
+        thread */
+void soundmap_request(t_soundmap *m, size_t frame);
+
+    /** returns 1 if nframes from onset are paged in and can be read without
+        blocking, safe in the audio thread */
+int soundmap_ready(const t_soundmap *m, size_t onset, size_t nframes);
+
+    /** convert n consecutive frames of one channel starting at frame,
+        performs no bounds or paging checks */
+void soundmap_getsamples(const t_soundmap *m, size_t frame, int channel,
+    int n, t_sample *dest);
+
+    /** convert up to nframes from onset into interleaved samples and ask the
+        pager to continue from there, safe in the audio thread: only frames
+        which are paged in are read, the rest of dest is zeroed
+        returns number of frames read */
+size_t soundmap_read(t_soundmap *m, size_t onset, size_t nframes,
+    t_sample *dest);
+
+    /** page in nframes from onset on the calling thread, waiting for the
+        disk, so not for the audio thread */
+void soundmap_prefetch(t_soundmap *m, size_t onset, size_t nframes);
+
+/* ----- sequential soundfile streams ----- */
+
+    /** a soundfile read or written one run of interleaved sample frames at a
+        time from outside the DSP graph, as when rendering offline */
+typedef struct _soundstream
+{
+    t_soundfile ss_sf;      /**< format info and open file                */
+    size_t ss_nframes;      /**< frames in the file (read) or written     */
+    size_t ss_pos;          /**< frames read so far                       */
+    int ss_write;           /**< 1 if open for writing                    */
+} t_soundstream;
+
+    /** open a soundfile of any readable type via the canvas search paths
+        (canvas may be NULL), returns NULL on error and sets errno */
+t_soundstream *soundstream_open(const t_canvas *canvas, const char *filename);
+
+    /** create a soundfile for writing, relative to the canvas directory (or
+        the current directory if canvas is NULL); the type follows the file
+        extension, wave by default, and bytespersample is 2, 3, or 4 (float)
+        returns NULL on error and sets errno */
+t_soundstream *soundstream_create(const t_canvas *canvas, const char *filename,
+    int nchannels, int samplerate, int bytespersample);
+
+    /** read the next nframes into interleaved frames spaced stride samples
+        apart, so that several files can share one buffer; only the first
+        nchannels (or stride) samples of each frame are touched and those
+        past the end of the file are zeroed
+        returns number of frames read from the file */
+size_t soundstream_read(t_soundstream *s, t_sample *frames, size_t nframes,
+    int stride);
+
+    /** append nframes interleaved frames, clipping integer formats
+        returns number of frames written or -1 on error and sets errno */
+ssize_t soundstream_write(t_soundstream *s, const t_sample *frames,
+    size_t nframes);
+
+    /** close and free, updating the header of a written file
+        returns 0 on success or -1 if the header update failed */
+int soundstream_close(t_soundstream *s);
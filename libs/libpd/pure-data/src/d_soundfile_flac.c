@@ -0,0 +1,866 @@
+/* Copyright (c) 1997- Miller Puckette and others.
+* For information on usage and redistribution, and for a DISCLAIMER OF ALL
+* WARRANTIES, see the file, "LICENSE.txt," in this distribution.  */
+
+/* refs: https://xiph.org/flac/format.html
+         https://www.rfc-editor.org/rfc/rfc9639 */
+
+#include "d_soundfile.h"
+#include <stdlib.h>
+
+/* FLAC (Free Lossless Audio Codec)
+
+  * "fLaC" id followed by metadata blocks, then audio frames
+  * the first metadata block is always STREAMINFO: block sizes, sample rate,
+    channels, bits per sample, and total number of sample frames
+  * an optional SEEKTABLE block lists the byte offsets of some frames
+  * each frame has a header with a sync code and CRC-8, one subframe per
+    channel, and a CRC-16 footer
+  * subframes are constant, verbatim, or a fixed or LPC predictor plus a
+    Rice coded residual; stereo can be coded as left/side, side/right, or
+    mid/side
+  * all numbers are big endian and bit packed
+
+  this implementation:
+
+    * reads only, there is no encoder
+    * decodes on whichever thread reads the samples, ie. readsf~'s I/O
+      thread or soundfiler's caller
+    * delivers little endian 16 bit lpcm for sources of up to 16 bits and
+      24 bit lpcm for 17 to 24 bits; smaller sizes are shifted up
+    * requires the total number of frames in STREAMINFO
+    * seeks using the SEEKTABLE if there is one, then decodes up to the
+      requested frame
+    * checks the frame header CRC-8 when syncing but not the CRC-16 or MD5
+    * skips frames that fail to decode
+    * does not support ID3 tags before the "fLaC" id, 32 bit samples, or
+      blocking strategies with varying bit depth or channel count
+
+*/
+
+#define FLACHEADSIZE 42        /**< id + metadata block header + STREAMINFO */
+#define FLACMAXCHANNELS 8
+#define FLACBUFSIZE 65536      /**< file read buffer size */
+
+#define FLAC_STREAMINFO 0
+#define FLAC_SEEKTABLE  3
+
+#define FLAC_CHANNELS_LEFTSIDE  8
+#define FLAC_CHANNELS_SIDERIGHT 9
+#define FLAC_CHANNELS_MIDSIDE   10
+
+#define FLAC_PLACEHOLDER 0xffffffffffffffffULL /**< unused seek point */
+
+typedef struct _flacseekpoint
+{
+    uint64_t sp_frame;  /**< first sample frame of the target audio frame */
+    uint64_t sp_offset; /**< its byte offset from the first audio frame   */
+} t_flacseekpoint;
+
+    /** decoder state, kept in sf_data */
+typedef struct _flac
+{
+    int f_fd;
+    /* bit reader */
+    unsigned char *f_buf;     /**< file read buffer                          */
+    size_t f_bufpos;          /**< next byte in buffer                       */
+    size_t f_buflen;          /**< bytes in buffer                           */
+    uint64_t f_cache;         /**< bits read ahead, right aligned            */
+    int f_nbits;              /**< number of valid bits in cache             */
+    int f_error;              /**< ran out of data or read failed            */
+    int f_ioerror;            /**< errno of a failed read or 0               */
+    /* stream info */
+    int f_samplerate;
+    int f_maxblocksize;
+    int f_nchannels;
+    int f_bitspersample;
+    int f_shift;              /**< left shift up to 16 or 24 bits            */
+    int f_bytespersample;
+    uint64_t f_nframes;       /**< total sample frames                       */
+    off_t f_firstframe;       /**< byte offset of the first audio frame      */
+    t_flacseekpoint *f_seekpoints;
+    int f_nseekpoints;
+    /* decoding */
+    int32_t *f_samples[FLACMAXCHANNELS]; /**< one block per channel          */
+    unsigned char *f_pcm;     /**< last block as interleaved lpcm            */
+    size_t f_pcmpos;          /**< next byte to deliver                      */
+    size_t f_pcmlen;          /**< bytes in the last block                   */
+    uint64_t f_position;      /**< sample frame after the last block         */
+} t_flac;
+
+/* ----- bit reader ----- */
+
+#if defined(__GNUC__) || defined(__clang__)
+#define flac_clz64(x) __builtin_clzll(x)
+#else
+static int flac_clz64(uint64_t x)
+{
+    int n = 0;
+    while (!(x & 0x8000000000000000ULL))
+        x <<= 1, n++;
+    return n;
+}
+#endif
+
+    /** start reading at the current file position */
+static void flac_reset(t_flac *f)
+{
+    f->f_bufpos = f->f_buflen = 0;
+    f->f_cache = 0;
+    f->f_nbits = f->f_error = 0;
+}
+
+    /** read ahead whole bytes until the cache holds at least 56 bits, or
+        less at the end of the file */
+static void flac_fill(t_flac *f)
+{
+    while (f->f_nbits <= 48)
+    {
+        if (f->f_bufpos == f->f_buflen)
+        {
+            ssize_t n = read(f->f_fd, f->f_buf, FLACBUFSIZE);
+            if (n <= 0)
+            {
+                if (n < 0)
+                    f->f_ioerror = errno;
+                return;
+            }
+            f->f_buflen = n;
+            f->f_bufpos = 0;
+        }
+        f->f_cache = (f->f_cache << 8) | f->f_buf[f->f_bufpos++];
+        f->f_nbits += 8;
+    }
+}
+
+    /** returns the next n bits, n <= 32 */
+static uint32_t flac_getbits(t_flac *f, int n)
+{
+    if (f->f_nbits < n)
+    {
+        flac_fill(f);
+        if (f->f_nbits < n)
+        {
+            f->f_error = 1;
+            f->f_nbits = 0;
+            return 0;
+        }
+    }
+    f->f_nbits -= n;
+    return (uint32_t)((f->f_cache >> f->f_nbits) &
+        ((((uint64_t)1) << n) - 1));
+}
+
+    /** returns the next n bits as a two's complement number, n <= 32 */
+static int32_t flac_getsigned(t_flac *f, int n)
+{
+    uint32_t x;
+    if (!n)
+        return 0;
+    x = flac_getbits(f, n);
+    if (n < 32 && (x & ((uint32_t)1 << (n - 1))))
+        x |= ~(uint32_t)0 << n;
+    return (int32_t)x;
+}
+
+    /** returns the number of 0 bits before the next 1 bit */
+static uint32_t flac_getunary(t_flac *f)
+{
+    uint32_t n = 0;
+    while (1)
+    {
+        uint64_t bits;
+        int zeros;
+        if (!f->f_nbits)
+        {
+            flac_fill(f);
+            if (!f->f_nbits)
+            {
+                f->f_error = 1;
+                return 0;
+            }
+        }
+        bits = f->f_cache & ((((uint64_t)1) << f->f_nbits) - 1);
+        if (!bits)
+        {
+            n += f->f_nbits;
+            f->f_nbits = 0;
+            continue;
+        }
+        zeros = flac_clz64(bits) - (64 - f->f_nbits);
+        f->f_nbits -= zeros + 1;
+        return (n + zeros);
+    }
+}
+
+    /** skip to the next byte boundary; the cache only ever gets whole
+        bytes, so the bit position within a byte is nbits mod 8 */
+static void flac_align(t_flac *f)
+{
+    f->f_nbits &= ~7;
+}
+
+    /** skip n bytes at a byte boundary, seeking over what isn't buffered */
+static int flac_skip(t_flac *f, size_t n)
+{
+    size_t m = f->f_nbits / 8;
+    if (m > n)
+        m = n;
+    f->f_nbits -= m * 8;
+    n -= m;
+    m = f->f_buflen - f->f_bufpos;
+    if (m > n)
+        m = n;
+    f->f_bufpos += m;
+    n -= m;
+    if (n && lseek(f->f_fd, n, SEEK_CUR) < 0)
+        return 0;
+    return 1;
+}
+
+/* ----- frames ----- */
+
+    /** CRC-8 with polynomial x^8 + x^2 + x + 1 */
+static unsigned char flac_crc8(unsigned char crc, unsigned char byte)
+{
+    int i;
+    crc ^= byte;
+    for (i = 0; i < 8; i++)
+        crc = (crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1);
+    return crc;
+}
+
+    /** read a header byte and add it to the CRC */
+static unsigned int flac_getheaderbyte(t_flac *f, unsigned char *crc)
+{
+    unsigned int byte = flac_getbits(f, 8);
+    *crc = flac_crc8(*crc, byte);
+    return byte;
+}
+
+    /** parse a frame header following a sync code ending in byte1, returns
+        the block size and sets the channel assignment, or returns 0 if the
+        header is invalid or for a different stream */
+static int flac_readframeheader(t_flac *f, unsigned int byte1, int *chanassign)
+{
+    unsigned char crc = flac_crc8(flac_crc8(0, 0xff), byte1);
+    unsigned int byte, blockcode, ratecode, sizecode, i, n;
+    int blocksize, nchannels, bits;
+
+    byte = flac_getheaderbyte(f, &crc);
+    blockcode = byte >> 4;
+    ratecode = byte & 0xf;
+    byte = flac_getheaderbyte(f, &crc);
+    *chanassign = byte >> 4;
+    sizecode = (byte >> 1) & 0x7;
+    if (!blockcode || ratecode == 0xf || *chanassign > FLAC_CHANNELS_MIDSIDE ||
+        sizecode == 3 || (byte & 1))
+            return 0;
+
+        /* coded frame or sample number, UTF-8 style: skipped, as we count
+        sample frames ourselves */
+    byte = flac_getheaderbyte(f, &crc);
+    for (n = 0; n < 8 && (byte & (0x80 >> n)); n++)
+        ;
+    if (n == 1 || n == 8)
+        return 0;
+    for (i = 1; i < n; i++)
+        if ((flac_getheaderbyte(f, &crc) & 0xc0) != 0x80)
+            return 0;
+
+    if (blockcode == 1)
+        blocksize = 192;
+    else if (blockcode <= 5)
+        blocksize = 576 << (blockcode - 2);
+    else if (blockcode == 6)
+        blocksize = flac_getheaderbyte(f, &crc) + 1;
+    else if (blockcode == 7)
+    {
+        blocksize = flac_getheaderbyte(f, &crc) << 8;
+        blocksize = (blocksize | flac_getheaderbyte(f, &crc)) + 1;
+    }
+    else blocksize = 256 << (blockcode - 8);
+
+        /* the sample rate is only for information, so just skip it */
+    if (ratecode == 12)
+        flac_getheaderbyte(f, &crc);
+    else if (ratecode == 13 || ratecode == 14)
+    {
+        flac_getheaderbyte(f, &crc);
+        flac_getheaderbyte(f, &crc);
+    }
+    if (flac_getbits(f, 8) != crc || f->f_error)
+        return 0;
+
+        /* must match STREAMINFO */
+    nchannels = (*chanassign < FLAC_CHANNELS_LEFTSIDE ? *chanassign + 1 : 2);
+    switch (sizecode)
+    {
+        case 0: bits = f->f_bitspersample; break;
+        case 1: bits = 8; break;
+        case 2: bits = 12; break;
+        case 4: bits = 16; break;
+        case 5: bits = 20; break;
+        case 6: bits = 24; break;
+        default: bits = 32; break;
+    }
+    if (nchannels != f->f_nchannels || bits != f->f_bitspersample ||
+        blocksize > f->f_maxblocksize)
+            return 0;
+    return blocksize;
+}
+
+    /** read n Rice coded numbers with parameter k: a unary quotient and k
+        low bits, then "zigzag" folded back to signed.  This is where most
+        of the time goes, so the cache is kept in local variables. */
+static int flac_readrice(t_flac *f, int32_t *out, int n, int k)
+{
+    uint64_t cache = f->f_cache;
+    int nbits = f->f_nbits, i;
+    for (i = 0; i < n; i++)
+    {
+        uint32_t q = 0, x;
+        while (1)
+        {
+            uint64_t bits;
+            if (nbits < 32)
+            {
+                f->f_nbits = nbits;
+                flac_fill(f);
+                cache = f->f_cache;
+                if (!(nbits = f->f_nbits))
+                    return 0;
+            }
+                /* shift out what's been read, leaving zeros below */
+            if ((bits = cache << (64 - nbits)))
+            {
+                int zeros = flac_clz64(bits);
+                q += zeros;
+                nbits -= zeros + 1;
+                break;
+            }
+            q += nbits;
+            nbits = 0;
+        }
+        if (nbits < k)
+        {
+            f->f_nbits = nbits;
+            flac_fill(f);
+            cache = f->f_cache;
+            if ((nbits = f->f_nbits) < k)
+                return 0;
+        }
+        nbits -= k;
+        x = (q << k) |
+            (uint32_t)((cache >> nbits) & ((((uint64_t)1) << k) - 1));
+        out[i] = (int32_t)(x >> 1) ^ -(int32_t)(x & 1);
+    }
+    f->f_nbits = nbits;
+    return 1;
+}
+
+    /** read the residual of a predicted subframe after the warm up samples,
+        returns 1 on success */
+static int flac_readresidual(t_flac *f, int32_t *out, int blocksize,
+    int order)
+{
+    unsigned int method = flac_getbits(f, 2), partorder, paramsize, escape,
+        k, part, nparts;
+    int i = order, partsize;
+    if (method > 1)
+        return 0;
+    paramsize = (method ? 5 : 4);
+    escape = (method ? 31 : 15);
+    partorder = flac_getbits(f, 4);
+    nparts = 1 << partorder;
+    partsize = blocksize >> partorder;
+    if ((partsize << partorder) != blocksize || partsize < order)
+        return 0;
+    for (part = 0; part < nparts; part++)
+    {
+        int end = i + (part ? partsize : partsize - order);
+        if ((k = flac_getbits(f, paramsize)) == escape)
+        {
+            int nbits = flac_getbits(f, 5);
+            for (; i < end; i++)
+                out[i] = flac_getsigned(f, nbits);
+        }
+        else
+        {
+            if (!flac_readrice(f, out + i, end - i, k))
+                return 0;
+            i = end;
+        }
+        if (f->f_error)
+            return 0;
+    }
+    return 1;
+}
+
+    /** decode one channel of a frame, returns 1 on success */
+static int flac_readsubframe(t_flac *f, int32_t *out, int blocksize,
+    int bits)
+{
+    unsigned int type;
+    int wasted = 0, order, i, j;
+    if (flac_getbits(f, 1))
+        return 0;
+    type = flac_getbits(f, 6);
+    if (flac_getbits(f, 1))
+    {
+        wasted = flac_getunary(f) + 1;
+        if ((bits -= wasted) <= 0)
+            return 0;
+    }
+    if (type == 0)  /* constant */
+    {
+        int32_t x = flac_getsigned(f, bits);
+        for (i = 0; i < blocksize; i++)
+            out[i] = x;
+    }
+    else if (type == 1) /* verbatim */
+    {
+        for (i = 0; i < blocksize; i++)
+            out[i] = flac_getsigned(f, bits);
+    }
+    else if ((type & 0x38) == 0x08) /* fixed predictor */
+    {
+        if ((order = type & 0x7) > 4 || order > blocksize)
+            return 0;
+        for (i = 0; i < order; i++)
+            out[i] = flac_getsigned(f, bits);
+        if (!flac_readresidual(f, out, blocksize, order))
+            return 0;
+        switch (order)
+        {
+        case 1:
+            for (i = 1; i < blocksize; i++)
+                out[i] += out[i-1];
+            break;
+        case 2:
+            for (i = 2; i < blocksize; i++)
+                out[i] += 2 * out[i-1] - out[i-2];
+            break;
+        case 3:
+            for (i = 3; i < blocksize; i++)
+                out[i] += 3 * (out[i-1] - out[i-2]) + out[i-3];
+            break;
+        case 4:
+            for (i = 4; i < blocksize; i++)
+                out[i] += 4 * (out[i-1] + out[i-3]) - 6 * out[i-2] - out[i-4];
+            break;
+        }
+    }
+    else if (type & 0x20) /* linear predictor */
+    {
+        int32_t coefs[32];
+        int precision, shift;
+        if ((order = (type & 0x1f) + 1) > blocksize)
+            return 0;
+        for (i = 0; i < order; i++)
+            out[i] = flac_getsigned(f, bits);
+        if ((precision = flac_getbits(f, 4) + 1) == 16 ||
+            (shift = flac_getsigned(f, 5)) < 0)
+                return 0;
+        for (i = 0; i < order; i++)
+            coefs[i] = flac_getsigned(f, precision);
+        if (!flac_readresidual(f, out, blocksize, order))
+            return 0;
+            /* the sum fits in 32 bits for most streams, eg. 16 bit audio
+            with 12 bit coefficients up to order 15 */
+        if (bits + precision + ilog2(order) <= 32)
+        {
+            for (i = order; i < blocksize; i++)
+            {
+                int32_t sum = 0;
+                for (j = 0; j < order; j++)
+                    sum += coefs[j] * out[i-1-j];
+                out[i] += sum >> shift;
+            }
+        }
+        else for (i = order; i < blocksize; i++)
+        {
+            int64_t sum = 0;
+            for (j = 0; j < order; j++)
+                sum += (int64_t)coefs[j] * out[i-1-j];
+            out[i] += (int32_t)(sum >> shift);
+        }
+    }
+    else return 0;
+    if (wasted)
+        for (i = 0; i < blocksize; i++)
+            out[i] = (int32_t)((uint32_t)out[i] << wasted);
+    return (!f->f_error);
+}
+
+    /** decode the next frame into f_pcm, skipping any that are damaged,
+        returns the number of sample frames or 0 at the end of the file */
+static int flac_readframe(t_flac *f)
+{
+    int blocksize = 0, chanassign, ch, i;
+    unsigned int byte, prev = 0;
+    unsigned char *sp;
+
+    while (!blocksize)
+    {
+            /* find a sync code: 14 1 bits, a 0 bit, and a 0 reserved bit */
+        flac_align(f);
+        f->f_error = 0;
+        byte = flac_getbits(f, 8);
+        if (f->f_error)
+            return 0;
+        if (prev != 0xff || (byte & 0xfe) != 0xf8)
+        {
+            prev = byte;
+            continue;
+        }
+        prev = 0;
+        if (!(blocksize = flac_readframeheader(f, byte, &chanassign)))
+            continue;
+        for (ch = 0; ch < f->f_nchannels; ch++)
+        {
+                /* the side channel has an extra bit */
+            int bits = f->f_bitspersample +
+                ((chanassign == FLAC_CHANNELS_LEFTSIDE && ch == 1) ||
+                 (chanassign == FLAC_CHANNELS_SIDERIGHT && ch == 0) ||
+                 (chanassign == FLAC_CHANNELS_MIDSIDE && ch == 1));
+            if (!flac_readsubframe(f, f->f_samples[ch], blocksize, bits))
+            {
+                blocksize = 0;
+                break;
+            }
+        }
+    }
+    flac_align(f);
+    flac_getbits(f, 16); /* CRC-16 */
+
+    if (chanassign >= FLAC_CHANNELS_LEFTSIDE)
+    {
+        int32_t *left = f->f_samples[0], *right = f->f_samples[1];
+        if (chanassign == FLAC_CHANNELS_LEFTSIDE)
+            for (i = 0; i < blocksize; i++)
+                right[i] = left[i] - right[i];
+        else if (chanassign == FLAC_CHANNELS_SIDERIGHT)
+            for (i = 0; i < blocksize; i++)
+                left[i] += right[i];
+        else for (i = 0; i < blocksize; i++)
+        {
+            int32_t side = right[i],
+                mid = (int32_t)((uint32_t)left[i] << 1) | (side & 1);
+            left[i] = (mid + side) >> 1;
+            right[i] = (mid - side) >> 1;
+        }
+    }
+
+        /* interleave as little endian lpcm */
+    sp = f->f_pcm;
+    if (f->f_bytespersample == 2)
+    {
+        for (i = 0; i < blocksize; i++)
+            for (ch = 0; ch < f->f_nchannels; ch++, sp += 2)
+            {
+                uint32_t x = (uint32_t)f->f_samples[ch][i] << f->f_shift;
+                sp[0] = x;
+                sp[1] = x >> 8;
+            }
+    }
+    else
+    {
+        for (i = 0; i < blocksize; i++)
+            for (ch = 0; ch < f->f_nchannels; ch++, sp += 3)
+            {
+                uint32_t x = (uint32_t)f->f_samples[ch][i] << f->f_shift;
+                sp[0] = x;
+                sp[1] = x >> 8;
+                sp[2] = x >> 16;
+            }
+    }
+    f->f_pcmpos = 0;
+    f->f_pcmlen = sp - f->f_pcm;
+    f->f_position += blocksize;
+    return blocksize;
+}
+
+/* ----- decoder ----- */
+
+static void flac_free(t_flac *f)
+{
+    int i;
+    for (i = 0; i < FLACMAXCHANNELS; i++)
+        if (f->f_samples[i])
+            free(f->f_samples[i]);
+    if (f->f_pcm)
+        free(f->f_pcm);
+    if (f->f_seekpoints)
+        free(f->f_seekpoints);
+    if (f->f_buf)
+        free(f->f_buf);
+    free(f);
+}
+
+    /** read the id and metadata blocks, leaving f at the first frame,
+        returns 1 on success or 0 with errno set */
+static int flac_readmetadata(t_flac *f)
+{
+    int last = 0, haveinfo = 0;
+    off_t offset = 4;
+    if (flac_getbits(f, 32) != 0x664c6143) /* "fLaC" */
+    {
+        errno = SOUNDFILE_ERRUNKNOWN;
+        return 0;
+    }
+    while (!last)
+    {
+        int type;
+        uint32_t size;
+        last = flac_getbits(f, 1);
+        type = flac_getbits(f, 7);
+        size = flac_getbits(f, 24);
+        if (f->f_error ||
+            (!haveinfo && (type != FLAC_STREAMINFO || size < 34)))
+        {
+            errno = SOUNDFILE_ERRMALFORMED;
+            return 0;
+        }
+        offset += 4 + size;
+        if (type == FLAC_STREAMINFO)
+        {
+            flac_getbits(f, 16); /* min block size */
+            f->f_maxblocksize = flac_getbits(f, 16);
+            flac_getbits(f, 24); /* min frame size */
+            flac_getbits(f, 24); /* max frame size */
+            f->f_samplerate = flac_getbits(f, 20);
+            f->f_nchannels = flac_getbits(f, 3) + 1;
+            f->f_bitspersample = flac_getbits(f, 5) + 1;
+            f->f_nframes = (uint64_t)flac_getbits(f, 4) << 32;
+            f->f_nframes |= flac_getbits(f, 32);
+            size -= 18;
+            haveinfo = 1;
+        }
+        else if (type == FLAC_SEEKTABLE && !f->f_seekpoints && size >= 18)
+        {
+            int i, n = size / 18;
+            if (!(f->f_seekpoints =
+                (t_flacseekpoint *)malloc(n * sizeof(t_flacseekpoint))))
+            {
+                errno = ENOMEM;
+                return 0;
+            }
+            for (i = 0; i < n; i++)
+            {
+                t_flacseekpoint *sp = &f->f_seekpoints[i];
+                sp->sp_frame = (uint64_t)flac_getbits(f, 32) << 32;
+                sp->sp_frame |= flac_getbits(f, 32);
+                sp->sp_offset = (uint64_t)flac_getbits(f, 32) << 32;
+                sp->sp_offset |= flac_getbits(f, 32);
+                flac_getbits(f, 16); /* number of samples */
+            }
+            f->f_nseekpoints = n;
+            size -= n * 18;
+        }
+        if (!flac_skip(f, size) || f->f_error)
+        {
+            errno = SOUNDFILE_ERRMALFORMED;
+            return 0;
+        }
+    }
+    f->f_firstframe = offset;
+    return 1;
+}
+
+/* ----- type implementation ----- */
+
+static int flac_isheader(const char *buf, size_t size)
+{
+    return (size >= 4 && !strncmp(buf, "fLaC", 4));
+}
+
+static int flac_readheader(t_soundfile *sf)
+{
+    t_flac *f = (t_flac *)calloc(1, sizeof(t_flac));
+    int i;
+    if (!f)
+    {
+        errno = ENOMEM;
+        return 0;
+    }
+    if (!(f->f_buf = (unsigned char *)malloc(FLACBUFSIZE)))
+        goto nomem;
+    f->f_fd = sf->sf_fd;
+    flac_reset(f);
+    if (!flac_readmetadata(f))
+        goto fail;
+    if (f->f_nchannels > FLACMAXCHANNELS || f->f_bitspersample < 4 ||
+        f->f_bitspersample > 24)
+    {
+        errno = SOUNDFILE_ERRSAMPLEFMT;
+        goto fail;
+    }
+    if (f->f_maxblocksize < 16 || !f->f_samplerate || !f->f_nframes)
+    {
+        errno = SOUNDFILE_ERRMALFORMED;
+        goto fail;
+    }
+    f->f_bytespersample = (f->f_bitspersample <= 16 ? 2 : 3);
+    f->f_shift = f->f_bytespersample * 8 - f->f_bitspersample;
+    for (i = 0; i < f->f_nchannels; i++)
+        if (!(f->f_samples[i] =
+            (int32_t *)malloc(f->f_maxblocksize * sizeof(int32_t))))
+                goto nomem;
+    if (!(f->f_pcm = (unsigned char *)malloc(f->f_maxblocksize *
+        f->f_nchannels * f->f_bytespersample)))
+            goto nomem;
+
+    sf->sf_samplerate = f->f_samplerate;
+    sf->sf_nchannels = f->f_nchannels;
+    sf->sf_bytespersample = f->f_bytespersample;
+    sf->sf_headersize = f->f_firstframe;
+    sf->sf_bigendian = 0;
+    sf->sf_bytesperframe = f->f_nchannels * f->f_bytespersample;
+    sf->sf_bytelimit = (f->f_nframes > SFMAXBYTES / sf->sf_bytesperframe ?
+        SFMAXBYTES : (ssize_t)f->f_nframes * sf->sf_bytesperframe);
+    sf->sf_data = f;
+
+#ifdef DEBUG_SOUNDFILE
+    post("flac %d Hz, %d channels, %d bits, %lld frames",
+        sf->sf_samplerate, f->f_nchannels, f->f_bitspersample,
+        (long long)f->f_nframes);
+    post("  max block size %d, %d seek points, audio at %ld",
+        f->f_maxblocksize, f->f_nseekpoints, (long)f->f_firstframe);
+#endif
+
+    return 1;
+
+nomem:
+    errno = ENOMEM;
+fail:
+    flac_free(f);
+    return 0;
+}
+
+static ssize_t flac_readsamples(t_soundfile *sf, void *buf, size_t size)
+{
+    t_flac *f = (t_flac *)sf->sf_data;
+    unsigned char *dst = (unsigned char *)buf;
+    size_t done = 0;
+    while (done < size)
+    {
+        size_t n;
+        if (f->f_pcmpos == f->f_pcmlen && !flac_readframe(f))
+            break;
+        n = f->f_pcmlen - f->f_pcmpos;
+        if (n > size - done)
+            n = size - done;
+        memcpy(dst + done, f->f_pcm + f->f_pcmpos, n);
+        f->f_pcmpos += n;
+        done += n;
+    }
+    if (!done && f->f_ioerror)
+    {
+        errno = f->f_ioerror;
+        return -1;
+    }
+    return done;
+}
+
+    /* start at the closest seek point before the frame, if any, and decode
+    forward from there */
+static int flac_seek(t_soundfile *sf, size_t frame)
+{
+    t_flac *f = (t_flac *)sf->sf_data;
+    uint64_t start = 0, offset = 0;
+    int i;
+    if (frame >= f->f_nframes)
+    {
+        flac_reset(f);
+        f->f_pcmpos = f->f_pcmlen = 0;
+        f->f_position = f->f_nframes;
+        return (lseek(f->f_fd, 0, SEEK_END) >= 0);
+    }
+    if (frame || f->f_position)
+    {
+        for (i = 0; i < f->f_nseekpoints; i++)
+        {
+            const t_flacseekpoint *sp = &f->f_seekpoints[i];
+            if (sp->sp_frame != FLAC_PLACEHOLDER && sp->sp_frame <= frame &&
+                sp->sp_frame >= start)
+                    start = sp->sp_frame, offset = sp->sp_offset;
+        }
+        if (lseek(f->f_fd, f->f_firstframe + (off_t)offset, SEEK_SET) < 0)
+            return 0;
+        flac_reset(f);
+        f->f_pcmpos = f->f_pcmlen = 0;
+        f->f_position = start;
+    }
+    while (f->f_position <= frame)
+        if (!flac_readframe(f))
+            return 0;
+    f->f_pcmpos = f->f_pcmlen -
+        (f->f_position - frame) * sf->sf_bytesperframe;
+    return 1;
+}
+
+static void flac_close(t_soundfile *sf)
+{
+    flac_free((t_flac *)sf->sf_data);
+    sf->sf_data = NULL;
+}
+
+    /* there is no encoder */
+static int flac_writeheader(t_soundfile *sf, size_t nframes)
+{
+    errno = SOUNDFILE_ERRSAMPLEFMT;
+    return -1;
+}
+
+static int flac_updateheader(t_soundfile *sf, size_t nframes)
+{
+    return 0;
+}
+
+static int flac_hasextension(const char *filename, size_t size)
+{
+    int len = strnlen(filename, size);
+    if (len >= 6 &&
+        (!strncmp(filename + (len - 5), ".flac", 5) ||
+         !strncmp(filename + (len - 5), ".FLAC", 5)))
+        return 1;
+    return 0;
+}
+
+static int flac_addextension(char *filename, size_t size)
+{
+    int len = strnlen(filename, size);
+    if (len + 5 >= size)
+        return 0;
+    strcpy(filename + len, ".flac");
+    return 1;
+}
+
+    /* decoded samples are always little endian */
+static int flac_endianness(int endianness)
+{
+    return 0;
+}
+
+/* ------------------------- setup routine ------------------------ */
+
+t_soundfile_type flac = {
+    "flac",
+    FLACHEADSIZE,
+    flac_isheader,
+    flac_readheader,
+    flac_writeheader,
+    flac_updateheader,
+    flac_hasextension,
+    flac_addextension,
+    flac_endianness,
+    flac_readsamples,
+    flac_seek,
+    flac_close
+};
+
+void soundfile_flac_setup( void)
+{
+    soundfile_addtype(&flac);
+}
@@ -32,16 +32,42 @@ void voutlet_dspepilog(struct _voutlet *x, t_signal **parentsigs,
     int myvecsize, int phase, int period, int frequency,
     int downsample, int upsample, int reblock, int switched);
 
+    /* signal vectors are carved out of large blocks ("arenas") which are
+    all freed at once when DSP is stopped.  Vectors are allocated in the
+    order the graph is sorted, so the buffers of neighboring ugens tend to
+    be neighbors in memory too.  Each vector is cache-line aligned. */
+#define SIGARENA_ALIGN 64
+#define SIGARENA_SIZE 65536     /* bytes per arena unless a vector is larger */
+#define SIGREUSECLASSES 2       /* reuse free vectors up to 4x the size needed */
+
+typedef struct _sigarena
+{
+    struct _sigarena *a_next;  /* previously filled arena */
+    size_t a_size;             /* usable bytes starting at a_mem */
+    size_t a_used;             /* bytes handed out so far */
+    char *a_mem;               /* aligned start of usable memory */
+} t_sigarena;
+
+    /* initial number of elements allocated for the DSP chain; it grows
+    by doubling from there */
+#define DSPCHAIN_INITSIZE 256
+
 struct _instanceugen
 {
     t_int *u_dspchain;         /* DSP chain */
     int u_dspchainsize;        /* number of elements in DSP chain */
+    int u_dspchainalloc;       /* number of elements allocated */
     t_signal *u_signals;       /* list of signals used by DSP chain */
+    t_sigarena *u_arena;       /* memory for signal vectors */
     int u_sortno;              /* number of DSP sortings so far */
         /* list of signals which can be reused, sorted by buffer size */
     t_signal *u_freelist[MAXLOGSIG+1];
         /* list of reusable "borrowed" signals (which don't own sample buffers) */
     t_signal *u_freeborrowed;
+    int u_nsignals;            /* signal vectors requested by this sorting */
+    size_t u_sigrequested;     /* bytes they'd take without any reuse */
+    int u_nvecs;               /* vectors actually allocated */
+    size_t u_vecbytes;         /* bytes actually allocated */
     int u_phase;
     int u_loud;
     struct _dspcontext *u_context;
@@ -54,7 +80,9 @@ void d_ugen_newpdinstance(void)
     THIS = getbytes(sizeof(*THIS));
     THIS->u_dspchain = 0;
     THIS->u_dspchainsize = 0;
+    THIS->u_dspchainalloc = 0;
     THIS->u_signals = 0;
+    THIS->u_arena = 0;
 }
 
 void d_ugen_freepdinstance(void)
@@ -260,6 +288,7 @@ static void block_float(t_block *x, t_floatarg f)
 
 static void block_bang(t_block *x)
 {
+    canvas_flush_dsp();     /* make sure our chain onset is current */
     if (x->x_switched && !x->x_switchon && THIS->u_dspchain)
     {
         t_int *ip;
@@ -347,13 +376,27 @@ static t_int dsp_done(t_int *w)
     return (0);
 }
 
+    /* make room for "newsize" elements in the DSP chain.  The chain is
+    grown geometrically so that building it is linear in its length. */
+static void dsp_growchain(int newsize)
+{
+    if (newsize > THIS->u_dspchainalloc)
+    {
+        int newalloc = 2 * THIS->u_dspchainalloc;
+        if (newalloc < newsize)
+            newalloc = newsize;
+        THIS->u_dspchain = t_resizebytes(THIS->u_dspchain,
+            THIS->u_dspchainalloc * sizeof (t_int), newalloc * sizeof (t_int));
+        THIS->u_dspchainalloc = newalloc;
+    }
+}
+
 void dsp_add(t_perfroutine f, int n, ...)
 {
     int newsize = THIS->u_dspchainsize + n+1, i;
     va_list ap;
 
-    THIS->u_dspchain = t_resizebytes(THIS->u_dspchain,
-        THIS->u_dspchainsize * sizeof (t_int), newsize * sizeof (t_int));
+    dsp_growchain(newsize);
     THIS->u_dspchain[THIS->u_dspchainsize-1] = (t_int)f;
     if (THIS->u_loud)
         post("add to chain: %lx",
@@ -376,8 +419,7 @@ void dsp_addv(t_perfroutine f, int n, t_int *vec)
 {
     int newsize = THIS->u_dspchainsize + n+1, i;
 
-    THIS->u_dspchain = t_resizebytes(THIS->u_dspchain,
-        THIS->u_dspchainsize * sizeof (t_int), newsize * sizeof (t_int));
+    dsp_growchain(newsize);
     THIS->u_dspchain[THIS->u_dspchainsize-1] = (t_int)f;
     for (i = 0; i < n; i++)
         THIS->u_dspchain[THIS->u_dspchainsize + i] = vec[i];
@@ -410,17 +452,46 @@ int ilog2(int n)
 }
 
 
+    /* get zeroed, aligned memory for a signal vector from the current
+    arena, starting a new arena if it's full */
+static t_sample *sigarena_alloc(int nsamps)
+{
+    size_t nbytes = nsamps * sizeof(t_sample), size;
+    t_sigarena *a = THIS->u_arena;
+    t_sample *ret;
+    nbytes = (nbytes + SIGARENA_ALIGN - 1) & ~(size_t)(SIGARENA_ALIGN - 1);
+    if (!a || a->a_used + nbytes > a->a_size)
+    {
+        size = (nbytes > SIGARENA_SIZE ? nbytes : SIGARENA_SIZE);
+        a = (t_sigarena *)getbytes(sizeof(*a) + size + SIGARENA_ALIGN);
+        a->a_mem = (char *)(((size_t)(a + 1) + SIGARENA_ALIGN - 1) &
+            ~(size_t)(SIGARENA_ALIGN - 1));
+        a->a_size = size;
+        a->a_used = 0;
+        a->a_next = THIS->u_arena;
+        THIS->u_arena = a;
+    }
+    ret = (t_sample *)(a->a_mem + a->a_used);
+    a->a_used += nbytes;
+    return (ret);
+}
+
     /* call this when DSP is stopped to free all the signals */
 static void signal_cleanup(void)
 {
     t_signal *sig;
+    t_sigarena *a;
     int i;
     while ((sig = THIS->u_signals))
     {
         THIS->u_signals = sig->s_nextused;
-        if (!sig->s_isborrowed && !sig->s_isscalar)
-            t_freebytes(sig->s_vec, sig->s_nalloc * sizeof (*sig->s_vec));
         t_freebytes(sig, sizeof *sig);
+    }
+        /* signal vectors all go at once */
+    while ((a = THIS->u_arena))
+    {
+        THIS->u_arena = a->a_next;
+        freebytes(a, sizeof(*a) + a->a_size + SIGARENA_ALIGN);
     }
     for (i = 0; i <= MAXLOGSIG; i++)
         THIS->u_freelist[i] = 0;
@@ -495,14 +566,14 @@ void signal_makereusable(t_signal *sig)
 
 t_signal *signal_new(int length, int nchans, t_float sr, t_sample *scalarptr)
 {
-    int allocsize = 0;
+    int allocsize = 0, logn = 0;
     t_signal *ret, **whichlist;
     if (sr < 1)
         bug("signal_new");
     if (length && !scalarptr)
     {
             /* figure out which free list to use, depending on size of vector */
-        int logn = ilog2(length*nchans);
+        logn = ilog2(length*nchans);
             /* round up to a power of two */
         if ((1<<logn) < length*nchans)
             logn++;
@@ -514,7 +585,24 @@ t_signal *signal_new(int length, int nchans, t_float sr, t_sample *scalarptr)
     else /* scalar or borrowed signal */
         whichlist = &THIS->u_freeborrowed;
 
-        /* try to reclaim one from the free list */
+        /* try to reclaim one from the free list.  Free lists are filled as
+        each signal's last reader is scheduled, so this is a linear scan over
+        the live ranges in chain order.  If no vector of the right size is
+        free, take one at most SIGREUSECLASSES sizes larger rather than
+        allocating another; going further would tie up big vectors in small
+        signals and leave bigger signals to allocate their own. */
+    if (allocsize)
+    {
+        t_signal **biglist = whichlist, **lastlist = whichlist +
+            (logn + SIGREUSECLASSES < MAXLOGSIG ? SIGREUSECLASSES :
+                MAXLOGSIG - logn);
+        THIS->u_nsignals++;
+        THIS->u_sigrequested += allocsize * sizeof(t_sample);
+        while (!*biglist && biglist < lastlist)
+            biglist++;
+        if (*biglist)
+            whichlist = biglist, allocsize = (*biglist)->s_nalloc;
+    }
     if ((ret = *whichlist))
         *whichlist = ret->s_nextfree;
     else
@@ -522,7 +610,11 @@ t_signal *signal_new(int length, int nchans, t_float sr, t_sample *scalarptr)
                  /* LATER figure out what to do if we ran out of space */
         ret = (t_signal *)t_getbytes(sizeof *ret);
         if (allocsize)
-            ret->s_vec = (t_sample *)getbytes(allocsize * sizeof (*ret->s_vec));
+        {
+            ret->s_vec = sigarena_alloc(allocsize);
+            THIS->u_nvecs++;
+            THIS->u_vecbytes += allocsize * sizeof(t_sample);
+        }
         ret->s_nextused = THIS->u_signals;
         THIS->u_signals = ret;
     }
@@ -676,8 +768,9 @@ void ugen_stop(void)
     if (THIS->u_dspchain)
     {
         freebytes(THIS->u_dspchain,
-            THIS->u_dspchainsize * sizeof (t_int));
+            THIS->u_dspchainalloc * sizeof (t_int));
         THIS->u_dspchain = 0;
+        THIS->u_dspchainalloc = 0;
     }
     signal_cleanup();
 
@@ -688,12 +781,25 @@ void ugen_start(void)
     ugen_stop();
     THIS->u_sortno++;
     /*  THIS->u_loud = 1;  -- enable this for volumes of debugging output */
-    THIS->u_dspchain = (t_int *)getbytes(sizeof(*THIS->u_dspchain));
+    THIS->u_dspchain = (t_int *)getbytes(
+        DSPCHAIN_INITSIZE * sizeof(*THIS->u_dspchain));
     THIS->u_dspchain[0] = (t_int)dsp_done;
     THIS->u_dspchainsize = 1;
+    THIS->u_dspchainalloc = DSPCHAIN_INITSIZE;
+    THIS->u_nsignals = THIS->u_nvecs = 0;
+    THIS->u_sigrequested = THIS->u_vecbytes = 0;
     if (THIS->u_context) bug("ugen_start");
 }
 
+    /* called after all toplevel graphs are sorted */
+void ugen_done(void)
+{
+    logpost(NULL, PD_DEBUG,
+        "DSP sort %d: %d signals (%ld bytes) in %d vectors (%ld bytes)",
+            THIS->u_sortno, THIS->u_nsignals, (long)THIS->u_sigrequested,
+                THIS->u_nvecs, (long)THIS->u_vecbytes);
+}
+
 int ugen_getsortno(void)
 {
     return (THIS->u_sortno);
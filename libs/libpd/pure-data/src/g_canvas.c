@@ -901,7 +901,11 @@ void canvas_free(t_canvas *x)
 {
     t_gobj *y;
     t_canvas_private*private = x->gl_privatedata;
-    int dspstate = canvas_suspend_dsp();
+    int dspstate;
+        /* a suspended patch needs its bindings back to be torn down */
+    if (!x->gl_owner && THISGUI->i_suspended)
+        canvas_resume(x);
+    dspstate = canvas_suspend_dsp();
     canvas_noundo(x);
     if (canvas_whichfind == x)
         canvas_whichfind = 0;
@@ -1325,6 +1329,7 @@ EXTERN_STRUCT _dspcontext;
 
 void ugen_start(void);
 void ugen_stop(void);
+void ugen_done(void);
 
 t_dspcontext *ugen_start_graph(int toplevel, t_signal **sp,
     int ninlets, int noutlets);
@@ -1395,9 +1400,12 @@ static void canvas_start_dsp(void)
     ugen_start();
 
     for (x = pd_getcanvaslist(); x; x = x->gl_next)
-        canvas_dodsp(x, 1, 0);
+        if (!THISGUI->i_suspended || !canvas_issuspended(x))
+            canvas_dodsp(x, 1, 0);
+    ugen_done();
 
     canvas_dspstate = THISGUI->i_dspstate = 1;
+    THISGUI->i_dspdirty = 0;
     if (gensym("pd-dsp-started")->s_thing)
         pd_bang(gensym("pd-dsp-started")->s_thing);
 }
@@ -1408,7 +1416,7 @@ static void canvas_stop_dsp(void)
     {
         ugen_stop();
         pdgui_vmess("pdtk_pd_dsp", "s", "OFF");
-        canvas_dspstate = THISGUI->i_dspstate = 0;
+        canvas_dspstate = THISGUI->i_dspstate = THISGUI->i_dspdirty = 0;
         if (gensym("pd-dsp-stopped")->s_thing)
             pd_bang(gensym("pd-dsp-stopped")->s_thing);
     }
@@ -1417,7 +1425,15 @@ static void canvas_stop_dsp(void)
     /* DSP can be suspended before, and resumed after, operations which
     might affect the DSP chain.  For example, we suspend before loading and
     resume afterward, so that DSP doesn't get resorted for every DSP object
-    int the patch. */
+    int the patch.
+
+    Resuming doesn't sort the DSP graph right away; it only marks it "dirty"
+    so that canvas_flush_dsp() rebuilds it once, just before the next DSP
+    tick.  This way any number of edits within one scheduler tick (such as
+    a dynamically patched graph being connected up, or many objects being
+    deleted by message) costs only one re-sort.  The old chain is freed
+    immediately since it may point to deleted objects; nothing computes
+    DSP between now and the next tick anyway. */
 
 int canvas_suspend_dsp(void)
 {
@@ -1428,17 +1444,191 @@ int canvas_suspend_dsp(void)
 
 void canvas_resume_dsp(int oldstate)
 {
-    if (oldstate) canvas_start_dsp();
+    if (oldstate && !THISGUI->i_dspstate)
+    {
+        pdgui_vmess("pdtk_pd_dsp", "s", "ON");
+        canvas_dspstate = THISGUI->i_dspstate = 1;
+        THISGUI->i_dspdirty = 1;
+    }
 }
 
-    /* this is equivalent to suspending and resuming in one step. */
+    /* this is equivalent to suspending and resuming in one step, except
+    that DSP is never considered stopped so "pd-dsp-stopped" isn't sent. */
 void canvas_update_dsp(void)
 {
-    if (THISGUI->i_dspstate)
+    if (THISGUI->i_dspstate && !THISGUI->i_dspdirty)
     {
-        canvas_stop_dsp();
+        ugen_stop();
+        THISGUI->i_dspdirty = 1;
+    }
+}
+
+    /* called from the scheduler before each DSP tick (and by anyone else
+    who needs the DSP chain to be current) to rebuild the chain if the
+    graph changed since it was last sorted. */
+void canvas_flush_dsp(void)
+{
+    if (THISGUI->i_dspdirty)
         canvas_start_dsp();
+}
+
+/* ------------------------- suspended patches ------------------------ */
+
+    /* A toplevel patch can be suspended: it stays in memory, fully built,
+    but is cut off from the rest of Pd.  Its objects are unbound from all
+    symbols (so sends, "pd-" messages and GUI messages don't reach it),
+    its pending clocks are stopped with the time they had left, and it is
+    skipped when the DSP chain is sorted.  Resuming puts all this back.
+    Both are fast because nothing is created, deleted or reconnected;
+    the DSP chain is rebuilt once before the next tick.  Suspended patches
+    are kept on the instance's i_suspended list.
+
+    Clocks and bindings are found by their owner, so those held by helper
+    objects that aren't in the patch themselves (such as [pipe]'s
+    per-message clocks) aren't affected. */
+
+typedef struct _suspended
+{
+    struct _suspended *su_next;
+    t_canvas *su_canvas;
+    t_pd **su_who;          /* bindings removed by pd_unbindowned() */
+    t_symbol **su_sym;
+    int su_nbind;
+    t_clock **su_clocks;    /* clocks stopped by clock_freeze() */
+    double *su_left;
+    int su_nclock;
+} t_suspended;
+
+    /* hash set of every object in a patch */
+typedef struct _ownerset
+{
+    void **o_vec;
+    int o_size;             /* power of 2 */
+    int o_n;
+} t_ownerset;
+
+static unsigned int ownerset_hash(void *p)
+{
+    size_t u = (size_t)p;
+    return ((unsigned int)(u >> 4) ^ (unsigned int)(u >> 20)) * 2654435761u;
+}
+
+static void ownerset_add(t_ownerset *x, void *p)
+{
+    unsigned int i;
+    if (2 * (x->o_n + 1) > x->o_size)
+    {
+        void **oldvec = x->o_vec;
+        int oldsize = x->o_size, j;
+        x->o_size = (oldsize ? 2 * oldsize : 256);
+        x->o_vec = (void **)getbytes(x->o_size * sizeof(void *));
+        x->o_n = 0;
+        for (j = 0; j < oldsize; j++)
+            if (oldvec[j])
+                ownerset_add(x, oldvec[j]);
+        if (oldvec)
+            freebytes(oldvec, oldsize * sizeof(void *));
     }
+    for (i = ownerset_hash(p) & (x->o_size - 1); x->o_vec[i];
+        i = (i + 1) & (x->o_size - 1))
+            if (x->o_vec[i] == p)
+                return;
+    x->o_vec[i] = p;
+    x->o_n++;
+}
+
+static int ownerset_has(void *p, void *data)
+{
+    t_ownerset *x = (t_ownerset *)data;
+    unsigned int i;
+    for (i = ownerset_hash(p) & (x->o_size - 1); x->o_vec[i];
+        i = (i + 1) & (x->o_size - 1))
+            if (x->o_vec[i] == p)
+                return (1);
+    return (0);
+}
+
+extern int clone_get_n(t_gobj *x);
+extern t_glist *clone_get_instance_raw(t_gobj *x, int n);
+
+static void ownerset_addcanvas(t_ownerset *x, t_canvas *gl)
+{
+    t_gobj *y;
+    int i, n;
+    ownerset_add(x, gl);
+    for (y = gl->gl_list; y; y = y->g_next)
+    {
+        if (pd_class(&y->g_pd) == canvas_class)
+            ownerset_addcanvas(x, (t_canvas *)y);
+        else
+        {
+            ownerset_add(x, y);
+            for (i = 0, n = clone_get_n(y); i < n; i++)
+                ownerset_addcanvas(x, clone_get_instance_raw(y, i));
+        }
+    }
+}
+
+static t_suspended *canvas_findsuspended(t_canvas *x)
+{
+    t_suspended *su;
+    for (su = THISGUI->i_suspended; su; su = su->su_next)
+        if (su->su_canvas == x)
+            return (su);
+    return (0);
+}
+
+int canvas_issuspended(t_canvas *x)
+{
+    return (canvas_findsuspended(x) != 0);
+}
+
+    /* suspend a toplevel patch.  Returns 0 if it isn't a toplevel or is
+    already suspended. */
+int canvas_suspend(t_canvas *x)
+{
+    t_suspended *su;
+    t_ownerset set;
+    if (x->gl_owner || x->gl_isclone || canvas_findsuspended(x))
+        return (0);
+    if (x->gl_havewindow)
+        canvas_vis(x, 0);
+    set.o_vec = 0;
+    set.o_size = set.o_n = 0;
+    ownerset_addcanvas(&set, x);
+    su = (t_suspended *)getbytes(sizeof(*su));
+    su->su_canvas = x;
+    su->su_nbind = pd_unbindowned(ownerset_has, &set,
+        &su->su_who, &su->su_sym);
+    su->su_nclock = clock_freeze(ownerset_has, &set,
+        &su->su_clocks, &su->su_left);
+    freebytes(set.o_vec, set.o_size * sizeof(void *));
+    su->su_next = THISGUI->i_suspended;
+    THISGUI->i_suspended = su;
+    canvas_update_dsp();
+    return (1);
+}
+
+    /* put a suspended patch back.  Returns 0 if it wasn't suspended. */
+int canvas_resume(t_canvas *x)
+{
+    t_suspended *su, *su2;
+    if (!(su = canvas_findsuspended(x)))
+        return (0);
+    if (THISGUI->i_suspended == su)
+        THISGUI->i_suspended = su->su_next;
+    else
+    {
+        for (su2 = THISGUI->i_suspended; su2->su_next != su;
+            su2 = su2->su_next)
+                ;
+        su2->su_next = su->su_next;
+    }
+    pd_rebind(su->su_who, su->su_sym, su->su_nbind);
+    clock_thaw(su->su_clocks, su->su_left, su->su_nclock);
+    freebytes(su, sizeof(*su));
+    canvas_update_dsp();
+    return (1);
 }
 
 /* the "dsp" message to pd starts and stops DSP computation, and, if
@@ -1831,14 +2021,16 @@ typedef struct _canvasopen
     char **nameresult;
     unsigned int size;
     int bin;
+    int indexed;
     int fd;
 } t_canvasopen;
 
 static int canvas_open_iter(const char *path, t_canvasopen *co)
 {
     int fd;
-    if ((fd = sys_trytoopenone(path, co->name, co->ext,
-        co->dirresult, co->nameresult, co->size, co->bin)) >= 0)
+    if ((fd = (co->indexed ? sys_trytoopenindexed : sys_trytoopenone)(path,
+        co->name, co->ext, co->dirresult, co->nameresult, co->size,
+            co->bin)) >= 0)
     {
         co->fd = fd;
         return 0;
@@ -1858,8 +2050,9 @@ static int canvas_open_iter(const char *path, t_canvasopen *co)
     attempted, otherwise ASCII (this only matters on Microsoft.)
     If "x" is zero, the file is sought in the directory "." or in the
     global path.*/
-int canvas_open(const t_canvas *x, const char *name, const char *ext,
-    char *dirresult, char **nameresult, unsigned int size, int bin)
+static int canvas_doopen(const t_canvas *x, const char *name, const char *ext,
+    char *dirresult, char **nameresult, unsigned int size, int bin,
+    int indexed)
 {
     int fd = -1;
     t_canvasopen co;
@@ -1875,6 +2068,7 @@ int canvas_open(const t_canvas *x, const char *name, const char *ext,
     co.nameresult = nameresult;
     co.size = size;
     co.bin = bin;
+    co.indexed = indexed;
     co.fd = -1;
 
     canvas_path_iterate(x, (t_canvas_path_iterator)canvas_open_iter, &co);
@@ -1882,6 +2076,20 @@ int canvas_open(const t_canvas *x, const char *name, const char *ext,
     return (co.fd);
 }
 
+int canvas_open(const t_canvas *x, const char *name, const char *ext,
+    char *dirresult, char **nameresult, unsigned int size, int bin)
+{
+    return (canvas_doopen(x, name, ext, dirresult, nameresult, size, bin, 0));
+}
+
+    /* same, but skip directories whose cached listing (see s_path.c) shows
+    the file isn't there.  Used for finding abstractions. */
+int canvas_open_indexed(const t_canvas *x, const char *name, const char *ext,
+    char *dirresult, char **nameresult, unsigned int size, int bin)
+{
+    return (canvas_doopen(x, name, ext, dirresult, nameresult, size, bin, 1));
+}
+
 /*
  * Iterate over all search-paths for <x> calling <fun> with the user-supplied
  * <data>.  The function is called with two arguments: a pathname to try to
@@ -2160,6 +2368,8 @@ void g_canvas_newpdinstance(void)
     THISGUI->i_newargv = 0;
     THISGUI->i_reloadingabstraction = 0;
     THISGUI->i_dspstate = 0;
+    THISGUI->i_dspdirty = 0;
+    THISGUI->i_suspended = 0;
     THISGUI->i_dollarzero = 1000;
     g_editor_newpdinstance();
     g_template_newpdinstance();
@@ -2167,6 +2377,23 @@ void g_canvas_newpdinstance(void)
 
 void g_canvas_freepdinstance(void)
 {
+        /* patches are freed before this, which resumes them */
+    while (THISGUI->i_suspended)
+    {
+        t_suspended *su = THISGUI->i_suspended;
+        THISGUI->i_suspended = su->su_next;
+        if (su->su_nbind)
+        {
+            freebytes(su->su_who, su->su_nbind * sizeof(t_pd *));
+            freebytes(su->su_sym, su->su_nbind * sizeof(t_symbol *));
+        }
+        if (su->su_nclock)
+        {
+            freebytes(su->su_clocks, su->su_nclock * sizeof(t_clock *));
+            freebytes(su->su_left, su->su_nclock * sizeof(double));
+        }
+        freebytes(su, sizeof(*su));
+    }
     g_editor_freepdinstance();
     g_template_freepdinstance();
     freebytes(THISGUI, sizeof(*THISGUI));
@@ -2180,11 +2407,15 @@ EXTERN int pd_getdspstate(void)
 void pd_doloadbang(void);
 
     /* evaluate a file, which is expected to create a patch, and perform
-    post-evaluation cleanup and loadbang */
+    post-evaluation cleanup and loadbang.  If STUFF->st_loadthreads is set,
+    the file and its abstractions are read on that many threads first (see
+    binbuf_prefetch()).  The time each step takes goes to
+    STUFF->st_loadtimes. */
 t_pd *glob_evalfile(t_pd *ignore, t_symbol *name, t_symbol *dir)
 {
     t_pd *x = 0, *boundx;
-    int dspstate;
+    int dspstate, nfiles = 0;
+    double starttime = sys_getrealtime(), buildtime, loadbangtime;
 
         /* even though binbuf_evalfile appears to take care of dspstate,
         we have to do it again here, because canvas_startdsp() assumes
@@ -2194,16 +2425,27 @@ t_pd *glob_evalfile(t_pd *ignore, t_symbol *name, t_symbol *dir)
     boundx = s__X.s_thing;
         s__X.s_thing = 0;       /* don't save #X; we'll need to leave it bound
                                 for the caller to grab it. */
-    binbuf_evalfile(name, dir);
+    if (STUFF->st_loadthreads > 0)
+        nfiles = binbuf_prefetch(name, dir, STUFF->st_loadthreads);
+    buildtime = sys_getrealtime();
+    if (nfiles)
+        binbuf_evalprefetched(name, dir);
+    else binbuf_evalfile(name, dir);
     while ((x != s__X.s_thing) && s__X.s_thing)
     {
         x = s__X.s_thing;
         vmess(x, gensym("pop"), "i", 1);
     }
+    loadbangtime = sys_getrealtime();
     if (!sys_noloadbang)
         pd_doloadbang();
     canvas_resume_dsp(dspstate);
     s__X.s_thing = boundx;
+    STUFF->st_loadtimes.lt_prefetch = 1000. * (buildtime - starttime);
+    STUFF->st_loadtimes.lt_build = 1000. * (loadbangtime - buildtime);
+    STUFF->st_loadtimes.lt_loadbang =
+        1000. * (sys_getrealtime() - loadbangtime);
+    STUFF->st_loadtimes.lt_nfiles = nfiles;
     return x;
 }
 
@@ -274,6 +274,8 @@ struct _instancecanvas
     t_atom *i_newargv;
     t_glist *i_reloadingabstraction;
     int i_dspstate;
+    int i_dspdirty;         /* DSP chain must be rebuilt before next tick */
+    struct _suspended *i_suspended; /* suspended toplevel patches */
     int i_dollarzero;
     t_float i_graph_lastxpix, i_graph_lastypix;
 };
@@ -520,6 +522,10 @@ EXTERN void canvas_vis(t_canvas *x, t_floatarg f);
 EXTERN t_canvasenvironment *canvas_getenv(const t_canvas *x);
 EXTERN void canvas_rename(t_canvas *x, t_symbol *s, t_symbol *dir);
 EXTERN void canvas_loadbang(t_canvas *x);
+EXTERN void canvas_flush_dsp(void);
+EXTERN int canvas_suspend(t_canvas *x);
+EXTERN int canvas_resume(t_canvas *x);
+EXTERN int canvas_issuspended(t_canvas *x);
 EXTERN int canvas_hitbox(t_canvas *x, t_gobj *y, int xpos, int ypos,
     int *x1p, int *y1p, int *x2p, int *y2p);
 EXTERN int canvas_setdeleting(t_canvas *x, int flag);
@@ -550,6 +556,9 @@ EXTERN t_glist *pd_checkglist(t_pd *x);
 typedef int (*t_canvas_path_iterator)(const char *path, void *user_data);
 EXTERN int canvas_path_iterate(const t_canvas *x, t_canvas_path_iterator fun,
     void *user_data);
+EXTERN int canvas_open_indexed(const t_canvas *x, const char *name,
+    const char *ext, char *dirresult, char **nameresult, unsigned int size,
+    int bin);
 
 /* check string for untitled canvas filename prefix */
 #define UNTITLED_STRNCMP(s) strncmp(s, "PDUNTITLED", 10)
@@ -668,3 +668,16 @@ t_glist *clone_get_instance(t_gobj *x, int n)
     return  c->x_vec[n].c_gl;
 }
 
+    /* the same, but n counts from 0 whatever the first voice number is */
+t_glist *clone_get_instance_raw(t_gobj *x, int n)
+{
+    t_clone *c;
+
+    if (pd_class(&x->g_pd) != clone_class) return NULL;
+
+    c = (t_clone *)x;
+    if (n < 0 || n >= c->x_n)
+        return NULL;
+    return  c->x_vec[n].c_gl;
+}
+
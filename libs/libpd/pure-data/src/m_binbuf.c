@@ -5,10 +5,12 @@
 
 #include <stdlib.h>
 #include "m_pd.h"
+#include "m_imp.h"
 #include "s_stuff.h"
 #include "g_canvas.h"
 #include <stdio.h>
 #include <errno.h>
+#include <sys/stat.h>
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
 #endif
@@ -17,6 +19,9 @@
 #endif
 #include <string.h>
 #include <stdarg.h>
+#if PDTHREADS
+#include <pthread.h>
+#endif
 
 #include "m_private_utils.h"
 
@@ -55,6 +60,85 @@ void binbuf_clear(t_binbuf *x)
     x->b_n = 0;
 }
 
+    /* A word ends at white space, ';' or ','.  Words containing '\\' or '$'
+    are left to the character-by-character scanner in binbuf_text(). */
+#define BINBUF_ISSPECIAL(c) \
+    ((c) == '\\' || ((c) < 64 && ((BINBUF_SPECIALMASK >> (c)) & 1)))
+#define BINBUF_SPECIALMASK \
+    ((1ULL << ' ') | (1ULL << '\n') | (1ULL << '\r') | (1ULL << '\t') | \
+    (1ULL << ',') | (1ULL << ';') | (1ULL << '$'))
+
+    /* check if a word is a float, [-](digits[.[digits]]|.digits), optionally
+    followed by e[+|-]digits: the forms binbuf_text() has always accepted */
+static int binbuf_isfloat(const char *s, int n)
+{
+    const char *e = s + n;
+    int ndigits = 0;
+    if (s != e && *s == '-')
+        s++;
+    while (s != e && *s >= '0' && *s <= '9')
+        s++, ndigits++;
+    if (s != e && *s == '.')
+        for (s++; s != e && *s >= '0' && *s <= '9'; s++)
+            ndigits++;
+    if (!ndigits)
+        return (0);
+    if (s != e && (*s == 'e' || *s == 'E'))
+    {
+        if (++s != e && (*s == '+' || *s == '-'))
+            s++;
+        if (s == e)
+            return (0);
+        while (s != e && *s >= '0' && *s <= '9')
+            s++;
+    }
+    return (s == e);
+}
+
+    /* convert a word known to be a float.  Up to 15 digits with a power of
+    ten up to 22 are exact in a double, so a single multiplication or
+    division rounds the same as atof(); anything else goes to atof(). */
+static double binbuf_atof(const char *s, int n, char *buf)
+{
+    static const double powten[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6,
+        1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+        1e18, 1e19, 1e20, 1e21, 1e22};
+    const char *e = s + n, *p = s;
+    unsigned long long mantissa = 0;
+    int ndigits = 0, nfrac = 0, expon = 0, expsign = 1, negative = 0;
+    double f;
+    if (*p == '-')
+        negative = 1, p++;
+    for (; p != e && *p >= '0' && *p <= '9'; p++, ndigits++)
+        mantissa = mantissa * 10 + (*p - '0');
+    if (p != e && *p == '.')
+        for (p++; p != e && *p >= '0' && *p <= '9'; p++, ndigits++, nfrac++)
+            mantissa = mantissa * 10 + (*p - '0');
+    if (p != e)
+    {
+        int nexp = 0;
+        if (*++p == '+')
+            p++;
+        else if (*p == '-')
+            expsign = -1, p++;
+        for (; p != e; p++, nexp++)
+            expon = expon * 10 + (*p - '0');
+        if (nexp > 3)
+            ndigits = 100;
+    }
+    expon = expsign * expon - nfrac;
+    if (ndigits > 15 || expon < -22 || expon > 22)
+    {
+        memcpy(buf, s, n);
+        buf[n] = 0;
+        return (atof(buf));
+    }
+    if (expon >= 0)
+        f = (double)mantissa * powten[expon];
+    else f = (double)mantissa / powten[-expon];
+    return (negative ? -f : f);
+}
+
     /* convert text to a binbuf */
 void binbuf_text(t_binbuf *x, const char *text, size_t size)
 {
@@ -76,109 +160,134 @@ void binbuf_text(t_binbuf *x, const char *text, size_t size)
         else if (*textp == ',') SETCOMMA(ap), textp++;
         else
         {
-                /* it's an atom other than a comma or semi */
-            char c;
-            int floatstate = 0, slash = 0, lastslash = 0, dollar = 0;
-            bufp = buf;
-            do
+                /* it's an atom other than a comma or semi.  First look for
+                the end of the word and, if it is plain, convert it in
+                place. */
+            const char *wordp = textp;
+            int n;
+            while (textp != etext && !BINBUF_ISSPECIAL((unsigned char)*textp))
+                textp++;
+            n = (int)(textp - wordp);
+            if (n < MAXPDSTRING && (textp == etext ||
+                (*textp != '\\' && *textp != '$')))
             {
-                c = *bufp = *textp++;
-                lastslash = slash;
-                slash = (c == '\\');
-
-                if (floatstate >= 0)
+                if (binbuf_isfloat(wordp, n))
+                    SETFLOAT(ap, binbuf_atof(wordp, n, buf));
+                else
                 {
-                    int digit = (c >= '0' && c <= '9'),
-                        dot = (c == '.'), minus = (c == '-'),
-                        plusminus = (minus || (c == '+')),
-                        expon = (c == 'e' || c == 'E');
-                    if (floatstate == 0)    /* beginning */
-                    {
-                        if (minus) floatstate = 1;
-                        else if (digit) floatstate = 2;
-                        else if (dot) floatstate = 3;
-                        else floatstate = -1;
-                    }
-                    else if (floatstate == 1)   /* got minus */
-                    {
-                        if (digit) floatstate = 2;
-                        else if (dot) floatstate = 3;
-                        else floatstate = -1;
-                    }
-                    else if (floatstate == 2)   /* got digits */
-                    {
-                        if (dot) floatstate = 4;
-                        else if (expon) floatstate = 6;
-                        else if (!digit) floatstate = -1;
-                    }
-                    else if (floatstate == 3)   /* got '.' without digits */
-                    {
-                        if (digit) floatstate = 5;
-                        else floatstate = -1;
-                    }
-                    else if (floatstate == 4)   /* got '.' after digits */
-                    {
-                        if (digit) floatstate = 5;
-                        else if (expon) floatstate = 6;
-                        else floatstate = -1;
-                    }
-                    else if (floatstate == 5)   /* got digits after . */
-                    {
-                        if (expon) floatstate = 6;
-                        else if (!digit) floatstate = -1;
-                    }
-                    else if (floatstate == 6)   /* got 'e' */
-                    {
-                        if (plusminus) floatstate = 7;
-                        else if (digit) floatstate = 8;
-                        else floatstate = -1;
-                    }
-                    else if (floatstate == 7)   /* got plus or minus */
+                    memcpy(buf, wordp, n);
+                    buf[n] = 0;
+                    SETSYMBOL(ap, gensym(buf));
+                }
+            }
+            else
+            {
+                    /* otherwise scan it again, handling escapes and dollars */
+                char c;
+                int floatstate = 0, slash = 0, lastslash = 0, dollar = 0;
+                textp = wordp;
+                bufp = buf;
+                do
+                {
+                    c = *bufp = *textp++;
+                    lastslash = slash;
+                    slash = (c == '\\');
+
+                    if (floatstate >= 0)
                     {
-                        if (digit) floatstate = 8;
-                        else floatstate = -1;
+                        int digit = (c >= '0' && c <= '9'),
+                            dot = (c == '.'), minus = (c == '-'),
+                            plusminus = (minus || (c == '+')),
+                            expon = (c == 'e' || c == 'E');
+                        if (floatstate == 0)    /* beginning */
+                        {
+                            if (minus) floatstate = 1;
+                            else if (digit) floatstate = 2;
+                            else if (dot) floatstate = 3;
+                            else floatstate = -1;
+                        }
+                        else if (floatstate == 1)   /* got minus */
+                        {
+                            if (digit) floatstate = 2;
+                            else if (dot) floatstate = 3;
+                            else floatstate = -1;
+                        }
+                        else if (floatstate == 2)   /* got digits */
+                        {
+                            if (dot) floatstate = 4;
+                            else if (expon) floatstate = 6;
+                            else if (!digit) floatstate = -1;
+                        }
+                        else if (floatstate == 3) /* got '.' without digits */
+                        {
+                            if (digit) floatstate = 5;
+                            else floatstate = -1;
+                        }
+                        else if (floatstate == 4)   /* got '.' after digits */
+                        {
+                            if (digit) floatstate = 5;
+                            else if (expon) floatstate = 6;
+                            else floatstate = -1;
+                        }
+                        else if (floatstate == 5)   /* got digits after . */
+                        {
+                            if (expon) floatstate = 6;
+                            else if (!digit) floatstate = -1;
+                        }
+                        else if (floatstate == 6)   /* got 'e' */
+                        {
+                            if (plusminus) floatstate = 7;
+                            else if (digit) floatstate = 8;
+                            else floatstate = -1;
+                        }
+                        else if (floatstate == 7)   /* got plus or minus */
+                        {
+                            if (digit) floatstate = 8;
+                            else floatstate = -1;
+                        }
+                        else if (floatstate == 8)   /* got digits */
+                        {
+                            if (!digit) floatstate = -1;
+                        }
                     }
-                    else if (floatstate == 8)   /* got digits */
+                    if (!lastslash && c == '$' && (textp != etext &&
+                        textp[0] >= '0' && textp[0] <= '9'))
+                            dollar = 1;
+                    if (!slash) bufp++;
+                    else if (lastslash)
                     {
-                        if (!digit) floatstate = -1;
+                        bufp++;
+                        slash = 0;
                     }
                 }
-                if (!lastslash && c == '$' && (textp != etext &&
-                    textp[0] >= '0' && textp[0] <= '9'))
-                        dollar = 1;
-                if (!slash) bufp++;
-                else if (lastslash)
-                {
-                    bufp++;
-                    slash = 0;
-                }
-            }
-            while (textp != etext && bufp != ebuf &&
-                (slash || (*textp != ' ' && *textp != '\n' && *textp != '\r'
-                    && *textp != '\t' &&*textp != ',' && *textp != ';')));
-            *bufp = 0;
+                while (textp != etext && bufp != ebuf &&
+                    (slash || (*textp != ' ' && *textp != '\n' &&
+                        *textp != '\r' && *textp != '\t' &&
+                        *textp != ',' && *textp != ';')));
+                *bufp = 0;
 #if 0
-            post("binbuf_text: buf %s", buf);
+                post("binbuf_text: buf %s", buf);
 #endif
-            if (floatstate == 2 || floatstate == 4 || floatstate == 5 ||
-                floatstate == 8)
-                    SETFLOAT(ap, atof(buf));
-                /* LATER try to figure out how to mix "$" and "\$" correctly;
-                here, the backslashes were already stripped so we assume all
-                "$" chars are real dollars.  In fact, we only know at least one
-                was. */
-            else if (dollar)
-            {
-                if (buf[0] != '$')
-                    dollar = 0;
-                for (bufp = buf+1; *bufp; bufp++)
-                    if (*bufp < '0' || *bufp > '9')
+                if (floatstate == 2 || floatstate == 4 || floatstate == 5 ||
+                    floatstate == 8)
+                        SETFLOAT(ap, atof(buf));
+                    /* LATER try to figure out how to mix "$" and "\$"
+                    correctly; here, the backslashes were already stripped so
+                    we assume all "$" chars are real dollars.  In fact, we
+                    only know at least one was. */
+                else if (dollar)
+                {
+                    if (buf[0] != '$')
                         dollar = 0;
-                if (dollar)
-                    SETDOLLAR(ap, atoi(buf+1));
-                else SETDOLLSYM(ap, gensym(buf));
+                    for (bufp = buf+1; *bufp; bufp++)
+                        if (*bufp < '0' || *bufp > '9')
+                            dollar = 0;
+                    if (dollar)
+                        SETDOLLAR(ap, atoi(buf+1));
+                    else SETDOLLSYM(ap, gensym(buf));
+                }
+                else SETSYMBOL(ap, gensym(buf));
             }
-            else SETSYMBOL(ap, gensym(buf));
         }
         ap++;
         natom++;
@@ -787,7 +896,362 @@ broken:
          FREEA(t_atom, mstack, maxnargs, HUGEMSG);
 }
 
-int binbuf_read(t_binbuf *b, const char *filename, const char *dirname, int crflag)
+/* Compiled patches.  A ".pdc" file holds a binbuf as it is after parsing,
+so that reading it needs no tokenizing or number conversion and each symbol
+is looked up only once.  It's made of:
+
+    the magic "\0PDC", a version byte and the size of a float (4 or 8),
+    the number of symbols, then each symbol as its length and its bytes,
+    the number of atoms, then each atom as a type byte followed by, for
+    floats, the value (little-endian IEEE) or, for whole numbers, the
+    number (zigzag encoded so that small negative ones stay short), for
+    symbols and dollsyms, an index into the symbol table, and for dollars,
+    the argument number.
+
+All counts and numbers are unsigned LEB128.  binbuf_read() recognizes the
+format by its magic, so compiled files can be read wherever text ones are;
+binbuf_write() writes it for file names ending in ".pdc". */
+
+#define COMPILED_MAGIC "\0PDC"
+#define COMPILED_VERSION 1
+
+#define COMPILED_SEMI 0
+#define COMPILED_COMMA 1
+#define COMPILED_FLOAT 2
+#define COMPILED_SYMBOL 3
+#define COMPILED_DOLLAR 4
+#define COMPILED_DOLLSYM 5
+#define COMPILED_INT 6
+
+static int binbuf_iscompiled(const char *buf, size_t size)
+{
+    return (size >= 6 && !memcmp(buf, COMPILED_MAGIC, 4));
+}
+
+static unsigned char *compiled_putnum(unsigned char *bp, size_t n)
+{
+    while (n >= 0x80)
+    {
+        *bp++ = (unsigned char)(n | 0x80);
+        n >>= 7;
+    }
+    *bp++ = (unsigned char)n;
+    return (bp);
+}
+
+    /* read a number; return 0 if it runs past the end */
+static int compiled_getnum(const unsigned char **bpp,
+    const unsigned char *ep, size_t *np)
+{
+    const unsigned char *bp = *bpp;
+    size_t n = 0;
+    int shift = 0;
+    while (bp < ep && shift < 64)
+    {
+        n |= (size_t)(*bp & 0x7f) << shift;
+        if (!(*bp++ & 0x80))
+        {
+            *bpp = bp;
+            *np = n;
+            return (1);
+        }
+        shift += 7;
+    }
+    return (0);
+}
+
+    /* symbol to table index, for writing */
+typedef struct _compiledsyms
+{
+    t_symbol **c_vec;       /* hash table, size a power of 2 */
+    int *c_index;
+    int c_size;
+    int c_n;
+} t_compiledsyms;
+
+static int compiledsyms_index(t_compiledsyms *x, t_symbol *s, int *isnew)
+{
+    unsigned int i = (unsigned int)(((size_t)s >> 3) * 2654435761u)
+        & (x->c_size - 1);
+    while (x->c_vec[i])
+    {
+        if (x->c_vec[i] == s)
+        {
+            *isnew = 0;
+            return (x->c_index[i]);
+        }
+        i = (i + 1) & (x->c_size - 1);
+    }
+    x->c_vec[i] = s;
+    *isnew = 1;
+    return (x->c_index[i] = x->c_n++);
+}
+
+    /* the symbol an atom is written with, or 0 if it has none.  Pointers
+    can't be saved, so like in text files they become empty symbols. */
+static t_symbol *compiled_atomsymbol(const t_atom *ap)
+{
+    switch (ap->a_type)
+    {
+    case A_SEMI: case A_COMMA: case A_FLOAT: case A_DOLLAR:
+        return (0);
+    case A_SYMBOL: case A_DOLLSYM:
+        return (ap->a_w.w_symbol);
+    default:
+        return (&s_);
+    }
+}
+
+    /* true if a file by this name could be found as an abstraction */
+static int binbuf_ispatchfile(const char *path)
+{
+    const char *ext = strrchr(path, '.');
+    return (ext && !strchr(ext, '/') && (!strcmp(ext, ".pd") ||
+        !strcmp(ext, ".pdc") || !strcmp(ext, ".pat") || !strcmp(ext, ".mxt")));
+}
+
+    /* called before writing the file "path".  A new patch file may be an
+    abstraction that the directory listings don't have yet; other files can't
+    be found as objects and files that are already there are listed, so the
+    listings are only read again in that case.  Parsed copies of files by the
+    same name are forgotten; the cache may spell the directory differently,
+    so this can drop a few same-named files elsewhere too. */
+static void binbuf_noticewrite(const char *path)
+{
+    const char *leaf = strrchr(path, '/');
+    int fd;
+    if (!binbuf_ispatchfile(path))
+        return;
+    if ((fd = sys_open(path, 0)) >= 0)
+        sys_close(fd);
+    else sys_flushdirindex();
+    binbuf_flushtemplates(gensym(leaf ? leaf + 1 : path));
+}
+
+    /* write "x" in compiled form to the file "path", whatever its
+    extension.  Return 0 on success. */
+int binbuf_write_compiled(const t_binbuf *x, const char *path)
+{
+    t_compiledsyms syms;
+    unsigned char *buf, *bp, *done;
+    size_t size = 16, symbytes = 0;
+    t_atom *ap;
+    t_symbol *s;
+    int i, isnew, ret = 1;
+    FILE *f;
+
+    for (syms.c_size = 64; syms.c_size < 2 * x->b_n; syms.c_size *= 2)
+        ;
+    syms.c_vec = (t_symbol **)getbytes(syms.c_size * sizeof(t_symbol *));
+    syms.c_index = (int *)getbytes(syms.c_size * sizeof(int));
+    syms.c_n = 0;
+        /* number the symbols in order of appearance and size the buffer */
+    for (ap = x->b_vec, i = x->b_n; i--; ap++)
+        if ((s = compiled_atomsymbol(ap)))
+    {
+        compiledsyms_index(&syms, s, &isnew);
+        if (isnew)
+            symbytes += strlen(s->s_name) + 10;
+    }
+    size += symbytes + (size_t)x->b_n * (1 + 10) + 20;
+    bp = buf = (unsigned char *)getbytes(size);
+
+    memcpy(bp, COMPILED_MAGIC, 4);
+    bp += 4;
+    *bp++ = COMPILED_VERSION;
+    *bp++ = (unsigned char)sizeof(t_float);
+    bp = compiled_putnum(bp, syms.c_n);
+        /* the symbols go in index order; find them again by a second pass
+        over the atoms, writing each the first time it's seen */
+    done = (unsigned char *)getbytes(syms.c_n ? syms.c_n : 1);
+    for (ap = x->b_vec, i = x->b_n; i--; ap++)
+        if ((s = compiled_atomsymbol(ap)))
+    {
+        int index = compiledsyms_index(&syms, s, &isnew);
+        if (!done[index])
+        {
+            size_t len = strlen(s->s_name);
+            done[index] = 1;
+            bp = compiled_putnum(bp, len);
+            memcpy(bp, s->s_name, len);
+            bp += len;
+        }
+    }
+    freebytes(done, syms.c_n ? syms.c_n : 1);
+
+    bp = compiled_putnum(bp, x->b_n);
+    for (ap = x->b_vec, i = x->b_n; i--; ap++)
+    {
+        switch (ap->a_type)
+        {
+        case A_SEMI:
+            *bp++ = COMPILED_SEMI;
+            break;
+        case A_COMMA:
+            *bp++ = COMPILED_COMMA;
+            break;
+        case A_FLOAT:
+        {
+            union
+            {
+                t_float f;
+                unsigned char c[sizeof(t_float)];
+            } u;
+            int j;
+            static const int one = 1;
+            t_float f = ap->a_w.w_float;
+                /* most numbers in patches are small integers */
+            if (f > -0x40000000 && f < 0x40000000 && f == (t_float)(long)f &&
+                (f != 0 || 1/f > 0))
+            {
+                long n = (long)f;
+                *bp++ = COMPILED_INT;
+                bp = compiled_putnum(bp,
+                    (n < 0 ? ((size_t)(-n) << 1) - 1 : (size_t)n << 1));
+                break;
+            }
+            *bp++ = COMPILED_FLOAT;
+            u.f = ap->a_w.w_float;
+            if (*(const char *)&one)     /* little endian */
+                for (j = 0; j < (int)sizeof(t_float); j++)
+                    *bp++ = u.c[j];
+            else for (j = (int)sizeof(t_float); j--; )
+                *bp++ = u.c[j];
+            break;
+        }
+        case A_DOLLAR:
+            *bp++ = COMPILED_DOLLAR;
+            bp = compiled_putnum(bp, ap->a_w.w_index);
+            break;
+        default:
+            *bp++ = (ap->a_type == A_DOLLSYM ?
+                COMPILED_DOLLSYM : COMPILED_SYMBOL);
+            bp = compiled_putnum(bp,
+                compiledsyms_index(&syms, compiled_atomsymbol(ap), &isnew));
+            break;
+        }
+    }
+    freebytes(syms.c_vec, syms.c_size * sizeof(t_symbol *));
+    freebytes(syms.c_index, syms.c_size * sizeof(int));
+
+    binbuf_noticewrite(path);
+    if ((f = sys_fopen(path, "wb")))
+    {
+        if (fwrite(buf, bp - buf, 1, f) == 1 && !fflush(f))
+            ret = 0;
+        fclose(f);
+    }
+    freebytes(buf, size);
+    return (ret);
+}
+
+    /* set "b" to the contents of a compiled file.  Return 0 on success. */
+static int binbuf_fromcompiled(t_binbuf *b, const char *buf, size_t size)
+{
+    const unsigned char *bp = (const unsigned char *)buf + 6,
+        *ep = (const unsigned char *)buf + size;
+    int floatsize = ((const unsigned char *)buf)[5];
+    size_t nsyms, natoms, len, i, n;
+    t_symbol **syms = 0;
+    char smallbuf[MAXPDSTRING], *namebuf;
+    t_atom *ap;
+    static const int one = 1;
+    int littleendian = *(const char *)&one, type;
+
+    binbuf_clear(b);
+    if (((const unsigned char *)buf)[4] != COMPILED_VERSION ||
+        (floatsize != 4 && floatsize != 8) ||
+            !compiled_getnum(&bp, ep, &nsyms) || nsyms > size)
+                return (1);
+    syms = (t_symbol **)getbytes((nsyms ? nsyms : 1) * sizeof(t_symbol *));
+    for (i = 0; i < nsyms; i++)
+    {
+        if (!compiled_getnum(&bp, ep, &len) || len > (size_t)(ep - bp))
+            goto fail;
+        namebuf = (len < MAXPDSTRING ? smallbuf :
+            (char *)getbytes(len + 1));
+        memcpy(namebuf, bp, len);
+        namebuf[len] = 0;
+        syms[i] = gensym(namebuf);
+        if (namebuf != smallbuf)
+            freebytes(namebuf, len + 1);
+        bp += len;
+    }
+    if (!compiled_getnum(&bp, ep, &natoms) || natoms > (size_t)(ep - bp) ||
+        !binbuf_resize(b, (int)natoms))
+            goto fail;
+    for (ap = b->b_vec, i = 0; i < natoms; i++, ap++)
+    {
+        if (bp >= ep)
+            goto fail;
+        switch ((type = *bp++))
+        {
+        case COMPILED_SEMI:
+            SETSEMI(ap);
+            break;
+        case COMPILED_COMMA:
+            SETCOMMA(ap);
+            break;
+        case COMPILED_FLOAT:
+        {
+            unsigned char c[8];
+            int j;
+            if (ep - bp < floatsize)
+                goto fail;
+            if (littleendian)
+                for (j = 0; j < floatsize; j++)
+                    c[j] = *bp++;
+            else for (j = floatsize; j--; )
+                c[j] = *bp++;
+            if (floatsize == 4)
+            {
+                float f;
+                memcpy(&f, c, 4);
+                SETFLOAT(ap, f);
+            }
+            else
+            {
+                double f;
+                memcpy(&f, c, 8);
+                SETFLOAT(ap, f);
+            }
+            break;
+        }
+        case COMPILED_SYMBOL:
+        case COMPILED_DOLLSYM:
+            if (!compiled_getnum(&bp, ep, &n) || n >= nsyms)
+                goto fail;
+            if (type == COMPILED_SYMBOL)
+                SETSYMBOL(ap, syms[n]);
+            else SETDOLLSYM(ap, syms[n]);
+            break;
+        case COMPILED_DOLLAR:
+            if (!compiled_getnum(&bp, ep, &n))
+                goto fail;
+            SETDOLLAR(ap, (int)n);
+            break;
+        case COMPILED_INT:
+            if (!compiled_getnum(&bp, ep, &n))
+                goto fail;
+            SETFLOAT(ap, (n & 1) ? -(t_float)((n + 1) >> 1) :
+                (t_float)(n >> 1));
+            break;
+        default:
+            goto fail;
+        }
+    }
+    freebytes(syms, (nsyms ? nsyms : 1) * sizeof(t_symbol *));
+    return (0);
+fail:
+    binbuf_clear(b);
+    freebytes(syms, (nsyms ? nsyms : 1) * sizeof(t_symbol *));
+    return (1);
+}
+
+    /* read a file into "b"; if "quiet" is set, fail without a word (for the
+    prefetch threads, which mustn't post) */
+static int binbuf_doread(t_binbuf *b, const char *filename,
+    const char *dirname, int crflag, int quiet)
 {
     long length;
     int fd;
@@ -803,25 +1267,48 @@ int binbuf_read(t_binbuf *b, const char *filename, const char *dirname, int crfl
 
     if ((fd = sys_open(namebuf, 0)) < 0)
     {
-        fprintf(stderr, "open: ");
-        perror(namebuf);
+        if (!quiet)
+        {
+            fprintf(stderr, "open: ");
+            perror(namebuf);
+        }
         return (1);
     }
     if ((length = (long)lseek(fd, 0, SEEK_END)) < 0 || lseek(fd, 0, SEEK_SET) < 0
         || !(buf = t_getbytes(length)))
     {
-        fprintf(stderr, "lseek: ");
-        perror(namebuf);
+        if (!quiet)
+        {
+            fprintf(stderr, "lseek: ");
+            perror(namebuf);
+        }
         close(fd);
         return(1);
     }
     if ((readret = (int)read(fd, buf, length)) < length)
     {
-        fprintf(stderr, "read (%d %ld) -> %d\n", fd, length, readret);
-        perror(namebuf);
+        if (!quiet)
+        {
+            fprintf(stderr, "read (%d %ld) -> %d\n", fd, length, readret);
+            perror(namebuf);
+        }
         close(fd);
         t_freebytes(buf, length);
         return(1);
+    }
+    if (binbuf_iscompiled(buf, length))
+    {
+        if (binbuf_fromcompiled(b, buf, length))
+        {
+            if (!quiet)
+                pd_error(0, "%s: bad compiled patch", namebuf);
+            t_freebytes(buf, length);
+            close(fd);
+            return (1);
+        }
+        t_freebytes(buf, length);
+        close(fd);
+        return (0);
     }
         /* optionally map carriage return to semicolon */
     if (crflag)
@@ -842,6 +1329,11 @@ int binbuf_read(t_binbuf *b, const char *filename, const char *dirname, int crfl
     return (0);
 }
 
+int binbuf_read(t_binbuf *b, const char *filename, const char *dirname, int crflag)
+{
+    return (binbuf_doread(b, filename, dirname, crflag, 0));
+}
+
     /* read a binbuf from a file, via the search patch of a canvas */
 int binbuf_read_via_canvas(t_binbuf *b, const char *filename,
     const t_canvas *canvas, int crflag)
@@ -882,7 +1374,8 @@ int binbuf_read_via_path(t_binbuf *b, const char *filename, const char *dirname,
 static t_binbuf *binbuf_convert(const t_binbuf *oldb, int maxtopd);
 
     /* write a binbuf to a text file.  If "crflag" is set we suppress
-    semicolons. */
+    semicolons.  File names ending in ".pdc" get a compiled file instead
+    (see binbuf_write_compiled()). */
 int binbuf_write(const t_binbuf *x, const char *filename, const char *dir, int crflag)
 {
     FILE *f = 0;
@@ -905,6 +1398,10 @@ int binbuf_write(const t_binbuf *x, const char *filename, const char *dir, int c
         z = y;
     }
 
+    if (strlen(filename) > 4 &&
+        !strcmp(filename + strlen(filename) - 4, ".pdc"))
+            return (binbuf_write_compiled(x, fbuf));
+    binbuf_noticewrite(fbuf);
     if (!(f = sys_fopen(fbuf, "w")))
         goto fail;
     for (ap = z->b_vec, indx = z->b_n; indx--; ap++)
@@ -1440,7 +1937,517 @@ static t_binbuf *binbuf_convert(const t_binbuf *oldb, int maxtopd)
 
 /* LATER make this evaluate the file on-the-fly. */
 /* LATER figure out how to log errors */
-void binbuf_evalfile(t_symbol *name, t_symbol *dir)
+    /* Parsed abstractions.  Every instance of an abstraction would read
+    and tokenize its file again; instead we keep the (converted) contents of
+    each file read by binbuf_evaltemplate() and copy its atoms.  An entry is
+    only used as long as the file's size and modification time are unchanged,
+    and it's dropped when Pd writes a patch file by the same name or
+    binbuf_flushtemplates() is called. */
+
+typedef struct _bintemplate
+{
+    struct _bintemplate *bt_next;
+    t_symbol *bt_path;          /* "dir/name" as passed to binbuf_read() */
+    long bt_size;
+    long bt_mtime;
+    long bt_mtimensec;
+    t_binbuf *bt_binbuf;
+} t_bintemplate;
+
+    /* get size and modification time of a file; return 0 on success */
+static int binbuf_stampfile(const char *path, t_bintemplate *bt)
+{
+    struct stat statbuf;
+#ifdef _WIN32
+        /* go through sys_open() for UTF-8 file names */
+    int fd = sys_open(path, 0), ok;
+    if (fd < 0)
+        return (1);
+    ok = (fstat(fd, &statbuf) >= 0);
+    close(fd);
+    if (!ok)
+        return (1);
+#else
+    if (stat(path, &statbuf) < 0)
+        return (1);
+#endif
+    bt->bt_size = (long)statbuf.st_size;
+    bt->bt_mtime = (long)statbuf.st_mtime;
+#if defined(__APPLE__)
+    bt->bt_mtimensec = (long)statbuf.st_mtimespec.tv_nsec;
+#elif defined(__linux__)
+    bt->bt_mtimensec = (long)statbuf.st_mtim.tv_nsec;
+#else
+    bt->bt_mtimensec = 0;
+#endif
+    return (0);
+}
+
+    /* forget the template for "path", or all of them if "path" is zero.
+    "path" may also be just the file name, or the end of the path after a
+    slash, which matches every file of that name. */
+void binbuf_flushtemplates(t_symbol *path)
+{
+    t_bintemplate **btp = &STUFF->st_bintemplates, *bt;
+    int len = (path ? (int)strlen(path->s_name) : 0);
+    while ((bt = *btp))
+    {
+        const char *s = bt->bt_path->s_name;
+        int slen = (int)strlen(s);
+        if (!path || bt->bt_path == path ||
+            (slen > len && s[slen-len-1] == '/' &&
+                !strcmp(s + slen - len, path->s_name)))
+        {
+            *btp = bt->bt_next;
+            binbuf_free(bt->bt_binbuf);
+            freebytes(bt, sizeof(*bt));
+        }
+        else btp = &bt->bt_next;
+    }
+}
+
+    /* the key of a file in the template cache */
+static t_symbol *binbuf_templatepath(const char *filename, const char *dirname)
+{
+    char namebuf[MAXPDSTRING];
+    if (*dirname)
+        snprintf(namebuf, MAXPDSTRING-1, "%s/%s", dirname, filename);
+    else
+        snprintf(namebuf, MAXPDSTRING-1, "%s", filename);
+    namebuf[MAXPDSTRING-1] = 0;
+    return (gensym(namebuf));
+}
+
+    /* find the template for "path".  If "stamp" is given, only return it
+    if it's up to date, and drop it if it isn't and "drop" is set. */
+static t_bintemplate **binbuf_findtemplate(t_symbol *path,
+    const t_bintemplate *stamp, int drop)
+{
+    t_bintemplate **btp, *bt;
+    for (btp = &STUFF->st_bintemplates; (bt = *btp); btp = &bt->bt_next)
+        if (bt->bt_path == path)
+    {
+        if (!stamp || (bt->bt_size == stamp->bt_size &&
+            bt->bt_mtime == stamp->bt_mtime &&
+                bt->bt_mtimensec == stamp->bt_mtimensec))
+                    return (btp);
+            /* file changed on disk */
+        if (drop)
+        {
+            *btp = bt->bt_next;
+            binbuf_free(bt->bt_binbuf);
+            freebytes(bt, sizeof(*bt));
+        }
+        break;
+    }
+    return (0);
+}
+
+    /* add a template, which takes over "b" */
+static void binbuf_addtemplate(t_symbol *path, const t_bintemplate *stamp,
+    t_binbuf *b)
+{
+    t_bintemplate *bt = (t_bintemplate *)getbytes(sizeof(*bt));
+    *bt = *stamp;
+    bt->bt_path = path;
+    bt->bt_binbuf = b;
+    bt->bt_next = STUFF->st_bintemplates;
+    STUFF->st_bintemplates = bt;
+}
+
+    /* read a file, or copy it from the template cache.  If "take" is set,
+    the template is handed over and removed from the cache, and a file that
+    had to be read isn't cached.  Return 0 on success. */
+static int binbuf_readtemplate(t_binbuf *b, const char *filename,
+    const char *dirname, int import, int take)
+{
+    char namebuf[MAXPDSTRING];
+    t_symbol *path;
+    t_bintemplate stamp, *bt, **btp;
+
+    if (*dirname)
+        snprintf(namebuf, MAXPDSTRING-1, "%s/%s", dirname, filename);
+    else
+        snprintf(namebuf, MAXPDSTRING-1, "%s", filename);
+    namebuf[MAXPDSTRING-1] = 0;
+    if (binbuf_stampfile(namebuf, &stamp))
+        return (binbuf_read(b, filename, dirname, 0));
+    path = gensym(namebuf);
+    if ((btp = binbuf_findtemplate(path, &stamp, 1)))
+    {
+        bt = *btp;
+        *btp = bt->bt_next;
+        if (take)
+        {
+            t_freebytes(b->b_vec, b->b_n * sizeof(*b->b_vec));
+            *b = *bt->bt_binbuf;
+            t_freebytes(bt->bt_binbuf, sizeof(*bt->bt_binbuf));
+            freebytes(bt, sizeof(*bt));
+            return (0);
+        }
+            /* move to front so that busy files are found quickly */
+        bt->bt_next = STUFF->st_bintemplates;
+        STUFF->st_bintemplates = bt;
+        binbuf_add(b, bt->bt_binbuf->b_n, bt->bt_binbuf->b_vec);
+        return (0);
+    }
+    if (binbuf_read(b, filename, dirname, 0))
+        return (1);
+    if (import)
+    {
+        t_binbuf *newb = binbuf_convert(b, 1);
+        binbuf_clear(b);
+        binbuf_add(b, newb->b_n, newb->b_vec);
+        binbuf_free(newb);
+    }
+    if (!take)
+        binbuf_addtemplate(path, &stamp, binbuf_duplicate(b));
+    return (0);
+}
+
+    /* Prefetching.  To open a big patch faster, glob_evalfile() may first
+    have binbuf_prefetch() read and parse the file and the abstractions it
+    uses, and the ones those use, and so on, on several threads.  They end up
+    in the template cache, so that creating the objects afterward doesn't
+    wait for any files.  Abstractions are looked for beside the file using
+    them and in the global search path.  Paths added by [declare] aren't
+    known yet, so abstractions found there are just read when they're
+    created, as usual. */
+
+#define PREFETCH_MAXTHREADS 16
+
+typedef struct _pffile
+{
+    t_symbol *pf_dir;           /* directory and file name as passed to */
+    t_symbol *pf_name;          /* binbuf_readtemplate() */
+    t_bintemplate pf_stamp;
+    t_binbuf *pf_binbuf;        /* contents if read, else 0 */
+} t_pffile;
+
+typedef struct _prefetch
+{
+#ifdef PDINSTANCE
+    t_pdinstance *p_pd_this;
+#endif
+#if PDTHREADS
+    pthread_mutex_t p_mutex;    /* protects the fields below */
+    pthread_cond_t p_cond;      /* signaled when a file is done */
+#endif
+    t_pffile *p_files;          /* files found so far */
+    int p_nfiles;
+    int p_maxfiles;
+    int p_next;                 /* next file to read */
+    int p_nbusy;                /* files being read */
+    int p_nfound;               /* files read or found in the cache */
+    t_symbol **p_tried;         /* (dir, name) pairs looked up already */
+    int p_ntried;
+    int p_maxtried;
+} t_prefetch;
+
+#if PDTHREADS
+#define prefetch_lock(p) pthread_mutex_lock(&(p)->p_mutex)
+#define prefetch_unlock(p) pthread_mutex_unlock(&(p)->p_mutex)
+#else
+#define prefetch_lock(p)
+#define prefetch_unlock(p)
+#endif
+
+static void prefetch_addfile(t_prefetch *p, t_symbol *dir, t_symbol *name)
+{
+    int i;
+    for (i = 0; i < p->p_nfiles; i++)
+        if (p->p_files[i].pf_dir == dir && p->p_files[i].pf_name == name)
+            return;
+    if (p->p_nfiles == p->p_maxfiles)
+    {
+        p->p_files = (t_pffile *)resizebytes(p->p_files,
+            p->p_maxfiles * sizeof(t_pffile),
+                2 * p->p_maxfiles * sizeof(t_pffile));
+        p->p_maxfiles *= 2;
+    }
+    p->p_files[p->p_nfiles].pf_dir = dir;
+    p->p_files[p->p_nfiles].pf_name = name;
+    p->p_files[p->p_nfiles].pf_binbuf = 0;
+    p->p_nfiles++;
+}
+
+    /* look for a file the way canvas_open() would, minus [declare] paths */
+static int prefetch_open(const char *dir, const char *name, const char *ext,
+    char *dirbuf, char **nameptr)
+{
+    t_namelist *paths[3], *nl;
+    int fd, i;
+    if (!sys_open_absolute(name, ext, dirbuf, nameptr, MAXPDSTRING, 0,
+        &fd))
+    {
+        paths[0] = STUFF->st_searchpath;
+        paths[1] = STUFF->st_temppath;
+        paths[2] = (sys_usestdpath ? STUFF->st_staticpath : 0);
+        fd = sys_trytoopenindexed(dir, name, ext, dirbuf, nameptr,
+            MAXPDSTRING, 0);
+        for (i = 0; i < 3 && fd < 0; i++)
+            for (nl = paths[i]; nl && fd < 0; nl = nl->nl_next)
+                fd = sys_trytoopenindexed(nl->nl_string, name, ext,
+                    dirbuf, nameptr, MAXPDSTRING, 0);
+    }
+    if (fd < 0)
+        return (0);
+    sys_close(fd);
+    return (1);
+}
+
+    /* check whether the abstraction "name" used by a file in "dir" is new
+    and note it if so.  Called with the prefetch locked. */
+static int prefetch_try(t_prefetch *p, t_symbol *dir, t_symbol *name)
+{
+    int i;
+    for (i = 0; i < p->p_ntried; i += 2)
+        if (p->p_tried[i] == dir && p->p_tried[i+1] == name)
+            return (0);
+    if (p->p_ntried == p->p_maxtried)
+    {
+        p->p_tried = (t_symbol **)resizebytes(p->p_tried,
+            p->p_maxtried * sizeof(t_symbol *),
+                2 * p->p_maxtried * sizeof(t_symbol *));
+        p->p_maxtried *= 2;
+    }
+    p->p_tried[p->p_ntried++] = dir;
+    p->p_tried[p->p_ntried++] = name;
+    return (1);
+}
+
+    /* find the file for the abstraction "name" used by a file in "dir".
+    This goes to the file system, so it's called without the lock. */
+static int prefetch_find(t_symbol *dir, t_symbol *name,
+    t_symbol **dirp, t_symbol **namep)
+{
+    char dirbuf[MAXPDSTRING], classslashclass[MAXPDSTRING], *nameptr;
+    snprintf(classslashclass, MAXPDSTRING, "%s/%s", name->s_name,
+        name->s_name);
+    if (prefetch_open(dir->s_name, name->s_name, ".pd", dirbuf, &nameptr) ||
+        prefetch_open(dir->s_name, name->s_name, ".pdc", dirbuf, &nameptr) ||
+        prefetch_open(dir->s_name, classslashclass, ".pd", dirbuf, &nameptr))
+    {
+        *dirp = gensym(dirbuf);
+        *namep = gensym(nameptr);
+        return (1);
+    }
+    return (0);
+}
+
+    /* get the names of the objects in a patch, each once, leaving out
+    known classes.  For [clone], get the name of the abstraction it clones
+    instead.  Returns the number of names; free "*namesp" with "*sizep". */
+static int prefetch_getnames(t_binbuf *b, t_symbol ***namesp, int *sizep)
+{
+    t_atom *ap = b->b_vec, *ep = b->b_vec + b->b_n, *msg;
+    t_symbol *objsym = gensym("obj"), *clonesym = gensym("clone"), *name;
+    t_symbol **names;
+    int size, mask, nnames = 0, argc, i;
+        /* "#X obj x y name;" takes six atoms, so the set stays a third full
+        at most */
+    for (size = 64; size < b->b_n / 2; size *= 2)
+        ;
+    names = (t_symbol **)getbytes(size * sizeof(*names));
+    mask = size - 1;
+    while (ap < ep)
+    {
+        for (msg = ap; ap < ep && ap->a_type != A_SEMI; ap++)
+            ;
+        argc = (int)(ap++ - msg) - 4;
+        if (argc < 1 || msg[0].a_type != A_SYMBOL ||
+            msg[0].a_w.w_symbol != &s__X || msg[1].a_type != A_SYMBOL ||
+            msg[1].a_w.w_symbol != objsym || msg[4].a_type != A_SYMBOL)
+                continue;
+        name = msg[4].a_w.w_symbol;
+        if (name == clonesym)
+        {
+                /* skip flags, then "clone n name" or "clone name n" */
+            t_atom *argv = msg + 5;
+            argc--;
+            while (argc > 0 && argv->a_type == A_SYMBOL &&
+                argv->a_w.w_symbol->s_name[0] == '-')
+            {
+                i = (!strcmp(argv->a_w.w_symbol->s_name, "-s") &&
+                    argc > 1 && argv[1].a_type == A_FLOAT ? 2 : 1);
+                argc -= i, argv += i;
+            }
+            if (argc >= 2 && argv[0].a_type == A_FLOAT &&
+                argv[1].a_type == A_SYMBOL)
+                    name = argv[1].a_w.w_symbol;
+            else if (argc >= 2 && argv[0].a_type == A_SYMBOL)
+                name = argv[0].a_w.w_symbol;
+            else continue;
+        }
+            /* hash the pointer into an open-addressed set */
+        for (i = (int)(((size_t)name >> 4) & mask); names[i] && names[i] != name;
+            i = (i + 1) & mask)
+                ;
+        if (!names[i])
+            names[i] = name, nnames++;
+    }
+    for (i = nnames = 0; i < size; i++)
+        if (names[i] && !sys_isclassname(names[i]))
+            names[nnames++] = names[i];
+    *namesp = names;
+    *sizep = size;
+    return (nnames);
+}
+
+    /* read files until all are done; run by each thread */
+static void *prefetch_work(void *z)
+{
+    t_prefetch *p = (t_prefetch *)z;
+#ifdef PDINSTANCE
+    pd_this = p->p_pd_this;
+#endif
+    prefetch_lock(p);
+    while (p->p_next < p->p_nfiles || p->p_nbusy)
+    {
+        t_symbol *dir, *name, *path, **names = 0, **found = 0;
+        t_bintemplate stamp, **btp;
+        t_binbuf *b = 0, *parsed = 0;
+        int i, j, k = 0, nnames = 0, nfound = 0, size = 0;
+        if (p->p_next == p->p_nfiles)
+        {
+                /* wait for other threads to find more files */
+#if PDTHREADS
+            pthread_cond_wait(&p->p_cond, &p->p_mutex);
+#endif
+            continue;
+        }
+        i = p->p_next++;
+        dir = p->p_files[i].pf_dir;
+        name = p->p_files[i].pf_name;
+        p->p_nbusy++;
+        prefetch_unlock(p);
+
+        path = binbuf_templatepath(name->s_name, dir->s_name);
+        if (!binbuf_stampfile(path->s_name, &stamp))
+        {
+                /* the cache doesn't change until we're done */
+            if ((btp = binbuf_findtemplate(path, &stamp, 0)))
+                parsed = (*btp)->bt_binbuf;
+                /* errors are left for Pd's thread, which reads the file
+                again when it creates the abstraction */
+            else if (!binbuf_doread((b = binbuf_new()), name->s_name,
+                dir->s_name, 0, 1))
+                    parsed = b;
+            else binbuf_free(b), b = 0;
+        }
+        if (parsed)
+            nnames = prefetch_getnames(parsed, &names, &size);
+
+        prefetch_lock(p);
+        if (parsed)
+            p->p_nfound++;
+        if (b)
+        {
+            p->p_files[i].pf_stamp = stamp;
+            p->p_files[i].pf_binbuf = b;
+        }
+            /* keep the names nobody looked up yet, then look them up
+            without the lock and queue what we find */
+        for (j = k = 0; j < nnames; j++)
+            if (prefetch_try(p, dir, names[j]))
+                names[k++] = names[j];
+        prefetch_unlock(p);
+        if (k)
+        {
+            found = (t_symbol **)getbytes(2 * k * sizeof(*found));
+            for (j = 0; j < k; j++)
+                if (prefetch_find(dir, names[j],
+                    &found[2 * nfound], &found[2 * nfound + 1]))
+                        nfound++;
+        }
+        prefetch_lock(p);
+        for (j = 0; j < nfound; j++)
+            prefetch_addfile(p, found[2 * j], found[2 * j + 1]);
+        if (found)
+            freebytes(found, 2 * k * sizeof(*found));
+        if (names)
+            freebytes(names, size * sizeof(*names));
+        p->p_nbusy--;
+#if PDTHREADS
+        pthread_cond_broadcast(&p->p_cond);
+#endif
+    }
+    prefetch_unlock(p);
+    return (0);
+}
+
+    /* read and parse the file "dir/name" and the abstractions it uses on
+    "nthreads" threads into the template cache; see above.  Returns the
+    number of files now in the cache, or 0 if the file itself can't be read
+    (or isn't a ".pd" or ".pdc" file).  If not 0, open the file with
+    binbuf_evalprefetched() afterward. */
+int binbuf_prefetch(t_symbol *name, t_symbol *dir, int nthreads)
+{
+    t_prefetch p;
+    int i, nstarted = 0;
+#if PDTHREADS
+    pthread_t threads[PREFETCH_MAXTHREADS];
+#endif
+    if ((strlen(name->s_name) < 3 ||
+        strcmp(name->s_name + strlen(name->s_name) - 3, ".pd")) &&
+        (strlen(name->s_name) < 4 ||
+            strcmp(name->s_name + strlen(name->s_name) - 4, ".pdc")))
+                return (0);
+#ifdef PDINSTANCE
+    p.p_pd_this = pd_this;
+#endif
+    p.p_maxfiles = 16;
+    p.p_files = (t_pffile *)getbytes(p.p_maxfiles * sizeof(t_pffile));
+    p.p_maxtried = 64;
+    p.p_tried = (t_symbol **)getbytes(p.p_maxtried * sizeof(t_symbol *));
+    p.p_nfiles = p.p_next = p.p_nbusy = p.p_nfound = p.p_ntried = 0;
+    prefetch_addfile(&p, dir, name);
+#if PDTHREADS
+    pthread_mutex_init(&p.p_mutex, 0);
+    pthread_cond_init(&p.p_cond, 0);
+    if (nthreads > PREFETCH_MAXTHREADS)
+        nthreads = PREFETCH_MAXTHREADS;
+        /* verbose lookups post from each thread, so keep them on this one */
+    if (sys_verbose)
+        nthreads = 1;
+    sys_makedirindex();
+    if (nthreads > 1)
+        symtab_setlocked(1);
+    for (; nstarted < nthreads - 1; nstarted++)
+        if (pthread_create(&threads[nstarted], 0, prefetch_work, &p))
+            break;
+#endif
+    prefetch_work(&p);
+#if PDTHREADS
+    for (i = 0; i < nstarted; i++)
+        pthread_join(threads[i], 0);
+    symtab_setlocked(0);
+    pthread_cond_destroy(&p.p_cond);
+    pthread_mutex_destroy(&p.p_mutex);
+#endif
+    for (i = 0; i < p.p_nfiles; i++)
+        if (p.p_files[i].pf_binbuf)
+    {
+        t_symbol *path = binbuf_templatepath(p.p_files[i].pf_name->s_name,
+            p.p_files[i].pf_dir->s_name);
+        t_bintemplate **btp = binbuf_findtemplate(path, 0, 0), *bt;
+        if (btp)
+        {
+            *btp = (bt = *btp)->bt_next;
+            binbuf_free(bt->bt_binbuf);
+            freebytes(bt, sizeof(*bt));
+        }
+        binbuf_addtemplate(path, &p.p_files[i].pf_stamp,
+            p.p_files[i].pf_binbuf);
+    }
+    freebytes(p.p_files, p.p_maxfiles * sizeof(t_pffile));
+    freebytes(p.p_tried, p.p_maxtried * sizeof(t_symbol *));
+    return (p.p_nfound);
+}
+
+    /* cached: 0 to read the file, 1 to use the template cache, 2 to take
+    the file's template out of the cache (for one prefetched) */
+static void binbuf_doevalfile(t_symbol *name, t_symbol *dir, int cached)
 {
     t_binbuf *b = binbuf_new();
     int import = !strcmp(name->s_name + strlen(name->s_name) - 4, ".pat") ||
@@ -1448,15 +2455,16 @@ void binbuf_evalfile(t_symbol *name, t_symbol *dir)
     int dspstate = canvas_suspend_dsp();
         /* set filename so that new canvases can pick them up */
     glob_setfilename(0, name, dir);
-    if (binbuf_read(b, name->s_name, dir->s_name, 0))
-        pd_error(0, "%s: read failed; %s", name->s_name, strerror(errno));
+    if (cached ? binbuf_readtemplate(b, name->s_name, dir->s_name, import,
+        cached == 2) : binbuf_read(b, name->s_name, dir->s_name, 0))
+            pd_error(0, "%s: read failed; %s", name->s_name, strerror(errno));
     else
     {
             /* save bindings of symbols #N, #A (and restore afterward) */
         t_pd *bounda = gensym("#A")->s_thing, *boundn = s__N.s_thing;
         gensym("#A")->s_thing = 0;
         s__N.s_thing = &pd_canvasmaker;
-        if (import)
+        if (import && !cached)
         {
             t_binbuf *newb = binbuf_convert(b, 1);
             binbuf_free(b);
@@ -1474,6 +2482,23 @@ void binbuf_evalfile(t_symbol *name, t_symbol *dir)
     canvas_resume_dsp(dspstate);
 }
 
+void binbuf_evalfile(t_symbol *name, t_symbol *dir)
+{
+    binbuf_doevalfile(name, dir, 0);
+}
+
+    /* same, but use the template cache; for abstractions */
+void binbuf_evaltemplate(t_symbol *name, t_symbol *dir)
+{
+    binbuf_doevalfile(name, dir, 1);
+}
+
+    /* same for a file read by binbuf_prefetch(), which isn't kept */
+void binbuf_evalprefetched(t_symbol *name, t_symbol *dir)
+{
+    binbuf_doevalfile(name, dir, 2);
+}
+
     /* save a text object to a binbuf for a file or copy buf */
 void binbuf_savetext(const t_binbuf *bfrom, t_binbuf *bto)
 {
@@ -18,6 +18,9 @@
 #include <stdarg.h>
 #include <string.h>
 #include <stdio.h>
+#if PDTHREADS
+#include <pthread.h>
+#endif
 
 #include "m_private_utils.h"
 
@@ -42,6 +45,13 @@ t_pdinstance pd_maininstance;
 
 static t_symbol *dogensym(const char *s, t_symbol *oldsym,
     t_pdinstance *pdinstance);
+static void symtab_new(t_pdinstance *pdinstance);
+#ifdef PDINSTANCE
+static void symtab_free(t_pdinstance *pdinstance);
+#endif
+t_binbuf *textbuf_getbinbuf(t_pd *x);
+int clone_get_n(t_gobj *x);
+t_glist *clone_get_instance_raw(t_gobj *x, int n);
 void x_midi_newpdinstance( void);
 void x_midi_freepdinstance( void);
 void s_inter_newpdinstance( void);
@@ -50,6 +60,8 @@ void g_canvas_newpdinstance( void);
 void g_canvas_freepdinstance( void);
 void d_ugen_newpdinstance( void);
 void d_ugen_freepdinstance( void);
+void mayer_freeplans( void);
+void soundfiler_freebatches( void);
 void new_anything(void *dummy, t_symbol *s, int argc, t_atom *argv);
 
 void s_stuff_newpdinstance(void)
@@ -61,23 +73,29 @@ void s_stuff_newpdinstance(void)
     STUFF->st_dacsr = DEFDACSAMPLERATE;
     STUFF->st_printhook = sys_printhook;
     STUFF->st_impdata = NULL;
+    STUFF->st_fftplans = 0;
+    STUFF->st_clocksetcount = 0;
+    STUFF->st_dirindex = 0;
+    STUFF->st_bintemplates = 0;
+    STUFF->st_loadthreads = 0;
+    memset(&STUFF->st_loadtimes, 0, sizeof(STUFF->st_loadtimes));
+    STUFF->st_sfbatches = 0;
 }
 
 void s_stuff_freepdinstance(void)
 {
+    sys_flushdirindex();
+    binbuf_flushtemplates(0);
     freebytes(STUFF, sizeof(*STUFF));
 }
 
 static t_pdinstance *pdinstance_init(t_pdinstance *x)
 {
-    int i;
     x->pd_systime = 0;
     x->pd_clock_setlist = 0;
     x->pd_canvaslist = 0;
     x->pd_templatelist = 0;
-    x->pd_symhash = getbytes(SYMTABHASHSIZE * sizeof(*x->pd_symhash));
-    for (i = 0; i < SYMTABHASHSIZE; i++)
-        x->pd_symhash[i] = 0;
+    symtab_new(x);
 #ifdef PDINSTANCE
     dogensym("pointer",   &x->pd_s_pointer,  x);
     dogensym("float",     &x->pd_s_float,    x);
@@ -195,7 +213,6 @@ EXTERN t_pdinstance *pdinstance_new(void)
 
 EXTERN void pdinstance_free(t_pdinstance *x)
 {
-    t_symbol *s;
     t_canvas *canvas;
     int i, instanceno;
     t_class *c;
@@ -211,6 +228,7 @@ EXTERN void pdinstance_free(t_pdinstance *x)
         pd_free((t_pd *)x->pd_canvaslist);
     while (x->pd_templatelist)
         pd_free((t_pd *)x->pd_templatelist);
+    soundfiler_freebatches();
     for (c = class_list; c; c = c->c_next)
     {
         if(c->c_methods[instanceno])
@@ -223,34 +241,12 @@ EXTERN void pdinstance_free(t_pdinstance *x)
             pd_ninstances * sizeof(*c->c_methods),
             (pd_ninstances - 1) * sizeof(*c->c_methods));
     }
-    for (i =0; i < SYMTABHASHSIZE; i++)
-    {
-        while ((s = x->pd_symhash[i]))
-        {
-            x->pd_symhash[i] = s->s_next;
-            if(s != &x->pd_s_pointer &&
-               s != &x->pd_s_float &&
-               s != &x->pd_s_symbol &&
-               s != &x->pd_s_bang &&
-               s != &x->pd_s_list &&
-               s != &x->pd_s_anything &&
-               s != &x->pd_s_signal &&
-               s != &x->pd_s__N &&
-               s != &x->pd_s__X &&
-               s != &x->pd_s_x &&
-               s != &x->pd_s_y &&
-               s != &x->pd_s_)
-            {
-                freebytes((void *)s->s_name, strlen(s->s_name)+1);
-                freebytes(s, sizeof(*s));
-            }
-        }
-    }
-    freebytes(x->pd_symhash, SYMTABHASHSIZE * sizeof (*x->pd_symhash));
     x_midi_freepdinstance();
     g_canvas_freepdinstance();
     d_ugen_freepdinstance();
+    mayer_freeplans();
     s_stuff_freepdinstance();
+    symtab_free(x);
     for (i = instanceno; i < pd_ninstances-1; i++)
         pd_instances[i] = pd_instances[i+1];
     pd_instances = (t_pdinstance **)resizebytes(pd_instances,
@@ -843,37 +839,437 @@ t_propertiesfn class_getpropertiesfn(const t_class *c)
 
 /* ---------------- the symbol table ------------------------ */
 
-static t_symbol *dogensym(const char *s, t_symbol *oldsym,
-    t_pdinstance *pdinstance)
+    /* Each instance keeps its symbols in an open-addressed hash table with
+    linear probing.  Slots store the hash beside the symbol, so probing and
+    growing don't have to touch the symbols, and the table doubles in size
+    when half full.  Symbols never move; a new symbol and its name share one
+    allocation.
+
+    Normally symbols are never freed either.  In "transient" mode, symbols
+    that the application creates through gensym_transient() (libpd does for
+    symbols it sends) are marked as such and retired by symtab_collect() once
+    nothing is bound to them and no object box, message box or [text] buffer
+    holds them.  Objects may still keep them privately (the value of a
+    [symbol] box, a [list store], a scalar's symbol field...), so a retired
+    symbol is only moved to a second table: it keeps its address, and looking
+    the name up again brings the same symbol back.  Retired symbols are freed
+    when no patch is open any more, since then nothing can refer to them.
+    As soon as Pd itself asks for a transient name with gensym() the symbol
+    becomes permanent. */
+
+#define SYMTAB_TRANSIENT 1      /* may be collected */
+#define SYMTAB_MARK 2           /* found in use while collecting */
+
+typedef struct _symentry
+{
+    t_symbol *se_sym;
+    unsigned int se_hash;
+    unsigned int se_flags;
+} t_symentry;
+
+struct _symtab
+{
+    t_symentry *st_vec;
+    int st_size;                /* number of slots, a power of two */
+    int st_shift;               /* 32 - log2(st_size) */
+    int st_count;               /* number of symbols */
+    int st_ntransient;          /* how many of them are transient */
+    int st_transientmode;       /* make gensym_transient() symbols transient */
+    int st_locked;              /* lock for each lookup, see symtab_setlocked() */
+#if PDTHREADS
+    pthread_mutex_t st_mutex;   /* the lock, one per instance */
+#endif
+    size_t st_bytes;            /* memory taken by symbols and names */
+    size_t st_created;          /* symbols created so far */
+    struct _symtab *st_retired; /* collected symbols, or 0 */
+};
+
+#define SYMTABRETIREDSIZE 64    /* initial size of the retired table */
+
+    /* spread djb2 hashes, which differ little for names like "foo1" and
+    "foo2", over the table (Fibonacci hashing) */
+#define SYMTAB_SLOT(st, hash) \
+    ((int)(((hash) * 2654435769u) >> (st)->st_shift))
+
+static unsigned int symtab_hash(const char *s, int *length)
 {
-    char *symname = 0;
-    t_symbol **symhashloc, *sym2;
     unsigned int hash = 5381;
-    int length = 0;
     const char *s2 = s;
     while (*s2) /* djb2 hash algo */
     {
         hash = ((hash << 5) + hash) + *s2;
-        length++;
         s2++;
     }
-    symhashloc = pdinstance->pd_symhash + (hash & (SYMTABHASHSIZE-1));
-    while ((sym2 = *symhashloc))
+    *length = (int)(s2 - s);
+    return (hash);
+}
+
+static void symtab_resize(struct _symtab *st, int size)
+{
+    t_symentry *oldvec = st->st_vec;
+    int i, oldsize = st->st_size, mask = size - 1;
+    st->st_vec = (t_symentry *)getbytes(size * sizeof(t_symentry));
+    st->st_size = size;
+    for (st->st_shift = 32; size > 1; size >>= 1)
+        st->st_shift--;
+    for (i = 0; i < oldsize; i++)
+        if (oldvec[i].se_sym)
+    {
+        int j = SYMTAB_SLOT(st, oldvec[i].se_hash);
+        while (st->st_vec[j].se_sym)
+            j = (j + 1) & mask;
+        st->st_vec[j] = oldvec[i];
+    }
+    if (oldvec)
+        freebytes(oldvec, oldsize * sizeof(t_symentry));
+}
+
+static void symtab_new(t_pdinstance *pdinstance)
+{
+    struct _symtab *st = (struct _symtab *)getbytes(sizeof(*st));
+    st->st_vec = 0;
+    st->st_size = st->st_count = st->st_ntransient = 0;
+    st->st_transientmode = st->st_locked = 0;
+    st->st_bytes = st->st_created = 0;
+    st->st_retired = 0;
+#if PDTHREADS
+    pthread_mutex_init(&st->st_mutex, 0);
+#endif
+    symtab_resize(st, SYMTABHASHSIZE);
+    pdinstance->pd_symtab = st;
+}
+
+    /* move a collected symbol to the retired table */
+static void symtab_retire(struct _symtab *st, t_symentry *se)
+{
+    struct _symtab *rt = st->st_retired;
+    int i, mask;
+    if (!rt)
+    {
+        rt = st->st_retired = (struct _symtab *)getbytes(sizeof(*rt));
+        symtab_resize(rt, SYMTABRETIREDSIZE);
+    }
+    mask = rt->st_size - 1;
+    for (i = SYMTAB_SLOT(rt, se->se_hash); rt->st_vec[i].se_sym;
+        i = (i + 1) & mask)
+            ;
+    rt->st_vec[i].se_sym = se->se_sym;
+    rt->st_vec[i].se_hash = se->se_hash;
+    rt->st_vec[i].se_flags = 0;
+    if (2 * ++rt->st_count > rt->st_size)
+        symtab_resize(rt, 2 * rt->st_size);
+}
+
+    /* take a retired symbol out of the retired table, or return 0 */
+static t_symbol *symtab_revive(struct _symtab *st, const char *s,
+    unsigned int hash)
+{
+    struct _symtab *rt = st->st_retired;
+    t_symbol *sym;
+    int i, j, mask;
+    if (!rt || !rt->st_count)
+        return (0);
+    mask = rt->st_size - 1;
+    for (i = SYMTAB_SLOT(rt, hash); (sym = rt->st_vec[i].se_sym);
+        i = (i + 1) & mask)
+            if (rt->st_vec[i].se_hash == hash && !strcmp(sym->s_name, s))
+                break;
+    if (!sym)
+        return (0);
+        /* empty the slot, moving later entries of the probe sequence back
+        unless that would put them before their home slot */
+    rt->st_vec[i].se_sym = 0;
+    for (j = (i + 1) & mask; rt->st_vec[j].se_sym; j = (j + 1) & mask)
     {
-        if (!strcmp(sym2->s_name, s))
-            return(sym2);
-        symhashloc = &sym2->s_next;
+        int k = SYMTAB_SLOT(rt, rt->st_vec[j].se_hash);
+        if (j > i ? (k <= i || k > j) : (k <= i && k > j))
+        {
+            rt->st_vec[i] = rt->st_vec[j];
+            rt->st_vec[j].se_sym = 0;
+            i = j;
+        }
+    }
+    rt->st_count--;
+    return (sym);
+}
+
+    /* free the retired symbols */
+static void symtab_freeretired(struct _symtab *st)
+{
+    struct _symtab *rt = st->st_retired;
+    int i;
+    if (!rt)
+        return;
+    for (i = 0; i < rt->st_size; i++)
+    {
+        t_symbol *s = rt->st_vec[i].se_sym;
+        if (s)
+        {
+            size_t bytes = sizeof(*s) + strlen(s->s_name) + 1;
+            freebytes(s, bytes);
+            st->st_bytes -= bytes;
+        }
+    }
+    freebytes(rt->st_vec, rt->st_size * sizeof(t_symentry));
+    freebytes(rt, sizeof(*rt));
+    st->st_retired = 0;
+}
+
+#ifdef PDINSTANCE
+    /* free all symbols; the built-in ones are part of the instance (or
+    static) and only their names are freed */
+static void symtab_free(t_pdinstance *pdinstance)
+{
+    struct _symtab *st = pdinstance->pd_symtab;
+    int i;
+    symtab_freeretired(st);
+    for (i = 0; i < st->st_size; i++)
+    {
+        t_symbol *s = st->st_vec[i].se_sym;
+        if (!s)
+            continue;
+        if (s->s_name == (const char *)(s + 1))
+            freebytes(s, sizeof(*s) + strlen(s->s_name) + 1);
+        else freebytes((void *)s->s_name, strlen(s->s_name) + 1);
+    }
+    freebytes(st->st_vec, st->st_size * sizeof(t_symentry));
+#if PDTHREADS
+    pthread_mutex_destroy(&st->st_mutex);
+#endif
+    freebytes(st, sizeof(*st));
+    pdinstance->pd_symtab = 0;
+}
+#endif /* PDINSTANCE */
+
+static t_symbol *symtab_dolookup(const char *s, t_symbol *oldsym,
+    t_pdinstance *pdinstance, int transient)
+{
+    struct _symtab *st = pdinstance->pd_symtab;
+    t_symentry *se;
+    t_symbol *sym;
+    int length, i, mask = st->st_size - 1;
+    unsigned int hash = symtab_hash(s, &length);
+    for (i = SYMTAB_SLOT(st, hash); (sym = (se = &st->st_vec[i])->se_sym);
+        i = (i + 1) & mask)
+            if (se->se_hash == hash && !strcmp(sym->s_name, s))
+    {
+        if ((se->se_flags & SYMTAB_TRANSIENT) && !transient)
+        {
+            se->se_flags &= ~SYMTAB_TRANSIENT;
+            st->st_ntransient--;
+        }
+        return (sym);
+    }
+    if (!oldsym && (sym = symtab_revive(st, s, hash)))
+    {
+        se->se_sym = sym;
+        se->se_hash = hash;
+        se->se_flags = 0;
+        if (transient && st->st_transientmode)
+        {
+            se->se_flags = SYMTAB_TRANSIENT;
+            st->st_ntransient++;
+        }
+        if (2 * ++st->st_count > st->st_size)
+            symtab_resize(st, 2 * st->st_size);
+        return (sym);
     }
     if (oldsym)
-        sym2 = oldsym;
-    else sym2 = (t_symbol *)t_getbytes(sizeof(*sym2));
-    symname = t_getbytes(length+1);
-    sym2->s_next = 0;
-    sym2->s_thing = 0;
-    strcpy(symname, s);
-    sym2->s_name = symname;
-    *symhashloc = sym2;
-    return (sym2);
+    {
+        char *symname = t_getbytes(length+1);
+        strcpy(symname, s);
+        sym = oldsym;
+        sym->s_name = symname;
+        st->st_bytes += length + 1;
+    }
+    else
+    {
+        sym = (t_symbol *)t_getbytes(sizeof(*sym) + length + 1);
+        strcpy((char *)(sym + 1), s);
+        sym->s_name = (char *)(sym + 1);
+        st->st_bytes += sizeof(*sym) + length + 1;
+    }
+    sym->s_next = 0;
+    sym->s_thing = 0;
+    se->se_sym = sym;
+    se->se_hash = hash;
+    se->se_flags = 0;
+    if (transient && st->st_transientmode && !oldsym)
+    {
+        se->se_flags = SYMTAB_TRANSIENT;
+        st->st_ntransient++;
+    }
+    st->st_created++;
+    if (2 * ++st->st_count > st->st_size)
+        symtab_resize(st, 2 * st->st_size);
+    return (sym);
+}
+
+static t_symbol *symtab_lookup(const char *s, t_symbol *oldsym,
+    t_pdinstance *pdinstance, int transient)
+{
+#if PDTHREADS
+    if (pdinstance->pd_symtab->st_locked)
+    {
+        t_symbol *sym;
+        pthread_mutex_lock(&pdinstance->pd_symtab->st_mutex);
+        sym = symtab_dolookup(s, oldsym, pdinstance, transient);
+        pthread_mutex_unlock(&pdinstance->pd_symtab->st_mutex);
+        return (sym);
+    }
+#endif
+    return (symtab_dolookup(s, oldsym, pdinstance, transient));
+}
+
+    /* let other threads call gensym() for this instance while "flag" is
+    set, for reading files in parallel (see binbuf_prefetch()) */
+void symtab_setlocked(int flag)
+{
+    pd_this->pd_symtab->st_locked = (flag != 0);
+}
+
+static t_symbol *dogensym(const char *s, t_symbol *oldsym,
+    t_pdinstance *pdinstance)
+{
+    return (symtab_lookup(s, oldsym, pdinstance, 0));
+}
+
+    /* get a symbol for the application, which may be collected if
+    transient mode is on (see above) */
+t_symbol *gensym_transient(const char *s)
+{
+    return (symtab_lookup(s, 0, pd_this, 1));
+}
+
+void symtab_settransient(int flag)
+{
+    pd_this->pd_symtab->st_transientmode = (flag != 0);
+}
+
+static void symtab_mark(struct _symtab *st, t_symbol *sym)
+{
+    int length, i, mask = st->st_size - 1;
+    unsigned int hash = symtab_hash(sym->s_name, &length);
+    for (i = SYMTAB_SLOT(st, hash); st->st_vec[i].se_sym; i = (i + 1) & mask)
+        if (st->st_vec[i].se_sym == sym)
+    {
+        st->st_vec[i].se_flags |= SYMTAB_MARK;
+        return;
+    }
+}
+
+static void symtab_markatoms(struct _symtab *st, t_binbuf *b)
+{
+    int n = binbuf_getnatom(b);
+    t_atom *ap = binbuf_getvec(b);
+    for (; n--; ap++)
+        if (ap->a_type == A_SYMBOL || ap->a_type == A_DOLLSYM)
+            symtab_mark(st, ap->a_w.w_symbol);
+}
+
+static void symtab_markglist(struct _symtab *st, t_glist *gl)
+{
+    t_gobj *y;
+    for (y = gl->gl_list; y; y = y->g_next)
+    {
+        t_object *ob = pd_checkobject(&y->g_pd);
+        t_binbuf *b;
+        int i, n;
+        if (ob && ob->te_binbuf)
+            symtab_markatoms(st, ob->te_binbuf);
+        if ((b = textbuf_getbinbuf(&y->g_pd)))
+            symtab_markatoms(st, b);
+        if (pd_class(&y->g_pd) == canvas_class)
+            symtab_markglist(st, (t_glist *)y);
+        else for (i = 0, n = clone_get_n(y); i < n; i++)
+            symtab_markglist(st, clone_get_instance_raw(y, i));
+    }
+}
+
+    /* is any patch open, other than the built-in templates? */
+static int symtab_patchesopen(void)
+{
+    t_canvas *x;
+    for (x = pd_getcanvaslist(); x; x = x->gl_next)
+        if (strcmp(x->gl_name->s_name, "_float_template") &&
+            strcmp(x->gl_name->s_name, "_float_array_template") &&
+                strcmp(x->gl_name->s_name, "_text_template"))
+                    return (1);
+    return (0);
+}
+
+    /* retire transient symbols that are neither bound nor found in any
+    patch (see above), and shrink the table if it got sparse.  Returns the
+    number of symbols retired. */
+int symtab_collect(void)
+{
+    struct _symtab *st = pd_this->pd_symtab;
+    t_canvas *gl;
+    int i, nretired = 0, size, patchesopen = symtab_patchesopen();
+    if (!patchesopen)
+        symtab_freeretired(st);
+    if (!st->st_ntransient)
+        return (0);
+    for (gl = pd_getcanvaslist(); gl; gl = gl->gl_next)
+        symtab_markglist(st, gl);
+    for (i = 0; i < st->st_size; i++)
+    {
+        t_symentry *se = &st->st_vec[i];
+        if (se->se_flags == SYMTAB_TRANSIENT && !se->se_sym->s_thing)
+        {
+            if (patchesopen)
+                symtab_retire(st, se);
+            else
+            {
+                size_t bytes = sizeof(t_symbol) +
+                    strlen(se->se_sym->s_name) + 1;
+                freebytes(se->se_sym, bytes);
+                st->st_bytes -= bytes;
+            }
+            se->se_sym = 0;
+            se->se_flags = 0;
+            nretired++;
+        }
+        else se->se_flags &= ~SYMTAB_MARK;
+    }
+    st->st_count -= nretired;
+    st->st_ntransient -= nretired;
+    if (nretired)
+    {
+            /* reinsert to close the gaps, at half load or less */
+        for (size = st->st_size; size > SYMTABHASHSIZE &&
+            4 * st->st_count <= size; size >>= 1)
+                ;
+        symtab_resize(st, size);
+    }
+    return (nretired);
+}
+
+    /* call "fn" for each symbol of this instance; "fn" mustn't create
+    symbols */
+void symtab_foreach(void (*fn)(t_symbol *s, void *data), void *data)
+{
+    struct _symtab *st = pd_this->pd_symtab;
+    int i;
+    for (i = 0; i < st->st_size; i++)
+        if (st->st_vec[i].se_sym)
+            (*fn)(st->st_vec[i].se_sym, data);
+}
+
+    /* statistics for this instance: number of symbols, memory they take
+    including the table, symbols created so far, and how many symbols are
+    transient */
+void symtab_getstats(int *count, size_t *bytes, size_t *created,
+    int *ntransient)
+{
+    struct _symtab *st = pd_this->pd_symtab;
+    *count = st->st_count;
+    *bytes = st->st_bytes + st->st_size * sizeof(t_symentry) + sizeof(*st);
+    if (st->st_retired)
+        *bytes += st->st_retired->st_size * sizeof(t_symentry) +
+            sizeof(*st->st_retired);
+    *created = st->st_created;
+    *ntransient = st->st_ntransient;
 }
 
 t_symbol *gensym(const char *s)
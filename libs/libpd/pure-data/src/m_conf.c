@@ -50,6 +50,7 @@ void d_global_setup(void);
 void d_math_setup(void);
 void d_misc_setup(void);
 void d_osc_setup(void);
+void d_partconv_setup(void);
 void d_soundfile_setup(void);
 void d_ugen_setup(void);
 
@@ -100,6 +101,7 @@ void conf_init(void)
     d_math_setup();
     d_misc_setup();
     d_osc_setup();
+    d_partconv_setup();
     d_soundfile_setup();
     d_ugen_setup();
 }
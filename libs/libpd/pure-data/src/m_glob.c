@@ -31,6 +31,7 @@ void glob_midi_setapi(t_pd *dummy, t_floatarg f);
 void glob_start_path_dialog(t_pd *dummy, t_floatarg flongform);
 void glob_path_dialog(t_pd *dummy, t_symbol *s, int argc, t_atom *argv);
 void glob_addtopath(t_pd *dummy, t_symbol *path, t_float saveit);
+void sys_flushdirindex(void);
 void glob_start_startup_dialog(t_pd *dummy, t_floatarg flongform);
 void glob_startup_dialog(t_pd *dummy, t_symbol *s, int argc, t_atom *argv);
 void glob_ping(t_pd *dummy);
@@ -91,6 +92,13 @@ static void glob_perf(t_pd *dummy, t_float f)
     sys_perf = (f != 0);
 }
 
+    /* forget cached directory listings, e.g., after files were added to
+    the search path from outside Pd */
+static void glob_rescanpaths(t_pd *dummy)
+{
+    sys_flushdirindex();
+}
+
 void max_default(t_pd *x, t_symbol *s, int argc, t_atom *argv)
 {
     int i;
@@ -163,6 +171,8 @@ void glob_init(void)
         gensym("path-dialog"), A_GIMME, 0);
     class_addmethod(glob_pdobject, (t_method)glob_addtopath,
         gensym("add-to-path"), A_SYMBOL, A_DEFFLOAT, 0);
+    class_addmethod(glob_pdobject, (t_method)glob_rescanpaths,
+        gensym("rescan-paths"), 0);
     class_addmethod(glob_pdobject, (t_method)glob_start_startup_dialog,
         gensym("start-startup-dialog"), 0);
     class_addmethod(glob_pdobject, (t_method)glob_startup_dialog,
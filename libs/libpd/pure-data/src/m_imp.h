@@ -65,6 +65,9 @@ struct _class
 /* m_pd.c */
 EXTERN void pd_init_systems(void);
 EXTERN void pd_term_systems(void);
+EXTERN int pd_unbindowned(int (*owned)(void *x, void *data), void *data,
+    t_pd ***whop, t_symbol ***symp);
+EXTERN void pd_rebind(t_pd **who, t_symbol **sym, int n);
 
 /* m_class.c */
 EXTERN void pd_emptylist(t_pd *x);
@@ -94,9 +97,16 @@ void pd_globallock(void);
 void pd_globalunlock(void);
 
 /* misc */
-#ifndef SYMTABHASHSIZE  /* set this to, say, 1024 for small memory footprint */
-#define SYMTABHASHSIZE 16384
+#ifndef SYMTABHASHSIZE  /* initial symbol table size (a power of 2), grows */
+#define SYMTABHASHSIZE 1024
 #endif /* SYMTABHASHSIZE */
+EXTERN void symtab_getstats(int *count, size_t *bytes, size_t *created,
+    int *ntransient);
+EXTERN t_symbol *gensym_transient(const char *s);
+EXTERN void symtab_settransient(int flag);
+EXTERN int symtab_collect(void);
+EXTERN void symtab_setlocked(int flag);
+EXTERN void symtab_foreach(void (*fn)(t_symbol *s, void *data), void *data);
 
 EXTERN t_pd *glob_evalfile(t_pd *ignore, t_symbol *name, t_symbol *dir);
 EXTERN void glob_initfromgui(void *dummy, t_symbol *s, int argc, t_atom *argv);
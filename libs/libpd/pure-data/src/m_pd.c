@@ -5,6 +5,7 @@
 #include "m_pd.h"
 #include "m_imp.h"
 #include "g_canvas.h"   /* just for LB_LOAD */
+#include <string.h>
 
     /* FIXME no out-of-memory testing yet! */
 
@@ -50,64 +51,140 @@ void gobj_save(t_gobj *x, t_binbuf *b)
 
 /* deal with several objects bound to the same symbol.  If more than one, we
 actually bind a collection object to the symbol, which forwards messages sent
-to the symbol. */
+to the symbol.
 
-static t_class *bindlist_class;
+The objects are kept in an array, oldest first, and messages go to the newest
+first.  An object may unbind (or be freed) while a message is being forwarded,
+so while that's going on, unbinding only clears the object's slot; the array
+is compacted, and the bindlist replaced by its single remaining object if
+that's what's left, once the outermost message is done.  Objects bound while
+a message is being forwarded don't get it. */
 
-typedef struct _bindelem
-{
-    t_pd *e_who;
-    struct _bindelem *e_next;
-} t_bindelem;
+static t_class *bindlist_class;
 
 typedef struct _bindlist
 {
     t_pd b_pd;
-    t_bindelem *b_list;
+    t_symbol *b_sym;        /* the symbol we're bound to */
+    t_pd **b_vec;           /* bound objects; 0 if unbound while busy */
+    int b_n;
+    int b_size;
+    int b_busy;             /* nesting depth of messages being forwarded */
+    int b_ncleared;         /* slots cleared while busy */
 } t_bindlist;
 
+static void bindlist_add(t_bindlist *x, t_pd *who)
+{
+    if (x->b_n == x->b_size)
+    {
+        x->b_vec = (t_pd **)resizebytes(x->b_vec,
+            x->b_size * sizeof(t_pd *), 2 * x->b_size * sizeof(t_pd *));
+        x->b_size *= 2;
+    }
+    x->b_vec[x->b_n++] = who;
+}
+
+    /* when no message is being forwarded, squeeze out cleared slots and
+    get rid of the bindlist if it's down to one object (or none) */
+static void bindlist_tidy(t_bindlist *x)
+{
+    int i, n;
+    if (x->b_busy)
+        return;
+    if (x->b_ncleared)
+    {
+        for (i = n = 0; i < x->b_n; i++)
+            if (x->b_vec[i])
+                x->b_vec[n++] = x->b_vec[i];
+        x->b_n = n;
+        x->b_ncleared = 0;
+    }
+    if (x->b_n < 2)
+    {
+        x->b_sym->s_thing = (x->b_n ? x->b_vec[0] : 0);
+        freebytes(x->b_vec, x->b_size * sizeof(t_pd *));
+        pd_free(&x->b_pd);
+    }
+    else if (x->b_size > 8 && x->b_n < x->b_size / 4)
+    {
+        x->b_vec = (t_pd **)resizebytes(x->b_vec,
+            x->b_size * sizeof(t_pd *), (x->b_size / 2) * sizeof(t_pd *));
+        x->b_size /= 2;
+    }
+}
+
 static void bindlist_bang(t_bindlist *x)
 {
-    t_bindelem *e;
-    for (e = x->b_list; e; e = e->e_next)
-        pd_bang(e->e_who);
+    int i;
+    t_pd *who;
+    x->b_busy++;
+    for (i = x->b_n; i--; )
+        if ((who = x->b_vec[i]))
+            pd_bang(who);
+    x->b_busy--;
+    bindlist_tidy(x);
 }
 
 static void bindlist_float(t_bindlist *x, t_float f)
 {
-    t_bindelem *e;
-    for (e = x->b_list; e; e = e->e_next)
-        pd_float(e->e_who, f);
+    int i;
+    t_pd *who;
+    x->b_busy++;
+    for (i = x->b_n; i--; )
+        if ((who = x->b_vec[i]))
+            pd_float(who, f);
+    x->b_busy--;
+    bindlist_tidy(x);
 }
 
 static void bindlist_symbol(t_bindlist *x, t_symbol *s)
 {
-    t_bindelem *e;
-    for (e = x->b_list; e; e = e->e_next)
-        pd_symbol(e->e_who, s);
+    int i;
+    t_pd *who;
+    x->b_busy++;
+    for (i = x->b_n; i--; )
+        if ((who = x->b_vec[i]))
+            pd_symbol(who, s);
+    x->b_busy--;
+    bindlist_tidy(x);
 }
 
 static void bindlist_pointer(t_bindlist *x, t_gpointer *gp)
 {
-    t_bindelem *e;
-    for (e = x->b_list; e; e = e->e_next)
-        pd_pointer(e->e_who, gp);
+    int i;
+    t_pd *who;
+    x->b_busy++;
+    for (i = x->b_n; i--; )
+        if ((who = x->b_vec[i]))
+            pd_pointer(who, gp);
+    x->b_busy--;
+    bindlist_tidy(x);
 }
 
 static void bindlist_list(t_bindlist *x, t_symbol *s,
     int argc, t_atom *argv)
 {
-    t_bindelem *e;
-    for (e = x->b_list; e; e = e->e_next)
-        pd_list(e->e_who, s, argc, argv);
+    int i;
+    t_pd *who;
+    x->b_busy++;
+    for (i = x->b_n; i--; )
+        if ((who = x->b_vec[i]))
+            pd_list(who, s, argc, argv);
+    x->b_busy--;
+    bindlist_tidy(x);
 }
 
 static void bindlist_anything(t_bindlist *x, t_symbol *s,
     int argc, t_atom *argv)
 {
-    t_bindelem *e;
-    for (e = x->b_list; e; e = e->e_next)
-        pd_typedmess(e->e_who, s, argc, argv);
+    int i;
+    t_pd *who;
+    x->b_busy++;
+    for (i = x->b_n; i--; )
+        if ((who = x->b_vec[i]))
+            pd_typedmess(who, s, argc, argv);
+    x->b_busy--;
+    bindlist_tidy(x);
 }
 
 void m_pd_setup(void)
@@ -127,23 +204,17 @@ void pd_bind(t_pd *x, t_symbol *s)
     if (s->s_thing)
     {
         if (*s->s_thing == bindlist_class)
-        {
-            t_bindlist *b = (t_bindlist *)s->s_thing;
-            t_bindelem *e = (t_bindelem *)getbytes(sizeof(t_bindelem));
-            e->e_next = b->b_list;
-            e->e_who = x;
-            b->b_list = e;
-        }
+            bindlist_add((t_bindlist *)s->s_thing, x);
         else
         {
             t_bindlist *b = (t_bindlist *)pd_new(bindlist_class);
-            t_bindelem *e1 = (t_bindelem *)getbytes(sizeof(t_bindelem));
-            t_bindelem *e2 = (t_bindelem *)getbytes(sizeof(t_bindelem));
-            b->b_list = e1;
-            e1->e_who = x;
-            e1->e_next = e2;
-            e2->e_who = s->s_thing;
-            e2->e_next = 0;
+            b->b_sym = s;
+            b->b_size = 4;
+            b->b_vec = (t_pd **)getbytes(b->b_size * sizeof(t_pd *));
+            b->b_vec[0] = s->s_thing;
+            b->b_vec[1] = x;
+            b->b_n = 2;
+            b->b_busy = b->b_ncleared = 0;
             s->s_thing = &b->b_pd;
         }
     }
@@ -155,39 +226,120 @@ void pd_unbind(t_pd *x, t_symbol *s)
     if (s->s_thing == x) s->s_thing = 0;
     else if (s->s_thing && *s->s_thing == bindlist_class)
     {
-            /* bindlists always have at least two elements... if the number
-            goes down to one, get rid of the bindlist and bind the symbol
-            straight to the remaining element. */
-
+            /* remove the newest binding of x, which is the one that
+            used to be found first */
         t_bindlist *b = (t_bindlist *)s->s_thing;
-        t_bindelem *e, *e2;
-        if ((e = b->b_list)->e_who == x)
-        {
-            b->b_list = e->e_next;
-            e->e_who = 0; e->e_next = 0;
-            freebytes(e, sizeof(t_bindelem));
-        }
-        else for (e = b->b_list; (e2 = e->e_next); e = e2)
-            if (e2->e_who == x)
+        int i;
+        for (i = b->b_n; i--; )
+            if (b->b_vec[i] == x)
+                break;
+        if (i < 0)
+            pd_error(x, "%s: couldn't unbind", s->s_name);
+        else if (b->b_busy)
         {
-            e->e_next = e2->e_next;
-            e2->e_who = 0; e2->e_next = 0;
-            freebytes(e2, sizeof(t_bindelem));
-            break;
+            b->b_vec[i] = 0;
+            b->b_ncleared++;
         }
-        if (!b->b_list->e_next)
+        else
         {
-
-            s->s_thing = b->b_list->e_who;
-            freebytes(b->b_list, sizeof(t_bindelem));
-            b->b_list = 0;
-            pd_free(&b->b_pd);
-            b = 0;
+            memmove(b->b_vec + i, b->b_vec + i + 1,
+                (b->b_n - i - 1) * sizeof(t_pd *));
+            b->b_n--;
+            bindlist_tidy(b);
         }
     }
     else pd_error(x, "%s: couldn't unbind", s->s_name);
 }
 
+    /* collect the bindings of objects that satisfy "owned" */
+typedef struct _bindsearch
+{
+    int (*b_owned)(void *x, void *data);
+    void *b_data;
+    t_pd **b_who;
+    t_symbol **b_sym;
+    int b_n;
+    int b_size;
+} t_bindsearch;
+
+static void bindsearch_add(t_bindsearch *x, t_pd *who, t_symbol *s)
+{
+    if (!(*x->b_owned)(who, x->b_data))
+        return;
+    if (x->b_n == x->b_size)
+    {
+        int newsize = (x->b_size ? 2 * x->b_size : 16);
+        x->b_who = (t_pd **)resizebytes(x->b_who,
+            x->b_size * sizeof(t_pd *), newsize * sizeof(t_pd *));
+        x->b_sym = (t_symbol **)resizebytes(x->b_sym,
+            x->b_size * sizeof(t_symbol *), newsize * sizeof(t_symbol *));
+        x->b_size = newsize;
+    }
+    x->b_who[x->b_n] = who;
+    x->b_sym[x->b_n] = s;
+    x->b_n++;
+}
+
+static void bindsearch_symbol(t_symbol *s, void *data)
+{
+    t_bindsearch *x = (t_bindsearch *)data;
+    if (!s->s_thing)
+        return;
+    if (*s->s_thing == bindlist_class)
+    {
+        t_bindlist *b = (t_bindlist *)s->s_thing;
+        int i;
+        for (i = b->b_n; i--; )
+            if (b->b_vec[i])
+                bindsearch_add(x, b->b_vec[i], s);
+    }
+    else bindsearch_add(x, s->s_thing, s);
+}
+
+    /* unbind every object that satisfies "owned" from all its symbols,
+    returning the pairs so that pd_rebind() can restore them.  Returns the
+    number of bindings removed. */
+int pd_unbindowned(int (*owned)(void *x, void *data), void *data,
+    t_pd ***whop, t_symbol ***symp)
+{
+    t_bindsearch search;
+    int i;
+    search.b_owned = owned;
+    search.b_data = data;
+    search.b_who = 0;
+    search.b_sym = 0;
+    search.b_n = search.b_size = 0;
+        /* can't unbind while walking the table: unbinding frees bindlists */
+    symtab_foreach(bindsearch_symbol, &search);
+    for (i = 0; i < search.b_n; i++)
+        pd_unbind(search.b_who[i], search.b_sym[i]);
+    if (search.b_n < search.b_size)
+    {
+        search.b_who = (t_pd **)resizebytes(search.b_who,
+            search.b_size * sizeof(t_pd *), search.b_n * sizeof(t_pd *));
+        search.b_sym = (t_symbol **)resizebytes(search.b_sym,
+            search.b_size * sizeof(t_symbol *),
+                search.b_n * sizeof(t_symbol *));
+    }
+    *whop = search.b_who;
+    *symp = search.b_sym;
+    return (search.b_n);
+}
+
+    /* restore bindings removed by pd_unbindowned() and free the arrays.
+    Bindlists are newest-first, so bind in reverse to keep the order. */
+void pd_rebind(t_pd **who, t_symbol **sym, int n)
+{
+    int i;
+    for (i = n; i--; )
+        pd_bind(who[i], sym[i]);
+    if (n)
+    {
+        freebytes(who, n * sizeof(t_pd *));
+        freebytes(sym, n * sizeof(t_symbol *));
+    }
+}
+
 t_pd *pd_findbyclass(t_symbol *s, const t_class *c)
 {
     t_pd *x = 0;
@@ -197,17 +349,16 @@ t_pd *pd_findbyclass(t_symbol *s, const t_class *c)
     if (*s->s_thing == bindlist_class)
     {
         t_bindlist *b = (t_bindlist *)s->s_thing;
-        t_bindelem *e, *e2;
-        int warned = 0;
-        for (e = b->b_list; e; e = e->e_next)
-            if (*e->e_who == c)
+        int i, warned = 0;
+        for (i = b->b_n; i--; )
+            if (b->b_vec[i] && *b->b_vec[i] == c)
         {
             if (x && !warned)
             {
                 post("warning: %s: multiply defined", s->s_name);
                 warned = 1;
             }
-            x = e->e_who;
+            x = b->b_vec[i];
         }
     }
     return x;
@@ -922,6 +922,8 @@ EXTERN_STRUCT _instanceugen;
 EXTERN_STRUCT _instancestuff;
 #define t_instancestuff struct _instancestuff
 
+EXTERN_STRUCT _symtab;
+
 #ifndef PDTHREADS
 #define PDTHREADS 1
 #endif
@@ -929,11 +931,11 @@ EXTERN_STRUCT _instancestuff;
 struct _pdinstance
 {
     double pd_systime;          /* global time in Pd ticks */
-    t_clock *pd_clock_setlist;  /* list of set clocks */
+    t_clock *pd_clock_setlist;  /* heap of set clocks, see m_sched.c */
     t_canvas *pd_canvaslist;    /* list of all root canvases */
     struct _template *pd_templatelist;  /* list of all templates */
     int pd_instanceno;          /* ordinal number of this instance */
-    t_symbol **pd_symhash;      /* symbol table hash table */
+    struct _symtab *pd_symtab;  /* symbol table, see m_class.c */
     t_instancemidi *pd_midi;    /* private stuff for x_midi.c */
     t_instanceinter *pd_inter;  /* private stuff for s_inter.c */
     t_instanceugen *pd_ugen;    /* private stuff for d_ugen.c */
@@ -961,6 +963,11 @@ struct _pdinstance
 #define t_pdinstance struct _pdinstance
 EXTERN t_pdinstance pd_maininstance;
 
+    /* the symbol table used to be a hash array named pd_symhash.  The old
+    name still compiles, but the table is opaque now and can't be walked as
+    chains of s_next pointers. */
+#define pd_symhash pd_symtab
+
 /* m_pd.c */
 #ifdef PDINSTANCE
 EXTERN t_pdinstance *pdinstance_new(void);
@@ -7,6 +7,7 @@
 #include "m_pd.h"
 #include "m_imp.h"
 #include "s_stuff.h"
+#include <stdlib.h>
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -30,12 +31,20 @@ int sys_sleepgrain;
 
 typedef void (*t_clockmethod)(void *client);
 
+    /* set clocks are kept in a pairing heap rooted at pd_clock_setlist,
+    ordered by time and then by the order in which they were set, so that
+    clocks set for the same time go off first-come, first-served.  Each
+    clock points to its first child, its next sibling, and back to its
+    previous sibling or (if it's the first child) its parent. */
 struct _clock
 {
     double c_settime;       /* in TIMEUNITS; <0 if unset */
     void *c_owner;
     t_clockmethod c_fn;
-    struct _clock *c_next;
+    struct _clock *c_child;     /* first child in heap */
+    struct _clock *c_sibling;   /* next sibling */
+    struct _clock *c_prev;      /* previous sibling or parent */
+    double c_setcount;      /* breaks ties between equal settimes */
     t_float c_unit;         /* >0 if in TIMEUNITS; <0 if in samples */
 };
 
@@ -49,23 +58,88 @@ t_clock *clock_new(void *owner, t_method fn)
     x->c_settime = -1;
     x->c_owner = owner;
     x->c_fn = (t_clockmethod)fn;
-    x->c_next = 0;
+    x->c_child = x->c_sibling = x->c_prev = 0;
+    x->c_setcount = 0;
     x->c_unit = TIMEUNITPERMSEC;
     return (x);
 }
 
+    /* true if clock 'a' should go off before clock 'b' */
+static int clock_before(t_clock *a, t_clock *b)
+{
+    return (a->c_settime < b->c_settime ||
+        (a->c_settime == b->c_settime && a->c_setcount < b->c_setcount));
+}
+
+    /* merge two heaps, returning the new root */
+static t_clock *clock_meld(t_clock *a, t_clock *b)
+{
+    if (clock_before(b, a))
+    {
+        t_clock *tmp = a;
+        a = b;
+        b = tmp;
+    }
+    b->c_prev = a;
+    b->c_sibling = a->c_child;
+    if (a->c_child)
+        a->c_child->c_prev = b;
+    a->c_child = b;
+    a->c_prev = a->c_sibling = 0;
+    return (a);
+}
+
+    /* merge a list of sibling heaps into one: pair them up left to right,
+    then fold the pairs together right to left */
+static t_clock *clock_combine(t_clock *first)
+{
+    t_clock *stack = 0, *next, *x;
+    while (first)
+    {
+        x = first;
+        if ((first = x->c_sibling))
+        {
+            next = first->c_sibling;
+            x = clock_meld(x, first);
+            first = next;
+        }
+        x->c_sibling = stack;
+        stack = x;
+    }
+    if (!(x = stack))
+        return (0);
+    stack = x->c_sibling;
+    x->c_sibling = 0;
+    while (stack)
+    {
+        next = stack->c_sibling;
+        x = clock_meld(stack, x);
+        stack = next;
+    }
+    x->c_prev = 0;
+    return (x);
+}
+
 void clock_unset(t_clock *x)
 {
     if (x->c_settime >= 0)
     {
+        t_clock *sub = clock_combine(x->c_child);
         if (x == pd_this->pd_clock_setlist)
-            pd_this->pd_clock_setlist = x->c_next;
+            pd_this->pd_clock_setlist = sub;
         else
         {
-            t_clock *x2 = pd_this->pd_clock_setlist;
-            while (x2->c_next != x) x2 = x2->c_next;
-            x2->c_next = x->c_next;
+                /* cut x out of its parent's list of children */
+            if (x->c_prev->c_child == x)
+                x->c_prev->c_child = x->c_sibling;
+            else x->c_prev->c_sibling = x->c_sibling;
+            if (x->c_sibling)
+                x->c_sibling->c_prev = x->c_prev;
+            if (sub)
+                pd_this->pd_clock_setlist =
+                    clock_meld(pd_this->pd_clock_setlist, sub);
         }
+        x->c_child = x->c_sibling = x->c_prev = 0;
         x->c_settime = -1;
     }
 }
@@ -76,23 +150,9 @@ void clock_set(t_clock *x, double setticks)
     if (setticks < pd_this->pd_systime) setticks = pd_this->pd_systime;
     clock_unset(x);
     x->c_settime = setticks;
-    if (pd_this->pd_clock_setlist &&
-        pd_this->pd_clock_setlist->c_settime <= setticks)
-    {
-        t_clock *cbefore, *cafter;
-        for (cbefore = pd_this->pd_clock_setlist,
-            cafter = pd_this->pd_clock_setlist->c_next;
-                cbefore; cbefore = cafter, cafter = cbefore->c_next)
-        {
-            if (!cafter || cafter->c_settime > setticks)
-            {
-                cbefore->c_next = x;
-                x->c_next = cafter;
-                return;
-            }
-        }
-    }
-    else x->c_next = pd_this->pd_clock_setlist, pd_this->pd_clock_setlist = x;
+    x->c_setcount = STUFF->st_clocksetcount++;
+    pd_this->pd_clock_setlist = (pd_this->pd_clock_setlist ?
+        clock_meld(pd_this->pd_clock_setlist, x) : x);
 }
 
     /* set the clock to call back after a delay in msec */
@@ -170,6 +230,84 @@ void clock_free(t_clock *x)
     freebytes(x, sizeof *x);
 }
 
+static int clock_compare(const void *a, const void *b)
+{
+    t_clock *x = *(t_clock **)a, *y = *(t_clock **)b;
+    return (clock_before(x, y) ? -1 : (clock_before(y, x) ? 1 : 0));
+}
+
+    /* unset every pending clock whose owner satisfies 'owned' so that it
+    can later be restarted by clock_thaw() with the same time left.  The
+    clocks are returned in the order they would have gone off, along with
+    the logical time left on each.  Returns the number of clocks frozen. */
+int clock_freeze(int (*owned)(void *owner, void *data), void *data,
+    t_clock ***clocksp, double **leftp)
+{
+    t_clock **stack, **clocks = 0, *x;
+    double *left = 0;
+    int nstack = 0, stacksize = 64, n = 0, size = 0, i;
+    *clocksp = 0;
+    *leftp = 0;
+    if (!pd_this->pd_clock_setlist)
+        return (0);
+    stack = (t_clock **)getbytes(stacksize * sizeof(*stack));
+    stack[nstack++] = pd_this->pd_clock_setlist;
+    while (nstack)
+    {
+        x = stack[--nstack];
+        if (nstack + 2 > stacksize)
+        {
+            stack = (t_clock **)resizebytes(stack,
+                stacksize * sizeof(*stack), 2 * stacksize * sizeof(*stack));
+            stacksize *= 2;
+        }
+        if (x->c_child)
+            stack[nstack++] = x->c_child;
+        if (x->c_sibling)
+            stack[nstack++] = x->c_sibling;
+        if (!(*owned)(x->c_owner, data))
+            continue;
+        if (n == size)
+        {
+            int newsize = (size ? 2 * size : 16);
+            clocks = (t_clock **)resizebytes(clocks,
+                size * sizeof(*clocks), newsize * sizeof(*clocks));
+            size = newsize;
+        }
+        clocks[n++] = x;
+    }
+    freebytes(stack, stacksize * sizeof(*stack));
+    if (!n)
+        return (0);
+        /* put them in firing order so that thawing them preserves it */
+    qsort(clocks, n, sizeof(*clocks), clock_compare);
+    left = (double *)getbytes(n * sizeof(*left));
+    for (i = 0; i < n; i++)
+    {
+        left[i] = clocks[i]->c_settime - pd_this->pd_systime;
+        clock_unset(clocks[i]);
+    }
+    *clocksp = (t_clock **)resizebytes(clocks,
+        size * sizeof(*clocks), n * sizeof(*clocks));
+    *leftp = left;
+    return (n);
+}
+
+    /* restart clocks stopped by clock_freeze() and free the arrays.  Clocks
+    that were set again in the meantime keep their new time. */
+void clock_thaw(t_clock **clocks, double *left, int n)
+{
+    int i;
+    for (i = 0; i < n; i++)
+        if (clocks[i]->c_settime < 0)
+            clock_set(clocks[i], pd_this->pd_systime + left[i]);
+    if (n)
+    {
+        freebytes(clocks, n * sizeof(*clocks));
+        freebytes(left, n * sizeof(*left));
+    }
+}
+
 
 void glob_audiostatus(void)
 {
@@ -208,6 +346,7 @@ void glob_fastforward(void *dummy, t_floatarg f)
 }
 
 void dsp_tick(void);
+void canvas_flush_dsp(void);
 
 static int sched_useaudio = SCHED_AUDIO_NONE;
 static double sched_referencerealtime, sched_referencelogicaltime;
@@ -258,6 +397,7 @@ void sched_tick(void)
             return;
     }
     pd_this->pd_systime = next_sys_time;
+    canvas_flush_dsp();
     dsp_tick();
     sched_counter++;
 }
@@ -393,7 +393,7 @@ static int sys_do_load_lib(t_canvas *canvas, const char *objectname,
         /* try looking in the path for (objectname).(sys_dllextent) ... */
     for(dllextent=sys_get_dllextensions(); *dllextent; dllextent++)
     {
-        if ((fd = sys_trytoopenone(path, objectname, *dllextent,
+        if ((fd = sys_trytoopenindexed(path, objectname, *dllextent,
             dirbuf, &nameptr, MAXPDSTRING, 1)) >= 0)
             if(sys_do_load_lib_from_file(fd, objectname, dirbuf, nameptr, symname))
                 return 1;
@@ -406,7 +406,7 @@ static int sys_do_load_lib(t_canvas *canvas, const char *objectname,
     filename[MAXPDSTRING-1] = 0;
     for(dllextent=sys_get_dllextensions(); *dllextent; dllextent++)
     {
-        if ((fd = sys_trytoopenone(path, filename, *dllextent,
+        if ((fd = sys_trytoopenindexed(path, filename, *dllextent,
             dirbuf, &nameptr, MAXPDSTRING, 1)) >= 0)
             if(sys_do_load_lib_from_file(fd, objectname, dirbuf, nameptr, symname))
                 return 1;
@@ -419,7 +419,7 @@ static int sys_do_load_lib(t_canvas *canvas, const char *objectname,
     if (libname[len-1] == '~' && len < MAXPDSTRING - 6) {
         strcpy(libname+len-1, "_tilde");
     }
-    if ((fd = sys_trytoopenone(path, libname, ".so",
+    if ((fd = sys_trytoopenindexed(path, libname, ".so",
         dirbuf, &nameptr, MAXPDSTRING, 1)) >= 0)
             if(sys_do_load_lib_from_file(fd, objectname, dirbuf, nameptr, symname))
                 return 1;
@@ -588,13 +588,10 @@ int sys_run_scheduler(const char *externalschedlibname,
 void canvas_popabstraction(t_canvas *x);
 int pd_setloadingabstraction(t_symbol *sym);
 
+    /* the file is parsed once and later instances copy the result, see
+    binbuf_evaltemplate() */
 static t_pd *do_create_abstraction(t_symbol*s, int argc, t_atom *argv)
 {
-    /*
-     * TODO: check if the there is a binbuf cached for <canvas::symbol>
-        and use that instead.  We'll have to invalidate the cache once we
-        are done (either with a clock_delay(0) or something else)
-     */
     if (!pd_setloadingabstraction(s))
     {
         const char *objectname = s->s_name;
@@ -605,17 +602,19 @@ static t_pd *do_create_abstraction(t_symbol*s, int argc, t_atom *argv)
 
         t_pd *was = s__X.s_thing;
         snprintf(classslashclass, MAXPDSTRING, "%s/%s", objectname, objectname);
-        if ((fd = canvas_open(canvas, objectname, ".pd",
+        if ((fd = canvas_open_indexed(canvas, objectname, ".pd",
                   dirbuf, &nameptr, MAXPDSTRING, 0)) >= 0 ||
-            (fd = canvas_open(canvas, objectname, ".pat",
+            (fd = canvas_open_indexed(canvas, objectname, ".pat",
                   dirbuf, &nameptr, MAXPDSTRING, 0)) >= 0 ||
-            (fd = canvas_open(canvas, classslashclass, ".pd",
+            (fd = canvas_open_indexed(canvas, objectname, ".pdc",
+                  dirbuf, &nameptr, MAXPDSTRING, 0)) >= 0 ||
+            (fd = canvas_open_indexed(canvas, classslashclass, ".pd",
                   dirbuf, &nameptr, MAXPDSTRING, 0)) >= 0)
         {
             close(fd);
             canvas_setargs(argc, argv);
 
-            binbuf_evalfile(gensym(nameptr), gensym(dirbuf));
+            binbuf_evaltemplate(gensym(nameptr), gensym(dirbuf));
             if (s__X.s_thing && was != s__X.s_thing)
                 canvas_popabstraction((t_canvas *)(s__X.s_thing));
             else s__X.s_thing = was;
@@ -629,6 +628,14 @@ static t_pd *do_create_abstraction(t_symbol*s, int argc, t_atom *argv)
     return (0);
 }
 
+    /* check whether "s" names a built-in or loaded class other than an
+    abstraction; for prefetching abstractions, see binbuf_prefetch() */
+int sys_isclassname(t_symbol *s)
+{
+    t_gotfn fn = zgetfn(&pd_objectmaker, s);
+    return (fn && fn != (t_gotfn)do_create_abstraction);
+}
+
 /* search for abstraction; register a creator if found */
 static int sys_do_load_abs(t_canvas *canvas, const char *objectname,
     const char *path)
@@ -641,11 +648,13 @@ static int sys_do_load_abs(t_canvas *canvas, const char *objectname,
     if (!path) return (0);
 
     snprintf(classslashclass, MAXPDSTRING, "%s/%s", objectname, objectname);
-    if ((fd = sys_trytoopenone(path, objectname, ".pd",
+    if ((fd = sys_trytoopenindexed(path, objectname, ".pd",
+              dirbuf, &nameptr, MAXPDSTRING, 1)) >= 0 ||
+        (fd = sys_trytoopenindexed(path, objectname, ".pat",
               dirbuf, &nameptr, MAXPDSTRING, 1)) >= 0 ||
-        (fd = sys_trytoopenone(path, objectname, ".pat",
+        (fd = sys_trytoopenindexed(path, objectname, ".pdc",
               dirbuf, &nameptr, MAXPDSTRING, 1)) >= 0 ||
-        (fd = sys_trytoopenone(path, classslashclass, ".pd",
+        (fd = sys_trytoopenindexed(path, classslashclass, ".pd",
               dirbuf, &nameptr, MAXPDSTRING, 1)) >= 0)
     {
         t_class*c=0;
@@ -1621,6 +1621,7 @@ void glob_path_dialog(t_pd *dummy, t_symbol *s, int argc, t_atom *argv)
             STUFF->st_searchpath =
                 namelist_append_files(STUFF->st_searchpath, s->s_name);
     }
+    sys_flushdirindex();
 }
 
     /* add one item to search path (intended for use by Deken plugin).
@@ -1638,6 +1639,7 @@ void glob_addtopath(t_pd *dummy, t_symbol *path, t_float saveit)
         else
             STUFF->st_searchpath =
                 namelist_append_files(STUFF->st_searchpath, s->s_name);
+        sys_flushdirindex();
         if (saveit > 0)
             sys_savepreferences(0);
     }
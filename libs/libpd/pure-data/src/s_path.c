@@ -21,10 +21,16 @@
 #ifdef _WIN32
 #include <io.h>
 #include <windows.h>
+#else
+#include <dirent.h>
 #endif
+#include <errno.h>
 
 #include <string.h>
 #include "m_pd.h"
+#if PDTHREADS
+#include <pthread.h>
+#endif
 #include "m_imp.h"
 #include "s_stuff.h"
 #include "s_utf8.h"
@@ -316,6 +322,282 @@ int sys_trytoopenone(const char *dir, const char *name, const char* ext,
     return (-1);
 }
 
+/* Directory index.  Resolving an object name walks every search path and
+tries several file names in each (".pd", ".pat", ".pdc", "name/name.pd" and
+one per dll extension), so a patch full of abstractions costs many failed
+open() calls.  Instead we read each directory once, keep its entries in a hash
+table, and only call sys_trytoopenone() for names that are actually there.
+Listings are read lazily and kept until the search path changes, a new
+patch file is written, or sys_flushdirindex() is called; files created behind
+Pd's back after a directory was read aren't seen until then.  Only object and
+abstraction lookup goes through here; opening data files always asks the
+file system.  binbuf_prefetch() looks files up on several threads, so the
+table has a mutex; it's held only to find or insert a listing, which never
+changes once inserted, and not while reading a directory. */
+
+#define DIRINDEXHASH 64
+
+typedef struct _dirindex
+{
+    struct _dirindex *di_next;  /* next in hash chain */
+    char *di_path;              /* directory as passed to opendir() */
+    unsigned int di_hash;
+    int di_unlisted;            /* exists but can't be read: always try */
+    int di_nnames;              /* number of entries */
+    int di_size;                /* size of di_names, a power of two */
+    char **di_names;            /* open-addressed table of entries */
+} t_dirindex;
+
+typedef struct _dirindextab
+{
+    t_dirindex *dt_hash[DIRINDEXHASH];
+#if PDTHREADS
+    pthread_mutex_t dt_mutex;
+#endif
+} t_dirindextab;
+
+#if PDTHREADS
+#define dirindex_lock(t) pthread_mutex_lock(&(t)->dt_mutex)
+#define dirindex_unlock(t) pthread_mutex_unlock(&(t)->dt_mutex)
+#else
+#define dirindex_lock(t)
+#define dirindex_unlock(t)
+#endif
+
+    /* file names don't differ by case alone on Windows and macOS */
+#if defined(_WIN32) || defined(__APPLE__)
+#define DIRINDEXCASE(c) (((c) >= 'A' && (c) <= 'Z') ? (c) + ('a' - 'A') : (c))
+#else
+#define DIRINDEXCASE(c) (c)
+#endif
+
+static unsigned int dirindex_hash(const char *s, int n)
+{
+    unsigned int hash = 5381;
+    while (n-- && *s)
+        hash = hash * 33 + DIRINDEXCASE((unsigned char)*s), s++;
+    return (hash);
+}
+
+    /* compare the first n bytes of "s1" to the string "s2" */
+static int dirindex_match(const char *s1, int n, const char *s2)
+{
+    while (n--)
+    {
+        unsigned char c1 = *s1++, c2 = *s2++;
+        if (!c2 || DIRINDEXCASE(c1) != DIRINDEXCASE(c2))
+            return (0);
+    }
+    return (!*s2);
+}
+
+static int dirindex_find(t_dirindex *d, const char *name)
+{
+    int i, n = (int)strlen(name), mask = d->di_size - 1;
+    if (!d->di_nnames)
+        return (0);
+    for (i = dirindex_hash(name, n) & mask; d->di_names[i];
+        i = (i + 1) & mask)
+        if (dirindex_match(name, n, d->di_names[i]))
+            return (1);
+    return (0);
+}
+
+static void dirindex_add(t_dirindex *d, const char *name)
+{
+    int i, mask, n = (int)strlen(name);
+    if (2 * (d->di_nnames + 1) > d->di_size)
+    {
+        char **was = d->di_names;
+        int j, sizewas = d->di_size;
+        d->di_size = (sizewas ? 2 * sizewas : 16);
+        d->di_names = (char **)getbytes(d->di_size * sizeof(char *));
+        mask = d->di_size - 1;
+        for (j = 0; j < sizewas; j++)
+            if (was[j])
+        {
+            for (i = dirindex_hash(was[j], -1) & mask; d->di_names[i];
+                i = (i + 1) & mask)
+                    ;
+            d->di_names[i] = was[j];
+        }
+        if (was)
+            freebytes(was, sizewas * sizeof(char *));
+    }
+    mask = d->di_size - 1;
+    for (i = dirindex_hash(name, -1) & mask; d->di_names[i];
+        i = (i + 1) & mask)
+            if (dirindex_match(name, n, d->di_names[i]))
+                return;
+    d->di_names[i] = (char *)getbytes(n + 1);
+    strcpy(d->di_names[i], name);
+    d->di_nnames++;
+}
+
+    /* read a directory's entries.  A missing directory stays empty; one we
+    may not list (but maybe open files in) is marked to be tried anyway. */
+static void dirindex_read(t_dirindex *d)
+{
+    const char *path = (*d->di_path ? d->di_path : ".");
+#ifdef _WIN32
+    char pattern[MAXPDSTRING], name[MAXPDSTRING];
+    wchar_t ucs2pattern[MAXPDSTRING];
+    WIN32_FIND_DATAW data;
+    HANDLE h;
+    snprintf(pattern, MAXPDSTRING, "%s/*", path);
+    sys_bashfilename(pattern, pattern);
+    u8_utf8toucs2(ucs2pattern, MAXPDSTRING, pattern, MAXPDSTRING-1);
+    if ((h = FindFirstFileW(ucs2pattern, &data)) == INVALID_HANDLE_VALUE)
+    {
+        DWORD err = GetLastError();
+        d->di_unlisted = (err != ERROR_FILE_NOT_FOUND &&
+            err != ERROR_PATH_NOT_FOUND && err != ERROR_DIRECTORY);
+        return;
+    }
+    do
+    {
+        u8_ucs2toutf8(name, MAXPDSTRING-1, data.cFileName, -1);
+        dirindex_add(d, name);
+    } while (FindNextFileW(h, &data));
+    FindClose(h);
+#else
+    DIR *dir = opendir(path);
+    struct dirent *entry;
+    if (!dir)
+    {
+        d->di_unlisted = (errno != ENOENT && errno != ENOTDIR);
+        return;
+    }
+    while ((entry = readdir(dir)))
+        dirindex_add(d, entry->d_name);
+    closedir(dir);
+#endif
+}
+
+static void dirindex_free(t_dirindex *d)
+{
+    int i;
+    for (i = 0; i < d->di_size; i++)
+        if (d->di_names[i])
+            freebytes(d->di_names[i], strlen(d->di_names[i]) + 1);
+    if (d->di_names)
+        freebytes(d->di_names, d->di_size * sizeof(char *));
+    freebytes(d->di_path, strlen(d->di_path) + 1);
+    freebytes(d, sizeof(*d));
+}
+
+static t_dirindex *dirindex_lookup(t_dirindex *d, const char *path, int n,
+    unsigned int hash)
+{
+    for (; d; d = d->di_next)
+        if (d->di_hash == hash && dirindex_match(path, n, d->di_path))
+            return (d);
+    return (0);
+}
+
+    /* find the listing of the first n bytes of "path", reading it if new.
+    The table itself is made by sys_trytoopenindexed() before any lookup. */
+static t_dirindex *dirindex_get(const char *path, int n)
+{
+    unsigned int hash = dirindex_hash(path, n);
+    t_dirindextab *tab = STUFF->st_dirindex;
+    t_dirindex *d, *d2, **bucket = &tab->dt_hash[hash % DIRINDEXHASH];
+    dirindex_lock(tab);
+    d = dirindex_lookup(*bucket, path, n, hash);
+    dirindex_unlock(tab);
+    if (d)
+        return (d);
+    d = (t_dirindex *)getbytes(sizeof(*d));
+    d->di_path = (char *)getbytes(n + 1);
+    strncpy(d->di_path, path, n);
+    d->di_path[n] = 0;
+    d->di_hash = hash;
+    d->di_unlisted = 0;
+    d->di_nnames = d->di_size = 0;
+    d->di_names = 0;
+    dirindex_read(d);
+        /* another thread may have read the same directory meanwhile */
+    dirindex_lock(tab);
+    if ((d2 = dirindex_lookup(*bucket, path, n, hash)))
+    {
+        dirindex_unlock(tab);
+        dirindex_free(d);
+        return (d2);
+    }
+    d->di_next = *bucket;
+    *bucket = d;
+    dirindex_unlock(tab);
+    return (d);
+}
+
+    /* make the table if there isn't one.  Called on Pd's own thread (also
+    by binbuf_prefetch() before it starts any others). */
+void sys_makedirindex(void)
+{
+    if (!STUFF->st_dirindex)
+    {
+        STUFF->st_dirindex = (t_dirindextab *)getbytes(
+            sizeof(*STUFF->st_dirindex));
+#if PDTHREADS
+        pthread_mutex_init(&STUFF->st_dirindex->dt_mutex, 0);
+#endif
+    }
+}
+
+    /* forget all directory listings so they're read again on next use */
+void sys_flushdirindex(void)
+{
+    int i;
+    t_dirindex *d, *next;
+    if (!STUFF->st_dirindex)
+        return;
+    for (i = 0; i < DIRINDEXHASH; i++)
+        for (d = STUFF->st_dirindex->dt_hash[i]; d; d = next)
+    {
+        next = d->di_next;
+        dirindex_free(d);
+    }
+#if PDTHREADS
+    pthread_mutex_destroy(&STUFF->st_dirindex->dt_mutex);
+#endif
+    freebytes(STUFF->st_dirindex, sizeof(*STUFF->st_dirindex));
+    STUFF->st_dirindex = 0;
+}
+
+    /* like sys_trytoopenone() but first check the directory index, so that
+    a file that isn't there costs a hash lookup instead of a system call */
+int sys_trytoopenindexed(const char *dir, const char *name, const char* ext,
+    char *dirresult, char **nameresult, unsigned int size, int bin)
+{
+    char buf[MAXPDSTRING], *leaf;
+    t_dirindex *d;
+    int dirlen;
+    if (strlen(dir) + strlen(name) + strlen(ext) + 4 > size)
+        return (-1);
+    sys_expandpath(dir, buf, MAXPDSTRING);
+    if (*buf && buf[strlen(buf)-1] != '/')
+        strcat(buf, "/");
+    strcat(buf, name);
+    strcat(buf, ext);
+    sys_unbashfilename(buf, buf);
+        /* "name" may have slashes, so look the last component up in the
+        listing of whatever directory precedes it */
+    if (!(leaf = strrchr(buf, '/')))
+        leaf = buf, dirlen = 0;         /* current directory */
+    else if (leaf == buf)
+        leaf++, dirlen = 1;             /* root directory */
+    else dirlen = (int)(leaf++ - buf);
+    sys_makedirindex();
+    d = dirindex_get(buf, dirlen);
+    if (!d->di_unlisted && !dirindex_find(d, leaf))
+    {
+        logpost(NULL, PD_VERBOSE, "tried %s; not in directory listing", buf);
+        return (-1);
+    }
+    return (sys_trytoopenone(dir, name, ext, dirresult, nameresult,
+        size, bin));
+}
+
     /* check if we were given an absolute pathname, if so try to open it
     and return 1 to signal the caller to cancel any path searches */
 int sys_open_absolute(const char *name, const char* ext,
@@ -26,6 +26,10 @@ int sys_open_absolute(const char *name, const char* ext,
     char *dirresult, char **nameresult, unsigned int size, int bin, int *fdp);
 int sys_trytoopenone(const char *dir, const char *name, const char* ext,
     char *dirresult, char **nameresult, unsigned int size, int bin);
+int sys_trytoopenindexed(const char *dir, const char *name, const char* ext,
+    char *dirresult, char **nameresult, unsigned int size, int bin);
+void sys_makedirindex(void);
+EXTERN void sys_flushdirindex(void);
 t_symbol *sys_decodedialog(t_symbol *s);
 
 /* s_file.c */
@@ -53,6 +57,7 @@ typedef int (*loader_t)(t_canvas *canvas, const char *classname, const char*path
 EXTERN int sys_load_lib(t_canvas *canvas, const char *classname);
 EXTERN void sys_register_loader(loader_t loader);
 EXTERN const char**sys_get_dllextensions(void);
+int sys_isclassname(t_symbol *s);
 
                         /* s_audio.c */
 
@@ -298,6 +303,13 @@ void sys_alsa_do_open_midi(int nmidiindev, int *midiindev,
     int nmidioutdev, int *midioutdev);
 #endif
 
+/* m_binbuf.c */
+void binbuf_evaltemplate(t_symbol *name, t_symbol *dir);
+void binbuf_evalprefetched(t_symbol *name, t_symbol *dir);
+EXTERN void binbuf_flushtemplates(t_symbol *path);
+int binbuf_prefetch(t_symbol *name, t_symbol *dir, int nthreads);
+EXTERN int binbuf_write_compiled(const t_binbuf *x, const char *path);
+
 /* m_sched.c */
 EXTERN void sys_log_error(int type);
 #define ERR_NOTHING 0
@@ -310,6 +322,9 @@ EXTERN void sys_log_error(int type);
 #define SCHED_AUDIO_POLL 1
 #define SCHED_AUDIO_CALLBACK 2
 void sched_set_using_audio(int flag);
+int clock_freeze(int (*owned)(void *owner, void *data), void *data,
+    t_clock ***clocksp, double **leftp);
+void clock_thaw(t_clock **clocks, double *left, int n);
 extern int sys_sleepgrain;      /* override value set in command line */
 EXTERN int sched_get_sleepgrain( void);     /* returns actual value */
 
@@ -393,6 +408,15 @@ EXTERN void inmidi_polyaftertouch(int portno,
 /* } jsarlo */
 EXTERN int sys_zoom_open;
 
+    /* time taken to open a file, see glob_evalfile() */
+typedef struct _loadtimes
+{
+    double lt_prefetch;         /* ms reading abstractions beforehand */
+    double lt_build;            /* ms creating and connecting objects */
+    double lt_loadbang;         /* ms sending loadbang */
+    int lt_nfiles;              /* number of files prefetched */
+} t_loadtimes;
+
 struct _instancestuff
 {
     t_namelist *st_externlist;
@@ -410,6 +434,13 @@ struct _instancestuff
     double st_time_per_dsp_tick;    /* obsolete - included for GEM?? */
     t_printhook st_printhook;   /* set this to override per-instance printing */
     void *st_impdata; /* optional implementation-specific data for libpd, etc */
+    struct _fftplan *st_fftplans;   /* FFT tables by size, see d_fft_simd.c */
+    double st_clocksetcount;    /* orders clocks set for equal times */
+    struct _dirindextab *st_dirindex; /* cached directory listings, s_path.c */
+    struct _bintemplate *st_bintemplates; /* parsed abstractions, m_binbuf.c */
+    int st_loadthreads;         /* threads to prefetch files on, or 0 */
+    t_loadtimes st_loadtimes;   /* phases of the last file opened */
+    struct _sfbatch *st_sfbatches;  /* soundfile batches started by libpd */
 };
 
 #define STUFF (pd_this->pd_stuff)
@@ -2370,6 +2370,15 @@ t_binbuf *text_getbufbyname(t_symbol *s)
     else return (0);
 }
 
+    /* get the contents of a [text define], [qlist] or [textfile], or 0 if
+    'x' is none of those */
+t_binbuf *textbuf_getbinbuf(t_pd *x)
+{
+    if (*x == text_define_class || *x == qlist_class || *x == textfile_class)
+        return (((t_textbuf *)x)->b_binbuf);
+    else return (0);
+}
+
     /* notify text object that binbuf was modified */
 void text_notifybyname(t_symbol *s)
 {
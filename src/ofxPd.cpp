@@ -150,6 +150,43 @@ void ofxPd::closePatch(Patch &patch) {
 	PdBase::closePatch(patch);
 }	
 
+bool ofxPd::compilePatch(const std::string &patch, const std::string &outPatch) {
+
+	string fullpath = ofFilePath::getAbsolutePath(ofToDataPath(patch));
+	string file = ofFilePath::getFileName(fullpath);
+	string folder = ofFilePath::getEnclosingDirectory(fullpath);
+
+	// trim the trailing slash Poco::Path always adds ... blarg
+	if(folder.size() > 0 && folder.at(folder.size()-1) == '/') {
+		folder.erase(folder.end()-1);
+	}
+
+	ofLogVerbose("Pd") << "compiling patch: "+file+" path: "+folder;
+	if(!PdBase::compilePatch(file, folder, outPatch)) {
+		ofLogError("Pd") << "compiling patch \""+file+"\" failed";
+		return false;
+	}
+	return true;
+}
+
+bool ofxPd::suspendPatch(Patch &patch) {
+	ofLogVerbose("Pd") << "suspending patch: "+patch.filename();
+	if(!PdBase::suspendPatch(patch)) {
+		ofLogError("Pd") << "suspending patch \""+patch.filename()+"\" failed";
+		return false;
+	}
+	return true;
+}
+
+bool ofxPd::resumePatch(Patch &patch) {
+	ofLogVerbose("Pd") << "resuming patch: "+patch.filename();
+	if(!PdBase::resumePatch(patch)) {
+		ofLogError("Pd") << "resuming patch \""+patch.filename()+"\" failed";
+		return false;
+	}
+	return true;
+}
+
 //------------------------------------------------------------------------------
 void ofxPd::computeAudio(bool state) {
 	if(state) {
@@ -582,6 +619,35 @@ void ofxPd::sendPolyAftertouch(const int channel, int pitch, int value) {
 	PdBase::sendPolyAftertouch(channel-1, pitch, value);
 }
 
+//------------------------------------------------------------------------------
+bool ofxPd::render(const pd::RenderJob &job) {
+
+	// resolve paths relative to the data folder
+	pd::RenderJob j = job;
+	j.path = ofFilePath::getAbsolutePath(ofToDataPath(job.path));
+	j.output = ofFilePath::getAbsolutePath(ofToDataPath(job.output));
+	for(size_t i = 0; i < j.inputs.size(); ++i) {
+		j.inputs[i] = ofFilePath::getAbsolutePath(ofToDataPath(job.inputs[i]));
+	}
+
+	ofLogVerbose("Pd") << "rendering patch: "+j.patch+" to: "+j.output;
+	bool wasComputing = computing;
+	bool ok = PdBase::render(j);
+	if(!ok) {
+		ofLogError("Pd") << "rendering patch \""+j.patch+"\" failed";
+	}
+
+	// back to the realtime audio settings
+	if(isInited()) {
+		PdBase::init(inChannels, outChannels, srate, isQueued());
+		if(wasComputing) {
+			computeAudio(true);
+		}
+	}
+
+	return ok;
+}
+
 //------------------------------------------------------------------------------
 void ofxPd::audioIn(float *input, int bufferSize, int nChannels) {
 	try {
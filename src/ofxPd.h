@@ -130,6 +130,32 @@ class ofxPd : public pd::PdBase, protected pd::PdReceiver, protected pd::PdMidiR
 		/// does not affect other open instances of the same patch
 		void closePatch(pd::Patch &patch);
 
+		/// convert a patch file to the compiled ".pdc" format, which opens
+		/// faster as it needs no parsing, ie. on boards with slow storage
+		///
+		/// the path is relative to the data folder, outPatch is relative to
+		/// the patch's folder, default: the patch name with a ".pdc" extension
+		///
+		/// openPatch() takes either kind of file
+		///
+		bool compilePatch(const std::string &patch, const std::string &outPatch="");
+
+		/// suspend a patch: it stays loaded but receives no messages,
+		/// its timers stop and it's left out of audio processing,
+		/// returns true on success
+		///
+		/// resuming is much faster than reopening, so several scenes can
+		/// be kept loaded and switched between:
+		///
+		///   pd.suspendPatch(sceneA);
+		///   pd.resumePatch(sceneB);
+		///
+		bool suspendPatch(pd::Patch &patch);
+
+		/// resume a suspended patch, timers continue with the time they had left,
+		/// returns true on success
+		bool resumePatch(pd::Patch &patch);
+
 	/// \section Audio Processing Control
 
 		/// start/stop audio processing
@@ -287,6 +313,18 @@ class ofxPd : public pd::PdBase, protected pd::PdReceiver, protected pd::PdMidiR
 		///
 		/// see PdBase.h for function declarations
 
+		/// bulk float lists, sent at once without per element calls
+		///
+		/// std::vector<float> values(256);
+		/// pd.sendList("test", values);
+		///
+		/// intern the destination once for repeated sends:
+		///
+		/// pd::Interned test = pd.intern("test");
+		/// pd.sendList(test, values);
+		///
+		/// see PdBase.h for function declarations
+
 		/// midi
 		///
 		/// send midi messages, any out of range messages will be silently ignored
@@ -359,8 +397,62 @@ class ofxPd : public pd::PdBase, protected pd::PdReceiver, protected pd::PdMidiR
 		///
 		/// clearArray("array1", 0);
 		///
+		/// direct, zero-copy access to the live array samples, note: the pd
+		/// instance stays locked until the view is closed, so keep it short
+		///
+		/// pd::ArrayView view;
+		/// if(pd.openArray("array1", view)) {
+		///     view.read(&array1[0], 0, view.size());
+		/// }
+		///
+		/// see PdBase.h for function declarations
+
+	/// \section Sound Files
+
+		/// large, uncompressed soundfiles can be mapped into memory instead of
+		/// loaded into arrays, only the parts read take up memory:
+		///
+		/// pd::SoundFileMap map;
+		/// if(pd.openSoundFile("sounds/drums.wav", map)) {
+		///     map.prefetch(0, numFrames); // page in, blocks
+		///     map.read(&frames[0], offset, numFrames); // interleaved
+		/// }
+		///
+		/// reads never wait for the disk, frames not paged in yet read as zeros
+		///
+		/// use the [sfread4~] object to play mapped soundfiles in a patch
+		///
+		/// many soundfiles can be read into arrays on background threads,
+		/// progress and completion are sent to a receiver:
+		///
+		/// pd.subscribe("loader"); // "progress ndone nfiles", "done nread nfailed"
+		/// pd.readSoundFiles("loader", files, arrays);
+		///
+		/// [readsf~] drops blocks rather than stall audio when the disk can't
+		/// keep up ([writesf~] too after a "wait 0" message), count them with
+		/// soundFileUnderruns() or use setSoundFileWait(true) when processing
+		/// faster than realtime
+		///
 		/// see PdBase.h for function declarations
 
+	/// \section Offline Rendering
+
+		/// render a patch into a soundfile as fast as possible, without an
+		/// audio device, takes absolute or relative paths (in data folder)
+		///
+		/// pd::RenderJob job("synth.pd", "patches", "renders/out.wav", 10000);
+		/// job.addInput("sounds/voice.wav"); // feeds [adc~]
+		/// job.addFloat(2500, "cutoff", 1200); // at 2.5 seconds
+		/// pd.render(job);
+		///
+		/// the audio settings from init() are restored afterwards, but don't
+		/// render while this instance is processing realtime audio, use a
+		/// separate ofxPd instance (compiled with PDINSTANCE) instead; renders
+		/// on separate instances can run in parallel on separate threads
+		///
+		/// see PdBase.h & PdTypes.h for details
+		bool render(const pd::RenderJob &job);
+
 	/// \section Utils
 
 		/// has this pd instance been initialized?
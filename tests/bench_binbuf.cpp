@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// times binbuf_text() against the tokenizer it replaced on the corpus: the
+// array data patch, the [text] style file, and the rest taken together
+
+#include "PdBase.hpp"
+#include "test.h"
+#include "binbuf.h"
+
+// best of 7 in ms for tokenizing the files
+template<class Tokenize>
+static double best(const std::vector<const CorpusFile *> &files, Tokenize tokenize) {
+	double best = 1e30;
+	for(int run = 0; run < 7; run++) {
+		double t = testNow();
+		for(const CorpusFile *file : files) {tokenize(file->text);}
+		best = std::min(best, testNow() - t);
+	}
+	return best;
+}
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	pd.init(0, 1, 44100);
+
+	std::vector<CorpusFile> corpus = makeCorpus("..");
+	std::vector<const CorpusFile *> groups[3];
+	for(const CorpusFile &file : corpus) {
+		groups[file.name == "data.pd" ? 0 : file.name == "text.txt" ? 1 : 2]
+			.push_back(&file);
+	}
+	const char *names[] = {"array data patch", "text file", "other files"};
+
+	t_binbuf *b = binbuf_new();
+	std::printf("%-18s %8s %10s %10s\n", "", "MB", "old ms", "new ms");
+	for(int g = 0; g < 3; g++) {
+		size_t bytes = 0;
+		for(const CorpusFile *file : groups[g]) {bytes += file->text.size();}
+		double old = best(groups[g], [](const std::string &text) {
+			oldBinbufText(text.data(), text.size());
+		});
+		double now = best(groups[g], [b](const std::string &text) {
+			binbuf_text(b, text.data(), text.size());
+		});
+		std::printf("%-18s %8.2f %10.2f %10.2f\n", names[g], bytes / 1e6,
+			old, now);
+	}
+	binbuf_free(b);
+	return EXIT_SUCCESS;
+}
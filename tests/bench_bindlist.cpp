@@ -0,0 +1,51 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// times a float sent to N [r] objects bound to the same name, as from an [s],
+// for N from 1 to 10000
+//
+// usage: bench_bindlist [deliveries in millions]
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <fstream>
+#include <string>
+
+int main(int argc, char **argv) {
+	double millions = (argc > 1 ? std::atof(argv[1]) : 20);
+
+	pd::PdBase pd;
+	pd.init(0, 1, 44100);
+
+	std::printf("%g million deliveries per row, best of 3:\n", millions);
+	for(int receivers : {1, 10, 100, 1000, 10000}) {
+		std::ofstream file("build/bench_bindlist.pd");
+		file << "#N canvas 0 50 450 300 12;\n";
+		for(int i = 0; i < receivers; i++) {file << "#X obj 0 0 r bench;\n";}
+		file.close();
+		pd::Patch patch = pd.openPatch("bench_bindlist.pd", "build");
+		if(!patch.isValid()) {return EXIT_FAILURE;}
+
+		long sends = millions * 1e6 / receivers;
+		double best = 1e30;
+		for(int run = 0; run < 3; run++) {
+			double t = testNow();
+			for(long i = 0; i < sends; i++) {pd.sendFloat("bench", i);}
+			best = std::min(best, testNow() - t);
+		}
+		std::printf("%5d receivers: %8ld sends in %7.1f ms, %7.1f ns per send, "
+			"%5.2f ns per receiver\n", receivers, sends, best, best * 1e6 / sends,
+			best * 1e6 / (sends * receivers));
+		pd.closePatch(patch);
+	}
+	std::remove("build/bench_bindlist.pd");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// times the clock scheduler with many active clocks, each resetting itself
+// when it goes off like a [metro] with one of 97 different periods
+//
+// usage: bench_clocks [clocks] [seconds]
+
+#include "PdBase.hpp"
+#include "m_pd.h"
+#include "test.h"
+
+struct Metro {
+	t_clock *clock;
+	double period;
+	static long count;
+	static void tick(Metro *x) {
+		clock_delay(x->clock, x->period);
+		count++;
+	}
+};
+long Metro::count = 0;
+
+int main(int argc, char **argv) {
+	int numClocks = (argc > 1 ? std::atoi(argv[1]) : 100000);
+	double seconds = (argc > 2 ? std::atof(argv[2]) : 1);
+	const int rate = 44100, ticks = seconds * rate / 64;
+
+	pd::PdBase pd;
+	pd.init(0, 1, rate);
+	std::vector<float> out(64);
+
+	std::vector<Metro> metros(numClocks);
+	double t = testNow();
+	for(int i = 0; i < numClocks; i++) {
+		metros[i].clock = clock_new(&metros[i], (t_method)Metro::tick);
+		metros[i].period = 1 + (i % 97) * 0.37;
+		clock_delay(metros[i].clock, metros[i].period);
+	}
+	double set = testNow() - t;
+
+	t = testNow();
+	for(int i = 0; i < ticks; i++) {pd.processFloat(1, NULL, out.data());}
+	double run = testNow() - t;
+
+	std::printf("%d clocks: set in %.1f ms, %g seconds in %.1f ms, "
+		"%ld callbacks at %.0f ns each\n", numClocks, set, seconds, run,
+		Metro::count, run * 1e6 / Metro::count);
+
+	for(Metro &m : metros) {clock_free(m.clock);}
+	return EXIT_SUCCESS;
+}
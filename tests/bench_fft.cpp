@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// times the mayer_* real and complex FFTs against the Ooura FFT wrapped the
+// same way, for sizes 64 to 65536
+//
+// usage: bench_fft [points per size]
+
+#include "PdBase.hpp"
+#include "test.h"
+#include "fft.h"
+
+// best of 5 runs of f, in ns per call
+template<typename F>
+static double best(int calls, F f) {
+	double ns = 1e18;
+	for(int run = 0; run < 5; run++) {
+		double start = testNow();
+		for(int i = 0; i < calls; i++) {f();}
+		ns = std::min(ns, (testNow() - start) * 1e6 / calls);
+	}
+	return ns;
+}
+
+int main(int argc, char **argv) {
+	// enough calls for each size to transform this many points
+	long points = (argc > 1 ? std::atol(argv[1]) : 1 << 22);
+	pd::PdBase pd;
+	pd.init(0, 2, 44100);
+
+	std::printf("    n    real fwd+inv (ns)        complex fwd+inv (ns)\n"
+	            "         ooura   default speedup  ooura   default speedup\n");
+	for(int n = 64; n <= 65536; n *= 2) {
+		int calls = std::max(1L, points / n);
+		OouraFFT ooura(n);
+		std::vector<t_sample> x(n), re(n / 2), im(n / 2);
+		for(auto &f : x) {f = std::rand() / (t_sample)RAND_MAX * 2 - 1;}
+		for(int i = 0; i < n / 2; i++) {re[i] = x[2 * i], im[i] = x[2 * i + 1];}
+
+		// scale between calls to keep the values bounded
+		t_sample scale = 1.0 / n;
+		double realooura = best(calls, [&] {
+			ooura.realfft(x.data());
+			ooura.realifft(x.data());
+			for(auto &f : x) {f *= scale;}
+		});
+		double realsimd = best(calls, [&] {
+			mayer_realfft(n, x.data());
+			mayer_realifft(n, x.data());
+			for(auto &f : x) {f *= scale;}
+		});
+		scale = 2.0 / n;
+		double cplxooura = best(calls, [&] {
+			ooura.fft(re.data(), im.data(), -1);
+			ooura.fft(re.data(), im.data(), 1);
+			for(auto &f : re) {f *= scale;}
+			for(auto &f : im) {f *= scale;}
+		});
+		double cplxsimd = best(calls, [&] {
+			mayer_fft(n / 2, re.data(), im.data());
+			mayer_ifft(n / 2, re.data(), im.data());
+			for(auto &f : re) {f *= scale;}
+			for(auto &f : im) {f *= scale;}
+		});
+		std::printf("%5d %8.0f %8.0f %6.2fx %8.0f %8.0f %6.2fx\n", n,
+			realooura, realsimd, realooura / realsimd,
+			cplxooura, cplxsimd, cplxooura / cplxsimd);
+	}
+	return 0;
+}
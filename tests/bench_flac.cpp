@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// times loading a stereo FLAC file into arrays with [soundfiler] against the
+// same samples as a WAV file, at 16 and 24 bit; the FLAC files are made by a
+// small encoder below using a fixed 2nd order predictor and rice coding, as
+// the decoder has no encoder to go with it
+//
+// usage: bench_flac [seconds]
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <cmath>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// msb first bit writer with the FLAC checksums
+class BitWriter {
+	public:
+		std::vector<unsigned char> bytes;
+		void bits(unsigned long long v, int n) {
+			for(int i = n - 1; i >= 0; i--) {
+				acc = (acc << 1) | ((v >> i) & 1);
+				if(++count == 8) {
+					bytes.push_back(acc);
+					acc = count = 0;
+				}
+			}
+		}
+		void unary(unsigned int q) { // q zeros then a one
+			for(; q >= 32; q -= 32) {bits(0, 32);}
+			bits(1, q + 1);
+		}
+		void align() {if(count) {bits(0, 8 - count);}}
+		unsigned char crc8() const {
+			unsigned char crc = 0;
+			for(unsigned char b : bytes) {
+				crc ^= b;
+				for(int i = 0; i < 8; i++) {
+					crc = (crc & 0x80 ? (crc << 1) ^ 0x07 : crc << 1);
+				}
+			}
+			return crc;
+		}
+		unsigned short crc16() const {
+			unsigned short crc = 0;
+			for(unsigned char b : bytes) {
+				crc ^= b << 8;
+				for(int i = 0; i < 8; i++) {
+					crc = (crc & 0x8000 ? (crc << 1) ^ 0x8005 : crc << 1);
+				}
+			}
+			return crc;
+		}
+	private:
+		unsigned int acc = 0;
+		int count = 0;
+};
+
+// write planar integer samples as FLAC with 4096 frame blocks
+static bool writeFlac(const char *path, const std::vector<std::vector<int>> &chans,
+                      int bits, int rate) {
+	const int blocksize = 4096, porder = 4, nch = chans.size();
+	const int total = chans[0].size();
+	const int method = (bits > 16), escape = (method ? 31 : 15);
+	BitWriter out;
+	for(const char *c = "fLaC"; *c; c++) {out.bits(*c, 8);}
+	out.bits(0x80, 8); out.bits(34, 24); // last metadata block, STREAMINFO
+	out.bits(blocksize, 16); out.bits(blocksize, 16);
+	out.bits(0, 24); out.bits(0, 24);
+	out.bits(rate, 20); out.bits(nch - 1, 3); out.bits(bits - 1, 5);
+	out.bits(total, 36);
+	out.bits(0, 64); out.bits(0, 64); // no MD5
+	for(int pos = 0, num = 0; pos < total; pos += blocksize, num++) {
+		int n = std::min(blocksize, total - pos);
+		BitWriter frame;
+		frame.bits(0x3ffe, 14); frame.bits(0, 2);
+		frame.bits(n == blocksize ? 12 : 7, 4); // 4096 or 16 bit size below
+		frame.bits(0, 4); // rate from STREAMINFO
+		frame.bits(nch - 1, 4); frame.bits(bits == 16 ? 4 : 6, 3);
+		frame.bits(0, 1);
+		if(num < 0x80) {frame.bits(num, 8);} // utf-8 style frame number
+		else if(num < 0x800) {
+			frame.bits(0xc0 | (num >> 6), 8); frame.bits(0x80 | (num & 0x3f), 8);
+		}
+		else {
+			frame.bits(0xe0 | (num >> 12), 8);
+			frame.bits(0x80 | ((num >> 6) & 0x3f), 8);
+			frame.bits(0x80 | (num & 0x3f), 8);
+		}
+		if(n != blocksize) {frame.bits(n - 1, 16);}
+		frame.bits(frame.crc8(), 8);
+		for(int c = 0; c < nch; c++) {
+			const int *s = chans[c].data() + pos;
+			int order = std::min(2, n);
+			frame.bits(0, 1); frame.bits(8 | order, 6); frame.bits(0, 1);
+			for(int i = 0; i < order; i++) {frame.bits(s[i] & ((1 << bits) - 1), bits);}
+			int parts = (n % (1 << porder) || (n >> porder) < order ? 0 : porder);
+			frame.bits(method, 2); frame.bits(parts, 4);
+			for(int p = 0, i = order; p < (1 << parts); p++) {
+				int end = (p + 1) * (n >> parts);
+				std::vector<unsigned int> res;
+				for(; i < end; i++) {
+					int r = (order == 2 ? s[i] - 2 * s[i-1] + s[i-2] : s[i] - s[i-1]);
+					res.push_back(r >= 0 ? 2u * r : -2u * r - 1);
+				}
+				// rice parameter with the fewest bits
+				int k = 0;
+				unsigned long long best = ~0ull;
+				for(int t = 0; t < escape; t++) {
+					unsigned long long cost = res.size() * (t + 1);
+					for(unsigned int u : res) {cost += u >> t;}
+					if(cost < best) {best = cost; k = t;}
+				}
+				frame.bits(k, method ? 5 : 4);
+				for(unsigned int u : res) {
+					frame.unary(u >> k);
+					frame.bits(u & ((1u << k) - 1), k);
+				}
+			}
+		}
+		frame.align();
+		frame.bits(frame.crc16(), 16);
+		out.bytes.insert(out.bytes.end(), frame.bytes.begin(), frame.bytes.end());
+	}
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char *)out.bytes.data(), out.bytes.size());
+	return file.good();
+}
+
+// write interleaved little endian integer samples as WAV
+static bool writeWav(const char *path, const std::vector<std::vector<int>> &chans,
+                     int bits, int rate) {
+	const int nch = chans.size(), total = chans[0].size(), bytes = bits / 8;
+	std::vector<unsigned char> data;
+	auto le = [&data](unsigned v, int n) {
+		for(int i = 0; i < n; i++) {data.push_back(v >> (8 * i));}
+	};
+	data.insert(data.end(), {'R', 'I', 'F', 'F'}); le(36 + total * nch * bytes, 4);
+	data.insert(data.end(), {'W', 'A', 'V', 'E', 'f', 'm', 't', ' '});
+	le(16, 4); le(1, 2); le(nch, 2); le(rate, 4);
+	le(rate * nch * bytes, 4); le(nch * bytes, 2); le(bits, 2);
+	data.insert(data.end(), {'d', 'a', 't', 'a'}); le(total * nch * bytes, 4);
+	for(int i = 0; i < total; i++) {
+		for(int c = 0; c < nch; c++) {le(chans[c][i], bytes);}
+	}
+	std::ofstream file(path, std::ios::binary);
+	file.write((const char *)data.data(), data.size());
+	return file.good();
+}
+
+static long fileSize(const char *path) {
+	std::ifstream file(path, std::ios::binary | std::ios::ate);
+	return file.tellg();
+}
+
+int main(int argc, char **argv) {
+	double seconds = (argc > 1 ? std::atof(argv[1]) : 60);
+	const int rate = 48000, frames = seconds * rate;
+
+	pd::PdBase pd;
+	pd.init(0, 2, rate);
+	std::ofstream patch("build/bench_flac.pd");
+	patch << "#N canvas 0 50 450 300 12;\n"
+	      << "#X obj 0 0 r sf;\n"
+	      << "#X obj 0 0 soundfiler;\n"
+	      << "#X obj 0 0 table left;\n"
+	      << "#X obj 0 0 table right;\n"
+	      << "#X connect 0 0 1 0;\n";
+	patch.close();
+	pd::Patch p = pd.openPatch("bench_flac.pd", "build");
+	if(!p.isValid()) {return EXIT_FAILURE;}
+
+	std::printf("stereo, %g seconds at %d Hz, best of 3:\n", seconds, rate);
+	for(int bits = 16; bits <= 24; bits += 8) {
+		// two sines and a little noise per channel
+		const int amp = (1 << (bits - 1)) - 1;
+		std::vector<std::vector<int>> chans(2, std::vector<int>(frames));
+		for(int c = 0; c < 2; c++) {
+			for(int i = 0; i < frames; i++) {
+				double x = 0.5 * std::sin((0.01 + 0.003 * c) * i) +
+					0.3 * std::sin((0.0371 + 0.001 * c) * i + c) +
+					0.002 * (std::rand() / (double)RAND_MAX - 0.5);
+				chans[c][i] = x * amp;
+			}
+		}
+		std::string name = "bench_flac" + std::to_string(bits);
+		std::string wav = name + ".wav", flac = name + ".flac";
+		writeWav(("build/" + wav).c_str(), chans, bits, rate);
+		writeFlac(("build/" + flac).c_str(), chans, bits, rate);
+
+		std::vector<float> decoded[2];
+		for(const std::string &file : {wav, flac}) {
+			double best = 1e30;
+			for(int run = 0; run < 3; run++) {
+				double t = testNow();
+				pd.sendMessage("sf", "read",
+					pd::List() << "-resize" << file << "left" << "right");
+				best = std::min(best, testNow() - t);
+			}
+			long size = fileSize(("build/" + file).c_str());
+			std::printf("%d bit %-4s %6.1f MB %8.1f ms %7.1f MB/s %6.0fx realtime\n",
+				bits, file.substr(file.rfind('.') + 1).c_str(), size / 1e6,
+				best, size / 1e3 / best, seconds * 1e3 / best);
+		}
+		// both files hold the same samples, the FLAC file was read last
+		pd.readArray("right", decoded[1]);
+		pd.sendMessage("sf", "read", pd::List() << wav << "left" << "right");
+		pd.readArray("right", decoded[0]);
+		if(decoded[0] != decoded[1]) {
+			std::printf("%d bit: FLAC and WAV samples differ\n", bits);
+			return EXIT_FAILURE;
+		}
+		std::remove(("build/" + wav).c_str());
+		std::remove(("build/" + flac).c_str());
+	}
+
+	pd.closePatch(p);
+	return EXIT_SUCCESS;
+}
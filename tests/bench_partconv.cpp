@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// times a stereo [partconv~] with a 5 second impulse response at 48 kHz,
+// with 64 sample partitions (no latency at the default block size) and
+// with larger ones for comparison
+//
+// usage: bench_partconv [seconds of audio]
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+int main(int argc, char **argv) {
+	double seconds = (argc > 1 ? std::atof(argv[1]) : 10);
+	const int rate = 48000, irsize = 5 * rate;
+	const int ticks = seconds * rate / 64;
+
+	pd::PdBase pd;
+	pd.init(2, 2, rate);
+
+	// the same decaying noise for both channels
+	std::vector<float> ir(irsize), in(2 * 64 * 16), out(2 * 64 * 16);
+	for(int i = 0; i < irsize; i++) {
+		ir[i] = (std::rand() / (float)RAND_MAX * 2 - 1) *
+			std::exp(-6.9f * i / irsize);
+	}
+	for(auto &f : in) {f = std::rand() / (float)RAND_MAX * 2 - 1;}
+
+	std::printf("stereo, %d point impulse response, %d Hz:\n", irsize, rate);
+	for(int partsize = 64; partsize <= 1024; partsize *= 4) {
+		std::ofstream patch("build/bench_partconv.pd");
+		patch << "#N canvas 0 50 450 300 12;\n"
+		      << "#X obj 0 0 table ir " << irsize << ";\n"
+		      << "#X obj 0 0 adc~ 1 2;\n"
+		      << "#X obj 0 0 partconv~ ir " << partsize << ";\n"
+		      << "#X obj 0 0 partconv~ ir " << partsize << ";\n"
+		      << "#X obj 0 0 dac~ 1 2;\n"
+		      << "#X connect 1 0 2 0;\n"
+		      << "#X connect 1 1 3 0;\n"
+		      << "#X connect 2 0 4 0;\n"
+		      << "#X connect 3 0 4 1;\n";
+		patch.close();
+		// partconv~ loads the array when dsp starts
+		pd.computeAudio(false);
+		pd::Patch p = pd.openPatch("bench_partconv.pd", "build");
+		pd.writeArray("ir", ir);
+		pd.computeAudio(true);
+
+		// best of 3, 16 ticks per call
+		float peak = 0;
+		for(int i = 0; i < 2; i++) { // past the latency
+			pd.processFloat(16, in.data(), out.data());
+			for(auto f : out) {peak = std::max(peak, std::fabs(f));}
+		}
+		if(peak == 0) {
+			std::printf("no output, impulse response not loaded?\n");
+			return 1;
+		}
+		double best = 1e9;
+		for(int run = 0; run < 3; run++) {
+			double start = testNow();
+			for(int i = 0; i < ticks; i += 16) {
+				pd.processFloat(16, in.data(), out.data());
+			}
+			best = std::min(best, (testNow() - start) / 1000);
+		}
+		std::printf("  %4d point partitions (latency %4d): %.2f s for %.0f s "
+			"of audio, %.1f%% of one core\n", partsize,
+			partsize > 64 ? partsize : 0, best, seconds,
+			100 * best / seconds);
+		pd.closePatch(p);
+	}
+	return 0;
+}
@@ -0,0 +1,154 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// times the sample format converters in d_soundfile.c: writing and reading
+// a multichannel file of each sample size and byte order, both from arrays
+// with [soundfiler] and streamed with [writesf~] and [readsf~]
+//
+// usage: bench_soundfile [seconds] [channels]
+//
+// the defaults are 60 seconds of 32 channels at 48 kHz; the times are also
+// given per hour of audio. the [soundfiler] part keeps the whole file in
+// arrays, so a real hour needs about 700 MB per channel, while the streamed
+// part runs for any length given enough disk space
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <cmath>
+#include <fstream>
+#include <vector>
+
+class Receiver : public pd::PdReceiver {
+	public:
+		int done = 0;
+		void receiveBang(const std::string &dest) {done++;}
+};
+
+struct Format {
+	const char *name;
+	const char *flag; // file type flag
+	const char *ext;
+	int bytes;
+};
+
+int main(int argc, char **argv) {
+	double seconds = (argc > 1 ? std::atof(argv[1]) : 60);
+	int channels = (argc > 2 ? std::atoi(argv[2]) : 32);
+	const int rate = 48000;
+	const int frames = seconds * rate, ticks = frames / 64;
+
+	pd::PdBase pd;
+	Receiver receiver;
+	pd.init(0, 1, rate);
+	pd.setReceiver(&receiver);
+	pd.subscribe("rsf-done");
+	pd.setSoundFileWait(true); // time the conversions, don't drop blocks
+	pd.setMaxMessageLen(channels + 8); // soundfiler messages name every array
+
+	std::ofstream patch("build/bench_soundfile.pd");
+	patch << "#N canvas 0 50 450 300 12;\n"
+	      << "#X obj 0 0 r sf;\n"
+	      << "#X obj 0 0 soundfiler;\n"
+	      << "#X obj 0 0 noise~;\n"
+	      << "#X obj 0 0 r wsf;\n"
+	      << "#X obj 0 0 writesf~ " << channels << ";\n"
+	      << "#X obj 0 0 r rsf;\n"
+	      << "#X obj 0 0 readsf~ " << channels << ";\n"
+	      << "#X obj 0 0 s rsf-done;\n";
+	for(int c = 0; c < channels; c++) {
+		patch << "#X obj 0 0 table a" << c << " " << frames << ";\n";
+	}
+	patch << "#X connect 0 0 1 0;\n"
+	      << "#X connect 3 0 4 0;\n"
+	      << "#X connect 5 0 6 0;\n"
+	      << "#X connect 6 " << channels << " 7 0;\n";
+	for(int c = 0; c < channels; c++) {
+		patch << "#X connect 2 0 4 " << c << ";\n";
+	}
+	patch.close();
+	pd::Patch p = pd.openPatch("bench_soundfile.pd", "build");
+	if(!p.isValid()) {return EXIT_FAILURE;}
+
+	// a different sine per channel, at half scale
+	std::vector<float> array(frames);
+	for(int c = 0; c < channels; c++) {
+		float inc = 2 * M_PI * (100 + 10 * c) / rate;
+		for(int i = 0; i < frames; i++) {array[i] = 0.5f * std::sin(inc * i);}
+		pd.writeArray("a" + std::to_string(c), array);
+	}
+	array.clear();
+	array.shrink_to_fit();
+
+	const Format formats[] = {
+		{"16 bit little endian", "-wave", "wav", 2},
+		{"24 bit little endian", "-wave", "wav", 3},
+		{"float little endian", "-wave", "wav", 4},
+		{"16 bit big endian", "-aiff", "aif", 2},
+		{"24 bit big endian", "-aiff", "aif", 3},
+		{"float big endian", "-aiff", "aif", 4},
+	};
+	double hour = 3600 / seconds;
+	std::printf("%d channels, %g seconds at %d Hz, ms (ms per hour):\n",
+		channels, seconds, rate);
+	std::printf("%-22s %22s %22s %22s %22s\n", "", "soundfiler write",
+		"soundfiler read", "writesf~", "readsf~");
+	std::vector<float> out(64);
+	for(const Format &f : formats) {
+		std::string file = std::string("bench_soundfile.") + f.ext;
+		double t[4];
+
+		// arrays to file and back
+		pd::List write, read;
+		write << f.flag << "-bytes" << f.bytes << file;
+		read << file;
+		for(int c = 0; c < channels; c++) {
+			write << "a" + std::to_string(c);
+			read << "a" + std::to_string(c);
+		}
+		t[0] = testNow();
+		pd.sendMessage("sf", "write", write);
+		t[0] = testNow() - t[0];
+		t[1] = testNow();
+		pd.sendMessage("sf", "read", read);
+		t[1] = testNow() - t[1];
+
+		// noise recorded and played back, the dsp graph does little else
+		pd.computeAudio(true);
+		pd.sendMessage("wsf", "open",
+			pd::List() << f.flag << "-bytes" << f.bytes << file);
+		t[2] = testNow();
+		pd.sendMessage("wsf", "start");
+		for(int i = 0; i < ticks; i++) {pd.processFloat(1, NULL, out.data());}
+		pd.sendMessage("wsf", "stop");
+		// opening waits until the last file is written, use another name
+		pd.sendMessage("wsf", "open", pd::List() << "bench_soundfile.tmp");
+		t[2] = testNow() - t[2];
+		receiver.done = 0;
+		pd.sendMessage("rsf", "open", pd::List() << file);
+		t[3] = testNow();
+		pd.sendFloat("rsf", 1);
+		while(!receiver.done) {pd.processFloat(1, NULL, out.data());}
+		t[3] = testNow() - t[3];
+		pd.computeAudio(false);
+
+		std::printf("%-22s", f.name);
+		for(double ms : t) {
+			std::printf(" %10.1f (%9.1f)", ms, ms * hour);
+		}
+		std::printf("\n");
+	}
+
+	pd.closePatch(p);
+	std::remove("build/bench_soundfile.wav");
+	std::remove("build/bench_soundfile.aif");
+	std::remove("build/bench_soundfile.tmp");
+	return EXIT_SUCCESS;
+}
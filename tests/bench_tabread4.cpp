@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// times 32 [tabread4~] reading a 65536 point table and 32 [tabosc4~]
+//
+// usage: bench_tabread4 [ticks]
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <fstream>
+#include <vector>
+
+int main(int argc, char **argv) {
+	int ticks = (argc > 1 ? std::atoi(argv[1]) : 20000), objects = 32;
+
+	// write the patch: phasor~ -> *~ -> tabread4~ and tabosc4~, all summed
+	std::ofstream patch("build/bench_tabread4.pd");
+	patch << "#N canvas 0 50 450 300 12;\n"
+	      << "#X obj 0 0 table big 65539;\n"
+	      << "#X obj 0 0 table osc 2051;\n"
+	      << "#X obj 0 0 dac~ 1;\n";
+	int obj = 3;
+	for(int i = 0; i < objects; i++) {
+		patch << "#X obj 0 0 phasor~ " << 0.5 + i * 0.37 << ";\n"
+		      << "#X obj 0 0 *~ 65536;\n"
+		      << "#X obj 0 0 tabread4~ big;\n"
+		      << "#X obj 0 0 tabosc4~ osc;\n"
+		      << "#X connect " << obj << " 0 " << obj + 1 << " 0;\n"
+		      << "#X connect " << obj + 1 << " 0 " << obj + 2 << " 0;\n"
+		      << "#X connect " << obj + 2 << " 0 2 0;\n"
+		      << "#X connect " << obj + 3 << " 0 2 0;\n"
+		      << "#X msg 0 0 " << 110 + i * 13.5 << ";\n"
+		      << "#X obj 0 0 loadbang;\n"
+		      << "#X connect " << obj + 5 << " 0 " << obj + 4 << " 0;\n"
+		      << "#X connect " << obj + 4 << " 0 " << obj + 3 << " 0;\n";
+		obj += 6;
+	}
+	patch.close();
+
+	pd::PdBase pd;
+	pd.init(0, 1, 44100);
+	pd.computeAudio(true);
+	pd::Patch p = pd.openPatch("bench_tabread4.pd", "build");
+	std::vector<float> big(65539), osc(2051), out(64);
+	for(auto &f : big) {f = std::rand() / (float)RAND_MAX * 2 - 1;}
+	for(auto &f : osc) {f = std::rand() / (float)RAND_MAX * 2 - 1;}
+	pd.writeArray("big", big);
+	pd.writeArray("osc", osc);
+
+	// best of 7
+	double best = 1e9;
+	for(int run = 0; run < 7; run++) {
+		double start = testNow();
+		for(int i = 0; i < ticks; i++) {
+			pd.processFloat(1, nullptr, out.data());
+		}
+		best = std::min(best, (testNow() - start) * 1000 / ticks);
+	}
+	std::printf("%d tabread4~ + %d tabosc4~: %.2f us per 64 sample tick\n",
+		objects, objects, best);
+	pd.closePatch(p);
+	return 0;
+}
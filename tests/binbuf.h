@@ -0,0 +1,226 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+#pragma once
+
+// the binbuf_text() tokenizer as it was before words were scanned in place,
+// and a corpus of patches and text to compare and time it with
+
+#include "m_pd.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// binbuf_text() from pd 0.54, appending to a vector instead of a binbuf
+static std::vector<t_atom> oldBinbufText(const char *text, size_t size) {
+	std::vector<t_atom> atoms;
+	char buf[MAXPDSTRING+1], *bufp, *ebuf = buf+MAXPDSTRING;
+	const char *textp = text, *etext = text+size;
+	t_atom a, *ap = &a;
+	while(1) {
+		// skip leading space
+		while((textp != etext) && (*textp == ' ' || *textp == '\n'
+			|| *textp == '\r' || *textp == '\t')) textp++;
+		if(textp == etext) break;
+		if(*textp == ';') SETSEMI(ap), textp++;
+		else if(*textp == ',') SETCOMMA(ap), textp++;
+		else {
+			// it's an atom other than a comma or semi
+			char c;
+			int floatstate = 0, slash = 0, lastslash = 0, dollar = 0;
+			bufp = buf;
+			do {
+				c = *bufp = *textp++;
+				lastslash = slash;
+				slash = (c == '\\');
+				if(floatstate >= 0) {
+					int digit = (c >= '0' && c <= '9'),
+						dot = (c == '.'), minus = (c == '-'),
+						plusminus = (minus || (c == '+')),
+						expon = (c == 'e' || c == 'E');
+					if(floatstate == 0) { // beginning
+						if(minus) floatstate = 1;
+						else if(digit) floatstate = 2;
+						else if(dot) floatstate = 3;
+						else floatstate = -1;
+					}
+					else if(floatstate == 1) { // got minus
+						if(digit) floatstate = 2;
+						else if(dot) floatstate = 3;
+						else floatstate = -1;
+					}
+					else if(floatstate == 2) { // got digits
+						if(dot) floatstate = 4;
+						else if(expon) floatstate = 6;
+						else if(!digit) floatstate = -1;
+					}
+					else if(floatstate == 3) { // got '.' without digits
+						if(digit) floatstate = 5;
+						else floatstate = -1;
+					}
+					else if(floatstate == 4) { // got '.' after digits
+						if(digit) floatstate = 5;
+						else if(expon) floatstate = 6;
+						else floatstate = -1;
+					}
+					else if(floatstate == 5) { // got digits after .
+						if(expon) floatstate = 6;
+						else if(!digit) floatstate = -1;
+					}
+					else if(floatstate == 6) { // got 'e'
+						if(plusminus) floatstate = 7;
+						else if(digit) floatstate = 8;
+						else floatstate = -1;
+					}
+					else if(floatstate == 7) { // got plus or minus
+						if(digit) floatstate = 8;
+						else floatstate = -1;
+					}
+					else if(floatstate == 8) { // got digits
+						if(!digit) floatstate = -1;
+					}
+				}
+				if(!lastslash && c == '$' && (textp != etext &&
+					textp[0] >= '0' && textp[0] <= '9'))
+						dollar = 1;
+				if(!slash) bufp++;
+				else if(lastslash) {
+					bufp++;
+					slash = 0;
+				}
+			}
+			while(textp != etext && bufp != ebuf &&
+				(slash || (*textp != ' ' && *textp != '\n' && *textp != '\r'
+					&& *textp != '\t' &&*textp != ',' && *textp != ';')));
+			*bufp = 0;
+			if(floatstate == 2 || floatstate == 4 || floatstate == 5 ||
+				floatstate == 8)
+					SETFLOAT(ap, atof(buf));
+			else if(dollar) {
+				if(buf[0] != '$')
+					dollar = 0;
+				for(bufp = buf+1; *bufp; bufp++)
+					if(*bufp < '0' || *bufp > '9')
+						dollar = 0;
+				if(dollar)
+					SETDOLLAR(ap, atoi(buf+1));
+				else SETDOLLSYM(ap, gensym(buf));
+			}
+			else SETSYMBOL(ap, gensym(buf));
+		}
+		atoms.push_back(a);
+		if(textp == etext) break;
+	}
+	return atoms;
+}
+
+struct CorpusFile {
+	std::string name, text;
+};
+
+// every .pd file under dir, skipping build folders
+static void addPatches(std::vector<CorpusFile> &corpus, const std::string &dir) {
+	DIR *d = opendir(dir.c_str());
+	if(!d) {return;}
+	while(struct dirent *entry = readdir(d)) {
+		std::string name = entry->d_name, path = dir + "/" + name;
+		if(name[0] == '.' || name == "build") {continue;}
+		if(name.size() > 3 && name.compare(name.size() - 3, 3, ".pd") == 0) {
+			std::ifstream file(path, std::ios::binary);
+			std::stringstream text;
+			text << file.rdbuf();
+			corpus.push_back({path, text.str()});
+		}
+		else if(entry->d_type == DT_DIR) {addPatches(corpus, path);}
+	}
+	closedir(d);
+}
+
+// the repo's patches, a patch full of array data, a [text] style file, and
+// random text full of escapes, dollars, NULs, odd numbers and long words
+static std::vector<CorpusFile> makeCorpus(const std::string &repo) {
+	std::vector<CorpusFile> corpus;
+	addPatches(corpus, repo);
+	std::mt19937 rnd(7);
+	auto pick = [&rnd](int n) {return (int)(rnd() % n);};
+	auto uniform = [&rnd](double lo, double hi) {
+		return lo + (hi - lo) * (rnd() / 4294967296.0);
+	};
+	char num[32];
+
+	std::string s = "#N canvas 0 0 800 600 12;\n";
+	for(int a = 0; a < 10; a++) {
+		s += "#N canvas 0 0 450 300 (subpatch) 0;\n#X array tab" +
+			std::to_string(a) + " 16384 float 3;\n";
+		for(int i = 0; i < 16384; i++) {
+			if(i % 1000 == 0) {s += (i ? ";\n#A " : "#A ") + std::to_string(i);}
+			double ranges[4][2] = {{-1, 1}, {-1e-5, 1e-5}, {-1000, 1000},
+				{-1e7, 1e7}};
+			int r = pick(4);
+			double v = uniform(ranges[r][0], ranges[r][1]);
+			std::snprintf(num, sizeof(num), "%g", (r == 2 ? (int)v : v));
+			s += " " + std::string(num);
+		}
+		s += ";\n#X coords 0 1 16384 -1 200 140 1 0 0;\n#X restore 10 10 graph;\n";
+	}
+	const char *objects[] = {"+ 1", "osc~ 440", "t b f", "pack 0 0 \\$1",
+		"r \\$0-foo", "s \\$0-bar", "f \\$1", "line~", "*~ 0.5", "moses 64"};
+	for(int i = 0; i < 2000; i++) {
+		s += "#X obj " + std::to_string(i) + " " + std::to_string(i * 2) +
+			" " + objects[pick(10)] + ";\n";
+		s += "#X msg " + std::to_string(i) +
+			" 10 set \\$1 \\, add2 foo \\; pd dsp 1;\n";
+	}
+	corpus.push_back({"data.pd", s});
+
+	const char *words[] = {"alpha", "beta", "gamma", "note", "vel", "cue", "x",
+		"y", "z", "end"};
+	s.clear();
+	for(int i = 0; i < 20000; i++) {
+		for(int n = 1 + pick(8); n--; ) {
+			int r = pick(3);
+			if(r == 0) {s += words[pick(10)];}
+			else if(r == 1) {s += std::to_string(pick(128));}
+			else {
+				std::snprintf(num, sizeof(num), "%g", uniform(0, 10));
+				s += num;
+			}
+			s += (n ? " " : ";\n");
+		}
+	}
+	corpus.push_back({"text.txt", s});
+
+	const char alphabet[] = " \n\t\r;,\\$0123456789.-+eEab";
+	const char *odd[] = {"1e5", "1.e5", ".5", "-.5", "-", ".", "1e", "1e+",
+		"1e-400", "1e400", "0.30000000000000004", "123456789012345678", "-0",
+		"00012", "1.5E+3", "9007199254740993", "\\1", "1\\2", "$1", "\\$1",
+		"$1$2", "$a", "a$1", "\\\\", "\\;", "\\,"};
+	for(int k = 0; k < 200; k++) {
+		s.clear();
+		for(int n = pick(3000); n--; ) {
+			s += alphabet[pick(sizeof(alphabet))]; // includes the NUL
+		}
+		if(k % 10 == 0) {
+			s += std::string(990 + pick(110), 'x') + "\\ " +
+				std::string(990 + pick(20), '1') + " $" + std::string(1200, '2');
+		}
+		if(k % 7 == 0) {
+			for(int n = 0; n < 500; n++) {s += std::string(n ? " " : "") + odd[pick(26)];}
+		}
+		corpus.push_back({"fuzz" + std::to_string(k), s});
+	}
+	return corpus;
+}
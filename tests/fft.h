@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+#pragma once
+
+// the Ooura FFT from d_fft_fftsg.c, which is always compiled, wrapped in the
+// Mayer API as the PD_FFT_FFTSG build does, for comparing the default FFT
+
+#include "m_pd.h"
+#include <vector>
+
+extern "C" {
+	void cdft(int n, int isgn, double *a, int *ip, double *w);
+	void rdft(int n, int isgn, double *a, int *ip, double *w);
+}
+
+// tables and scratch for one size, n real points or n/2 complex ones
+struct OouraFFT {
+	int n;
+	std::vector<int> ip;
+	std::vector<double> w, buf;
+
+	OouraFFT(int n) : n(n), ip(2 + (1 << (ilog2(n) / 2)), 0), w(n / 2), buf(n) {}
+
+	// mayer_realfft()
+	void realfft(t_sample *fz) {
+		int nover2 = n / 2;
+		for(int i = 0; i < n; i++) {buf[i] = fz[i];}
+		rdft(n, 1, buf.data(), ip.data(), w.data());
+		fz[0] = buf[0];
+		fz[nover2] = buf[1];
+		for(int i = 1; i < nover2; i++) {
+			fz[i] = buf[2 * i];
+			fz[n - i] = buf[2 * i + 1];
+		}
+	}
+
+	// mayer_realifft()
+	void realifft(t_sample *fz) {
+		int nover2 = n / 2;
+		buf[0] = fz[0];
+		buf[1] = fz[nover2];
+		for(int i = 1; i < nover2; i++) {
+			buf[2 * i] = fz[i];
+			buf[2 * i + 1] = fz[n - i];
+		}
+		rdft(n, -1, buf.data(), ip.data(), w.data());
+		for(int i = 0; i < n; i++) {fz[i] = 2 * buf[i];}
+	}
+
+	// mayer_fft() (sgn -1) and mayer_ifft() (sgn 1) of n/2 points
+	void fft(t_sample *re, t_sample *im, int sgn) {
+		for(int i = 0; i < n / 2; i++) {
+			buf[2 * i] = re[i];
+			buf[2 * i + 1] = im[i];
+		}
+		cdft(n, sgn, buf.data(), ip.data(), w.data());
+		for(int i = 0; i < n / 2; i++) {
+			re[i] = buf[2 * i];
+			im[i] = buf[2 * i + 1];
+		}
+	}
+};
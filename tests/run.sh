@@ -0,0 +1,72 @@
+#! /bin/sh
+#
+# build the bundled libpd out of tree and run the tests against it
+#
+# usage: tests/run.sh [name ...]
+#
+# names are test_*.cpp or bench_*.cpp files without the extension; with
+# none given, every test_*.cpp is run (benchmarks only run when named)
+#
+# CFLAGS is added to the libpd and test flags, ie. for multiple instance
+# support or a sanitizer:
+#
+#    CFLAGS="-DPDINSTANCE -DPDTHREADS" tests/run.sh
+#    CFLAGS="-fsanitize=address -g" tests/run.sh test_readsf
+#
+# objects are kept in tests/build, remove it after changing CFLAGS
+
+# exit on error
+set -e
+
+cd "$(dirname $0)"
+LIBPD=../libs/libpd
+BUILD=build
+
+CC=${CC:-cc}
+CXX=${CXX:-c++}
+OPT=${OPT:--O2}
+
+# the same defines as addon_config.mk
+DEFS="-DPD -DUSEAPI_DUMMY -DPD_INTERNAL -DHAVE_UNISTD_H -DHAVE_ALLOCA_H -DLIBPD_EXTRA -DHAVE_LIBDL"
+case "$(uname -s)" in
+	Darwin) DEFS="$DEFS -DHAVE_MACHINE_ENDIAN_H -D_DARWIN_C_SOURCE" ;;
+	*) DEFS="$DEFS -DHAVE_ENDIAN_H" ;;
+esac
+INCLUDES="-I$LIBPD/pure-data/src -I$LIBPD/libpd_wrapper -I$LIBPD/libpd_wrapper/util -I$LIBPD/cpp"
+
+###
+
+# build libpd.a, only recompiling changed sources
+mkdir -p $BUILD/obj
+for src in $LIBPD/pure-data/src/*.c $LIBPD/libpd_wrapper/*.c \
+           $LIBPD/libpd_wrapper/util/*.c $LIBPD/pure-data/extra/*/*.c ; do
+	case $src in
+		*/binarymsg.c) continue ;; # included by pd~.c
+	esac
+	obj=$BUILD/obj/$(basename $src .c).o
+	if [ ! -f $obj ] || [ $src -nt $obj ] ; then
+		echo "cc $(basename $src)"
+		$CC $OPT $CFLAGS $DEFS $INCLUDES -w -c $src -o $obj
+	fi
+done
+rm -f $BUILD/libpd.a
+ar rcs $BUILD/libpd.a $BUILD/obj/*.o
+
+# build and run
+if [ $# -eq 0 ] ; then
+	set -- $(ls test_*.cpp | sed 's/\.cpp$//')
+fi
+failed=""
+for name in "$@" ; do
+	$CXX $OPT $CFLAGS -std=c++11 $DEFS $INCLUDES $name.cpp $BUILD/libpd.a \
+		-o $BUILD/$name -lpthread -ldl -lm
+	echo "--- $name"
+	if ! ./$BUILD/$name ; then
+		failed="$failed $name"
+	fi
+done
+if [ -n "$failed" ] ; then
+	echo "FAILED:$failed"
+	exit 1
+fi
+echo "all passed"
@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+#pragma once
+
+// small helpers shared by the tests and benchmarks, see run.sh
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+static int testFailures = 0;
+
+// report a failed check without stopping
+#define CHECK(cond) do { \
+	if(!(cond)) { \
+		std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #cond); \
+		testFailures++; \
+	} \
+} while(0)
+
+// exit status for main()
+static inline int testResult() {
+	std::printf(testFailures ? "%d check(s) failed\n" : "ok\n", testFailures);
+	return testFailures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+// milliseconds since some fixed point
+static inline double testNow() {
+	return std::chrono::duration<double, std::milli>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// write a 16 bit wav file from interleaved samples, which may be empty
+static inline bool testWriteWav(const char *path, int channels, int rate,
+                                const std::vector<short> &samples) {
+	FILE *fp = std::fopen(path, "wb");
+	if(!fp) {return false;}
+	auto u32 = [fp](unsigned v) {
+		for(int i = 0; i < 4; i++) {std::fputc((v >> (8 * i)) & 0xff, fp);}
+	};
+	auto u16 = [fp](unsigned v) {
+		std::fputc(v & 0xff, fp);
+		std::fputc((v >> 8) & 0xff, fp);
+	};
+	unsigned bytes = samples.size() * 2;
+	std::fputs("RIFF", fp); u32(36 + bytes); std::fputs("WAVE", fp);
+	std::fputs("fmt ", fp); u32(16); u16(1); u16(channels); u32(rate);
+	u32(rate * channels * 2); u16(channels * 2); u16(16);
+	std::fputs("data", fp); u32(bytes);
+	for(short v : samples) {u16((unsigned short)v);}
+	return std::fclose(fp) == 0;
+}
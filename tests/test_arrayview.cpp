@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks array copies and pd::ArrayView against per-sample access, and that
+// calls made while a view is open fail instead of deadlocking
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <vector>
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	pd.init(0, 2, 44100);
+	pd::Patch patch = pd.openPatch("arrays.pd", "patches");
+	CHECK(patch.isValid());
+	std::printf("t_word is %d bytes\n", (int)sizeof(t_word));
+
+	// whole array, odd size for the tails
+	std::vector<float> src(1003), dest;
+	std::srand(1);
+	for(auto &f : src) {f = std::rand() / (float)RAND_MAX * 2 - 1;}
+	CHECK(pd.writeArray("array1", src));
+	CHECK(pd.readArray("array1", dest));
+	CHECK(dest == src);
+
+	// every length and offset near the ends
+	for(int len = 0; len < 10; len++) {
+		for(int offset = 0; offset < 6; offset++) {
+			std::vector<float> part(len, 7), got;
+			CHECK(pd.writeArray("array1", part, len, offset));
+			CHECK(pd.readArray("array1", got, len + 2, offset));
+			for(int i = 0; i < len; i++) {CHECK(got[i] == 7);}
+			CHECK(got[len] == src[offset + len]);
+			CHECK(pd.writeArray("array1", src));
+		}
+	}
+	CHECK(!pd.readArray("array1", dest, 10, 1000));
+	CHECK(!pd.readArray("nosucharray", dest));
+
+	// view reads and writes in place
+	{
+		pd::ArrayView view;
+		CHECK(pd.openArray("array1", view));
+		CHECK(view.isValid());
+		CHECK(view.size() == 1003);
+		for(int i = 0; i < view.size(); i++) {CHECK(view[i] == src[i]);}
+		std::vector<float> part(997);
+		CHECK(view.read(part.data(), 3, 997));
+		for(int i = 0; i < 997; i++) {CHECK(part[i] == src[i + 3]);}
+		for(auto &f : part) {f *= 0.5f;}
+		CHECK(view.write(part.data(), 5, 997));
+		CHECK(view[4] == src[4]);
+		for(int i = 0; i < 997; i++) {CHECK(view[i + 5] == part[i]);}
+		CHECK(!view.read(part.data(), 10, 997));
+		CHECK(!view.write(part.data(), -1, 2));
+
+		// no deadlock: calls on this thread fail while the view is open
+		pd::ArrayView other;
+		CHECK(!pd.openArray("array2", other));
+		CHECK(!other.isValid());
+		CHECK(pd.arraySize("array1") == 0);
+		CHECK(!pd.readArray("array1", dest));
+		CHECK(!pd.processFloat(1, NULL, NULL));
+		pd.sendFloat("nowhere", 1);
+		view.fill(0.25f);
+	}
+	CHECK(pd.arraySize("array1") == 1003);
+	CHECK(pd.readArray("array1", dest));
+	for(auto f : dest) {CHECK(f == 0.25f);}
+
+	// closed views reopen, ie. after a resize
+	pd::ArrayView view;
+	CHECK(pd.openArray("array2", view));
+	CHECK(view.size() == 10);
+	view.close();
+	CHECK(!view.isValid());
+	CHECK(pd.resizeArray("array2", 20));
+	CHECK(pd.openArray("array2", view));
+	CHECK(view.size() == 20);
+	view.close();
+
+	pd.closePatch(patch);
+	return testResult();
+}
@@ -0,0 +1,63 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks that binbuf_text() makes the same atoms as the tokenizer it
+// replaced, down to the float bits, for every file in the corpus
+
+#include "PdBase.hpp"
+#include "test.h"
+#include "binbuf.h"
+
+static bool same(const t_atom &a, const t_atom &b) {
+	if(a.a_type != b.a_type) {return false;}
+	switch(a.a_type) {
+		case A_FLOAT:
+			return !std::memcmp(&a.a_w.w_float, &b.a_w.w_float, sizeof(t_float));
+		case A_SYMBOL: case A_DOLLSYM:
+			return a.a_w.w_symbol == b.a_w.w_symbol;
+		case A_DOLLAR:
+			return a.a_w.w_index == b.a_w.w_index;
+		default:
+			return true;
+	}
+}
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	pd.init(0, 1, 44100);
+
+	std::vector<CorpusFile> corpus = makeCorpus("..");
+	size_t bytes = 0, atoms = 0;
+	t_binbuf *b = binbuf_new();
+	for(const CorpusFile &file : corpus) {
+		std::vector<t_atom> expected =
+			oldBinbufText(file.text.data(), file.text.size());
+		binbuf_text(b, file.text.data(), file.text.size());
+		int n = binbuf_getnatom(b);
+		t_atom *vec = binbuf_getvec(b);
+		CHECK(n == (int)expected.size());
+		for(int i = 0; i < n && i < (int)expected.size(); i++) {
+			if(!same(vec[i], expected[i])) {
+				std::printf("%s: atom %d differs\n", file.name.c_str(), i);
+				CHECK(same(vec[i], expected[i]));
+				break;
+			}
+		}
+		bytes += file.text.size();
+		atoms += expected.size();
+	}
+	binbuf_free(b);
+	std::printf("%d files, %.1f MB, %d atoms\n", (int)corpus.size(),
+		bytes / 1e6, (int)atoms);
+	CHECK(corpus.size() > 210);
+
+	return testResult();
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks several objects bound to one symbol: messages go to the newest
+// first, objects unbound or freed during a message don't get it, objects
+// bound during a message don't get it either, and the bindlist goes back to
+// a single object once the outermost message is done
+
+#include "PdBase.hpp"
+#include "m_pd.h"
+#include "test.h"
+#include <functional>
+#include <map>
+
+static t_class *binderClass;
+
+struct Binder {
+	t_pd pd;
+	int id;
+};
+
+static std::vector<int> received;
+static std::map<int, std::function<void(float)>> actions;
+
+static void binderFloat(Binder *x, t_floatarg f) {
+	received.push_back(x->id);
+	auto action = actions.find(x->id);
+	if(action != actions.end()) {action->second(f);}
+}
+
+// like [receive], unbind when freed
+static void binderFree(Binder *x) {
+	pd_unbind(&x->pd, gensym("bindlist-x"));
+}
+
+static Binder *newBinder(int id, t_symbol *s) {
+	Binder *x = (Binder *)pd_new(binderClass);
+	x->id = id;
+	pd_bind(&x->pd, s);
+	return x;
+}
+
+static std::vector<int> send(t_symbol *s, float f) {
+	received.clear();
+	pd_float(s->s_thing, f);
+	return received;
+}
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	pd.init(0, 1, 44100);
+	binderClass = class_new(gensym("testbinder"), 0, (t_method)binderFree,
+		sizeof(Binder), CLASS_PD, A_NULL);
+	class_addfloat(binderClass, (t_method)binderFloat);
+	t_symbol *x = gensym("bindlist-x");
+
+	// newest first
+	std::vector<Binder *> b;
+	for(int i = 0; i < 5; i++) {b.push_back(newBinder(i, x));}
+	CHECK(send(x, 0) == std::vector<int>({4, 3, 2, 1, 0}));
+
+	// 3 unbinds 1 and itself and binds 5, which only gets the next one
+	actions[3] = [&](float) {
+		pd_unbind(&b[1]->pd, x);
+		pd_unbind(&b[3]->pd, x);
+		b.push_back(newBinder(5, x));
+	};
+	CHECK(send(x, 0) == std::vector<int>({4, 3, 2, 0}));
+	actions.clear();
+	CHECK(send(x, 0) == std::vector<int>({5, 4, 2, 0}));
+
+	// 5 frees 4 and unbinds 2 and 0, leaving itself bound directly
+	actions[5] = [&](float) {
+		pd_free(&b[4]->pd);
+		pd_unbind(&b[2]->pd, x);
+		pd_unbind(&b[0]->pd, x);
+	};
+	CHECK(send(x, 0) == std::vector<int>({5}));
+	CHECK(x->s_thing == &b[5]->pd);
+	actions.clear();
+	CHECK(send(x, 0) == std::vector<int>({5}));
+
+	// nested: the inner message unbinds an object the outer one hasn't
+	// reached yet, which must stay skipped until the outer one is done
+	pd_unbind(&b[5]->pd, x);
+	CHECK(!x->s_thing);
+	Binder *c[3] = {newBinder(10, x), newBinder(11, x), newBinder(12, x)};
+	actions[12] = [&](float f) {if(f > 0) {pd_float(x->s_thing, f - 1);}};
+	actions[11] = [&](float f) {if(f == 0) {pd_unbind(&c[0]->pd, x);}};
+	CHECK(send(x, 1) == std::vector<int>({12, 12, 11, 11}));
+	actions.clear();
+	CHECK(send(x, 0) == std::vector<int>({12, 11}));
+
+	// an object bound twice is unbound once at a time
+	pd_bind(&c[1]->pd, x);
+	CHECK(send(x, 0) == std::vector<int>({11, 12, 11}));
+	pd_unbind(&c[1]->pd, x);
+	CHECK(send(x, 0) == std::vector<int>({12, 11}));
+
+	pd_unbind(&c[1]->pd, x);
+	pd_unbind(&c[2]->pd, x);
+	CHECK(!x->s_thing);
+	return testResult();
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks that clocks go off in time order, and clocks set for the same time
+// in the order they were set, against a model of the sorted list pd used to
+// keep: 1000 clocks are set, unset, and reset at random times with many
+// ties, from inside their callbacks and between ticks
+
+#include "PdBase.hpp"
+#include "m_pd.h"
+#include "test.h"
+#include <list>
+#include <utility>
+
+#define TIMEUNITPERMSEC (32. * 441.)
+
+static const int numClocks = 1000, numTicks = 3000;
+
+// the same random actions for pd and the model
+static unsigned int seed;
+static unsigned int rnd() {seed = seed * 1103515245 + 12345; return seed >> 8;}
+
+template<class Clocks>
+static void act(Clocks &clocks, int id) {
+	unsigned int r = rnd() % 10;
+	if(r < 4) {clocks.delay(id, (rnd() % 8) * 0.5);} // many ties
+	else if(r < 5) {clocks.delay(id, 0);} // again in this tick
+	else if(r < 6) {clocks.unset(rnd() % numClocks);}
+	else if(r < 8) {clocks.delay(rnd() % numClocks, rnd() % 4);} // moves it
+	else if(r < 9) {
+		clocks.unset(id);
+		clocks.setUnit(id, 1 + rnd() % 3, rnd() & 1);
+		clocks.delay(id, rnd() % 5);
+	}
+	// else let it lapse
+}
+
+// the clocks in pd, logging ids and times as they go off
+class PdClocks {
+	public:
+		std::vector<std::pair<int, double>> log;
+		std::vector<double> ticks; // time at the start of each tick
+		PdClocks() {
+			for(int i = 0; i < numClocks; i++) {
+				owners[i] = {this, i};
+				clocks[i] = clock_new(&owners[i], (t_method)tick);
+			}
+		}
+		~PdClocks() {
+			for(t_clock *c : clocks) {clock_free(c);}
+		}
+		double now() {return clock_getlogicaltime();}
+		void delay(int id, double ms) {clock_delay(clocks[id], ms);}
+		void unset(int id) {clock_unset(clocks[id]);}
+		void setUnit(int id, double unit, int samples) {
+			clock_setunit(clocks[id], unit, samples);
+		}
+	private:
+		struct Owner {PdClocks *clocks; int id;};
+		Owner owners[numClocks];
+		t_clock *clocks[numClocks];
+		static void tick(Owner *owner) {
+			owner->clocks->log.push_back({owner->id, clock_getlogicaltime()});
+			act(*owner->clocks, owner->id);
+		}
+};
+
+// the old clock list: a clock goes after all clocks set for the same time
+class ModelClocks {
+	public:
+		std::vector<std::pair<int, double>> log;
+		double time = 0;
+		ModelClocks() : units(numClocks, TIMEUNITPERMSEC) {}
+		double now() {return time;}
+		void delay(int id, double ms) {
+			double t = time + (units[id] > 0 ? units[id] * ms :
+				-(units[id] * (TIMEUNITPERMSEC * 1000. / 44100.f)) * ms);
+			unset(id);
+			auto it = list.begin();
+			while(it != list.end() && it->first <= t) {it++;}
+			list.insert(it, {t, id});
+		}
+		void unset(int id) {
+			for(auto it = list.begin(); it != list.end(); it++) {
+				if(it->second == id) {list.erase(it); return;}
+			}
+		}
+		void setUnit(int id, double unit, int samples) {
+			units[id] = (samples ? -unit : unit * TIMEUNITPERMSEC);
+		}
+		void run(double until) { // one tick
+			while(!list.empty() && list.front().first < until) {
+				int id = list.front().second;
+				time = list.front().first;
+				list.pop_front();
+				log.push_back({id, time});
+				act(*this, id);
+			}
+			time = until;
+		}
+	private:
+		std::list<std::pair<double, int>> list;
+		std::vector<double> units;
+};
+
+// set clocks from outside every few ticks, before the tick runs
+template<class Clocks>
+static void between(Clocks &clocks, int tick) {
+	if(tick == 0) {
+		for(int i = 0; i < numClocks; i++) {clocks.delay(i, (rnd() % 20) * 0.25);}
+	}
+	else if(tick % 7 == 0) {
+		for(int i = 0; i < 50; i++) {
+			clocks.delay(rnd() % numClocks, (rnd() % 16) * 0.125);
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	pd.init(0, 1, 44100);
+	std::vector<float> out(64);
+
+	PdClocks clocks;
+	seed = 1;
+	for(int t = 0; t < numTicks; t++) {
+		clocks.ticks.push_back(clocks.now());
+		between(clocks, t);
+		pd.processFloat(1, NULL, out.data());
+	}
+	clocks.ticks.push_back(clocks.now());
+
+	ModelClocks model;
+	model.time = clocks.ticks[0];
+	seed = 1;
+	for(int t = 0; t < numTicks; t++) {
+		between(model, t);
+		model.run(clocks.ticks[t + 1]);
+	}
+
+	std::printf("%d clocks went off in %d ticks\n", (int)clocks.log.size(),
+		numTicks);
+	CHECK(clocks.log.size() > numTicks * 10);
+	CHECK(clocks.log.size() == model.log.size());
+	for(size_t i = 0; i < clocks.log.size() && i < model.log.size(); i++) {
+		if(clocks.log[i] != model.log[i]) {
+			std::printf("clock %d: id %d at %g, expected id %d at %g\n", (int)i,
+				clocks.log[i].first, clocks.log[i].second,
+				model.log[i].first, model.log[i].second);
+			CHECK(clocks.log[i] == model.log[i]);
+			break;
+		}
+	}
+	return testResult();
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks compiled .pdc patches: every file of the tokenizer corpus reads
+// back from its compiled form as the same atoms, and a patch using an
+// abstraction with arguments and escapes behaves the same from either form
+
+#include "PdBase.hpp"
+#include "test.h"
+#include "binbuf.h"
+#include <sys/stat.h>
+
+static bool same(const t_atom &a, const t_atom &b) {
+	if(a.a_type != b.a_type) {return false;}
+	switch(a.a_type) {
+		case A_FLOAT:
+			return !std::memcmp(&a.a_w.w_float, &b.a_w.w_float, sizeof(t_float));
+		case A_SYMBOL: case A_DOLLSYM:
+			return a.a_w.w_symbol == b.a_w.w_symbol;
+		case A_DOLLAR:
+			return a.a_w.w_index == b.a_w.w_index;
+		default:
+			return true;
+	}
+}
+
+class Receiver : public pd::PdReceiver {
+	public:
+		std::vector<float> out;
+		void receiveFloat(const std::string &dest, float num) {out.push_back(num);}
+};
+
+static void writeFile(const std::string &path, const std::string &text) {
+	std::ofstream file(path, std::ios::binary);
+	file << text;
+}
+
+// send to the open patch and return what came out
+static std::vector<float> run(pd::PdBase &pd, Receiver &receiver) {
+	receiver.out.clear();
+	pd.sendFloat("in", 3);
+	pd.sendFloat("in2", 4);
+	return receiver.out;
+}
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	Receiver receiver;
+	pd.init(0, 1, 44100);
+	pd.setReceiver(&receiver);
+	pd.subscribe("out");
+	mkdir("build/pdc", 0777);
+
+	// every corpus file as text and compiled
+	std::vector<CorpusFile> corpus = makeCorpus("..");
+	t_binbuf *text = binbuf_new(), *compiled = binbuf_new();
+	int files = 0;
+	for(size_t i = 0; i < corpus.size(); i++) {
+		writeFile("build/pdc/file.pd", corpus[i].text);
+		CHECK(pd.compilePatch("file.pd", "build/pdc"));
+		CHECK(!binbuf_read(text, "file.pd", "build/pdc", 0));
+		CHECK(!binbuf_read(compiled, "file.pdc", "build/pdc", 0));
+		int n = binbuf_getnatom(text);
+		t_atom *a = binbuf_getvec(text), *b = binbuf_getvec(compiled);
+		CHECK(binbuf_getnatom(compiled) == n);
+		for(int j = 0; j < n && j < binbuf_getnatom(compiled); j++) {
+			if(!same(a[j], b[j])) {
+				std::printf("%s: atom %d differs\n", corpus[i].name.c_str(), j);
+				CHECK(same(a[j], b[j]));
+				break;
+			}
+		}
+		files++;
+	}
+	binbuf_free(text);
+	binbuf_free(compiled);
+	std::printf("%d files read the same compiled\n", files);
+
+	// [adder 5] adds its argument, the message box sends $1 then 7
+	writeFile("build/pdc/adder.pd",
+		"#N canvas 0 50 450 300 12;\n"
+		"#X obj 0 0 inlet;\n"
+		"#X obj 0 0 + \\$1;\n"
+		"#X obj 0 0 outlet;\n"
+		"#X connect 0 0 1 0;\n"
+		"#X connect 1 0 2 0;\n");
+	writeFile("build/pdc/main.pd",
+		"#N canvas 0 50 450 300 12;\n"
+		"#X obj 0 0 r in;\n"
+		"#X obj 0 0 adder 5;\n"
+		"#X obj 0 0 s out;\n"
+		"#X obj 0 0 r in2;\n"
+		"#X msg 0 0 \\$1 \\, 7;\n"
+		"#X connect 0 0 1 0;\n"
+		"#X connect 1 0 2 0;\n"
+		"#X connect 3 0 4 0;\n"
+		"#X connect 4 0 2 0;\n");
+	pd::Patch patch = pd.openPatch("main.pd", "build/pdc");
+	CHECK(patch.isValid());
+	std::vector<float> expected = run(pd, receiver);
+	CHECK(expected == std::vector<float>({8, 4, 7}));
+	pd.closePatch(patch);
+
+	// compiled, with the abstraction only found as adder.pdc
+	CHECK(pd.compilePatch("adder.pd", "build/pdc"));
+	CHECK(pd.compilePatch("main.pd", "build/pdc"));
+	std::remove("build/pdc/adder.pd");
+	pd.rescanSearchPath();
+	patch = pd.openPatch("main.pdc", "build/pdc");
+	CHECK(patch.isValid());
+	CHECK(run(pd, receiver) == expected);
+	pd.closePatch(patch);
+
+	return testResult();
+}
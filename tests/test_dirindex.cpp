@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks the search path directory listings: abstractions added behind pd's
+// back are found after a rescan or after pd writes a new patch file, but not
+// after pd writes some other file
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+
+class Receiver : public pd::PdReceiver {
+	public:
+		std::vector<std::string> found;
+		void receiveSymbol(const std::string &dest, const std::string &symbol) {
+			found.push_back(symbol);
+		}
+};
+
+// an abstraction that sends its name to "found" when created
+static void writeAbstraction(const std::string &name) {
+	std::ofstream file("build/dirindex/" + name + ".pd");
+	file << "#N canvas 0 50 450 300 12;\n"
+	     << "#X obj 0 0 loadbang;\n"
+	     << "#X msg 0 0 symbol " << name << ";\n"
+	     << "#X obj 0 0 s found;\n"
+	     << "#X connect 0 0 1 0;\n"
+	     << "#X connect 1 0 2 0;\n";
+}
+
+// open and close a patch with the abstraction, true if it was created
+static bool found(pd::PdBase &pd, Receiver &receiver, const std::string &name) {
+	std::ofstream file("build/dirindex_main.pd");
+	file << "#N canvas 0 50 450 300 12;\n"
+	     << "#X obj 0 0 " << name << ";\n";
+	file.close();
+	receiver.found.clear();
+	pd::Patch patch = pd.openPatch("dirindex_main.pd", "build");
+	pd.closePatch(patch);
+	return receiver.found == std::vector<std::string>({name});
+}
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	Receiver receiver;
+	pd.init(0, 1, 44100);
+	pd.setReceiver(&receiver);
+	pd.subscribe("found");
+
+	mkdir("build/dirindex", 0777);
+	for(const char *file : {"abs1.pd", "abs2.pd", "abs3.pd", "notes.txt",
+	                        "new.pd"}) {
+		std::remove(("build/dirindex/" + std::string(file)).c_str());
+	}
+	pd.addToSearchPath("build/dirindex");
+	std::ofstream writer("build/dirindex_writer.pd");
+	writer << "#N canvas 0 50 450 300 12;\n"
+	       << "#X obj 0 0 r write;\n"
+	       << "#X obj 0 0 text define notes;\n"
+	       << "#X connect 0 0 1 0;\n";
+	writer.close();
+	pd::Patch patch = pd.openPatch("dirindex_writer.pd", "build");
+	CHECK(patch.isValid());
+
+	// found once listed, a file added later only after a rescan
+	writeAbstraction("abs1");
+	CHECK(found(pd, receiver, "abs1"));
+	writeAbstraction("abs2");
+	CHECK(!found(pd, receiver, "abs2"));
+	pd.rescanSearchPath();
+	CHECK(found(pd, receiver, "abs2"));
+
+	// writing a file that isn't a patch keeps the listings
+	writeAbstraction("abs3");
+	pd.sendMessage("write", "write", pd::List() << "dirindex/notes.txt");
+	CHECK(!found(pd, receiver, "abs3"));
+
+	// writing a new patch file lists the directories again
+	pd.sendMessage("write", "write", pd::List() << "dirindex/new.pd");
+	CHECK(found(pd, receiver, "abs3"));
+	CHECK(found(pd, receiver, "abs1"));
+
+	pd.closePatch(patch);
+	return testResult();
+}
@@ -0,0 +1,113 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks the mayer_* and pd_fft() transforms against the Ooura FFT for
+// sizes 4 to 65536
+
+#include "PdBase.hpp"
+#include "test.h"
+#include "fft.h"
+#include <cmath>
+
+// largest difference between a and b, relative to the largest value in b
+static double error(const std::vector<t_sample> &a,
+                    const std::vector<t_sample> &b) {
+	double maxdiff = 0, maxval = 0;
+	for(size_t i = 0; i < a.size(); i++) {
+		maxdiff = std::fmax(maxdiff, std::fabs(a[i] - b[i]));
+		maxval = std::fmax(maxval, std::fabs(b[i]));
+	}
+	return maxval > 0 ? maxdiff / maxval : maxdiff;
+}
+
+static std::vector<t_sample> noise(int n) {
+	std::vector<t_sample> v(n);
+	for(auto &f : v) {f = std::rand() / (t_sample)RAND_MAX * 2 - 1;}
+	return v;
+}
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	pd.init(0, 2, 44100);
+	std::srand(1);
+
+	// single precision FFTs are good to about 1e-7 * log2(n)
+	const double tolerance = 1e-5;
+	double worst = 0;
+	for(int n = 4; n <= 65536; n *= 2) {
+		OouraFFT ooura(n);
+		int half = n / 2;
+
+		// real forward and inverse
+		std::vector<t_sample> x = noise(n), got = x, want = x;
+		mayer_realfft(n, got.data());
+		ooura.realfft(want.data());
+		double realerr = error(got, want);
+		got = want;
+		mayer_realifft(n, got.data());
+		ooura.realifft(want.data());
+		double inverr = error(got, want);
+
+		// round trip
+		std::vector<t_sample> orig = x;
+		mayer_realfft(n, orig.data());
+		mayer_realifft(n, orig.data());
+		for(auto &f : orig) {f /= n;}
+		double triperr = error(orig, x);
+
+		// complex forward and inverse
+		std::vector<t_sample> re = noise(half), im = noise(half),
+			wantre = re, wantim = im;
+		mayer_fft(half, re.data(), im.data());
+		ooura.fft(wantre.data(), wantim.data(), -1);
+		double cplxerr = std::fmax(error(re, wantre), error(im, wantim));
+		mayer_ifft(half, re.data(), im.data());
+		ooura.fft(wantre.data(), wantim.data(), 1);
+		cplxerr = std::fmax(cplxerr, std::fmax(error(re, wantre),
+		                                       error(im, wantim)));
+
+		// interleaved
+		std::vector<t_sample> buf = noise(n), wantbuf = buf;
+		std::vector<t_sample> bre(half), bim(half);
+		for(int i = 0; i < half; i++) {
+			bre[i] = wantbuf[2 * i];
+			bim[i] = wantbuf[2 * i + 1];
+		}
+		pd_fft(buf.data(), half, 0);
+		ooura.fft(bre.data(), bim.data(), -1);
+		for(int i = 0; i < half; i++) {
+			wantbuf[2 * i] = bre[i];
+			wantbuf[2 * i + 1] = bim[i];
+		}
+		double pdffterr = error(buf, wantbuf);
+		pd_fft(buf.data(), half, 1);
+		ooura.fft(bre.data(), bim.data(), 1);
+		for(int i = 0; i < half; i++) {
+			wantbuf[2 * i] = bre[i];
+			wantbuf[2 * i + 1] = bim[i];
+		}
+		pdffterr = std::fmax(pdffterr, error(buf, wantbuf));
+
+		std::printf("%5d: real %.1e inverse %.1e round trip %.1e "
+			"complex %.1e pd_fft %.1e\n", n, realerr, inverr, triperr,
+			cplxerr, pdffterr);
+		CHECK(realerr < tolerance);
+		CHECK(inverr < tolerance);
+		CHECK(triperr < tolerance);
+		CHECK(cplxerr < tolerance);
+		CHECK(pdffterr < tolerance);
+		worst = std::fmax(worst, std::fmax(std::fmax(realerr, inverr),
+			std::fmax(cplxerr, pdffterr)));
+	}
+	std::printf("max error relative to the largest bin %.1e\n", worst);
+
+	return testResult();
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks opening a patch with several load threads: its abstractions are
+// created, and an abstraction that can't be read is reported once, by pd's
+// own thread, instead of also by the thread that prefetched it
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+
+class Receiver : public pd::PdReceiver {
+	public:
+		std::thread::id pdThread = std::this_thread::get_id();
+		int found = 0, errors = 0, otherThreads = 0;
+		void print(const std::string &message) {
+			if(message.find("bad compiled patch") != std::string::npos) {errors++;}
+			if(std::this_thread::get_id() != pdThread) {otherThreads++;}
+		}
+		void receiveBang(const std::string &dest) {found++;}
+};
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	Receiver receiver;
+	pd.init(0, 1, 44100);
+	pd.setReceiver(&receiver);
+	pd.subscribe("found");
+	pd.setLoadThreads(4);
+
+	// 20 good abstractions and a compiled one that's cut short
+	mkdir("build/prefetch", 0777);
+	std::ofstream main("build/prefetch/main.pd");
+	main << "#N canvas 0 50 450 300 12;\n";
+	for(int i = 0; i < 20; i++) {
+		std::ofstream abs("build/prefetch/abs" + std::to_string(i) + ".pd");
+		abs << "#N canvas 0 50 450 300 12;\n"
+		    << "#X obj 0 0 loadbang;\n"
+		    << "#X obj 0 0 s found;\n"
+		    << "#X connect 0 0 1 0;\n";
+		main << "#X obj 0 0 abs" << i << ";\n";
+	}
+	main << "#X obj 0 0 broken;\n";
+	main.close();
+	std::ofstream broken("build/prefetch/broken.pdc", std::ios::binary);
+	broken.write("\0PDC\x01\x05\x03", 7);
+	broken.close();
+
+	pd::Patch patch = pd.openPatch("main.pd", "build/prefetch");
+	CHECK(patch.isValid());
+	CHECK(receiver.found == 20);
+	CHECK(receiver.errors == 1);
+	CHECK(receiver.otherThreads == 0);
+	CHECK(pd.loadTimes().files > 0);
+	pd.closePatch(patch);
+
+	return testResult();
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks PdBase::readSoundFiles() with a normal, an empty, and a missing file
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <unistd.h>
+
+class Receiver : public pd::PdReceiver {
+	public:
+		std::vector<float> done;
+		int progress = 0;
+		void receiveMessage(const std::string &dest, const std::string &msg,
+		                    const pd::List &list) {
+			if(msg == "progress") {progress++;}
+			else if(msg == "done") {done = {list.getFloat(0), list.getFloat(1)};}
+		}
+};
+
+// tick until the batch is done, giving its threads time to run
+static void waitForBatch(pd::PdBase &pd, Receiver &receiver) {
+	std::vector<float> out(2 * 64); // stereo
+	double end = testNow() + 10000;
+	while(receiver.done.empty() && testNow() < end) {
+		pd.processFloat(1, NULL, out.data());
+		usleep(1000);
+	}
+}
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	Receiver receiver;
+	pd.init(0, 2, 44100);
+	pd.setReceiver(&receiver);
+	pd.subscribe("batch");
+	pd::Patch patch = pd.openPatch("arrays.pd", "patches");
+	CHECK(patch.isValid());
+
+	// a file with 1000 frames and one with only a header
+	std::vector<short> samples(1000);
+	for(int i = 0; i < 1000; i++) {samples[i] = (i % 2 ? -i : i) * 16;}
+	CHECK(testWriteWav("build/short.wav", 1, 44100, samples));
+	CHECK(testWriteWav("build/empty.wav", 1, 44100, {}));
+
+	// non-zero contents to see the empty file clear them
+	std::vector<float> ones(10, 1);
+	CHECK(pd.writeArray("array2", ones));
+
+	CHECK(pd.readSoundFiles("batch", {"build/short.wav", "build/empty.wav"},
+		{"array1", "array2"}));
+	waitForBatch(pd, receiver);
+
+	// the empty file counts as read and leaves a single zero
+	CHECK(receiver.progress == 2);
+	CHECK(receiver.done == std::vector<float>({2, 0}));
+	CHECK(pd.arraySize("array1") == 1000);
+	std::vector<float> got;
+	CHECK(pd.readArray("array1", got));
+	for(int i = 0; i < 1000 && i < (int)got.size(); i++) {
+		CHECK(got[i] == samples[i] / 32768.f);
+	}
+	CHECK(pd.arraySize("array2") == 1);
+	CHECK(pd.readArray("array2", got));
+	CHECK(got == std::vector<float>({0}));
+
+	// a missing file fails and leaves its array alone
+	receiver.done.clear();
+	CHECK(pd.readSoundFiles("batch", {"build/nosuchfile.wav"}, {"array2"}));
+	waitForBatch(pd, receiver);
+	CHECK(receiver.done == std::vector<float>({0, 1}));
+	CHECK(pd.arraySize("array2") == 1);
+
+	pd.closePatch(patch);
+	return testResult();
+}
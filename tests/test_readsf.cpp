@@ -0,0 +1,93 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks that [readsf~] plays a file and finishes right away when there is
+// nothing to read: a file with only a header, or an onset past the end
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <unistd.h>
+
+class Receiver : public pd::PdReceiver {
+	public:
+		int done = 0;
+		void receiveBang(const std::string &dest) {done++;}
+};
+
+// open a file with optional onset, start, and play until readsf~ bangs;
+// returns the samples played
+static std::vector<float> play(pd::PdBase &pd, Receiver &receiver,
+                               const char *file, int onset) {
+	std::vector<float> out(64), played;
+	receiver.done = 0;
+	pd::List open;
+	open << file;
+	if(onset) {open << onset;}
+	pd.sendMessage("readsf", "open", open);
+	pd.sendFloat("readsf", 1);
+	for(int i = 0; i < 1000 && !receiver.done; i++) {
+		pd.processFloat(1, NULL, out.data());
+		played.insert(played.end(), out.begin(), out.end());
+	}
+	CHECK(receiver.done == 1);
+	return played;
+}
+
+int main(int argc, char **argv) {
+	pd::PdBase pd;
+	Receiver receiver;
+	pd.init(0, 1, 44100);
+	pd.setReceiver(&receiver);
+	pd.subscribe("readsf-done");
+	pd.setSoundFileWait(true); // wait for the disk instead of dropping blocks
+	pd.computeAudio(true);
+	pd::Patch patch = pd.openPatch("readsf.pd", "patches");
+	CHECK(patch.isValid());
+
+	std::vector<short> samples(1000);
+	for(int i = 0; i < 1000; i++) {samples[i] = (i % 2 ? -i : i) * 16;}
+	CHECK(testWriteWav("build/short.wav", 1, 44100, samples));
+	CHECK(testWriteWav("build/empty.wav", 1, 44100, {}));
+
+	// these used to hang in "start", waiting for data that never came
+	alarm(20);
+
+	std::vector<float> played = play(pd, receiver, "../build/short.wav", 0);
+	CHECK(played.size() >= 1000);
+	for(int i = 0; i < 1000 && i < (int)played.size(); i++) {
+		CHECK(played[i] == samples[i] / 32768.f);
+	}
+	played = play(pd, receiver, "../build/short.wav", 990);
+	CHECK(played.size() >= 10);
+	for(int i = 0; i < 10 && i < (int)played.size(); i++) {
+		CHECK(played[i] == samples[990 + i] / 32768.f);
+	}
+
+	// nothing to play: silence and a bang after the first block
+	const char *files[] = {"../build/empty.wav", "../build/short.wav",
+		"../build/short.wav"};
+	const int onsets[] = {0, 1000, 5000};
+	for(int i = 0; i < 3; i++) {
+		played = play(pd, receiver, files[i], onsets[i]);
+		std::printf("%s %d: bang after %d samples\n", files[i], onsets[i],
+			(int)played.size());
+		CHECK(played.size() <= 128);
+		CHECK(played == std::vector<float>(played.size(), 0));
+	}
+
+	// and it still plays afterwards
+	played = play(pd, receiver, "../build/short.wav", 500);
+	CHECK(played.size() >= 500 && played[0] == samples[500] / 32768.f);
+
+	alarm(0);
+	pd.closePatch(patch);
+	return testResult();
+}
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2026 Dan Wilcox <danomatika@gmail.com>
+ *
+ * BSD Simplified License.
+ * For information on usage and redistribution, and for a DISCLAIMER OF ALL
+ * WARRANTIES, see the file, "LICENSE.txt," in this distribution.
+ *
+ * See https://github.com/danomatika/ofxPd for documentation
+ *
+ */
+
+// checks [tabread4~] and [tabosc4~] against the plain per-sample
+// interpolation they used before it was vectorized
+
+#include "PdBase.hpp"
+#include "test.h"
+#include <cmath>
+#include <vector>
+
+// 4-point interpolation between b and c
+static float interpolate(float a, float b, float c, float d, float frac) {
+	float cminusb = c - b;
+	return b + frac * (cminusb - (1.0f / 6.0f) * (1.0f - frac) *
+		((d - a - 3.0f * cminusb) * frac + (d + a * 2.0f - b * 3.0f)));
+}
+
+// what tabread4~ outputs for index x into tab
+static float tabread4(const std::vector<float> &tab, float x) {
+	int maxindex = (int)tab.size() - 3;
+	double findex = x;
+	int index = (int)findex;
+	float frac;
+	if(std::isnan(findex) || index < 1) {
+		index = 1, frac = 0;
+	}
+	else if(index > maxindex) {
+		index = maxindex, frac = 1;
+	}
+	else {
+		frac = findex - index;
+	}
+	return interpolate(tab[index-1], tab[index], tab[index+1], tab[index+2], frac);
+}
+
+int main(int argc, char **argv) {
+	const int ticks = 8, n = 64 * ticks;
+	pd::PdBase pd;
+	pd.init(2, 2, 44100);
+	pd.computeAudio(true);
+	pd::Patch patch = pd.openPatch("tabread4.pd", "patches");
+	CHECK(patch.isValid());
+
+	std::vector<float> tab(1000), osc(515);
+	std::srand(1);
+	for(auto &f : tab) {f = std::rand() / (float)RAND_MAX * 2 - 1;}
+	for(size_t i = 0; i < osc.size(); i++) {osc[i] = std::sin(i * 0.05) + 0.1f * (i % 7);}
+	pd.writeArray("t4read", tab);
+	pd.writeArray("t4osc", osc);
+
+	// indices: in range, at and past both ends, odd lengths for the tails
+	std::vector<float> in(n), freq(n), inter(2 * n), out(2 * n);
+	for(int i = 0; i < n; i++) {
+		in[i] = std::rand() / (float)RAND_MAX * 1010 - 5;
+		freq[i] = std::rand() / (float)RAND_MAX * 4000 - 2000;
+	}
+	const float edges[] = {-1e10f, -5, 0, 0.5f, 1, 1.25f, 996.9f, 997, 997.5f,
+		998, 1e10f, NAN, 2.5f};
+	for(size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++) {
+		in[i * 3] = edges[i];
+	}
+	for(int i = 0; i < n; i++) {
+		inter[2 * i] = in[i];
+		inter[2 * i + 1] = freq[i];
+	}
+	pd.processFloat(ticks, inter.data(), out.data());
+
+	// tabread4~ on the left, out is interleaved
+	float maxerr = 0;
+	for(int i = 0; i < n; i++) {
+		float want = tabread4(tab, in[i]), got = out[2 * i];
+		maxerr = std::max(maxerr, std::fabs(want - got));
+	}
+	std::printf("tabread4~ max error %g\n", maxerr);
+	CHECK(maxerr < 1e-6f);
+
+	// tabosc4~ on the right, from phase 0
+	double phase = 0;
+	maxerr = 0;
+	for(int i = 0; i < n; i++) {
+		double p = phase - std::floor(phase);
+		int index = (int)(p * 512);
+		float frac = p * 512 - index, want;
+		want = interpolate(osc[index], osc[index+1], osc[index+2], osc[index+3], frac);
+		maxerr = std::max(maxerr, std::fabs(want - out[2 * i + 1]));
+		phase += freq[i] / 44100.0;
+	}
+	std::printf("tabosc4~ max error %g\n", maxerr);
+	CHECK(maxerr < 1e-4f);
+
+	pd.closePatch(patch);
+	return testResult();
+}